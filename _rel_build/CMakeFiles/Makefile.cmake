@@ -0,0 +1,83 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/repo/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "CMakeFiles/gameserver.dir/DependInfo.cmake"
+  "CMakeFiles/test.dir/DependInfo.cmake"
+  "CMakeFiles/test_async_log.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_format.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_pool.dir/DependInfo.cmake"
+  "CMakeFiles/test_binlog.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_macro.dir/DependInfo.cmake"
+  "CMakeFiles/test_logger_manager.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_thread.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_rcu.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_flush.dir/DependInfo.cmake"
+  "CMakeFiles/test_mmap_log.dir/DependInfo.cmake"
+  "CMakeFiles/test_flight_recorder.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_limit.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_metrics.dir/DependInfo.cmake"
+  "CMakeFiles/test_log_json.dir/DependInfo.cmake"
+  "CMakeFiles/test_thread.dir/DependInfo.cmake"
+  "CMakeFiles/test_fiber.dir/DependInfo.cmake"
+  "CMakeFiles/test_scheduler.dir/DependInfo.cmake"
+  "CMakeFiles/test_iomanager.dir/DependInfo.cmake"
+  "CMakeFiles/test_timer.dir/DependInfo.cmake"
+  "CMakeFiles/test_hook.dir/DependInfo.cmake"
+  "CMakeFiles/test_bytearray.dir/DependInfo.cmake"
+  "CMakeFiles/test_http_parser.dir/DependInfo.cmake"
+  "CMakeFiles/test_http_server.dir/DependInfo.cmake"
+  "CMakeFiles/test_net_log.dir/DependInfo.cmake"
+  "CMakeFiles/bench_mutex.dir/DependInfo.cmake"
+  "CMakeFiles/bench_log.dir/DependInfo.cmake"
+  "CMakeFiles/bench_fiber.dir/DependInfo.cmake"
+  "CMakeFiles/bench_scheduler.dir/DependInfo.cmake"
+  "CMakeFiles/bench_iomanager.dir/DependInfo.cmake"
+  "CMakeFiles/bench_timer.dir/DependInfo.cmake"
+  "CMakeFiles/bench_hook.dir/DependInfo.cmake"
+  "CMakeFiles/bench_bytearray.dir/DependInfo.cmake"
+  "CMakeFiles/bench_http.dir/DependInfo.cmake"
+  "CMakeFiles/bench_net_log.dir/DependInfo.cmake"
+  "CMakeFiles/binlog_decode.dir/DependInfo.cmake"
+  )
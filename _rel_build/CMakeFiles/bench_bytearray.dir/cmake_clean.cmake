@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_bytearray"
+  "/root/repo/bin/release/bench_bytearray.pdb"
+  "CMakeFiles/bench_bytearray.dir/bench/bench_bytearray.cc.o"
+  "CMakeFiles/bench_bytearray.dir/bench/bench_bytearray.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_bytearray.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
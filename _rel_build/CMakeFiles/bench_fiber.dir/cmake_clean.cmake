@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_fiber"
+  "/root/repo/bin/release/bench_fiber.pdb"
+  "CMakeFiles/bench_fiber.dir/bench/bench_fiber.cc.o"
+  "CMakeFiles/bench_fiber.dir/bench/bench_fiber.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_fiber.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_hook"
+  "/root/repo/bin/release/bench_hook.pdb"
+  "CMakeFiles/bench_hook.dir/bench/bench_hook.cc.o"
+  "CMakeFiles/bench_hook.dir/bench/bench_hook.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_hook.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_http"
+  "/root/repo/bin/release/bench_http.pdb"
+  "CMakeFiles/bench_http.dir/bench/bench_http.cc.o"
+  "CMakeFiles/bench_http.dir/bench/bench_http.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_http.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
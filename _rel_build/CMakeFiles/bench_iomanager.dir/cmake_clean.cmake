@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_iomanager"
+  "/root/repo/bin/release/bench_iomanager.pdb"
+  "CMakeFiles/bench_iomanager.dir/bench/bench_iomanager.cc.o"
+  "CMakeFiles/bench_iomanager.dir/bench/bench_iomanager.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_iomanager.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_log"
+  "/root/repo/bin/release/bench_log.pdb"
+  "CMakeFiles/bench_log.dir/bench/bench_log.cc.o"
+  "CMakeFiles/bench_log.dir/bench/bench_log.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_log.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_mutex"
+  "/root/repo/bin/release/bench_mutex.pdb"
+  "CMakeFiles/bench_mutex.dir/bench/bench_mutex.cc.o"
+  "CMakeFiles/bench_mutex.dir/bench/bench_mutex.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_mutex.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_net_log"
+  "/root/repo/bin/release/bench_net_log.pdb"
+  "CMakeFiles/bench_net_log.dir/bench/bench_net_log.cc.o"
+  "CMakeFiles/bench_net_log.dir/bench/bench_net_log.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_net_log.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_scheduler"
+  "/root/repo/bin/release/bench_scheduler.pdb"
+  "CMakeFiles/bench_scheduler.dir/bench/bench_scheduler.cc.o"
+  "CMakeFiles/bench_scheduler.dir/bench/bench_scheduler.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_scheduler.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
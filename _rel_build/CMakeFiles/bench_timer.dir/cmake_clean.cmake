@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/bench_timer"
+  "/root/repo/bin/release/bench_timer.pdb"
+  "CMakeFiles/bench_timer.dir/bench/bench_timer.cc.o"
+  "CMakeFiles/bench_timer.dir/bench/bench_timer.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_timer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
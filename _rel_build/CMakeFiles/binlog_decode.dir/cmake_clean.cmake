@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/binlog_decode"
+  "/root/repo/bin/release/binlog_decode.pdb"
+  "CMakeFiles/binlog_decode.dir/tools/binlog_decode.cc.o"
+  "CMakeFiles/binlog_decode.dir/tools/binlog_decode.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/binlog_decode.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,45 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/gameserver/Fiber/context.cc" "CMakeFiles/gameserver.dir/gameserver/Fiber/context.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Fiber/context.cc.o.d"
+  "/root/repo/gameserver/Fiber/fd_manager.cc" "CMakeFiles/gameserver.dir/gameserver/Fiber/fd_manager.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Fiber/fd_manager.cc.o.d"
+  "/root/repo/gameserver/Fiber/fiber.cc" "CMakeFiles/gameserver.dir/gameserver/Fiber/fiber.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Fiber/fiber.cc.o.d"
+  "/root/repo/gameserver/Fiber/hook.cc" "CMakeFiles/gameserver.dir/gameserver/Fiber/hook.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Fiber/hook.cc.o.d"
+  "/root/repo/gameserver/Fiber/iomanager.cc" "CMakeFiles/gameserver.dir/gameserver/Fiber/iomanager.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Fiber/iomanager.cc.o.d"
+  "/root/repo/gameserver/Fiber/scheduler.cc" "CMakeFiles/gameserver.dir/gameserver/Fiber/scheduler.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Fiber/scheduler.cc.o.d"
+  "/root/repo/gameserver/Fiber/stack.cc" "CMakeFiles/gameserver.dir/gameserver/Fiber/stack.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Fiber/stack.cc.o.d"
+  "/root/repo/gameserver/Fiber/timer.cc" "CMakeFiles/gameserver.dir/gameserver/Fiber/timer.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Fiber/timer.cc.o.d"
+  "/root/repo/gameserver/Log/async_log.cc" "CMakeFiles/gameserver.dir/gameserver/Log/async_log.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/async_log.cc.o.d"
+  "/root/repo/gameserver/Log/binlog.cc" "CMakeFiles/gameserver.dir/gameserver/Log/binlog.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/binlog.cc.o.d"
+  "/root/repo/gameserver/Log/flight_recorder.cc" "CMakeFiles/gameserver.dir/gameserver/Log/flight_recorder.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/flight_recorder.cc.o.d"
+  "/root/repo/gameserver/Log/log.cc" "CMakeFiles/gameserver.dir/gameserver/Log/log.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/log.cc.o.d"
+  "/root/repo/gameserver/Log/log_format.cc" "CMakeFiles/gameserver.dir/gameserver/Log/log_format.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/log_format.cc.o.d"
+  "/root/repo/gameserver/Log/log_json.cc" "CMakeFiles/gameserver.dir/gameserver/Log/log_json.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/log_json.cc.o.d"
+  "/root/repo/gameserver/Log/log_metrics.cc" "CMakeFiles/gameserver.dir/gameserver/Log/log_metrics.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/log_metrics.cc.o.d"
+  "/root/repo/gameserver/Log/log_stream.cc" "CMakeFiles/gameserver.dir/gameserver/Log/log_stream.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/log_stream.cc.o.d"
+  "/root/repo/gameserver/Log/mmap_log.cc" "CMakeFiles/gameserver.dir/gameserver/Log/mmap_log.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/mmap_log.cc.o.d"
+  "/root/repo/gameserver/Log/net_log.cc" "CMakeFiles/gameserver.dir/gameserver/Log/net_log.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Log/net_log.cc.o.d"
+  "/root/repo/gameserver/Net/bytearray.cc" "CMakeFiles/gameserver.dir/gameserver/Net/bytearray.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Net/bytearray.cc.o.d"
+  "/root/repo/gameserver/Net/http.cc" "CMakeFiles/gameserver.dir/gameserver/Net/http.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Net/http.cc.o.d"
+  "/root/repo/gameserver/Net/http_parser.cc" "CMakeFiles/gameserver.dir/gameserver/Net/http_parser.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Net/http_parser.cc.o.d"
+  "/root/repo/gameserver/Net/http_server.cc" "CMakeFiles/gameserver.dir/gameserver/Net/http_server.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Net/http_server.cc.o.d"
+  "/root/repo/gameserver/Net/servlet.cc" "CMakeFiles/gameserver.dir/gameserver/Net/servlet.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Net/servlet.cc.o.d"
+  "/root/repo/gameserver/Thread/rcu.cc" "CMakeFiles/gameserver.dir/gameserver/Thread/rcu.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Thread/rcu.cc.o.d"
+  "/root/repo/gameserver/Thread/thread.cc" "CMakeFiles/gameserver.dir/gameserver/Thread/thread.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Thread/thread.cc.o.d"
+  "/root/repo/gameserver/Util/metrics.cc" "CMakeFiles/gameserver.dir/gameserver/Util/metrics.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Util/metrics.cc.o.d"
+  "/root/repo/gameserver/Util/util.cc" "CMakeFiles/gameserver.dir/gameserver/Util/util.cc.o" "gcc" "CMakeFiles/gameserver.dir/gameserver/Util/util.cc.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,63 @@
+file(REMOVE_RECURSE
+  "/root/repo/lib/release/libgameserver.pdb"
+  "/root/repo/lib/release/libgameserver.so"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/context.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/context.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/fd_manager.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/fd_manager.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/fiber.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/fiber.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/hook.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/hook.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/iomanager.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/iomanager.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/scheduler.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/scheduler.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/stack.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/stack.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/timer.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Fiber/timer.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/async_log.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/async_log.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/binlog.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/binlog.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/flight_recorder.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/flight_recorder.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log_format.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log_format.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log_json.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log_json.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log_metrics.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log_metrics.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log_stream.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/log_stream.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/mmap_log.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/mmap_log.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Log/net_log.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Log/net_log.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Net/bytearray.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Net/bytearray.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Net/http.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Net/http.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Net/http_parser.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Net/http_parser.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Net/http_server.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Net/http_server.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Net/servlet.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Net/servlet.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Thread/rcu.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Thread/rcu.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Thread/thread.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Thread/thread.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Util/metrics.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Util/metrics.cc.o.d"
+  "CMakeFiles/gameserver.dir/gameserver/Util/util.cc.o"
+  "CMakeFiles/gameserver.dir/gameserver/Util/util.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/gameserver.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
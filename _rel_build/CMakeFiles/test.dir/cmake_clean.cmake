@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test"
+  "/root/repo/bin/release/test.pdb"
+  "CMakeFiles/test.dir/tests/test.cc.o"
+  "CMakeFiles/test.dir/tests/test.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
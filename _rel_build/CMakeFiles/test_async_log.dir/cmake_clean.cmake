@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_async_log"
+  "/root/repo/bin/release/test_async_log.pdb"
+  "CMakeFiles/test_async_log.dir/tests/test_async_log.cc.o"
+  "CMakeFiles/test_async_log.dir/tests/test_async_log.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_async_log.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
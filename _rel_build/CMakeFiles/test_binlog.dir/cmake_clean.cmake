@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_binlog"
+  "/root/repo/bin/release/test_binlog.pdb"
+  "CMakeFiles/test_binlog.dir/tests/test_binlog.cc.o"
+  "CMakeFiles/test_binlog.dir/tests/test_binlog.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_binlog.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
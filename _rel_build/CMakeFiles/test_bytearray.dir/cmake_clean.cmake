@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_bytearray"
+  "/root/repo/bin/release/test_bytearray.pdb"
+  "CMakeFiles/test_bytearray.dir/tests/test_bytearray.cc.o"
+  "CMakeFiles/test_bytearray.dir/tests/test_bytearray.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_bytearray.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_fiber"
+  "/root/repo/bin/release/test_fiber.pdb"
+  "CMakeFiles/test_fiber.dir/tests/test_fiber.cc.o"
+  "CMakeFiles/test_fiber.dir/tests/test_fiber.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_fiber.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
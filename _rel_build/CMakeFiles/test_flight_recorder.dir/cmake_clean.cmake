@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_flight_recorder"
+  "/root/repo/bin/release/test_flight_recorder.pdb"
+  "CMakeFiles/test_flight_recorder.dir/tests/test_flight_recorder.cc.o"
+  "CMakeFiles/test_flight_recorder.dir/tests/test_flight_recorder.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_flight_recorder.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
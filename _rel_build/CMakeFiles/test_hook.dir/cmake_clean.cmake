@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_hook"
+  "/root/repo/bin/release/test_hook.pdb"
+  "CMakeFiles/test_hook.dir/tests/test_hook.cc.o"
+  "CMakeFiles/test_hook.dir/tests/test_hook.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_hook.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_http_parser"
+  "/root/repo/bin/release/test_http_parser.pdb"
+  "CMakeFiles/test_http_parser.dir/tests/test_http_parser.cc.o"
+  "CMakeFiles/test_http_parser.dir/tests/test_http_parser.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_http_parser.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
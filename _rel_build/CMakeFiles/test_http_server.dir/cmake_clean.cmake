@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_http_server"
+  "/root/repo/bin/release/test_http_server.pdb"
+  "CMakeFiles/test_http_server.dir/tests/test_http_server.cc.o"
+  "CMakeFiles/test_http_server.dir/tests/test_http_server.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_http_server.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_iomanager"
+  "/root/repo/bin/release/test_iomanager.pdb"
+  "CMakeFiles/test_iomanager.dir/tests/test_iomanager.cc.o"
+  "CMakeFiles/test_iomanager.dir/tests/test_iomanager.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_iomanager.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_log_flush"
+  "/root/repo/bin/release/test_log_flush.pdb"
+  "CMakeFiles/test_log_flush.dir/tests/test_log_flush.cc.o"
+  "CMakeFiles/test_log_flush.dir/tests/test_log_flush.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_log_flush.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_log_format"
+  "/root/repo/bin/release/test_log_format.pdb"
+  "CMakeFiles/test_log_format.dir/tests/test_log_format.cc.o"
+  "CMakeFiles/test_log_format.dir/tests/test_log_format.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_log_format.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
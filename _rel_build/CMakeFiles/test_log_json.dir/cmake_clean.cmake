@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_log_json"
+  "/root/repo/bin/release/test_log_json.pdb"
+  "CMakeFiles/test_log_json.dir/tests/test_log_json.cc.o"
+  "CMakeFiles/test_log_json.dir/tests/test_log_json.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_log_json.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_log_limit"
+  "/root/repo/bin/release/test_log_limit.pdb"
+  "CMakeFiles/test_log_limit.dir/tests/test_log_limit.cc.o"
+  "CMakeFiles/test_log_limit.dir/tests/test_log_limit.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_log_limit.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
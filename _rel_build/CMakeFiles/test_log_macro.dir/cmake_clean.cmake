@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_log_macro"
+  "/root/repo/bin/release/test_log_macro.pdb"
+  "CMakeFiles/test_log_macro.dir/tests/test_log_macro.cc.o"
+  "CMakeFiles/test_log_macro.dir/tests/test_log_macro.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_log_macro.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
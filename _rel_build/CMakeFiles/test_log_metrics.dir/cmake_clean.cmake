@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_log_metrics"
+  "/root/repo/bin/release/test_log_metrics.pdb"
+  "CMakeFiles/test_log_metrics.dir/tests/test_log_metrics.cc.o"
+  "CMakeFiles/test_log_metrics.dir/tests/test_log_metrics.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_log_metrics.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_log_pool"
+  "/root/repo/bin/release/test_log_pool.pdb"
+  "CMakeFiles/test_log_pool.dir/tests/test_log_pool.cc.o"
+  "CMakeFiles/test_log_pool.dir/tests/test_log_pool.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_log_pool.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_log_rcu"
+  "/root/repo/bin/release/test_log_rcu.pdb"
+  "CMakeFiles/test_log_rcu.dir/tests/test_log_rcu.cc.o"
+  "CMakeFiles/test_log_rcu.dir/tests/test_log_rcu.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_log_rcu.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_logger_manager"
+  "/root/repo/bin/release/test_logger_manager.pdb"
+  "CMakeFiles/test_logger_manager.dir/tests/test_logger_manager.cc.o"
+  "CMakeFiles/test_logger_manager.dir/tests/test_logger_manager.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_logger_manager.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
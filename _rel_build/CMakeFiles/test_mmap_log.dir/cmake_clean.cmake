@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_mmap_log"
+  "/root/repo/bin/release/test_mmap_log.pdb"
+  "CMakeFiles/test_mmap_log.dir/tests/test_mmap_log.cc.o"
+  "CMakeFiles/test_mmap_log.dir/tests/test_mmap_log.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_mmap_log.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
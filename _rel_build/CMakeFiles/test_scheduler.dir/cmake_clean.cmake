@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_scheduler"
+  "/root/repo/bin/release/test_scheduler.pdb"
+  "CMakeFiles/test_scheduler.dir/tests/test_scheduler.cc.o"
+  "CMakeFiles/test_scheduler.dir/tests/test_scheduler.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_scheduler.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
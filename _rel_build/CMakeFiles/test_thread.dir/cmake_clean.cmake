@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_thread"
+  "/root/repo/bin/release/test_thread.pdb"
+  "CMakeFiles/test_thread.dir/tests/test_thread.cc.o"
+  "CMakeFiles/test_thread.dir/tests/test_thread.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_thread.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
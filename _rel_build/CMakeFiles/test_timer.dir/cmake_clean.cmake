@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "/root/repo/bin/release/test_timer"
+  "/root/repo/bin/release/test_timer.pdb"
+  "CMakeFiles/test_timer.dir/tests/test_timer.cc.o"
+  "CMakeFiles/test_timer.dir/tests/test_timer.cc.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_timer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
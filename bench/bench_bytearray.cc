@@ -0,0 +1,223 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <endian.h>
+#include <sys/uio.h>
+#include "Net/bytearray.h"
+
+/**
+ * @brief 组包测试: ByteArray 对比 std::string 拼接
+ * @details 一个约200字节的包: 包头(长度, 消息号, 序号), 玩家id, 等级, 名字, 坐标, 25个物品(id, 数量).
+ *          sstream       每个包一个std::stringstream, 最后str() (LogFormatter::format的做法)
+ *          string        每个包一个新的std::string, append拼接
+ *          string_reuse  复用一个std::string, clear()后拼接
+ *          bytearray     每个包一个新的ByteArray(块来自线程缓存), 取iovec
+ *          bytearray_reuse 复用一个ByteArray, 取iovec后skip
+ *          bytearray_varint 同上, 等级, 物品id和数量用varint, 包更小
+ *          定长整数都是网络字节序, 字符串长度前缀16位.
+ *          输出每个包的纳秒数和字节数. 用法: bench_bytearray [包数]
+ */
+
+static double now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Item {
+    uint32_t id;
+    uint16_t count;
+};
+
+struct Packet {
+    uint16_t msgid = 1001;
+    uint32_t seq = 0;
+    uint64_t player = 1234567890123ull;
+    uint32_t level = 57;
+    std::string name = "DragonSlayer_42";
+    float x = 1024.5f, y = -33.25f, z = 7.0f;
+    std::vector<Item> items;
+};
+
+static uint64_t s_sink = 0;
+
+template<class T>
+static void append_fixed(std::string& s, T v) {
+    s.append((const char*)&v, sizeof(v));
+}
+
+static void append_float(std::string& s, float f) {
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    append_fixed(s, htobe32(v));
+}
+
+static void build_string(std::string& s, const Packet& p) {
+    append_fixed(s, htobe16(0));
+    append_fixed(s, htobe16(p.msgid));
+    append_fixed(s, htobe32(p.seq));
+    append_fixed(s, htobe64(p.player));
+    append_fixed(s, htobe32(p.level));
+    append_fixed(s, htobe16(p.name.size()));
+    s.append(p.name);
+    append_float(s, p.x);
+    append_float(s, p.y);
+    append_float(s, p.z);
+    append_fixed(s, htobe16(p.items.size()));
+    for(auto& i : p.items) {
+        append_fixed(s, htobe32(i.id));
+        append_fixed(s, htobe16(i.count));
+    }
+    uint16_t len = htobe16(s.size());
+    memcpy(&s[0], &len, sizeof(len));
+}
+
+template<class T>
+static void ss_fixed(std::stringstream& ss, T v) {
+    ss.write((const char*)&v, sizeof(v));
+}
+
+static std::string build_sstream(const Packet& p) {
+    std::stringstream ss;
+    ss_fixed(ss, htobe16(0));
+    ss_fixed(ss, htobe16(p.msgid));
+    ss_fixed(ss, htobe32(p.seq));
+    ss_fixed(ss, htobe64(p.player));
+    ss_fixed(ss, htobe32(p.level));
+    ss_fixed(ss, htobe16(p.name.size()));
+    ss << p.name;
+    for(float f : {p.x, p.y, p.z}) {
+        uint32_t v;
+        memcpy(&v, &f, sizeof(v));
+        ss_fixed(ss, htobe32(v));
+    }
+    ss_fixed(ss, htobe16(p.items.size()));
+    for(auto& i : p.items) {
+        ss_fixed(ss, htobe32(i.id));
+        ss_fixed(ss, htobe16(i.count));
+    }
+    std::string s = ss.str();
+    uint16_t len = htobe16(s.size());
+    memcpy(&s[0], &len, sizeof(len));
+    return s;
+}
+
+static void build_bytearray(gameserver::ByteArray& ba, const Packet& p, bool varint) {
+    size_t begin = ba.getReadSize();
+    ba.writeFuint16(0);
+    ba.writeFuint16(p.msgid);
+    ba.writeFuint32(p.seq);
+    ba.writeFuint64(p.player);
+    if(varint) {
+        ba.writeUint32(p.level);
+    } else {
+        ba.writeFuint32(p.level);
+    }
+    ba.writeStringF16(p.name);
+    ba.writeFloat(p.x);
+    ba.writeFloat(p.y);
+    ba.writeFloat(p.z);
+    if(varint) {
+        ba.writeUint32(p.items.size());
+        for(auto& i : p.items) {
+            ba.writeUint32(i.id);
+            ba.writeUint32(i.count);
+        }
+    } else {
+        ba.writeFuint16(p.items.size());
+        for(auto& i : p.items) {
+            ba.writeFuint32(i.id);
+            ba.writeFuint16(i.count);
+        }
+    }
+    uint16_t len = htobe16(ba.getReadSize() - begin);
+    ba.writeAt(begin, &len, sizeof(len));
+}
+
+static void print(const char* name, double ns, size_t bytes) {
+    std::cout << std::setw(18) << name
+              << std::setw(12) << ns
+              << std::setw(8) << bytes << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? atol(argv[1]) : 1000000;
+    if(n == 0) {
+        std::cerr << "usage: " << argv[0] << " [packets]" << std::endl;
+        return 1;
+    }
+    Packet p;
+    srand(12345);
+    for(int i = 0; i < 25; ++i) {
+        p.items.push_back(Item{(uint32_t)(10000 + rand() % 5000), (uint16_t)(1 + rand() % 99)});
+    }
+
+    std::cout << "packets=" << n << std::endl;
+    std::cout << std::setw(18) << "impl" << std::setw(12) << "ns/packet"
+              << std::setw(8) << "bytes" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+
+    size_t bytes = 0;
+    double t0 = now_ns();
+    for(size_t i = 0; i < n; ++i) {
+        p.seq = i;
+        std::string s = build_sstream(p);
+        s_sink += s.size() + (uint8_t)s[5];
+        bytes = s.size();
+    }
+    print("sstream", (now_ns() - t0) / n, bytes);
+
+    t0 = now_ns();
+    for(size_t i = 0; i < n; ++i) {
+        p.seq = i;
+        std::string s;
+        build_string(s, p);
+        s_sink += s.size() + (uint8_t)s[5];
+        bytes = s.size();
+    }
+    print("string", (now_ns() - t0) / n, bytes);
+
+    std::string reuse;
+    t0 = now_ns();
+    for(size_t i = 0; i < n; ++i) {
+        p.seq = i;
+        reuse.clear();
+        build_string(reuse, p);
+        s_sink += reuse.size() + (uint8_t)reuse[5];
+        bytes = reuse.size();
+    }
+    print("string_reuse", (now_ns() - t0) / n, bytes);
+
+    std::vector<iovec> iovs;
+    t0 = now_ns();
+    for(size_t i = 0; i < n; ++i) {
+        p.seq = i;
+        gameserver::ByteArray ba;
+        build_bytearray(ba, p, false);
+        iovs.clear();
+        bytes = ba.getReadBuffers(iovs);
+        s_sink += bytes + ((uint8_t*)iovs[0].iov_base)[5];
+    }
+    print("bytearray", (now_ns() - t0) / n, bytes);
+
+    gameserver::ByteArray ba;
+    for(bool varint : {false, true}) {
+        t0 = now_ns();
+        for(size_t i = 0; i < n; ++i) {
+            p.seq = i;
+            build_bytearray(ba, p, varint);
+            iovs.clear();
+            bytes = ba.getReadBuffers(iovs);
+            s_sink += bytes + ((uint8_t*)iovs[0].iov_base)[5];
+            ba.skip(bytes);
+        }
+        print(varint ? "bytearray_varint" : "bytearray_reuse", (now_ns() - t0) / n, bytes);
+    }
+
+    std::cerr << "sink=" << s_sink << std::endl;
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <stdlib.h>
+#include <ucontext.h>
+#include "Fiber/fiber.h"
+#include "Fiber/stack.h"
+
+/**
+ * @brief 协程切换和创建测试
+ * @details switch       swapIn + YieldToHold 来回一次的耗时的一半
+ *          ucontext     同样来回用swapcontext, 作为对比
+ *          create       创建 + 执行空函数 + 销毁, 栈来自缓存
+ *          create.nopool 同上, 关闭栈缓存, 每次mmap/mprotect/munmap
+ *          建议用优化编译: cmake -DCMAKE_BUILD_TYPE=Release
+ *          用法: bench_fiber [次数]
+ */
+
+static double now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double bench_switch(int n) {
+    gameserver::Fiber::ptr fiber(new gameserver::Fiber([n]() {
+        for(int i = 0; i < n; ++i) {
+            gameserver::Fiber::YieldToHold();
+        }
+    }));
+    double begin = now_ns();
+    for(int i = 0; i < n; ++i) {
+        fiber->swapIn();
+    }
+    double end = now_ns();
+    fiber->swapIn();
+    return (end - begin) / n / 2;
+}
+
+static ucontext_t s_main_ctx;
+static ucontext_t s_fiber_ctx;
+static int s_uc_n = 0;
+
+static void uc_func() {
+    for(int i = 0; i < s_uc_n; ++i) {
+        swapcontext(&s_fiber_ctx, &s_main_ctx);
+    }
+}
+
+static double bench_ucontext(int n) {
+    std::vector<char> stack(128 * 1024);
+    s_uc_n = n;
+    getcontext(&s_fiber_ctx);
+    s_fiber_ctx.uc_stack.ss_sp = &stack[0];
+    s_fiber_ctx.uc_stack.ss_size = stack.size();
+    s_fiber_ctx.uc_link = &s_main_ctx;
+    makecontext(&s_fiber_ctx, &uc_func, 0);
+    double begin = now_ns();
+    for(int i = 0; i < n; ++i) {
+        swapcontext(&s_main_ctx, &s_fiber_ctx);
+    }
+    double end = now_ns();
+    swapcontext(&s_main_ctx, &s_fiber_ctx);
+    return (end - begin) / n / 2;
+}
+
+static double bench_create(int n) {
+    int sum = 0;
+    double begin = now_ns();
+    for(int i = 0; i < n; ++i) {
+        gameserver::Fiber::ptr fiber(new gameserver::Fiber([&sum]() {
+            ++sum;
+        }));
+        fiber->swapIn();
+    }
+    double end = now_ns();
+    return (end - begin) / n;
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    if(n <= 0) {
+        std::cerr << "usage: " << argv[0] << " [iterations]" << std::endl;
+        return 1;
+    }
+    // 预热: 主协程, 栈缓存
+    bench_switch(1000);
+    bench_create(1000);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(16) << "switch" << std::setw(12) << bench_switch(n) << " ns" << std::endl;
+    std::cout << std::setw(16) << "ucontext" << std::setw(12) << bench_ucontext(n) << " ns" << std::endl;
+    uint64_t maps = gameserver::StackPool::GetMapCount();
+    double create = bench_create(n);
+    std::cout << std::setw(16) << "create" << std::setw(12) << create << " ns"
+              << "  " << (1e9 / create) << "/s  mmap=" << gameserver::StackPool::GetMapCount() - maps << std::endl;
+    gameserver::StackPool::SetCacheLimit(0, 0);
+    maps = gameserver::StackPool::GetMapCount();
+    int m = std::max(1, n / 10);
+    double nopool = bench_create(m);
+    std::cout << std::setw(16) << "create.nopool" << std::setw(12) << nopool << " ns"
+              << "  " << (1e9 / nopool) << "/s  mmap=" << gameserver::StackPool::GetMapCount() - maps << std::endl;
+    return 0;
+}
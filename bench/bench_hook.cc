@@ -0,0 +1,112 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include "Fiber/iomanager.h"
+#include "Fiber/hook.h"
+#include "Fiber/fd_manager.h"
+
+/**
+ * @brief hook开销测试
+ * @details native  不启用hook的线程上 write+read 一个字节(经过hook入口)
+ *          origin  直接调用原函数 write_f+read_f
+ *          fiber   启用hook的IOManager协程里 write+read, 数据总是就绪, 不让出
+ *          pingpong 启用hook的单线程上两个协程用socketpair互相收发, 每次读都让出
+ *          输出每次往返的纳秒数. 用法: bench_hook [次数]
+ */
+
+static double now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double rw_loop(int wfd, int rfd, size_t n, bool origin) {
+    char c = 'x';
+    double t0 = now_ns();
+    for(size_t i = 0; i < n; ++i) {
+        if(origin) {
+            write_f(wfd, &c, 1);
+            read_f(rfd, &c, 1);
+        } else {
+            write(wfd, &c, 1);
+            read(rfd, &c, 1);
+        }
+    }
+    return (now_ns() - t0) / n;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? atol(argv[1]) : 1000000;
+    if(n == 0) {
+        std::cerr << "usage: " << argv[0] << " [count]" << std::endl;
+        return 1;
+    }
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+
+    double native = rw_loop(fds[0], fds[1], n, false);
+    double origin = rw_loop(fds[0], fds[1], n, true);
+
+    double fiber = 0;
+    double pingpong = 0;
+    {
+        gameserver::IOManager iom(1, false, "bench_hook");
+        iom.setHookEnable(true);
+        iom.start();
+        iom.schedule([&fiber, n]() {
+            // hook线程上创建的socket才有上下文, 会走让出的路径
+            int sp[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sp);
+            gameserver::FdMgr::GetInstance()->get(sp[0], true);
+            gameserver::FdMgr::GetInstance()->get(sp[1], true);
+            fiber = rw_loop(sp[0], sp[1], n, false);
+            close(sp[0]);
+            close(sp[1]);
+        });
+        iom.stop();
+    }
+    {
+        gameserver::IOManager iom(1, false, "bench_hook");
+        iom.setHookEnable(true);
+        iom.start();
+        size_t m = n / 10;
+        iom.schedule([&iom, &pingpong, m]() {
+            int sp[2];
+            socketpair(AF_UNIX, SOCK_STREAM, 0, sp);
+            gameserver::FdMgr::GetInstance()->get(sp[0], true);
+            gameserver::FdMgr::GetInstance()->get(sp[1], true);
+            int peer = sp[1];
+            iom.schedule([peer, m]() {
+                char c;
+                for(size_t i = 0; i < m; ++i) {
+                    read(peer, &c, 1);
+                    write(peer, &c, 1);
+                }
+            });
+            char c = 'x';
+            double t0 = now_ns();
+            for(size_t i = 0; i < m; ++i) {
+                write(sp[0], &c, 1);
+                read(sp[0], &c, 1);
+            }
+            pingpong = (now_ns() - t0) / m;
+            close(sp[0]);
+            close(sp[1]);
+        });
+        iom.stop();
+    }
+
+    std::cout << "count=" << n << " (ns/roundtrip)" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << std::setw(10) << "native" << std::setw(10) << native << std::endl;
+    std::cout << std::setw(10) << "origin" << std::setw(10) << origin << std::endl;
+    std::cout << std::setw(10) << "fiber" << std::setw(10) << fiber << std::endl;
+    std::cout << std::setw(10) << "pingpong" << std::setw(10) << pingpong << std::endl;
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "Net/http_server.h"
+#include "Log/log.h"
+
+/**
+ * @brief HTTP解析和回环压测
+ * @details parse_full   一个约300字节, 8个头部字段的GET请求整块解析, 每次reset()
+ *          parse_split  同一个请求分两次到达(第二次在头部中间), 测增量解析的额外开销
+ *          parse_chunked 带3个chunk的POST请求, 含原地解码
+ *          loopback     服务端IOManager(2线程)上的HttpServer, 客户端另一个IOManager上每个连接一个协程,
+ *                       每轮一次发出depth个请求(流水线), 用HttpResponseParser读回depth个响应.
+ *                       depth=1是普通的长连接请求-响应, 输出请求/秒
+ *          建议用优化编译: cmake -DCMAKE_BUILD_TYPE=Release
+ *          用法: bench_http [解析次数] [连接数] [流水线深度] [压测秒数]
+ */
+
+using namespace gameserver::http;
+
+static double now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const char* s_request =
+    "GET /api/player/info?id=1234567&fields=name,level,items HTTP/1.1\r\n"
+    "Host: game.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) bench/1.0\r\n"
+    "Accept: application/json\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9\r\n"
+    "Cookie: session=0123456789abcdef; region=cn\r\n"
+    "X-Request-Id: 5f0c6a1e-3b7d-4a2b-9c11-8e2f3d4b5a6c\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static const char* s_chunked =
+    "POST /api/upload HTTP/1.1\r\n"
+    "Host: game.example.com\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "40\r\n0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\r\n"
+    "20\r\n0123456789abcdef0123456789abcdef\r\n"
+    "10\r\n0123456789abcdef\r\n"
+    "0\r\n\r\n";
+
+static uint64_t s_sink = 0;
+
+static void print(const char* name, double value, const char* unit) {
+    std::cout << std::setw(14) << name << std::setw(14) << value << " " << unit << std::endl;
+}
+
+static void bench_parse(size_t n) {
+    HttpRequestParser parser;
+    std::string tmpl = s_request;
+    std::string buf = tmpl;
+    double t0 = now_ns();
+    for(size_t i = 0; i < n; ++i) {
+        parser.reset();
+        if(parser.execute(&buf[0], buf.size()) != HttpParser::COMPLETE) {
+            std::cerr << "parse failed: " << parser.getErrorString() << std::endl;
+            return;
+        }
+        s_sink += parser.getRequest().getPath().size + parser.getRequest().getHeaderCount();
+    }
+    print("parse_full", (now_ns() - t0) / n, "ns/request");
+
+    size_t half = tmpl.find("Accept-Language");
+    t0 = now_ns();
+    for(size_t i = 0; i < n; ++i) {
+        parser.reset();
+        parser.execute(&buf[0], half);
+        if(parser.execute(&buf[0], buf.size()) != HttpParser::COMPLETE) {
+            std::cerr << "parse failed: " << parser.getErrorString() << std::endl;
+            return;
+        }
+        s_sink += parser.getRequest().getHeader("cookie").size;
+    }
+    print("parse_split", (now_ns() - t0) / n, "ns/request");
+
+    // chunked在缓冲里原地解码, 每次从模板恢复
+    std::string chunked = s_chunked;
+    buf = chunked;
+    t0 = now_ns();
+    for(size_t i = 0; i < n; ++i) {
+        memcpy(&buf[0], chunked.data(), chunked.size());
+        parser.reset();
+        if(parser.execute(&buf[0], buf.size()) != HttpParser::COMPLETE) {
+            std::cerr << "parse failed: " << parser.getErrorString() << std::endl;
+            return;
+        }
+        s_sink += parser.getRequest().getBody().size;
+    }
+    print("parse_chunked", (now_ns() - t0) / n, "ns/request");
+}
+
+static void bench_loopback(int conns, int depth, double seconds) {
+    gameserver::IOManager server_iom(2, false, "httpserver");
+    server_iom.setHookEnable(true);
+    server_iom.start();
+    HttpServer::ptr server(new HttpServer(true, &server_iom, &server_iom));
+    server->getServletDispatch()->addServlet("/api/player/info", [](const HttpRequest& req, HttpResponse& rsp) {
+        rsp.setHeader("Content-Type", "application/json");
+        rsp.setBody("{\"id\":1234567,\"name\":\"DragonSlayer_42\",\"level\":57}");
+        return 0;
+    });
+    if(!server->bind("127.0.0.1", 0) || !server->start()) {
+        std::cerr << "server start failed" << std::endl;
+        return;
+    }
+    int port = server->getPort();
+
+    std::atomic<uint64_t> done {0};
+    std::atomic<int> errors {0};
+    double begin = now_ns();
+    double deadline = begin + seconds * 1e9;
+    {
+        gameserver::IOManager client_iom(1, false, "httpclient");
+        client_iom.setHookEnable(true);
+        client_iom.start();
+        for(int c = 0; c < conns; ++c) {
+            client_iom.schedule([port, depth, deadline, &done, &errors]() {
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                sockaddr_in addr;
+                memset(&addr, 0, sizeof(addr));
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                addr.sin_port = htons(port);
+                if(connect(fd, (sockaddr*)&addr, sizeof(addr))) {
+                    ++errors;
+                    close(fd);
+                    return;
+                }
+                int on = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                std::string batch;
+                for(int i = 0; i < depth; ++i) {
+                    batch += s_request;
+                }
+                std::vector<char> buf(64 * 1024);
+                HttpResponseParser parser;
+                uint64_t count = 0;
+                while(now_ns() < deadline) {
+                    if(send(fd, batch.data(), batch.size(), 0) != (ssize_t)batch.size()) {
+                        ++errors;
+                        break;
+                    }
+                    int got = 0;
+                    size_t begin = 0;
+                    size_t end = 0;
+                    while(got < depth) {
+                        if(begin < end) {
+                            HttpParser::Result rt = parser.execute(&buf[begin], end - begin);
+                            if(rt == HttpParser::COMPLETE) {
+                                ++got;
+                                begin += parser.getConsumed();
+                                parser.reset();
+                                continue;
+                            }
+                            if(rt == HttpParser::ERROR) {
+                                break;
+                            }
+                        }
+                        if(end == buf.size()) {
+                            memmove(&buf[0], &buf[begin], end - begin);
+                            end -= begin;
+                            begin = 0;
+                        }
+                        ssize_t n = recv(fd, &buf[end], buf.size() - end, 0);
+                        if(n <= 0) {
+                            break;
+                        }
+                        end += n;
+                    }
+                    count += got;
+                    if(got != depth) {
+                        ++errors;
+                        break;
+                    }
+                }
+                done += count;
+                close(fd);
+            });
+        }
+        client_iom.stop();
+    }
+    double used = (now_ns() - begin) / 1e9;
+    server->stop();
+    server_iom.stop();
+
+    std::cout << std::setw(14) << "loopback" << " connections=" << conns << " depth=" << depth
+              << " requests=" << done << " errors=" << errors
+              << " req/s=" << (uint64_t)(done / used) << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? atol(argv[1]) : 1000000;
+    int conns = argc > 2 ? atoi(argv[2]) : 50;
+    int depth = argc > 3 ? atoi(argv[3]) : 16;
+    double seconds = argc > 4 ? atof(argv[4]) : 2;
+    if(n == 0 || conns <= 0 || depth <= 0 || seconds <= 0) {
+        std::cerr << "usage: " << argv[0] << " [parses] [connections] [depth] [seconds]" << std::endl;
+        return 1;
+    }
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::ERROR);
+    std::cout << std::fixed << std::setprecision(1);
+    bench_parse(n);
+    bench_loopback(conns, 1, seconds);
+    bench_loopback(conns, depth, seconds);
+    std::cerr << "sink=" << s_sink << std::endl;
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "Fiber/iomanager.h"
+#include "Log/log.h"
+
+/**
+ * @brief IO调度器回环连接测试
+ * @details 服务端一个线程的IOManager, 每个连接一个协程echo;
+ *          客户端另一个线程的IOManager, 每个连接一个协程, 连上后来回发rounds次64字节.
+ *          输出建立所有连接的时间和echo往返吞吐量(次/秒)
+ *          建议用优化编译: cmake -DCMAKE_BUILD_TYPE=Release
+ *          用法: bench_iomanager [连接数] [每个连接往返次数]
+ */
+
+static double now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void set_nonblock(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static ssize_t fiber_read(int fd, void* buf, size_t len) {
+    while(true) {
+        ssize_t n = read(fd, buf, len);
+        if(n >= 0 || errno != EAGAIN) {
+            return n;
+        }
+        gameserver::IOManager::GetThis()->addEvent(fd, gameserver::IOManager::READ);
+        gameserver::Fiber::YieldToHold();
+    }
+}
+
+static ssize_t fiber_write(int fd, const void* buf, size_t len) {
+    while(true) {
+        ssize_t n = write(fd, buf, len);
+        if(n >= 0 || errno != EAGAIN) {
+            return n;
+        }
+        gameserver::IOManager::GetThis()->addEvent(fd, gameserver::IOManager::WRITE);
+        gameserver::Fiber::YieldToHold();
+    }
+}
+
+int main(int argc, char** argv) {
+    int conns = argc > 1 ? atoi(argv[1]) : 5000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+    if(conns <= 0 || rounds <= 0) {
+        std::cerr << "usage: " << argv[0] << " [connections] [rounds]" << std::endl;
+        return 1;
+    }
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::INFO);
+
+    // 两端的fd都在本进程里
+    rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    if((rlim_t)conns * 2 + 64 > rl.rlim_cur) {
+        conns = ((int)rl.rlim_cur - 64) / 2;
+        std::cerr << "RLIMIT_NOFILE=" << rl.rlim_cur << ", connections=" << conns << std::endl;
+    }
+
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(bind(lfd, (sockaddr*)&addr, sizeof(addr)) || listen(lfd, 4096)) {
+        std::cerr << "listen failed errno=" << errno << std::endl;
+        return 1;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(lfd, (sockaddr*)&addr, &len);
+    set_nonblock(lfd);
+
+    std::atomic<int> accepted {0};
+    std::atomic<int> connected {0};
+    std::atomic<int> failed {0};
+    std::atomic<uint64_t> trips {0};
+    double connect_ns = 0;
+    double begin = 0;
+    double end = 0;
+    {
+        gameserver::IOManager server(1, false, "server");
+        gameserver::IOManager client(1, false, "client");
+        server.start();
+        client.start();
+        server.schedule([lfd, conns, &accepted]() {
+            while(accepted < conns) {
+                int fd = accept(lfd, nullptr, nullptr);
+                if(fd < 0) {
+                    if(errno == EAGAIN) {
+                        gameserver::IOManager::GetThis()->addEvent(lfd, gameserver::IOManager::READ);
+                        gameserver::Fiber::YieldToHold();
+                    }
+                    continue;
+                }
+                ++accepted;
+                set_nonblock(fd);
+                gameserver::IOManager::GetThis()->schedule([fd]() {
+                    char buf[256];
+                    ssize_t n;
+                    while((n = fiber_read(fd, buf, sizeof(buf))) > 0) {
+                        fiber_write(fd, buf, n);
+                    }
+                    close(fd);
+                });
+            }
+        });
+
+        // 所有连接建立后再一起开始往返
+        std::atomic<bool> go {false};
+        begin = now_ns();
+        for(int i = 0; i < conns; ++i) {
+            client.schedule([addr, rounds, &connected, &failed, &trips, &go]() {
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                set_nonblock(fd);
+                int rt = connect(fd, (const sockaddr*)&addr, sizeof(addr));
+                if(rt < 0 && errno == EINPROGRESS) {
+                    gameserver::IOManager::GetThis()->addEvent(fd, gameserver::IOManager::WRITE);
+                    gameserver::Fiber::YieldToHold();
+                }
+                ++connected;
+                while(!go) {
+                    gameserver::Fiber::YieldToReady();
+                }
+                char msg[64] = {0};
+                char buf[64];
+                for(int r = 0; r < rounds; ++r) {
+                    if(fiber_write(fd, msg, sizeof(msg)) != sizeof(msg)) {
+                        ++failed;
+                        break;
+                    }
+                    size_t got = 0;
+                    while(got < sizeof(msg)) {
+                        ssize_t n = fiber_read(fd, buf, sizeof(buf) - got);
+                        if(n <= 0) {
+                            break;
+                        }
+                        got += n;
+                    }
+                    if(got != sizeof(msg)) {
+                        ++failed;
+                        break;
+                    }
+                    ++trips;
+                }
+                close(fd);
+            });
+        }
+        while(connected < conns) {
+            usleep(1000);
+        }
+        connect_ns = now_ns() - begin;
+        begin = now_ns();
+        go = true;
+        client.stop();
+        end = now_ns();
+        server.stop();
+    }
+    close(lfd);
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "connections=" << conns << " rounds=" << rounds
+              << " failed=" << failed << std::endl;
+    std::cout << "connect_ms=" << connect_ns / 1e6
+              << " echo/s=" << trips / ((end - begin) / 1e9) << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,290 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Log/log.h"
+#include "Log/mmap_log.h"
+
+/**
+ * @brief 日志性能测试
+ * @details 按 线程数 x Handler x 格式 x 级别是否开启 组合运行, 每组输出一条结果:
+ *          ns/event     总耗时 / 总条数
+ *          events/sec   所有线程合计的吞吐
+ *          p50/p99/p999 调用方单条日志的耗时, 每16条取样一条
+ *          allocs/event 运行期间operator new的次数 / 总条数
+ *          结果为JSON数组或CSV, 方便在不同提交之间比较.
+ *          stdout Handler运行时标准输出重定向到/dev/null, 结果写到原来的标准输出.
+ *          建议用优化编译: cmake -DCMAKE_BUILD_TYPE=Release, 或 make bench
+ *
+ *          用法: bench_log [json|csv] [每线程条数] [最大线程数]
+ */
+
+/// 全局分配计数
+static std::atomic<uint64_t> s_allocs(0);
+
+void* operator new(size_t size) {
+    s_allocs.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size ? size : 1);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+/// 每多少条取样一次耗时
+static const int SAMPLE_EVERY = 16;
+
+/**
+ * @brief 丢弃已格式化的日志, 只计字节数
+ */
+class NullLogHandler : public gameserver::LogHandler {
+public:
+    typedef std::shared_ptr<NullLogHandler> ptr;
+    NullLogHandler() {
+        m_writer = true;
+    }
+
+    void log(const std::shared_ptr<gameserver::Logger>& logger, gameserver::LogLevel::Level level, const gameserver::LogEvent& event) override {
+        gameserver::LogStream buf;
+        getFormatter()->format(buf, logger, level, event);
+        write(level, buf.data(), buf.size());
+    }
+
+    void write(gameserver::LogLevel::Level level, const char* data, size_t len) override {
+        m_bytes.fetch_add(len, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> m_bytes{0};
+};
+
+/**
+ * @brief 一组测试的参数和结果
+ */
+struct Result {
+    std::string handler;
+    std::string pattern;
+    bool enabled = true;
+    int threads = 0;
+    uint64_t events = 0;
+    double nsPerEvent = 0;
+    double eventsPerSec = 0;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    double allocsPerEvent = 0;
+};
+
+static const struct {
+    const char* name;
+    const char* pattern;
+} s_patterns[] = {
+    {"default", gameserver::LogFormatter::DEFAULT_PATTERN},
+    {"short", "%d{%H:%M:%S}%T%p%T%m%n"},
+    {"message", "%m%n"},
+    {"json", gameserver::LogFormatter::JSON_PATTERN},
+};
+
+/**
+ * @brief 标准输出临时指向/dev/null
+ */
+class StdoutToNull {
+public:
+    StdoutToNull() {
+        std::cout.flush();
+        m_saved = dup(STDOUT_FILENO);
+        int fd = open("/dev/null", O_WRONLY);
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+    }
+    ~StdoutToNull() {
+        std::cout.flush();
+        dup2(m_saved, STDOUT_FILENO);
+        close(m_saved);
+    }
+private:
+    int m_saved;
+};
+
+static void log_loop(gameserver::Logger::ptr logger, int count, std::vector<uint32_t>* samples) {
+    for(int i = 0; i < count; ++i) {
+        if(i % SAMPLE_EVERY == 0) {
+            auto begin = std::chrono::steady_clock::now();
+            GAMESERVER_LOG_INFO(logger) << "player " << i << " moved to " << 1.5 * i << " zone " << "north";
+            auto end = std::chrono::steady_clock::now();
+            samples->push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+        } else {
+            GAMESERVER_LOG_INFO(logger) << "player " << i << " moved to " << 1.5 * i << " zone " << "north";
+        }
+    }
+}
+
+static uint64_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if(sorted.empty()) {
+        return 0;
+    }
+    size_t idx = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[idx];
+}
+
+static Result run(const std::string& handler_name, gameserver::LogHandler::ptr handler
+                  ,const char* pattern_name, const char* pattern
+                  ,bool enabled, int threads, int count) {
+    gameserver::Logger::ptr logger(new gameserver::Logger("bench"));
+    logger->setFormatter(pattern);
+    logger->addHandler(handler);
+    logger->setLevel(enabled ? gameserver::LogLevel::DEBUG : gameserver::LogLevel::ERROR);
+
+    // 预热: 线程缓冲, 事件池, 时间缓存
+    std::vector<uint32_t> warmup;
+    log_loop(logger, 1000, &warmup);
+
+    std::vector<std::vector<uint32_t> > samples(threads);
+    for(auto& s : samples) {
+        s.reserve(count / SAMPLE_EVERY + 1);
+    }
+    std::vector<std::thread> vec;
+    vec.reserve(threads);
+
+    uint64_t allocs_before = s_allocs.load();
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < threads; ++i) {
+        vec.push_back(std::thread(log_loop, logger, count, &samples[i]));
+    }
+    for(auto& t : vec) {
+        t.join();
+    }
+    handler->flush();
+    auto end = std::chrono::steady_clock::now();
+    uint64_t allocs = s_allocs.load() - allocs_before;
+
+    std::vector<uint32_t> all;
+    for(auto& s : samples) {
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    Result r;
+    r.handler = handler_name;
+    r.pattern = pattern_name;
+    r.enabled = enabled;
+    r.threads = threads;
+    r.events = (uint64_t)threads * count;
+    double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    r.nsPerEvent = ns / r.events;
+    r.eventsPerSec = r.events * 1e9 / ns;
+    r.p50 = percentile(all, 0.5);
+    r.p99 = percentile(all, 0.99);
+    r.p999 = percentile(all, 0.999);
+    // 线程创建的几次分配也算在内, 相对总条数可以忽略
+    r.allocsPerEvent = (double)allocs / r.events;
+    return r;
+}
+
+static Result run_handler(const std::string& handler_name, const char* pattern_name, const char* pattern
+                          ,bool enabled, int threads, int count) {
+    std::string path = "/tmp/gameserver_bench_" + std::to_string(getpid());
+    if(handler_name == "stdout") {
+        StdoutToNull redirect;
+        return run(handler_name, gameserver::LogHandler::ptr(new gameserver::StdoutLogHandler)
+                   ,pattern_name, pattern, enabled, threads, count);
+    } else if(handler_name == "file") {
+        Result r = run(handler_name, gameserver::LogHandler::ptr(new gameserver::FileLogHandler(path + ".log"))
+                       ,pattern_name, pattern, enabled, threads, count);
+        unlink((path + ".log").c_str());
+        return r;
+    } else if(handler_name == "mmap") {
+        Result r;
+        {
+            gameserver::MmapFileLogHandler::ptr handler(new gameserver::MmapFileLogHandler(path, 256 << 20));
+            r = run(handler_name, handler, pattern_name, pattern, enabled, threads, count);
+            path = handler->getCurrentPath();
+        }
+        unlink(path.c_str());
+        return r;
+    }
+    return run(handler_name, gameserver::LogHandler::ptr(new NullLogHandler)
+               ,pattern_name, pattern, enabled, threads, count);
+}
+
+static void print_json(std::ostream& os, const std::vector<Result>& results) {
+    os << "[" << std::endl;
+    for(size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "  {\"handler\": \"" << r.handler << "\""
+           << ", \"pattern\": \"" << r.pattern << "\""
+           << ", \"enabled\": " << (r.enabled ? "true" : "false")
+           << ", \"threads\": " << r.threads
+           << ", \"events\": " << r.events
+           << std::fixed << std::setprecision(1)
+           << ", \"ns_per_event\": " << r.nsPerEvent
+           << ", \"events_per_sec\": " << std::setprecision(0) << r.eventsPerSec
+           << ", \"p50_ns\": " << r.p50
+           << ", \"p99_ns\": " << r.p99
+           << ", \"p999_ns\": " << r.p999
+           << std::setprecision(4)
+           << ", \"allocs_per_event\": " << r.allocsPerEvent
+           << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+    }
+    os << "]" << std::endl;
+}
+
+static void print_csv(std::ostream& os, const std::vector<Result>& results) {
+    os << "handler,pattern,enabled,threads,events,ns_per_event,events_per_sec,p50_ns,p99_ns,p999_ns,allocs_per_event" << std::endl;
+    for(auto& r : results) {
+        os << r.handler << ',' << r.pattern << ',' << (r.enabled ? 1 : 0) << ','
+           << r.threads << ',' << r.events << ','
+           << std::fixed << std::setprecision(1) << r.nsPerEvent << ','
+           << std::setprecision(0) << r.eventsPerSec << ','
+           << r.p50 << ',' << r.p99 << ',' << r.p999 << ','
+           << std::setprecision(4) << r.allocsPerEvent << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string format = argc > 1 ? argv[1] : "json";
+    int count = argc > 2 ? atoi(argv[2]) : 200000;
+    int max_threads = argc > 3 ? atoi(argv[3]) : std::max(4u, std::thread::hardware_concurrency());
+    if((format != "json" && format != "csv") || count <= 0 || max_threads <= 0) {
+        std::cerr << "usage: " << argv[0] << " [json|csv] [events_per_thread] [max_threads]" << std::endl;
+        return 1;
+    }
+
+    static const char* handlers[] = {"null", "stdout", "file", "mmap"};
+    std::vector<Result> results;
+    for(int n = 1; n <= max_threads; n *= 2) {
+        for(auto& h : handlers) {
+            for(auto& p : s_patterns) {
+                results.push_back(run_handler(h, p.name, p.pattern, true, n, count));
+                std::cerr << "." << std::flush;
+            }
+        }
+        // 级别关闭时只有宏里的一次判断, 与Handler和格式无关
+        results.push_back(run_handler("null", "default", gameserver::LogFormatter::DEFAULT_PATTERN, false, n, count));
+    }
+    std::cerr << std::endl;
+
+    if(format == "csv") {
+        print_csv(std::cout, results);
+    } else {
+        print_json(std::cout, results);
+    }
+    return 0;
+}
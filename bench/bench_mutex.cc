@@ -0,0 +1,100 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include "Thread/mutex.h"
+
+/**
+ * @brief 锁竞争测试
+ * @details 每个线程反复加锁, 往共享缓冲里写一条"日志"(128字节)后解锁,
+ *          模拟Handler的写路径; 读锁一栏模拟Logger::log读取Handler列表.
+ *          用法: bench_mutex [每线程次数] [最大线程数]
+ */
+
+static const size_t LINE_SIZE = 128;
+
+struct Shared {
+    char buf[4096];
+    size_t pos = 0;
+    uint64_t count = 0;
+};
+
+template<class LockType, class MutexType>
+static void write_loop(MutexType& mutex, Shared& shared, int iterations) {
+    char line[LINE_SIZE];
+    memset(line, 'x', sizeof(line));
+    for(int i = 0; i < iterations; ++i) {
+        LockType lock(mutex);
+        memcpy(shared.buf + shared.pos, line, sizeof(line));
+        shared.pos = (shared.pos + LINE_SIZE) % sizeof(shared.buf);
+        ++shared.count;
+    }
+}
+
+static void read_loop(gameserver::RWMutex& mutex, Shared& shared, int iterations) {
+    uint64_t sum = 0;
+    for(int i = 0; i < iterations; ++i) {
+        gameserver::RWMutex::ReadLock lock(mutex);
+        sum += shared.pos;
+    }
+    if(sum == 1) {
+        std::cout << "";
+    }
+}
+
+/**
+ * @brief 返回每次加解锁的平均耗时(ns, 按总吞吐折算)
+ */
+template<class F>
+static double run(int threads, int iterations, F f) {
+    std::vector<std::thread> vec;
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < threads; ++i) {
+        vec.push_back(std::thread(f));
+    }
+    for(auto& t : vec) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()
+        / ((double)threads * iterations);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : std::max(32u, std::thread::hardware_concurrency());
+
+    std::cout << "ns/op (total time / total ops), " << iterations << " ops per thread, "
+              << std::thread::hardware_concurrency() << " cpus" << std::endl;
+    std::cout << std::setw(8) << "threads"
+              << std::setw(12) << "Mutex"
+              << std::setw(12) << "Spinlock"
+              << std::setw(12) << "CASLock"
+              << std::setw(12) << "RWMutex.w"
+              << std::setw(12) << "RWMutex.r"
+              << std::setw(12) << "NullMutex" << std::endl;
+
+    for(int n = 1; n <= max_threads; n *= 2) {
+        Shared shared;
+        gameserver::Mutex mutex;
+        gameserver::Spinlock spin;
+        gameserver::CASLock cas;
+        gameserver::RWMutex rw;
+        gameserver::NullMutex null;
+        std::cout << std::setw(8) << n << std::fixed << std::setprecision(1)
+            << std::setw(12) << run(n, iterations, [&]() { write_loop<gameserver::Mutex::Lock>(mutex, shared, iterations);})
+            << std::setw(12) << run(n, iterations, [&]() { write_loop<gameserver::Spinlock::Lock>(spin, shared, iterations);})
+            << std::setw(12) << run(n, iterations, [&]() { write_loop<gameserver::CASLock::Lock>(cas, shared, iterations);})
+            << std::setw(12) << run(n, iterations, [&]() { write_loop<gameserver::RWMutex::WriteLock>(rw, shared, iterations);})
+            << std::setw(12) << run(n, iterations, [&]() { read_loop(rw, shared, iterations);})
+            // 空锁各线程写自己的缓冲, 作为临界区本身开销的基线
+            << std::setw(12) << run(n, iterations, [&]() {
+                Shared local;
+                write_loop<gameserver::NullMutex::Lock>(null, local, iterations);
+            })
+            << std::endl;
+    }
+    return 0;
+}
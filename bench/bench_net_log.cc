@@ -0,0 +1,209 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <poll.h>
+#include <endian.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "Log/log.h"
+#include "Log/net_log.h"
+
+/**
+ * @brief 网络日志压测
+ * @details 回环上起一个只计数的收集器(TCP按帧解码, UDP按报文计数), 多个线程通过Logger写约120字节的日志,
+ *          输出写线程每次log()的平均耗时, 收集器收到的条数/吞吐, 以及丢失的条数(被拒绝的加上没送到的).
+ *          tcp_spill 收集器前半段时间不读(模拟慢收集器), 溢出文件兜底
+ *          建议用优化编译: cmake -DCMAKE_BUILD_TYPE=Release
+ *          用法: bench_net_log [线程数] [每线程日志数]
+ */
+
+using gameserver::NetworkLogHandler;
+using gameserver::NetworkLogOptions;
+
+static double now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 只计数的收集器
+ */
+class Collector {
+public:
+    Collector(bool tcp)
+        :m_tcp(tcp) {
+        m_fd = socket(AF_INET, tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+        int rcvbuf = 8 * 1024 * 1024;
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_fd, (sockaddr*)&addr, sizeof(addr));
+        if(tcp) {
+            listen(m_fd, 16);
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(m_fd, (sockaddr*)&addr, &len);
+        m_port = ntohs(addr.sin_port);
+        m_thread = std::thread([this]() { run();});
+    }
+
+    ~Collector() {
+        m_stop = true;
+        m_thread.join();
+        close(m_fd);
+    }
+
+    void setPaused(bool v) { m_paused = v;}
+    int getPort() const { return m_port;}
+    uint64_t getRecords() const { return m_records;}
+    uint64_t getBytes() const { return m_bytes;}
+private:
+    void run() {
+        std::vector<char> buf(256 * 1024);
+        int conn = -1;
+        size_t begin = 0;
+        size_t end = 0;
+        while(!m_stop) {
+            int fd = m_tcp ? conn : m_fd;
+            if(m_tcp && conn < 0) {
+                pollfd pfd = {m_fd, POLLIN, 0};
+                if(poll(&pfd, 1, 5) == 1) {
+                    conn = accept(m_fd, nullptr, nullptr);
+                }
+                continue;
+            }
+            if(m_paused) {
+                usleep(1000);
+                continue;
+            }
+            pollfd pfd = {fd, POLLIN, 0};
+            if(poll(&pfd, 1, 5) != 1) {
+                continue;
+            }
+            ssize_t n = recv(fd, &buf[end], buf.size() - end, 0);
+            if(n <= 0) {
+                break;
+            }
+            m_bytes += n;
+            if(!m_tcp) {
+                ++m_records;
+                continue;
+            }
+            end += n;
+            while(end - begin >= 4) {
+                uint32_t len;
+                memcpy(&len, &buf[begin], 4);
+                len = be32toh(len);
+                if(end - begin < len + 4) {
+                    break;
+                }
+                begin += len + 4;
+                ++m_records;
+            }
+            memmove(&buf[0], &buf[begin], end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        if(conn >= 0) {
+            close(conn);
+        }
+    }
+private:
+    bool m_tcp;
+    int m_fd;
+    int m_port;
+    std::thread m_thread;
+    std::atomic<bool> m_stop {false};
+    std::atomic<bool> m_paused {false};
+    std::atomic<uint64_t> m_records {0};
+    std::atomic<uint64_t> m_bytes {0};
+};
+
+static void bench(const char* name, bool tcp, bool slow, int threads, int n) {
+    Collector collector(tcp);
+    if(slow) {
+        collector.setPaused(true);
+    }
+    NetworkLogOptions options;
+    options.stopTimeoutMs = 5000;
+    if(slow) {
+        options.spillPath = "/tmp/bench_net_log_" + std::to_string(getpid());
+        options.spillSize = 1024ull * 1024 * 1024;
+    }
+    NetworkLogHandler::ptr handler(new NetworkLogHandler(tcp ? NetworkLogHandler::TCP : NetworkLogHandler::UDP_SYSLOG
+                                   ,"127.0.0.1", collector.getPort(), options));
+    gameserver::Logger::ptr logger(new gameserver::Logger("bench"));
+    logger->setFormatter("%d{%Y-%m-%d %H:%M:%S} %t %p [%c] %f:%l %m%n");
+    logger->addHandler(handler);
+    while(!handler->isConnected()) {
+        usleep(1000);
+    }
+
+    std::atomic<double> log_ns {0};
+    double t0 = now_ns();
+    std::vector<std::thread> ths;
+    for(int t = 0; t < threads; ++t) {
+        ths.emplace_back([&logger, &log_ns, n, t]() {
+            double begin = now_ns();
+            for(int i = 0; i < n; ++i) {
+                GAMESERVER_LOG_INFO(logger) << "player " << t << " moved to " << i << " hp=100 mp=50";
+            }
+            double used = now_ns() - begin;
+            double cur = log_ns;
+            while(!log_ns.compare_exchange_weak(cur, cur + used)) {
+            }
+        });
+    }
+    for(auto& th : ths) {
+        th.join();
+    }
+    double write_s = (now_ns() - t0) / 1e9;
+    uint64_t spilled = handler->getSpilled();
+    if(slow) {
+        collector.setPaused(false);
+    }
+    handler->flush();
+    // 等收集器收完
+    uint64_t total = (uint64_t)threads * n;
+    uint64_t accepted = total - handler->getDropped();
+    for(int i = 0; i < 500 && (handler->getQueueDepth() || collector.getRecords() < handler->getSent()); ++i) {
+        usleep(10 * 1000);
+    }
+    double used = (now_ns() - t0) / 1e9;
+    uint64_t got = collector.getRecords();
+    std::cout << std::setw(10) << name
+              << " log=" << log_ns / total << "ns"
+              << " write_s=" << write_s
+              << " received=" << got << "/" << total
+              << " lost=" << total - got
+              << " (rejected=" << total - accepted << ")"
+              << " spilled=" << spilled
+              << " writes=" << handler->getWrites()
+              << " rec/s=" << (uint64_t)(got / used)
+              << " MB/s=" << collector.getBytes() / used / 1e6 << std::endl;
+}
+
+int main(int argc, char** argv) {
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    int n = argc > 2 ? atoi(argv[2]) : 250000;
+    if(threads <= 0 || n <= 0) {
+        std::cerr << "usage: " << argv[0] << " [threads] [logs per thread]" << std::endl;
+        return 1;
+    }
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::ERROR);
+    std::cout << std::fixed << std::setprecision(1);
+    bench("tcp", true, false, threads, n);
+    bench("tcp_spill", true, true, threads, n);
+    bench("udp", false, false, threads, n);
+    return 0;
+}
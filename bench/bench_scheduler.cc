@@ -0,0 +1,113 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <unistd.h>
+#include "Fiber/scheduler.h"
+#include "Log/log.h"
+
+/**
+ * @brief 调度器任务分发测试
+ * @details external  非工作线程调度n个空函数, 从第一个调度到stop()返回, 经过全局队列
+ *          fanout    一个任务里调度n个空函数, 经过自己的队列和工作窃取
+ *          yield     n个协程各YieldToReady若干次, 每次都重新入队
+ *          对每个工作线程数(1到CPU数的2倍)输出吞吐量(任务/秒), 多核机器上应随线程数增长
+ *          建议用优化编译: cmake -DCMAKE_BUILD_TYPE=Release
+ *          用法: bench_scheduler [任务数] [最大线程数]
+ */
+
+static double now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// 每个任务的少量计算, 让分发开销之外有点实际工作
+static void work(std::atomic<uint64_t>& sum) {
+    sum.fetch_add(1, std::memory_order_relaxed);
+}
+
+static double bench_external(size_t threads, int n) {
+    std::atomic<uint64_t> sum {0};
+    gameserver::Scheduler sc(threads, false, "bench");
+    sc.start();
+    double begin = now_ns();
+    for(int i = 0; i < n; ++i) {
+        sc.schedule([&sum]() {
+            work(sum);
+        });
+    }
+    sc.stop();
+    double end = now_ns();
+    return n / ((end - begin) / 1e9);
+}
+
+static double bench_fanout(size_t threads, int n) {
+    std::atomic<uint64_t> sum {0};
+    gameserver::Scheduler sc(threads, false, "bench");
+    gameserver::Scheduler* psc = &sc;
+    sc.start();
+    double begin = now_ns();
+    sc.schedule([psc, n, &sum]() {
+        for(int i = 0; i < n; ++i) {
+            psc->schedule([&sum]() {
+                work(sum);
+            });
+        }
+    });
+    sc.stop();
+    double end = now_ns();
+    return n / ((end - begin) / 1e9);
+}
+
+static double bench_yield(size_t threads, int n) {
+    const int fibers = 1000;
+    int rounds = std::max(1, n / fibers);
+    std::atomic<uint64_t> sum {0};
+    std::vector<gameserver::Fiber::ptr> fs;
+    for(int i = 0; i < fibers; ++i) {
+        fs.push_back(gameserver::Fiber::ptr(new gameserver::Fiber([rounds, &sum]() {
+            for(int r = 0; r < rounds; ++r) {
+                work(sum);
+                gameserver::Fiber::YieldToReady();
+            }
+        })));
+    }
+    gameserver::Scheduler sc(threads, false, "bench");
+    sc.start();
+    double begin = now_ns();
+    sc.schedule(fs.begin(), fs.end());
+    sc.stop();
+    double end = now_ns();
+    return (double)fibers * rounds / ((end - begin) / 1e9);
+}
+
+int main(int argc, char** argv) {
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = argc > 2 ? atoi(argv[2]) : (int)std::max(2L, ncpu * 2);
+    if(n <= 0 || max_threads <= 0) {
+        std::cerr << "usage: " << argv[0] << " [tasks] [max_threads]" << std::endl;
+        return 1;
+    }
+    // 工作线程启停的DEBUG日志不计入
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::INFO);
+    // 预热: 栈缓存
+    bench_fanout(1, 10000);
+
+    std::cout << "cpus=" << ncpu << " tasks=" << n << std::endl;
+    std::cout << std::setw(8) << "threads"
+              << std::setw(16) << "external/s"
+              << std::setw(16) << "fanout/s"
+              << std::setw(16) << "yield/s" << std::endl;
+    std::cout << std::fixed << std::setprecision(0);
+    for(int t = 1; t <= max_threads; t *= 2) {
+        std::cout << std::setw(8) << t
+                  << std::setw(16) << bench_external(t, n)
+                  << std::setw(16) << bench_fanout(t, n)
+                  << std::setw(16) << bench_yield(t, n) << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <set>
+#include <queue>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <stdlib.h>
+#include "Fiber/timer.h"
+
+/**
+ * @brief 定时器测试: 分层时间轮(TimerManager) 对比 std::set 和 二叉堆
+ * @details 都用手动推进的时钟, n个定时器(默认1M)随机分布在1到60秒:
+ *          add     添加n个
+ *          refresh n/10次重新计时(会话超时续期: set为删除再插入, 堆为懒删除再插入)
+ *          cancel  取消n/10个
+ *          expire  按毫秒推进60秒, 执行所有剩下的定时器, 按执行的定时器数计
+ *          输出每个操作的纳秒数. 建议用优化编译: cmake -DCMAKE_BUILD_TYPE=Release
+ *          用法: bench_timer [定时器数]
+ */
+
+static double now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// 时间跨度(毫秒)
+static const uint64_t SPAN = 60000;
+
+struct Result {
+    double add = 0;
+    double refresh = 0;
+    double cancel = 0;
+    double expire = 0;
+};
+
+/**
+ * @brief 手动推进时间的时间轮
+ */
+class WheelTimers : public gameserver::TimerManager {
+public:
+    uint64_t m_now = 0;
+protected:
+    uint64_t nowMS() override { return m_now;}
+};
+
+static Result bench_wheel(const std::vector<uint64_t>& delays, const std::vector<size_t>& picks) {
+    Result r;
+    WheelTimers tm;
+    uint64_t fired = 0;
+    std::vector<gameserver::Timer::ptr> timers;
+    timers.reserve(delays.size());
+    double t0 = now_ns();
+    for(uint64_t d : delays) {
+        timers.push_back(tm.addTimer(d, [&fired]() { ++fired;}));
+    }
+    double t1 = now_ns();
+    for(size_t i : picks) {
+        timers[i]->refresh();
+    }
+    double t2 = now_ns();
+    for(size_t i : picks) {
+        timers[(i * 7) % timers.size()]->cancel();
+    }
+    double t3 = now_ns();
+    size_t left = tm.getTimerCount();
+    std::vector<std::function<void()> > cbs;
+    for(uint64_t t = 0; t <= SPAN; ++t) {
+        tm.m_now = t;
+        cbs.clear();
+        tm.listExpiredCbs(cbs);
+        for(auto& cb : cbs) {
+            cb();
+        }
+    }
+    double t4 = now_ns();
+    r.add = (t1 - t0) / delays.size();
+    r.refresh = (t2 - t1) / picks.size();
+    r.cancel = (t3 - t2) / picks.size();
+    r.expire = (t4 - t3) / std::max<size_t>(left, 1);
+    if(fired != left) {
+        std::cerr << "wheel fired " << fired << " expected " << left << std::endl;
+    }
+    return r;
+}
+
+/**
+ * @brief std::set 定时器, 按(到期时间, 地址)排序
+ */
+struct SetTimer {
+    typedef std::shared_ptr<SetTimer> ptr;
+    uint64_t next = 0;
+    uint64_t ms = 0;
+    std::function<void()> cb;
+};
+
+struct SetTimerCmp {
+    bool operator()(const SetTimer::ptr& a, const SetTimer::ptr& b) const {
+        if(a->next != b->next) {
+            return a->next < b->next;
+        }
+        return a.get() < b.get();
+    }
+};
+
+static Result bench_set(const std::vector<uint64_t>& delays, const std::vector<size_t>& picks) {
+    Result r;
+    std::set<SetTimer::ptr, SetTimerCmp> timers_set;
+    uint64_t now = 0;
+    uint64_t fired = 0;
+    std::vector<SetTimer::ptr> timers;
+    timers.reserve(delays.size());
+    double t0 = now_ns();
+    for(uint64_t d : delays) {
+        SetTimer::ptr t(new SetTimer);
+        t->ms = d;
+        t->next = now + d;
+        t->cb = [&fired]() { ++fired;};
+        timers_set.insert(t);
+        timers.push_back(t);
+    }
+    double t1 = now_ns();
+    for(size_t i : picks) {
+        SetTimer::ptr& t = timers[i];
+        auto it = timers_set.find(t);
+        if(it != timers_set.end()) {
+            timers_set.erase(it);
+            t->next = now + t->ms;
+            timers_set.insert(t);
+        }
+    }
+    double t2 = now_ns();
+    for(size_t i : picks) {
+        auto it = timers_set.find(timers[(i * 7) % timers.size()]);
+        if(it != timers_set.end()) {
+            timers_set.erase(it);
+        }
+    }
+    double t3 = now_ns();
+    size_t left = timers_set.size();
+    std::vector<std::function<void()> > cbs;
+    for(now = 0; now <= SPAN; ++now) {
+        cbs.clear();
+        while(!timers_set.empty() && (*timers_set.begin())->next <= now) {
+            cbs.push_back((*timers_set.begin())->cb);
+            timers_set.erase(timers_set.begin());
+        }
+        for(auto& cb : cbs) {
+            cb();
+        }
+    }
+    double t4 = now_ns();
+    r.add = (t1 - t0) / delays.size();
+    r.refresh = (t2 - t1) / picks.size();
+    r.cancel = (t3 - t2) / picks.size();
+    r.expire = (t4 - t3) / std::max<size_t>(left, 1);
+    if(fired != left) {
+        std::cerr << "set fired " << fired << " expected " << left << std::endl;
+    }
+    return r;
+}
+
+/**
+ * @brief 二叉堆定时器, 取消和重新计时用版本号懒删除
+ */
+struct HeapTimer {
+    typedef std::shared_ptr<HeapTimer> ptr;
+    uint64_t ms = 0;
+    uint32_t version = 0;
+    bool cancelled = false;
+    std::function<void()> cb;
+};
+
+struct HeapEntry {
+    uint64_t next;
+    uint32_t version;
+    HeapTimer::ptr timer;
+    bool operator<(const HeapEntry& o) const { return next > o.next;}
+};
+
+static Result bench_heap(const std::vector<uint64_t>& delays, const std::vector<size_t>& picks) {
+    Result r;
+    std::priority_queue<HeapEntry> heap;
+    uint64_t now = 0;
+    uint64_t fired = 0;
+    std::vector<HeapTimer::ptr> timers;
+    timers.reserve(delays.size());
+    double t0 = now_ns();
+    for(uint64_t d : delays) {
+        HeapTimer::ptr t(new HeapTimer);
+        t->ms = d;
+        t->cb = [&fired]() { ++fired;};
+        heap.push(HeapEntry{now + d, 0, t});
+        timers.push_back(t);
+    }
+    double t1 = now_ns();
+    for(size_t i : picks) {
+        HeapTimer::ptr& t = timers[i];
+        ++t->version;
+        heap.push(HeapEntry{now + t->ms, t->version, t});
+    }
+    double t2 = now_ns();
+    size_t cancelled = 0;
+    for(size_t i : picks) {
+        HeapTimer::ptr& t = timers[(i * 7) % timers.size()];
+        if(!t->cancelled) {
+            t->cancelled = true;
+            ++cancelled;
+        }
+    }
+    double t3 = now_ns();
+    size_t left = timers.size() - cancelled;
+    std::vector<std::function<void()> > cbs;
+    for(now = 0; now <= SPAN; ++now) {
+        cbs.clear();
+        while(!heap.empty() && heap.top().next <= now) {
+            const HeapEntry& e = heap.top();
+            if(!e.timer->cancelled && e.version == e.timer->version) {
+                cbs.push_back(e.timer->cb);
+            }
+            heap.pop();
+        }
+        for(auto& cb : cbs) {
+            cb();
+        }
+    }
+    double t4 = now_ns();
+    r.add = (t1 - t0) / delays.size();
+    r.refresh = (t2 - t1) / picks.size();
+    r.cancel = (t3 - t2) / picks.size();
+    r.expire = (t4 - t3) / std::max<size_t>(left, 1);
+    if(fired != left) {
+        std::cerr << "heap fired " << fired << " expected " << left << std::endl;
+    }
+    return r;
+}
+
+static void print(const char* name, const Result& r) {
+    std::cout << std::setw(8) << name
+              << std::setw(12) << r.add
+              << std::setw(12) << r.refresh
+              << std::setw(12) << r.cancel
+              << std::setw(12) << r.expire << std::endl;
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? atol(argv[1]) : 1000000;
+    if(n == 0) {
+        std::cerr << "usage: " << argv[0] << " [timers]" << std::endl;
+        return 1;
+    }
+    srand(12345);
+    std::vector<uint64_t> delays(n);
+    for(auto& d : delays) {
+        d = 1 + rand() % SPAN;
+    }
+    std::vector<size_t> picks(n / 10);
+    for(auto& p : picks) {
+        p = rand() % n;
+    }
+    // 重新计时的定时器各不相同
+    std::sort(picks.begin(), picks.end());
+    picks.erase(std::unique(picks.begin(), picks.end()), picks.end());
+    std::random_shuffle(picks.begin(), picks.end());
+
+    std::cout << "timers=" << n << " span_ms=" << SPAN << " (ns/op)" << std::endl;
+    std::cout << std::setw(8) << "impl"
+              << std::setw(12) << "add"
+              << std::setw(12) << "refresh"
+              << std::setw(12) << "cancel"
+              << std::setw(12) << "expire" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    print("wheel", bench_wheel(delays, picks));
+    print("set", bench_set(delays, picks));
+    print("heap", bench_heap(delays, picks));
+    return 0;
+}
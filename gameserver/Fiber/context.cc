@@ -0,0 +1,104 @@
+#include "context.h"
+#include <string.h>
+
+#if defined(__x86_64__)
+
+/**
+ * 切换时的栈布局(低地址在上), 切出时压栈, 切入时按相反顺序弹出:
+ *   sp+0   MXCSR(4字节) x87控制字(2字节)
+ *   sp+8   r12
+ *   sp+16  r13
+ *   sp+24  r14
+ *   sp+32  r15
+ *   sp+40  rbx
+ *   sp+48  rbp
+ *   sp+56  返回地址
+ */
+__asm__(
+    ".text\n"
+    ".globl gameserver_fiber_swap\n"
+    ".type gameserver_fiber_swap,@function\n"
+    ".align 16\n"
+    "gameserver_fiber_swap:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r15\n"
+    "    pushq %r14\n"
+    "    pushq %r13\n"
+    "    pushq %r12\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r12\n"
+    "    popq %r13\n"
+    "    popq %r14\n"
+    "    popq %r15\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size gameserver_fiber_swap,.-gameserver_fiber_swap\n"
+
+    // 新上下文第一次切入时从这里开始: r12为入口函数, r13为参数
+    ".globl gameserver_fiber_start\n"
+    ".type gameserver_fiber_start,@function\n"
+    ".align 16\n"
+    "gameserver_fiber_start:\n"
+    "    movq %r13, %rdi\n"
+    "    callq *%r12\n"
+    "    ud2\n"
+    ".size gameserver_fiber_start,.-gameserver_fiber_start\n"
+);
+
+extern "C" void gameserver_fiber_start();
+
+namespace gameserver{
+
+void FiberContext::make(void* stack, size_t size, Entry entry, void* arg) {
+    // 栈顶16字节对齐; ret进入gameserver_fiber_start后rsp为top-16, call之前16字节对齐
+    uintptr_t top = ((uintptr_t)stack + size) & ~(uintptr_t)15;
+    uint64_t* sp = (uint64_t*)(top - 80);
+    memset(sp, 0, 80);
+    uint32_t mxcsr = 0x1f80;    // 默认: 屏蔽所有浮点异常, 就近舍入
+    uint16_t fpucw = 0x037f;    // 默认: 屏蔽所有异常, 扩展精度
+    memcpy(sp, &mxcsr, sizeof(mxcsr));
+    memcpy((char*)sp + 4, &fpucw, sizeof(fpucw));
+    sp[1] = (uint64_t)entry;    // r12
+    sp[2] = (uint64_t)arg;      // r13
+    sp[7] = (uint64_t)&gameserver_fiber_start;
+    m_sp = sp;
+}
+
+}
+
+#else
+
+namespace gameserver{
+
+/**
+ * @brief makecontext只能传int参数, 指针拆成两半传
+ */
+static void ContextStart(uint32_t entry_lo, uint32_t entry_hi, uint32_t arg_lo, uint32_t arg_hi) {
+    FiberContext::Entry entry = (FiberContext::Entry)(((uintptr_t)entry_hi << 32) | entry_lo);
+    void* arg = (void*)(((uintptr_t)arg_hi << 32) | arg_lo);
+    entry(arg);
+}
+
+void FiberContext::make(void* stack, size_t size, Entry entry, void* arg) {
+    getcontext(&m_ctx);
+    m_ctx.uc_link = nullptr;
+    m_ctx.uc_stack.ss_sp = stack;
+    m_ctx.uc_stack.ss_size = size;
+    uint64_t e = (uintptr_t)entry;
+    uint64_t a = (uintptr_t)arg;
+    makecontext(&m_ctx, (void (*)())&ContextStart, 4
+                ,(uint32_t)e, (uint32_t)(e >> 32), (uint32_t)a, (uint32_t)(a >> 32));
+}
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef __GAMESERVER_CONTEXT_H__
+#define __GAMESERVER_CONTEXT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+#if defined(__x86_64__)
+extern "C" {
+/**
+ * @brief 保存当前的callee-saved寄存器和MXCSR/x87控制字到栈上, 栈指针写到*from_sp,
+ *        然后切到to_sp保存的上下文. 见context.cc
+ */
+void gameserver_fiber_swap(void** from_sp, void* to_sp);
+}
+#endif
+
+namespace gameserver{
+
+/**
+ * @brief 协程上下文
+ * @details x86-64上用手写汇编切换, 只保存System V ABI规定的callee-saved寄存器
+ *          (rbx rbp r12-r15 rsp)和浮点控制字, 不进内核, 不保存信号屏蔽字;
+ *          其他平台退回ucontext(swapcontext每次要做一次sigprocmask系统调用)
+ */
+class FiberContext {
+public:
+    /// 入口函数, 不能返回, 结束时必须切到别的上下文
+    typedef void (*Entry)(void* arg);
+
+    /**
+     * @brief 在栈上构造初始上下文, 第一次切入时执行entry(arg)
+     * @param[in] stack 栈的低地址
+     * @param[in] size 栈大小
+     */
+    void make(void* stack, size_t size, Entry entry, void* arg);
+
+    /**
+     * @brief 保存当前上下文到from, 切到to
+     */
+    static void Swap(FiberContext& from, FiberContext& to) {
+#if defined(__x86_64__)
+        gameserver_fiber_swap(&from.m_sp, to.m_sp);
+#else
+        swapcontext(&from.m_ctx, &to.m_ctx);
+#endif
+    }
+private:
+#if defined(__x86_64__)
+    /// 切出时的栈指针, 寄存器保存在栈上
+    void* m_sp = nullptr;
+#else
+    ucontext_t m_ctx;
+#endif
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef __GAMESERVER_FD_MANAGER_H__
+#define __GAMESERVER_FD_MANAGER_H__
+
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include "Thread/mutex.h"
+
+namespace gameserver{
+
+/**
+ * @brief 文件句柄上下文, 供hook使用
+ * @details 记录是否是socket, 用户是否设置了非阻塞, 以及SO_RCVTIMEO/SO_SNDTIMEO超时.
+ *          hook的socket在系统层面总是非阻塞的, 用户看到的阻塞属性由userNonblock表示
+ */
+class FdCtx : public std::enable_shared_from_this<FdCtx> {
+public:
+    typedef std::shared_ptr<FdCtx> ptr;
+
+    /**
+     * @brief 通过文件句柄构造, socket会被设置为系统非阻塞
+     */
+    FdCtx(int fd);
+
+    bool isInit() const { return m_isInit;}
+    bool isSocket() const { return m_isSocket;}
+    bool isClose() const { return m_isClosed;}
+    void setClose() { m_isClosed = true;}
+
+    /**
+     * @brief 用户是否主动设置了非阻塞(fcntl/O_NONBLOCK)
+     */
+    void setUserNonblock(bool v) { m_userNonblock = v;}
+    bool getUserNonblock() const { return m_userNonblock;}
+
+    /**
+     * @brief 是否由hook设置了系统非阻塞
+     */
+    void setSysNonblock(bool v) { m_sysNonblock = v;}
+    bool getSysNonblock() const { return m_sysNonblock;}
+
+    /**
+     * @brief 设置超时时间
+     * @param[in] type SO_RCVTIMEO 或 SO_SNDTIMEO
+     * @param[in] v 毫秒, ~0ull为不超时
+     */
+    void setTimeout(int type, uint64_t v);
+    uint64_t getTimeout(int type) const;
+private:
+    /**
+     * @brief 初始化: 判断是否socket, socket设为系统非阻塞
+     */
+    bool init();
+private:
+    bool m_isInit: 1;
+    bool m_isSocket: 1;
+    bool m_sysNonblock: 1;
+    bool m_userNonblock: 1;
+    bool m_isClosed: 1;
+    /// 文件句柄
+    int m_fd;
+    /// 读超时毫秒数
+    uint64_t m_recvTimeout;
+    /// 写超时毫秒数
+    uint64_t m_sendTimeout;
+};
+
+/**
+ * @brief 文件句柄管理, 上下文放在按fd下标的数组里
+ */
+class FdManager {
+public:
+    typedef RWMutex RWMutexType;
+
+    FdManager();
+
+    /**
+     * @brief 获取文件句柄上下文
+     * @param[in] fd 文件句柄
+     * @param[in] auto_create 不存在时是否创建
+     * @return 不存在且不创建时返回nullptr
+     */
+    FdCtx::ptr get(int fd, bool auto_create = false);
+
+    /**
+     * @brief 删除文件句柄上下文(close时)
+     */
+    void del(int fd);
+
+    /**
+     * @brief 单例
+     * @details 不析构: 进程退出时其他静态对象的析构函数还可能调用close(), 会访问这里
+     */
+    static FdManager* GetInstance();
+private:
+    RWMutexType m_mutex;
+    /// 下标为fd的上下文
+    std::vector<FdCtx::ptr> m_datas;
+};
+
+typedef FdManager FdMgr;
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "fiber.h"
+#include "stack.h"
+#include "Util/macro.h"
+#include <atomic>
+
+namespace gameserver{
+
+static Logger::ptr g_logger = GAMESERVER_LOG_NAME("system");
+
+/// 协程id
+static std::atomic<uint64_t> s_fiber_id {0};
+/// 协程数
+static std::atomic<uint64_t> s_fiber_count {0};
+
+/// 当前运行的协程
+static thread_local Fiber* t_fiber = nullptr;
+/// 线程的主协程
+static thread_local Fiber::ptr t_threadFiber = nullptr;
+
+Fiber::Fiber() {
+    m_state = EXEC;
+    SetThis(this);
+    ++s_fiber_count;
+}
+
+Fiber::Fiber(std::function<void()> cb, size_t stacksize)
+    :m_id(++s_fiber_id)
+    ,m_cb(cb) {
+    m_stacksize = stacksize ? stacksize : StackPool::DEFAULT_SIZE;
+    m_stack = StackPool::Alloc(m_stacksize);
+    m_ctx.make(m_stack, m_stacksize, &Fiber::MainFunc, this);
+    ++s_fiber_count;
+}
+
+Fiber::~Fiber() {
+    --s_fiber_count;
+    if(m_stack) {
+        // 暂停中的协程栈上的对象不会析构, 不能直接销毁
+        GAMESERVER_ASSERT2(m_state == TERM || m_state == EXCEPT || m_state == INIT
+                           ,"fiber id=" << m_id << " state=" << m_state);
+        StackPool::Free(m_stack, m_stacksize);
+    } else {
+        // 主协程
+        GAMESERVER_ASSERT(!m_cb);
+        GAMESERVER_ASSERT(m_state == EXEC);
+        if(t_fiber == this) {
+            SetThis(nullptr);
+        }
+    }
+}
+
+void Fiber::reset(std::function<void()> cb) {
+    GAMESERVER_ASSERT(m_stack);
+    GAMESERVER_ASSERT(m_state == TERM || m_state == EXCEPT || m_state == INIT);
+    m_cb = cb;
+    m_ctx.make(m_stack, m_stacksize, &Fiber::MainFunc, this);
+    m_state = INIT;
+}
+
+void Fiber::swapIn() {
+    Fiber* cur = t_fiber ? t_fiber : GetThis().get();
+    GAMESERVER_ASSERT2(cur != this, "fiber id=" << m_id);
+    // 协程先设置HOLD再切出, 别的线程可能在它切出完成前就调度它, 等原线程保存完上下文
+    while(m_running.exchange(true, std::memory_order_acquire)) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+    GAMESERVER_ASSERT2(m_state != EXEC, "fiber id=" << m_id);
+    m_caller = cur;
+    SetThis(this);
+    m_state = EXEC;
+    FiberContext::Swap(cur->m_ctx, m_ctx);
+    // 回到cur时本协程的上下文已经保存
+    m_running.store(false, std::memory_order_release);
+}
+
+void Fiber::swapOut() {
+    Fiber* caller = m_caller;
+    GAMESERVER_ASSERT2(caller, "fiber id=" << m_id << " was not swapped in");
+    m_caller = nullptr;
+    SetThis(caller);
+    FiberContext::Swap(m_ctx, caller->m_ctx);
+}
+
+void Fiber::SetThis(Fiber* f) {
+    t_fiber = f;
+}
+
+Fiber::ptr Fiber::GetThis() {
+    if(t_fiber) {
+        return t_fiber->shared_from_this();
+    }
+    Fiber::ptr main_fiber(new Fiber);
+    GAMESERVER_ASSERT(t_fiber == main_fiber.get());
+    t_threadFiber = main_fiber;
+    return t_fiber->shared_from_this();
+}
+
+void Fiber::YieldToReady() {
+    // 用裸指针, 暂停期间不持有自己的引用
+    Fiber* cur = t_fiber;
+    GAMESERVER_ASSERT(cur && cur->m_stack);
+    cur->m_state = READY;
+    cur->swapOut();
+}
+
+void Fiber::YieldToHold() {
+    Fiber* cur = t_fiber;
+    GAMESERVER_ASSERT(cur && cur->m_stack);
+    cur->m_state = HOLD;
+    cur->swapOut();
+}
+
+uint64_t Fiber::TotalFibers() {
+    return s_fiber_count;
+}
+
+uint64_t Fiber::GetFiberId() {
+    return t_fiber ? t_fiber->getId() : 0;
+}
+
+void Fiber::MainFunc(void* arg) {
+    Fiber* cur = (Fiber*)arg;
+    try {
+        cur->m_cb();
+        cur->m_cb = nullptr;
+        cur->m_state = TERM;
+    } catch (std::exception& ex) {
+        cur->m_cb = nullptr;
+        cur->m_state = EXCEPT;
+        GAMESERVER_LOG_ERROR(g_logger) << "Fiber Except: " << ex.what()
+            << " fiber_id=" << cur->getId()
+            << "\n" << BacktraceToString();
+    } catch (...) {
+        cur->m_cb = nullptr;
+        cur->m_state = EXCEPT;
+        GAMESERVER_LOG_ERROR(g_logger) << "Fiber Except"
+            << " fiber_id=" << cur->getId()
+            << "\n" << BacktraceToString();
+    }
+    cur->swapOut();
+    GAMESERVER_ASSERT2(false, "never reach fiber_id=" << cur->getId());
+}
+
+}
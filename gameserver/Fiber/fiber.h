@@ -0,0 +1,149 @@
+#ifndef __GAMESERVER_FIBER_H__
+#define __GAMESERVER_FIBER_H__
+
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <stdint.h>
+#include "context.h"
+
+namespace gameserver{
+
+/**
+ * @brief 协程(有栈, 非对称)
+ * @details swapIn()从当前协程切到本协程, 本协程swapOut()/YieldToHold()时回到切入它的协程,
+ *          可以嵌套. 每个线程第一次调用GetThis()时把线程本身包装成主协程(id为0).
+ *          栈来自StackPool, 带保护页, 释放后复用; 执行完(TERM/EXCEPT)的协程可以reset()复用栈.
+ *          当前协程指针在线程局部变量里, 日志的%F直接读它
+ */
+class Fiber : public std::enable_shared_from_this<Fiber> {
+public:
+    typedef std::shared_ptr<Fiber> ptr;
+
+    /**
+     * @brief 协程状态
+     */
+    enum State {
+        /// 初始化状态
+        INIT,
+        /// 暂停状态
+        HOLD,
+        /// 执行中状态
+        EXEC,
+        /// 结束状态
+        TERM,
+        /// 可执行状态
+        READY,
+        /// 异常状态
+        EXCEPT
+    };
+private:
+    /**
+     * @brief 主协程的构造函数, 使用线程自己的栈
+     */
+    Fiber();
+public:
+    /**
+     * @brief 构造函数
+     * @param[in] cb 协程执行的函数
+     * @param[in] stacksize 协程栈大小, 0为StackPool::DEFAULT_SIZE
+     */
+    Fiber(std::function<void()> cb, size_t stacksize = 0);
+    ~Fiber();
+
+    /**
+     * @brief 重置协程执行函数, 复用栈
+     * @pre getState() 为 INIT, TERM, EXCEPT
+     * @post getState() = INIT
+     */
+    void reset(std::function<void()> cb);
+
+    /**
+     * @brief 从当前协程切换到本协程执行
+     * @details 本协程刚在别的线程上让出, 还没切换完时, 先等它切出
+     * @pre getState() != EXEC
+     * @post getState() = EXEC
+     */
+    void swapIn();
+
+    /**
+     * @brief 切回到切入本协程的协程
+     */
+    void swapOut();
+
+    /**
+     * @brief 协程id
+     */
+    uint64_t getId() const { return m_id;}
+
+    /**
+     * @brief 协程状态
+     */
+    State getState() const { return m_state;}
+
+    /**
+     * @brief 设置协程状态, 供调度器使用
+     */
+    void setState(State state) { m_state = state;}
+
+    /**
+     * @brief 栈大小, 主协程为0
+     */
+    size_t getStackSize() const { return m_stacksize;}
+public:
+    /**
+     * @brief 设置当前线程的运行协程
+     */
+    static void SetThis(Fiber* f);
+
+    /**
+     * @brief 当前所在协程, 线程还没有协程时创建主协程
+     */
+    static Fiber::ptr GetThis();
+
+    /**
+     * @brief 当前协程切换到后台, 并设置为READY状态
+     */
+    static void YieldToReady();
+
+    /**
+     * @brief 当前协程切换到后台, 并设置为HOLD状态
+     */
+    static void YieldToHold();
+
+    /**
+     * @brief 协程总数(含主协程)
+     */
+    static uint64_t TotalFibers();
+
+    /**
+     * @brief 当前协程id, 不在协程里时为0
+     */
+    static uint64_t GetFiberId();
+private:
+    /**
+     * @brief 协程入口, 执行完成后切回切入者
+     */
+    static void MainFunc(void* arg);
+private:
+    /// 协程id
+    uint64_t m_id = 0;
+    /// 协程栈大小
+    size_t m_stacksize = 0;
+    /// 协程状态
+    State m_state = INIT;
+    /// 协程上下文
+    FiberContext m_ctx;
+    /// 协程栈
+    void* m_stack = nullptr;
+    /// 协程执行函数
+    std::function<void()> m_cb;
+    /// 切入本协程的协程, swapOut时回到它
+    Fiber* m_caller = nullptr;
+    /// 是否在某个线程上运行(从swapIn开始, 到切入者恢复执行为止)
+    std::atomic<bool> m_running {false};
+};
+
+}
+
+#endif
@@ -0,0 +1,470 @@
+#include "hook.h"
+#include "fd_manager.h"
+#include "iomanager.h"
+#include "Util/macro.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <sys/time.h>
+
+namespace gameserver{
+
+static Logger::ptr g_logger = GAMESERVER_LOG_NAME("system");
+
+/// 当前线程是否启用hook
+static thread_local bool t_hook_enable = false;
+
+#define HOOK_FUN(XX) \
+    XX(sleep) \
+    XX(usleep) \
+    XX(nanosleep) \
+    XX(socket) \
+    XX(connect) \
+    XX(accept) \
+    XX(read) \
+    XX(readv) \
+    XX(recv) \
+    XX(recvfrom) \
+    XX(recvmsg) \
+    XX(write) \
+    XX(writev) \
+    XX(send) \
+    XX(sendto) \
+    XX(sendmsg) \
+    XX(close) \
+    XX(fcntl) \
+    XX(setsockopt)
+
+/**
+ * @brief 取出原函数
+ * @details 用优先级最高的构造函数, 在本库其他静态对象初始化(可能写日志文件)之前完成
+ */
+__attribute__((constructor(101)))
+static void hook_init() {
+    static bool is_inited = false;
+    if(is_inited) {
+        return;
+    }
+#define XX(name) name ## _f = (name ## _fun)dlsym(RTLD_NEXT, #name);
+    HOOK_FUN(XX);
+#undef XX
+    is_inited = true;
+}
+
+bool IsHookEnable() {
+    return t_hook_enable;
+}
+
+void SetHookEnable(bool flag) {
+    t_hook_enable = flag;
+}
+
+/**
+ * @brief 当前是否在IOManager的协程里, 可以让出
+ */
+static bool can_yield() {
+    return IOManager::GetThis() && Fiber::GetFiberId() != 0;
+}
+
+/**
+ * @brief 在IOManager的协程里睡眠: 注册定时器后让出, 定时器到期时重新调度
+ */
+static void fiber_sleep(uint64_t ms) {
+    Fiber::ptr fiber = Fiber::GetThis();
+    IOManager* iom = IOManager::GetThis();
+    iom->addTimer(ms, [iom, fiber]() {
+        iom->schedule(fiber);
+    });
+    Fiber::YieldToHold();
+}
+
+/**
+ * @brief 阻塞线程等待fd就绪, 用于不能让出协程时
+ * @return 就绪返回true, 超时或出错返回false并设置errno
+ */
+static bool poll_wait(int fd, IOManager::Event event, uint64_t timeout, int timeout_errno) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = event == IOManager::READ ? POLLIN : POLLOUT;
+    pfd.revents = 0;
+    int to = timeout == ~0ull ? -1 : (int)timeout;
+    int rt;
+    do {
+        rt = poll(&pfd, 1, to);
+    } while(rt < 0 && errno == EINTR);
+    if(rt == 0) {
+        errno = timeout_errno;
+        return false;
+    }
+    return rt > 0;
+}
+
+/**
+ * @brief 超时标记, 定时器和等待的协程共享
+ */
+struct timer_info {
+    int cancelled = 0;
+};
+
+/**
+ * @brief 等fd就绪: 在IOManager协程里注册事件(和超时定时器)后让出, 否则阻塞线程poll
+ * @param[in] timeout_errno 超时时的errno
+ * @return 就绪返回true, 超时, fd关闭或出错返回false并设置errno
+ */
+static bool wait_ready(int fd, const FdCtx::ptr& ctx, IOManager::Event event, uint64_t timeout
+                       ,int timeout_errno, const char* hook_fun_name) {
+    if(!can_yield()) {
+        return poll_wait(fd, event, timeout, timeout_errno);
+    }
+    IOManager* iom = IOManager::GetThis();
+    std::shared_ptr<timer_info> tinfo(new timer_info);
+    Timer::ptr timer;
+    if(timeout != ~0ull) {
+        std::weak_ptr<timer_info> winfo(tinfo);
+        timer = iom->addConditionTimer(timeout, [winfo, fd, iom, event, timeout_errno]() {
+            auto t = winfo.lock();
+            if(!t || t->cancelled) {
+                return;
+            }
+            t->cancelled = timeout_errno;
+            iom->cancelEvent(fd, event);
+        }, winfo);
+    }
+
+    int rt = iom->addEvent(fd, event);
+    if(GAMESERVER_UNLIKELY(rt)) {
+        GAMESERVER_LOG_ERROR(g_logger) << hook_fun_name << " addEvent("
+            << fd << ", " << event << ")";
+        if(timer) {
+            timer->cancel();
+        }
+        return false;
+    }
+    Fiber::YieldToHold();
+    if(timer) {
+        timer->cancel();
+    }
+    if(tinfo->cancelled) {
+        errno = tinfo->cancelled;
+        return false;
+    }
+    if(ctx->isClose()) {
+        errno = EBADF;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief socket读写的公共流程
+ * @details 不启用hook时直接调用原函数; 只有原函数返回EAGAIN, 且fd是hook线程创建的socket
+ *          (系统层面非阻塞)而用户没有设置非阻塞时, 才阻塞线程等待, 保持阻塞语义
+ */
+template<typename OriginFun, typename... Args>
+static ssize_t do_io(int fd, OriginFun fun, const char* hook_fun_name
+                     ,IOManager::Event event, int timeout_so, Args... args) {
+    if(GAMESERVER_LIKELY(!t_hook_enable)) {
+        ssize_t n = fun(fd, args...);
+        if(GAMESERVER_LIKELY(n != -1 || errno != EAGAIN)) {
+            return n;
+        }
+        FdCtx::ptr ctx = FdMgr::GetInstance()->get(fd);
+        if(!ctx || !ctx->getSysNonblock() || ctx->getUserNonblock()) {
+            errno = EAGAIN;
+            return -1;
+        }
+        uint64_t to = ctx->getTimeout(timeout_so);
+        while(true) {
+            if(!poll_wait(fd, event, to, EAGAIN)) {
+                return -1;
+            }
+            do {
+                n = fun(fd, args...);
+            } while(n == -1 && errno == EINTR);
+            if(n != -1 || errno != EAGAIN) {
+                return n;
+            }
+        }
+    }
+
+    FdCtx::ptr ctx = FdMgr::GetInstance()->get(fd);
+    if(!ctx) {
+        return fun(fd, args...);
+    }
+    if(ctx->isClose()) {
+        errno = EBADF;
+        return -1;
+    }
+    if(!ctx->isSocket() || ctx->getUserNonblock()) {
+        return fun(fd, args...);
+    }
+
+    uint64_t to = ctx->getTimeout(timeout_so);
+    while(true) {
+        ssize_t n;
+        do {
+            n = fun(fd, args...);
+        } while(n == -1 && errno == EINTR);
+        if(n != -1 || errno != EAGAIN) {
+            return n;
+        }
+        if(!wait_ready(fd, ctx, event, to, EAGAIN, hook_fun_name)) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * @brief 非阻塞connect返回EINPROGRESS后等待连接完成
+ */
+static int connect_wait(int fd, const FdCtx::ptr& ctx) {
+    uint64_t to = ctx->getTimeout(SO_SNDTIMEO);
+    if(!wait_ready(fd, ctx, IOManager::WRITE, to, EINPROGRESS, "connect")) {
+        return -1;
+    }
+    int error = 0;
+    socklen_t len = sizeof(int);
+    if(-1 == getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len)) {
+        return -1;
+    }
+    if(!error) {
+        return 0;
+    }
+    errno = error;
+    return -1;
+}
+
+}
+
+extern "C" {
+#define XX(name) name ## _fun name ## _f = nullptr;
+    HOOK_FUN(XX);
+#undef XX
+
+unsigned int sleep(unsigned int seconds) {
+    if(!gameserver::t_hook_enable || !gameserver::can_yield()) {
+        return sleep_f(seconds);
+    }
+    gameserver::fiber_sleep(seconds * 1000ull);
+    return 0;
+}
+
+int usleep(useconds_t usec) {
+    if(!gameserver::t_hook_enable || !gameserver::can_yield()) {
+        return usleep_f(usec);
+    }
+    gameserver::fiber_sleep(usec / 1000);
+    return 0;
+}
+
+int nanosleep(const struct timespec *req, struct timespec *rem) {
+    if(!gameserver::t_hook_enable || !gameserver::can_yield()) {
+        return nanosleep_f(req, rem);
+    }
+    gameserver::fiber_sleep(req->tv_sec * 1000ull + req->tv_nsec / 1000 / 1000);
+    if(rem) {
+        rem->tv_sec = 0;
+        rem->tv_nsec = 0;
+    }
+    return 0;
+}
+
+int socket(int domain, int type, int protocol) {
+    if(!gameserver::t_hook_enable) {
+        return socket_f(domain, type, protocol);
+    }
+    int fd = socket_f(domain, type, protocol);
+    if(fd == -1) {
+        return fd;
+    }
+    gameserver::FdMgr::GetInstance()->get(fd, true);
+    return fd;
+}
+
+int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen) {
+    if(GAMESERVER_LIKELY(!gameserver::t_hook_enable)) {
+        int n = connect_f(sockfd, addr, addrlen);
+        if(GAMESERVER_LIKELY(n == 0 || errno != EINPROGRESS)) {
+            return n;
+        }
+        gameserver::FdCtx::ptr ctx = gameserver::FdMgr::GetInstance()->get(sockfd);
+        if(!ctx || !ctx->getSysNonblock() || ctx->getUserNonblock()) {
+            errno = EINPROGRESS;
+            return -1;
+        }
+        return gameserver::connect_wait(sockfd, ctx);
+    }
+    gameserver::FdCtx::ptr ctx = gameserver::FdMgr::GetInstance()->get(sockfd);
+    if(!ctx) {
+        // 不是hook的socket()创建的(比如在未hook的线程上创建), 按原样阻塞connect
+        return connect_f(sockfd, addr, addrlen);
+    }
+    if(ctx->isClose()) {
+        errno = EBADF;
+        return -1;
+    }
+    if(!ctx->isSocket() || ctx->getUserNonblock()) {
+        return connect_f(sockfd, addr, addrlen);
+    }
+    int n = connect_f(sockfd, addr, addrlen);
+    if(n == 0 || errno != EINPROGRESS) {
+        return n;
+    }
+    return gameserver::connect_wait(sockfd, ctx);
+}
+
+int accept(int s, struct sockaddr *addr, socklen_t *addrlen) {
+    int fd = gameserver::do_io(s, accept_f, "accept", gameserver::IOManager::READ, SO_RCVTIMEO, addr, addrlen);
+    if(fd >= 0 && gameserver::t_hook_enable) {
+        gameserver::FdMgr::GetInstance()->get(fd, true);
+    }
+    return fd;
+}
+
+ssize_t read(int fd, void *buf, size_t count) {
+    return gameserver::do_io(fd, read_f, "read", gameserver::IOManager::READ, SO_RCVTIMEO, buf, count);
+}
+
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt) {
+    return gameserver::do_io(fd, readv_f, "readv", gameserver::IOManager::READ, SO_RCVTIMEO, iov, iovcnt);
+}
+
+ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
+    return gameserver::do_io(sockfd, recv_f, "recv", gameserver::IOManager::READ, SO_RCVTIMEO, buf, len, flags);
+}
+
+ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen) {
+    return gameserver::do_io(sockfd, recvfrom_f, "recvfrom", gameserver::IOManager::READ, SO_RCVTIMEO, buf, len, flags, src_addr, addrlen);
+}
+
+ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
+    return gameserver::do_io(sockfd, recvmsg_f, "recvmsg", gameserver::IOManager::READ, SO_RCVTIMEO, msg, flags);
+}
+
+ssize_t write(int fd, const void *buf, size_t count) {
+    return gameserver::do_io(fd, write_f, "write", gameserver::IOManager::WRITE, SO_SNDTIMEO, buf, count);
+}
+
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
+    return gameserver::do_io(fd, writev_f, "writev", gameserver::IOManager::WRITE, SO_SNDTIMEO, iov, iovcnt);
+}
+
+ssize_t send(int s, const void *msg, size_t len, int flags) {
+    return gameserver::do_io(s, send_f, "send", gameserver::IOManager::WRITE, SO_SNDTIMEO, msg, len, flags);
+}
+
+ssize_t sendto(int s, const void *msg, size_t len, int flags, const struct sockaddr *to, socklen_t tolen) {
+    return gameserver::do_io(s, sendto_f, "sendto", gameserver::IOManager::WRITE, SO_SNDTIMEO, msg, len, flags, to, tolen);
+}
+
+ssize_t sendmsg(int s, const struct msghdr *msg, int flags) {
+    return gameserver::do_io(s, sendmsg_f, "sendmsg", gameserver::IOManager::WRITE, SO_SNDTIMEO, msg, flags);
+}
+
+int close(int fd) {
+    // 不启用hook的线程也要删掉上下文, 否则fd号复用时会带上旧的状态
+    gameserver::FdCtx::ptr ctx = gameserver::FdMgr::GetInstance()->get(fd);
+    if(ctx) {
+        ctx->setClose();
+        // 唤醒等在这个fd上的协程, 它们会拿到EBADF
+        gameserver::IOManager* iom = gameserver::IOManager::GetThis();
+        if(iom) {
+            iom->cancelAll(fd);
+        }
+        gameserver::FdMgr::GetInstance()->del(fd);
+    }
+    return close_f(fd);
+}
+
+int fcntl(int fd, int cmd, ... /* arg */ ) {
+    va_list va;
+    va_start(va, cmd);
+    switch(cmd) {
+        case F_SETFL:
+            {
+                int arg = va_arg(va, int);
+                va_end(va);
+                gameserver::FdCtx::ptr ctx = gameserver::FdMgr::GetInstance()->get(fd);
+                if(!ctx || ctx->isClose() || !ctx->isSocket()) {
+                    return fcntl_f(fd, cmd, arg);
+                }
+                // 记下用户要的阻塞属性, 系统层面保持hook设置的非阻塞
+                ctx->setUserNonblock(arg & O_NONBLOCK);
+                if(ctx->getSysNonblock()) {
+                    arg |= O_NONBLOCK;
+                } else {
+                    arg &= ~O_NONBLOCK;
+                }
+                return fcntl_f(fd, cmd, arg);
+            }
+            break;
+        case F_GETFL:
+            {
+                va_end(va);
+                int arg = fcntl_f(fd, cmd);
+                gameserver::FdCtx::ptr ctx = gameserver::FdMgr::GetInstance()->get(fd);
+                if(arg == -1 || !ctx || ctx->isClose() || !ctx->isSocket()) {
+                    return arg;
+                }
+                if(ctx->getUserNonblock()) {
+                    return arg | O_NONBLOCK;
+                } else {
+                    return arg & ~O_NONBLOCK;
+                }
+            }
+            break;
+        case F_DUPFD:
+        case F_DUPFD_CLOEXEC:
+        case F_SETFD:
+        case F_SETOWN:
+        case F_SETSIG:
+        case F_SETLEASE:
+        case F_NOTIFY:
+#ifdef F_SETPIPE_SZ
+        case F_SETPIPE_SZ:
+#endif
+            {
+                int arg = va_arg(va, int);
+                va_end(va);
+                return fcntl_f(fd, cmd, arg);
+            }
+            break;
+        case F_GETFD:
+        case F_GETOWN:
+        case F_GETSIG:
+        case F_GETLEASE:
+#ifdef F_GETPIPE_SZ
+        case F_GETPIPE_SZ:
+#endif
+            {
+                va_end(va);
+                return fcntl_f(fd, cmd);
+            }
+            break;
+        default:
+            {
+                // 其余命令(文件锁, F_GETOWN_EX等)的参数都是指针
+                void* arg = va_arg(va, void*);
+                va_end(va);
+                return fcntl_f(fd, cmd, arg);
+            }
+            break;
+    }
+}
+
+int setsockopt(int sockfd, int level, int optname, const void *optval, socklen_t optlen) {
+    if(level == SOL_SOCKET && (optname == SO_RCVTIMEO || optname == SO_SNDTIMEO)
+            && optval && optlen >= sizeof(timeval)) {
+        gameserver::FdCtx::ptr ctx = gameserver::FdMgr::GetInstance()->get(sockfd);
+        if(ctx) {
+            const timeval* v = (const timeval*)optval;
+            uint64_t ms = v->tv_sec * 1000ull + v->tv_usec / 1000;
+            // 0表示不超时
+            ctx->setTimeout(optname, ms ? ms : ~0ull);
+        }
+    }
+    return setsockopt_f(sockfd, level, optname, optval, optlen);
+}
+
+}
@@ -0,0 +1,383 @@
+#include "iomanager.h"
+#include "hook.h"
+#include "Util/macro.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace gameserver{
+
+static Logger::ptr g_logger = GAMESERVER_LOG_NAME("system");
+
+/// 一次epoll_wait最多取的事件数
+static const int MAX_EVENTS = 256;
+/// 休眠的最长时间(毫秒)
+static const uint64_t MAX_TIMEOUT = 3000;
+
+IOManager::FdContext::EventContext& IOManager::FdContext::getContext(Event event) {
+    switch(event) {
+        case IOManager::READ:
+            return read;
+        case IOManager::WRITE:
+            return write;
+        default:
+            GAMESERVER_ASSERT2(false, "getContext event=" << event);
+    }
+    throw std::invalid_argument("getContext invalid event");
+}
+
+void IOManager::FdContext::resetContext(EventContext& ctx) {
+    ctx.scheduler = nullptr;
+    ctx.fiber.reset();
+    ctx.cb = nullptr;
+}
+
+void IOManager::FdContext::triggerEvent(Event event) {
+    GAMESERVER_ASSERT(events & event);
+    events = (Event)(events & ~event);
+    EventContext& ctx = getContext(event);
+    if(ctx.cb) {
+        ctx.scheduler->schedule(std::move(ctx.cb));
+    } else {
+        ctx.scheduler->schedule(std::move(ctx.fiber));
+    }
+    resetContext(ctx);
+}
+
+IOManager::IOManager(size_t threads, bool use_caller, const std::string& name)
+    :Scheduler(threads, use_caller, name) {
+    m_epfd = epoll_create1(EPOLL_CLOEXEC);
+    GAMESERVER_ASSERT2(m_epfd >= 0, "epoll_create1 errno=" << errno);
+
+    m_pollers.resize(threads);
+    for(auto& p : m_pollers) {
+        p.epfd = epoll_create1(EPOLL_CLOEXEC);
+        p.eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        GAMESERVER_ASSERT2(p.epfd >= 0 && p.eventfd >= 0, "poller create errno=" << errno);
+
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = p.eventfd;
+        int rt = epoll_ctl(p.epfd, EPOLL_CTL_ADD, p.eventfd, &ev);
+        GAMESERVER_ASSERT2(!rt, "add eventfd errno=" << errno);
+        // 水平触发: 共享epoll上有就绪事件时, 休眠的线程都会醒来去取, 取完就不再就绪
+        ev.events = EPOLLIN;
+        ev.data.fd = m_epfd;
+        rt = epoll_ctl(p.epfd, EPOLL_CTL_ADD, m_epfd, &ev);
+        GAMESERVER_ASSERT2(!rt, "add shared epoll errno=" << errno);
+    }
+    contextResize(64);
+}
+
+IOManager::~IOManager() {
+    stop();
+    for(auto& p : m_pollers) {
+        close(p.eventfd);
+        close(p.epfd);
+    }
+    close(m_epfd);
+    for(auto i : m_fdContexts) {
+        delete i;
+    }
+}
+
+IOManager* IOManager::GetThis() {
+    return dynamic_cast<IOManager*>(Scheduler::GetThis());
+}
+
+void IOManager::contextResize(size_t size) {
+    size_t old = m_fdContexts.size();
+    m_fdContexts.resize(size);
+    for(size_t i = old; i < size; ++i) {
+        m_fdContexts[i] = new FdContext;
+        m_fdContexts[i]->fd = i;
+    }
+}
+
+int IOManager::addEvent(int fd, Event event, std::function<void()> cb) {
+    if(fd < 0) {
+        return -1;
+    }
+    FdContext* fd_ctx = nullptr;
+    RWMutexType::ReadLock lock(m_mutex);
+    if((size_t)fd < m_fdContexts.size()) {
+        fd_ctx = m_fdContexts[fd];
+        lock.unlock();
+    } else {
+        lock.unlock();
+        RWMutexType::WriteLock lock2(m_mutex);
+        if((size_t)fd >= m_fdContexts.size()) {
+            contextResize(std::max((size_t)fd + 1, m_fdContexts.size() * 3 / 2));
+        }
+        fd_ctx = m_fdContexts[fd];
+    }
+
+    FdContext::MutexType::Lock lock3(fd_ctx->mutex);
+    if(GAMESERVER_UNLIKELY(fd_ctx->events & event)) {
+        GAMESERVER_LOG_ERROR(g_logger) << "addEvent assert fd=" << fd
+            << " event=" << event << " fd_ctx.events=" << fd_ctx->events;
+        GAMESERVER_ASSERT(!(fd_ctx->events & event));
+        return -1;
+    }
+
+    int op = fd_ctx->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    epoll_event epevent;
+    memset(&epevent, 0, sizeof(epevent));
+    epevent.events = EPOLLET | fd_ctx->events | event;
+    epevent.data.ptr = fd_ctx;
+    int rt = epoll_ctl(m_epfd, op, fd, &epevent);
+    if(rt) {
+        GAMESERVER_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", "
+            << op << ", " << fd << ", " << epevent.events << "):"
+            << rt << " (" << errno << ") (" << strerror(errno) << ")";
+        return -1;
+    }
+
+    ++m_pendingEventCount;
+    fd_ctx->events = (Event)(fd_ctx->events | event);
+    FdContext::EventContext& event_ctx = fd_ctx->getContext(event);
+    GAMESERVER_ASSERT(!event_ctx.scheduler && !event_ctx.fiber && !event_ctx.cb);
+
+    event_ctx.scheduler = Scheduler::GetThis();
+    if(!event_ctx.scheduler) {
+        event_ctx.scheduler = this;
+    }
+    if(cb) {
+        event_ctx.cb.swap(cb);
+    } else {
+        event_ctx.fiber = Fiber::GetThis();
+        GAMESERVER_ASSERT2(event_ctx.fiber->getState() == Fiber::EXEC
+                      , "state=" << event_ctx.fiber->getState());
+    }
+    return 0;
+}
+
+bool IOManager::delEvent(int fd, Event event) {
+    RWMutexType::ReadLock lock(m_mutex);
+    if(fd < 0 || (size_t)fd >= m_fdContexts.size()) {
+        return false;
+    }
+    FdContext* fd_ctx = m_fdContexts[fd];
+    lock.unlock();
+
+    FdContext::MutexType::Lock lock2(fd_ctx->mutex);
+    if(GAMESERVER_UNLIKELY(!(fd_ctx->events & event))) {
+        return false;
+    }
+
+    Event new_events = (Event)(fd_ctx->events & ~event);
+    int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+    epoll_event epevent;
+    memset(&epevent, 0, sizeof(epevent));
+    epevent.events = EPOLLET | new_events;
+    epevent.data.ptr = fd_ctx;
+    int rt = epoll_ctl(m_epfd, op, fd, &epevent);
+    if(rt) {
+        GAMESERVER_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", "
+            << op << ", " << fd << ", " << epevent.events << "):"
+            << rt << " (" << errno << ") (" << strerror(errno) << ")";
+        return false;
+    }
+
+    fd_ctx->events = new_events;
+    fd_ctx->resetContext(fd_ctx->getContext(event));
+    lock2.unlock();
+    // 最后一个事件删掉后可能可以停止了, 休眠的线程不会自己醒来检查
+    if(--m_pendingEventCount == 0 && stopping()) {
+        wakeAll();
+    }
+    return true;
+}
+
+bool IOManager::cancelEvent(int fd, Event event) {
+    RWMutexType::ReadLock lock(m_mutex);
+    if(fd < 0 || (size_t)fd >= m_fdContexts.size()) {
+        return false;
+    }
+    FdContext* fd_ctx = m_fdContexts[fd];
+    lock.unlock();
+
+    FdContext::MutexType::Lock lock2(fd_ctx->mutex);
+    if(GAMESERVER_UNLIKELY(!(fd_ctx->events & event))) {
+        return false;
+    }
+
+    Event new_events = (Event)(fd_ctx->events & ~event);
+    int op = new_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+    epoll_event epevent;
+    memset(&epevent, 0, sizeof(epevent));
+    epevent.events = EPOLLET | new_events;
+    epevent.data.ptr = fd_ctx;
+    int rt = epoll_ctl(m_epfd, op, fd, &epevent);
+    if(rt) {
+        GAMESERVER_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", "
+            << op << ", " << fd << ", " << epevent.events << "):"
+            << rt << " (" << errno << ") (" << strerror(errno) << ")";
+        return false;
+    }
+
+    fd_ctx->triggerEvent(event);
+    --m_pendingEventCount;
+    return true;
+}
+
+bool IOManager::cancelAll(int fd) {
+    RWMutexType::ReadLock lock(m_mutex);
+    if(fd < 0 || (size_t)fd >= m_fdContexts.size()) {
+        return false;
+    }
+    FdContext* fd_ctx = m_fdContexts[fd];
+    lock.unlock();
+
+    FdContext::MutexType::Lock lock2(fd_ctx->mutex);
+    if(!fd_ctx->events) {
+        return false;
+    }
+
+    int op = EPOLL_CTL_DEL;
+    epoll_event epevent;
+    memset(&epevent, 0, sizeof(epevent));
+    epevent.data.ptr = fd_ctx;
+    int rt = epoll_ctl(m_epfd, op, fd, &epevent);
+    if(rt) {
+        GAMESERVER_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", "
+            << op << ", " << fd << ", " << epevent.events << "):"
+            << rt << " (" << errno << ") (" << strerror(errno) << ")";
+        return false;
+    }
+
+    if(fd_ctx->events & READ) {
+        fd_ctx->triggerEvent(READ);
+        --m_pendingEventCount;
+    }
+    if(fd_ctx->events & WRITE) {
+        fd_ctx->triggerEvent(WRITE);
+        --m_pendingEventCount;
+    }
+    GAMESERVER_ASSERT(fd_ctx->events == NONE);
+    return true;
+}
+
+void IOManager::tickle(size_t idx) {
+    uint64_t one = 1;
+    int rt = write_f(m_pollers[idx].eventfd, &one, sizeof(one));
+    GAMESERVER_ASSERT(rt == sizeof(one));
+}
+
+bool IOManager::stopping() {
+    return m_pendingEventCount == 0 && !hasTimer() && Scheduler::stopping();
+}
+
+void IOManager::onTimerInsertedAtFront() {
+    wakeAny();
+}
+
+/// 工作线程进入调度前的hook设置, 退出时恢复
+static thread_local bool t_prev_hook_enable = false;
+
+void IOManager::onWorkerStart(size_t idx) {
+    t_prev_hook_enable = IsHookEnable();
+    if(m_hookEnable) {
+        SetHookEnable(true);
+    }
+}
+
+void IOManager::onWorkerStop(size_t idx) {
+    SetHookEnable(t_prev_hook_enable);
+}
+
+void IOManager::processTimers() {
+    std::vector<std::function<void()> > cbs;
+    listExpiredCbs(cbs);
+    if(!cbs.empty()) {
+        schedule(cbs.begin(), cbs.end());
+    }
+}
+
+void IOManager::park(size_t idx) {
+    Poller& p = m_pollers[idx];
+    epoll_event evs[2];
+    uint64_t next = getNextTimer();
+    int timeout = next == ~0ull ? -1 : (int)std::min(next, MAX_TIMEOUT);
+    int rt = 0;
+    do {
+        rt = epoll_wait(p.epfd, evs, 2, timeout);
+    } while(rt < 0 && errno == EINTR);
+    if(rt < 0) {
+        GAMESERVER_LOG_ERROR(g_logger) << "epoll_wait(" << p.epfd << ") (rt="
+            << rt << ") (errno=" << errno << ") (" << strerror(errno) << ")";
+        return;
+    }
+    for(int i = 0; i < rt; ++i) {
+        if(evs[i].data.fd == p.eventfd) {
+            uint64_t dummy;
+            while(read_f(p.eventfd, &dummy, sizeof(dummy)) > 0);
+        }
+    }
+    poll();
+    processTimers();
+}
+
+void IOManager::busyPoll(size_t idx) {
+    poll();
+    processTimers();
+}
+
+size_t IOManager::poll() {
+    epoll_event events[MAX_EVENTS];
+    int rt = 0;
+    do {
+        rt = epoll_wait(m_epfd, events, MAX_EVENTS, 0);
+    } while(rt < 0 && errno == EINTR);
+
+    size_t triggered = 0;
+    for(int i = 0; i < rt; ++i) {
+        epoll_event& event = events[i];
+        FdContext* fd_ctx = (FdContext*)event.data.ptr;
+        FdContext::MutexType::Lock lock(fd_ctx->mutex);
+        // 出错或挂断时, 唤醒所有等待者, 由它们的读写调用拿到错误
+        if(event.events & (EPOLLERR | EPOLLHUP)) {
+            event.events |= (EPOLLIN | EPOLLOUT) & fd_ctx->events;
+        }
+        int real_events = NONE;
+        if(event.events & EPOLLIN) {
+            real_events |= READ;
+        }
+        if(event.events & EPOLLOUT) {
+            real_events |= WRITE;
+        }
+        if((fd_ctx->events & real_events) == NONE) {
+            continue;
+        }
+
+        int left_events = (fd_ctx->events & ~real_events);
+        int op = left_events ? EPOLL_CTL_MOD : EPOLL_CTL_DEL;
+        event.events = EPOLLET | left_events;
+        int rt2 = epoll_ctl(m_epfd, op, fd_ctx->fd, &event);
+        if(rt2) {
+            GAMESERVER_LOG_ERROR(g_logger) << "epoll_ctl(" << m_epfd << ", "
+                << op << ", " << fd_ctx->fd << ", " << event.events << "):"
+                << rt2 << " (" << errno << ") (" << strerror(errno) << ")";
+            continue;
+        }
+
+        if(real_events & READ) {
+            fd_ctx->triggerEvent(READ);
+            --m_pendingEventCount;
+            ++triggered;
+        }
+        if(real_events & WRITE) {
+            fd_ctx->triggerEvent(WRITE);
+            --m_pendingEventCount;
+            ++triggered;
+        }
+    }
+    return triggered;
+}
+
+}
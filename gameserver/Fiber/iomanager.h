@@ -0,0 +1,175 @@
+#ifndef __GAMESERVER_IOMANAGER_H__
+#define __GAMESERVER_IOMANAGER_H__
+
+#include <vector>
+#include <atomic>
+#include <functional>
+#include "scheduler.h"
+#include "timer.h"
+
+namespace gameserver{
+
+/**
+ * @brief 基于epoll的IO协程调度器
+ * @details 所有fd注册在一个共享的epoll上(边缘触发), 哪个线程空闲都可以处理就绪事件.
+ *          每个工作线程另有一个自己的epoll, 里面是自己的eventfd和共享的epoll,
+ *          park(idx)阻塞在自己的epoll上, tickle(idx)写它的eventfd, 可以准确唤醒指定线程.
+ *          fd的事件上下文放在按fd下标的数组里, 不查表.
+ *          addEvent()不给回调时等待的是当前协程, 事件就绪后把它重新调度.
+ *          定时器由TimerManager的时间轮管理, park()等到最近的定时器为止, 到期回调作为任务调度;
+ *          有定时器时不会停止, 循环定时器要在stop()之前取消
+ */
+class IOManager : public Scheduler, public TimerManager {
+public:
+    typedef std::shared_ptr<IOManager> ptr;
+    typedef RWMutex RWMutexType;
+
+    /**
+     * @brief IO事件, 与EPOLLIN/EPOLLOUT取值相同
+     */
+    enum Event {
+        /// 无事件
+        NONE    = 0x0,
+        /// 读事件(EPOLLIN)
+        READ    = 0x1,
+        /// 写事件(EPOLLOUT)
+        WRITE   = 0x4,
+    };
+private:
+    /**
+     * @brief fd的事件上下文
+     */
+    struct FdContext {
+        typedef Mutex MutexType;
+        /**
+         * @brief 一个事件等待者: 协程或回调, 以及调度它的调度器
+         */
+        struct EventContext {
+            Scheduler* scheduler = nullptr;
+            Fiber::ptr fiber;
+            std::function<void()> cb;
+        };
+
+        /**
+         * @brief 事件对应的上下文
+         */
+        EventContext& getContext(Event event);
+
+        /**
+         * @brief 清空上下文
+         */
+        void resetContext(EventContext& ctx);
+
+        /**
+         * @brief 触发事件: 从已注册事件中去掉, 调度等待者
+         */
+        void triggerEvent(Event event);
+
+        /// 读事件上下文
+        EventContext read;
+        /// 写事件上下文
+        EventContext write;
+        /// 文件描述符
+        int fd = 0;
+        /// 已注册的事件
+        Event events = NONE;
+        MutexType mutex;
+    };
+
+    /**
+     * @brief 工作线程休眠用的epoll和eventfd
+     */
+    struct Poller {
+        int epfd = -1;
+        int eventfd = -1;
+    };
+public:
+    /**
+     * @brief 构造函数
+     * @param[in] threads 线程数量
+     * @param[in] use_caller 是否使用当前调用线程
+     * @param[in] name 调度器名称
+     */
+    IOManager(size_t threads = 1, bool use_caller = true, const std::string& name = "");
+    ~IOManager();
+
+    /**
+     * @brief 注册事件, fd需要是非阻塞的
+     * @param[in] fd 文件描述符
+     * @param[in] event 事件, 同一个fd的同一事件同时只能有一个等待者
+     * @param[in] cb 事件回调, 为空时等待当前协程(调用者随后YieldToHold)
+     * @return 成功返回0, 失败返回-1
+     */
+    int addEvent(int fd, Event event, std::function<void()> cb = nullptr);
+
+    /**
+     * @brief 删除事件, 不触发等待者
+     */
+    bool delEvent(int fd, Event event);
+
+    /**
+     * @brief 取消事件, 事件已注册时触发一次等待者
+     */
+    bool cancelEvent(int fd, Event event);
+
+    /**
+     * @brief 取消fd的所有事件
+     */
+    bool cancelAll(int fd);
+
+    /**
+     * @brief 已注册未触发的事件数
+     */
+    size_t getPendingEventCount() const { return m_pendingEventCount;}
+
+    /**
+     * @brief 工作线程是否启用系统调用hook(见hook.h), 默认不启用, 在start()之前设置
+     */
+    void setHookEnable(bool v) { m_hookEnable = v;}
+    bool isHookEnable() const { return m_hookEnable;}
+public:
+    /**
+     * @brief 当前线程的IOManager, 不是时为nullptr
+     */
+    static IOManager* GetThis();
+protected:
+    void tickle(size_t idx) override;
+    void park(size_t idx) override;
+    bool stopping() override;
+    void busyPoll(size_t idx) override;
+    void onTimerInsertedAtFront() override;
+    void onWorkerStart(size_t idx) override;
+    void onWorkerStop(size_t idx) override;
+
+    /**
+     * @brief 取出共享epoll上的就绪事件并触发, 不阻塞
+     * @return 触发的事件数
+     */
+    size_t poll();
+
+    /**
+     * @brief 调度到期定时器的回调
+     */
+    void processTimers();
+
+    /**
+     * @brief fd上下文数组扩容到至少size
+     */
+    void contextResize(size_t size);
+private:
+    /// 共享epoll, 所有fd注册在这里
+    int m_epfd = -1;
+    /// 每个工作线程的休眠epoll
+    std::vector<Poller> m_pollers;
+    /// 已注册未触发的事件数
+    std::atomic<size_t> m_pendingEventCount {0};
+    /// 工作线程是否启用hook
+    bool m_hookEnable = false;
+    RWMutexType m_mutex;
+    /// 下标为fd的上下文
+    std::vector<FdContext*> m_fdContexts;
+};
+
+}
+
+#endif
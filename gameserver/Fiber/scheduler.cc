@@ -0,0 +1,454 @@
+#include "scheduler.h"
+#include "Util/macro.h"
+#include "Util/util.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace gameserver{
+
+static Logger::ptr g_logger = GAMESERVER_LOG_NAME("system");
+
+/// 当前线程的调度器
+static thread_local Scheduler* t_scheduler = nullptr;
+/// 当前线程在调度器中的编号
+static thread_local int t_worker_index = -1;
+
+/// 全局队列一次最多取走的任务数, 多出的放进自己的队列供别人窃取
+static const size_t GLOBAL_BATCH = 32;
+/// 自旋之后sched_yield的轮数
+static const uint32_t YIELD_COUNT = 4;
+/// 每多少次next()先看一次全局队列和yielded队列, 自己的队列一直有任务时它们也不会饿死
+static const uint32_t GLOBAL_CHECK_INTERVAL = 61;
+/// 连续执行多少个任务调用一次busyPoll()
+static const uint32_t BUSY_POLL_INTERVAL = 64;
+
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+Scheduler::Scheduler(size_t threads, bool use_caller, const std::string& name)
+    :m_name(name) {
+    GAMESERVER_ASSERT(threads > 0);
+    for(size_t i = 0; i < threads; ++i) {
+        m_workers.push_back(std::unique_ptr<Worker>(new Worker));
+        m_workers.back()->seed = (uint32_t)(i + 1) * 2654435761u;
+    }
+
+    if(use_caller) {
+        Fiber::GetThis();
+        GAMESERVER_ASSERT(GetThis() == nullptr);
+        setThis();
+        t_worker_index = 0;
+        m_rootFiber.reset(new Fiber(std::bind(&Scheduler::run, this, 0)));
+        m_rootThread = GetThreadId();
+        m_workers[0]->id = m_rootThread;
+    }
+}
+
+Scheduler::~Scheduler() {
+    GAMESERVER_ASSERT(m_stopping);
+    for(auto& w : m_workers) {
+        Task* t = nullptr;
+        while(w->deque.pop(t)) {
+            delete t;
+        }
+        for(auto i : w->inbox) {
+            delete i;
+        }
+        for(auto i : w->yielded) {
+            delete i;
+        }
+    }
+    for(auto i : m_global) {
+        delete i;
+    }
+    if(GetThis() == this) {
+        t_scheduler = nullptr;
+        t_worker_index = -1;
+    }
+}
+
+Scheduler* Scheduler::GetThis() {
+    return t_scheduler;
+}
+
+int Scheduler::GetWorkerIndex() {
+    return t_worker_index;
+}
+
+void Scheduler::setThis() {
+    t_scheduler = this;
+}
+
+std::vector<int> Scheduler::getThreadIds() const {
+    std::vector<int> ids;
+    for(auto& w : m_workers) {
+        ids.push_back(w->id);
+    }
+    return ids;
+}
+
+void Scheduler::start() {
+    if(m_started || m_stopping) {
+        return;
+    }
+    m_started = true;
+    for(size_t i = m_rootFiber ? 1 : 0; i < m_workers.size(); ++i) {
+        Worker& w = *m_workers[i];
+        w.thread.reset(new Thread(std::bind(&Scheduler::threadMain, this, i)
+                            , m_name + "_" + std::to_string(i)));
+        w.id = w.thread->getId();
+    }
+}
+
+void Scheduler::stop() {
+    if(m_rootFiber) {
+        GAMESERVER_ASSERT(GetThis() == this);
+    } else {
+        GAMESERVER_ASSERT(GetThis() != this);
+    }
+    m_stopping = true;
+    wakeAll();
+
+    if(m_rootFiber && m_rootFiber->getState() != Fiber::TERM
+            && m_rootFiber->getState() != Fiber::EXCEPT) {
+        m_rootFiber->swapIn();
+    }
+
+    for(auto& w : m_workers) {
+        if(w->thread) {
+            w->thread->join();
+        }
+    }
+}
+
+void Scheduler::threadMain(size_t idx) {
+    setThis();
+    t_worker_index = idx;
+    m_workers[idx]->id = GetThreadId();
+    if(m_affinity) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(idx % (ncpu > 0 ? ncpu : 1), &set);
+        int rt = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if(rt) {
+            GAMESERVER_LOG_WARN(g_logger) << m_name << " worker " << idx
+                << " set cpu affinity failed rt=" << rt;
+        }
+    }
+    Fiber::GetThis();
+    run(idx);
+}
+
+int Scheduler::indexOf(int thread) const {
+    for(size_t i = 0; i < m_workers.size(); ++i) {
+        if(m_workers[i]->id == thread) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void Scheduler::push(Task* task) {
+    ++m_taskCount;
+    if(task->thread != -1) {
+        int idx = indexOf(task->thread);
+        GAMESERVER_ASSERT2(idx >= 0, m_name << " no worker thread=" << task->thread);
+        Worker& w = *m_workers[idx];
+        {
+            Spinlock::Lock lock(w.inboxMutex);
+            w.inbox.push_back(task);
+            ++w.inboxSize;
+        }
+        wake(idx);
+        return;
+    }
+    if(t_scheduler == this && t_worker_index >= 0) {
+        m_workers[t_worker_index]->deque.push(task);
+    } else {
+        MutexType::Lock lock(m_mutex);
+        m_global.push_back(task);
+        ++m_globalSize;
+    }
+    wakeAny();
+}
+
+bool Scheduler::wake(size_t idx) {
+    Worker& w = *m_workers[idx];
+    if(!w.sleeping.exchange(false)) {
+        return false;
+    }
+    --m_idleThreadCount;
+    tickle(idx);
+    return true;
+}
+
+void Scheduler::wakeAny() {
+    // 和run()里休眠前的检查配对: 要么这里看到休眠的线程, 要么它看到新任务
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_idleThreadCount.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    size_t n = m_workers.size();
+    size_t start = m_wakeCursor.fetch_add(1, std::memory_order_relaxed);
+    for(size_t i = 0; i < n; ++i) {
+        size_t idx = (start + i) % n;
+        if(m_workers[idx]->sleeping.load(std::memory_order_relaxed) && wake(idx)) {
+            return;
+        }
+    }
+}
+
+void Scheduler::wakeAll() {
+    for(size_t i = 0; i < m_workers.size(); ++i) {
+        wake(i);
+    }
+}
+
+void Scheduler::tickle(size_t idx) {
+    m_workers[idx]->semaphore.notify();
+}
+
+void Scheduler::park(size_t idx) {
+    m_workers[idx]->semaphore.wait();
+}
+
+bool Scheduler::stopping() {
+    return m_stopping && m_taskCount == 0;
+}
+
+bool Scheduler::hasTasks() const {
+    if(m_globalSize) {
+        return true;
+    }
+    for(auto& w : m_workers) {
+        if(w->inboxSize || w->yieldedSize || !w->deque.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Scheduler::Task* Scheduler::next(size_t idx) {
+    Worker& w = *m_workers[idx];
+    Task* task = nullptr;
+    if(w.inboxSize.load(std::memory_order_relaxed)) {
+        Spinlock::Lock lock(w.inboxMutex);
+        if(!w.inbox.empty()) {
+            task = w.inbox.front();
+            w.inbox.pop_front();
+            --w.inboxSize;
+            return task;
+        }
+    }
+
+    if(++w.tick == GLOBAL_CHECK_INTERVAL) {
+        w.tick = 0;
+        task = nextGlobal(idx);
+        if(task) {
+            return task;
+        }
+        task = nextYielded(w);
+        if(task) {
+            return task;
+        }
+    }
+
+    if(w.deque.pop(task)) {
+        return task;
+    }
+
+    task = nextGlobal(idx);
+    if(task) {
+        return task;
+    }
+
+    task = nextYielded(w);
+    if(task) {
+        return task;
+    }
+
+    size_t n = m_workers.size();
+    if(n > 1) {
+        // xorshift选起点, 避免所有线程都先偷同一个
+        w.seed ^= w.seed << 13;
+        w.seed ^= w.seed >> 17;
+        w.seed ^= w.seed << 5;
+        size_t start = w.seed % n;
+        for(size_t i = 0; i < n; ++i) {
+            size_t v = (start + i) % n;
+            if(v == idx) {
+                continue;
+            }
+            if(m_workers[v]->deque.steal(task)) {
+                return task;
+            }
+            task = nextYielded(*m_workers[v]);
+            if(task) {
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+Scheduler::Task* Scheduler::nextGlobal(size_t idx) {
+    if(!m_globalSize.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    Worker& w = *m_workers[idx];
+    Task* task = nullptr;
+    bool more = false;
+    {
+        MutexType::Lock lock(m_mutex);
+        if(!m_global.empty()) {
+            task = m_global.front();
+            m_global.pop_front();
+            size_t n = std::min(m_global.size() / m_workers.size(), GLOBAL_BATCH);
+            for(size_t i = 0; i < n; ++i) {
+                w.deque.push(m_global.front());
+                m_global.pop_front();
+            }
+            m_globalSize = m_global.size();
+            more = n > 0;
+        }
+    }
+    if(more) {
+        wakeAny();
+    }
+    return task;
+}
+
+Scheduler::Task* Scheduler::nextYielded(Worker& w) {
+    if(!w.yieldedSize.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    Spinlock::Lock lock(w.yieldedMutex);
+    if(w.yielded.empty()) {
+        return nullptr;
+    }
+    Task* task = w.yielded.front();
+    w.yielded.pop_front();
+    --w.yieldedSize;
+    return task;
+}
+
+void Scheduler::requeue(size_t idx, Fiber::ptr fiber, int thread) {
+    if(thread != -1) {
+        schedule(fiber, thread);
+        return;
+    }
+    ++m_taskCount;
+    Worker& w = *m_workers[idx];
+    {
+        Spinlock::Lock lock(w.yieldedMutex);
+        w.yielded.push_back(new Task(fiber, -1));
+        ++w.yieldedSize;
+    }
+    wakeAny();
+}
+
+void Scheduler::runTask(size_t idx, Task* task, Fiber::ptr& cb_fiber) {
+    Fiber::ptr fiber;
+    std::function<void()> cb;
+    int thread = task->thread;
+    fiber.swap(task->fiber);
+    cb.swap(task->cb);
+    delete task;
+
+    if(fiber) {
+        fiber->swapIn();
+        if(fiber->getState() == Fiber::READY) {
+            requeue(idx, fiber, thread);
+        }
+        // HOLD: 由持有者再次调度
+    } else if(cb) {
+        if(cb_fiber) {
+            cb_fiber->reset(std::move(cb));
+        } else {
+            cb_fiber.reset(new Fiber(std::move(cb)));
+        }
+        cb_fiber->swapIn();
+        Fiber::State state = cb_fiber->getState();
+        if(state == Fiber::READY) {
+            requeue(idx, cb_fiber, thread);
+            cb_fiber.reset();
+        } else if(state != Fiber::TERM && state != Fiber::EXCEPT) {
+            // HOLD: 可能已经被别的线程调度, 不能复用
+            cb_fiber.reset();
+        }
+    }
+
+    if(m_taskCount.fetch_sub(1) == 1 && m_stopping) {
+        wakeAll();
+    }
+}
+
+void Scheduler::run(size_t idx) {
+    GAMESERVER_LOG_DEBUG(g_logger) << m_name << " run worker " << idx;
+    setThis();
+    t_worker_index = idx;
+    onWorkerStart(idx);
+    Worker& w = *m_workers[idx];
+    Fiber::ptr cb_fiber;
+    uint32_t spins = 0;
+    uint32_t ran = 0;
+    while(true) {
+        Task* task = next(idx);
+        if(task) {
+            spins = 0;
+            runTask(idx, task, cb_fiber);
+            if(++ran == BUSY_POLL_INTERVAL) {
+                ran = 0;
+                busyPoll(idx);
+            }
+            continue;
+        }
+        if(ran) {
+            // 任务刚做完, 自旋之前先不阻塞地收一次外部事件, 等待的协程可能已经就绪
+            ran = 0;
+            busyPoll(idx);
+            continue;
+        }
+        if(stopping()) {
+            break;
+        }
+        if(spins < m_spinCount) {
+            ++spins;
+            cpu_relax();
+            continue;
+        }
+        if(spins < m_spinCount + YIELD_COUNT) {
+            ++spins;
+            sched_yield();
+            continue;
+        }
+
+        w.sleeping.store(true);
+        ++m_idleThreadCount;
+        // 和wakeAny()配对, 设置休眠标记后再检查一次
+        if(hasTasks() || stopping()) {
+            if(w.sleeping.exchange(false)) {
+                --m_idleThreadCount;
+            }
+            spins = 0;
+            continue;
+        }
+        park(idx);
+        if(w.sleeping.exchange(false)) {
+            --m_idleThreadCount;
+        }
+        spins = 0;
+    }
+    // 子类的stopping()可能不经过任务完成就变为true, 叫醒其他线程自己检查
+    wakeAll();
+    onWorkerStop(idx);
+    GAMESERVER_LOG_DEBUG(g_logger) << m_name << " worker " << idx << " exit";
+}
+
+}
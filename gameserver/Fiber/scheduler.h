@@ -0,0 +1,288 @@
+#ifndef __GAMESERVER_SCHEDULER_H__
+#define __GAMESERVER_SCHEDULER_H__
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <string>
+#include <atomic>
+#include <functional>
+#include "fiber.h"
+#include "work_steal_queue.h"
+#include "Thread/thread.h"
+#include "Thread/mutex.h"
+
+namespace gameserver{
+
+/**
+ * @brief 协程调度器
+ * @details N个工作线程执行协程或函数, 每个工作线程有:
+ *          一个工作窃取队列(WorkStealQueue), 工作线程里调度的任务放进自己的队列, 不加锁;
+ *          一个收件箱, 指定线程的任务放在这里, 不会被别的线程偷走.
+ *          非工作线程调度的任务放进全局队列.
+ *          工作线程按 收件箱 -> 自己的队列 -> 全局队列 -> 自己让出的协程 -> 随机偷别人的队列 的顺序找任务,
+ *          都没有时先自旋, 再sched_yield, 最后休眠(park), 有新任务时只在有线程休眠时才唤醒(tickle).
+ *          线程id和协程id由Thread和Fiber的线程缓存提供, 日志里可以直接看到.
+ *          use_caller为true时调用构造函数的线程也是工作线程(0号), 在stop()里参与调度
+ */
+class Scheduler {
+public:
+    typedef std::shared_ptr<Scheduler> ptr;
+    typedef Mutex MutexType;
+
+    /**
+     * @brief 构造函数
+     * @param[in] threads 线程数量
+     * @param[in] use_caller 是否使用当前调用线程
+     * @param[in] name 调度器名称, 也是工作线程名称的前缀
+     */
+    Scheduler(size_t threads = 1, bool use_caller = true, const std::string& name = "");
+    virtual ~Scheduler();
+
+    const std::string& getName() const { return m_name;}
+
+    /**
+     * @brief 工作线程数(含调用线程)
+     */
+    size_t getThreadCount() const { return m_workers.size();}
+
+    /**
+     * @brief 工作线程的内核线程id, 用于schedule()指定线程
+     */
+    std::vector<int> getThreadIds() const;
+
+    /**
+     * @brief 工作线程绑定CPU(第i个线程绑到i % CPU数), start()之前设置
+     */
+    void setCpuAffinity(bool v) { m_affinity = v;}
+
+    /**
+     * @brief 自旋多少轮没有任务后休眠, start()之前设置
+     */
+    void setSpinCount(uint32_t v) { m_spinCount = v;}
+
+    /**
+     * @brief 启动工作线程
+     */
+    void start();
+
+    /**
+     * @brief 停止, 等所有已调度的任务执行完
+     */
+    void stop();
+
+    /**
+     * @brief 调度协程或函数
+     * @param[in] fc 协程(Fiber::ptr)或函数
+     * @param[in] thread 执行的线程id, -1为任意线程
+     */
+    template<class FiberOrCb>
+    void schedule(FiberOrCb fc, int thread = -1) {
+        push(new Task(fc, thread));
+    }
+
+    /**
+     * @brief 批量调度协程或函数, 都可以在任意线程执行
+     */
+    template<class InputIterator>
+    void schedule(InputIterator begin, InputIterator end) {
+        while(begin != end) {
+            push(new Task(*begin, -1));
+            ++begin;
+        }
+    }
+
+    /**
+     * @brief 是否有线程在休眠
+     */
+    bool hasIdleThreads() const { return m_idleThreadCount > 0;}
+public:
+    /**
+     * @brief 当前线程所在的调度器
+     */
+    static Scheduler* GetThis();
+
+    /**
+     * @brief 当前线程在所在调度器中的编号, 不是工作线程时为-1
+     */
+    static int GetWorkerIndex();
+protected:
+    /**
+     * @brief 唤醒休眠中的idx号工作线程, 子类重写时与park()配合
+     */
+    virtual void tickle(size_t idx);
+
+    /**
+     * @brief idx号工作线程没有任务时休眠, 直到被tickle(idx)唤醒
+     * @details 可以提前返回(超时, 有IO事件), 调度器会重新找任务
+     */
+    virtual void park(size_t idx);
+
+    /**
+     * @brief 是否可以停止(已调用stop()且没有未完成的任务)
+     */
+    virtual bool stopping();
+
+    /**
+     * @brief idx号工作线程连续执行任务时, 每执行BUSY_POLL_INTERVAL个任务调用一次, 任务做完转入空闲时也调用一次
+     * @details 子类在这里不阻塞地收取外部事件, 任务一直不断时也不会饿死IO, 协程间互相等待时不必先休眠
+     */
+    virtual void busyPoll(size_t idx) {}
+
+    /**
+     * @brief idx号工作线程进入/退出调度主循环时在该线程上调用, 子类设置线程局部状态
+     */
+    virtual void onWorkerStart(size_t idx) {}
+    virtual void onWorkerStop(size_t idx) {}
+
+    /**
+     * @brief 调度主循环, 在工作线程(或use_caller时的根协程)上执行
+     */
+    void run(size_t idx);
+
+    /**
+     * @brief 设置当前线程的调度器
+     */
+    void setThis();
+
+    /**
+     * @brief 是否还有任务(任意队列)
+     */
+    bool hasTasks() const;
+
+    /**
+     * @brief 唤醒一个休眠的线程
+     */
+    void wakeAny();
+
+    /**
+     * @brief 唤醒所有休眠的线程
+     */
+    void wakeAll();
+private:
+    /**
+     * @brief 任务: 协程或函数, 以及指定的线程
+     */
+    struct Task {
+        Fiber::ptr fiber;
+        std::function<void()> cb;
+        int thread;
+
+        Task(Fiber::ptr f, int thr)
+            :fiber(f), thread(thr) {
+        }
+
+        Task(std::function<void()> f, int thr)
+            :cb(f), thread(thr) {
+        }
+    };
+
+    /**
+     * @brief 工作线程的状态
+     */
+    struct Worker {
+        /// 工作窃取队列, 只有本线程push/pop
+        WorkStealQueue<Task*> deque;
+        /// 指定本线程的任务
+        Spinlock inboxMutex;
+        std::deque<Task*> inbox;
+        std::atomic<size_t> inboxSize {0};
+        /// 本线程上YieldToReady的任务, 先进先出; 其他线程也能偷
+        Spinlock yieldedMutex;
+        std::deque<Task*> yielded;
+        std::atomic<size_t> yieldedSize {0};
+        /// next()调用次数, 定期先看全局队列
+        uint32_t tick = 0;
+        /// 是否在休眠, 唤醒方把它从true改为false后负责tickle
+        std::atomic<bool> sleeping {false};
+        /// park/tickle用的信号量
+        Semaphore semaphore;
+        /// 内核线程id
+        std::atomic<int> id {-1};
+        /// 线程
+        Thread::ptr thread;
+        /// 选择窃取对象的随机数状态
+        uint32_t seed = 0;
+        char pad[64];
+    };
+
+    /**
+     * @brief 放入任务并按需唤醒
+     */
+    void push(Task* task);
+
+    /**
+     * @brief idx号线程取下一个任务
+     */
+    Task* next(size_t idx);
+
+    /**
+     * @brief 从全局队列取一个任务, 顺便搬一批到idx号线程的队列
+     */
+    Task* nextGlobal(size_t idx);
+
+    /**
+     * @brief 取w的yielded队列队头, w可以是其他线程
+     */
+    Task* nextYielded(Worker& w);
+
+    /**
+     * @brief 唤醒idx号线程(如果在休眠)
+     * @return 是否由本次调用唤醒
+     */
+    bool wake(size_t idx);
+
+    /**
+     * @brief 执行任务, cb_fiber用来执行函数任务, 执行完可复用
+     */
+    void runTask(size_t idx, Task* task, Fiber::ptr& cb_fiber);
+
+    /**
+     * @brief 执行后仍为READY的协程重新入队
+     * @details 不指定线程的放进本线程的yielded队列末尾: 不进LIFO的工作窃取队列, 一个反复让出的协程
+     *          不会总是被立刻取回而饿死其他任务; yielded队列每GLOBAL_CHECK_INTERVAL次必看,
+     *          其他线程也能偷走, 一直有任务自我调度时让出的协程也能继续执行
+     */
+    void requeue(size_t idx, Fiber::ptr fiber, int thread);
+
+    /**
+     * @brief 工作线程入口
+     */
+    void threadMain(size_t idx);
+
+    /**
+     * @brief 线程id对应的工作线程编号, 没有时为-1
+     */
+    int indexOf(int thread) const;
+private:
+    /// 调度器名称
+    std::string m_name;
+    /// 工作线程
+    std::vector<std::unique_ptr<Worker> > m_workers;
+    /// 全局队列, 非工作线程调度的任务
+    MutexType m_mutex;
+    std::deque<Task*> m_global;
+    std::atomic<size_t> m_globalSize {0};
+    /// use_caller时调用线程的根协程, 执行run(0)
+    Fiber::ptr m_rootFiber;
+    /// use_caller时调用线程的id
+    int m_rootThread = -1;
+    /// 是否绑定CPU
+    bool m_affinity = false;
+    /// 休眠前自旋轮数
+    uint32_t m_spinCount = 64;
+    /// 是否已启动
+    bool m_started = false;
+    /// 未完成的任务数(排队中和执行中)
+    std::atomic<size_t> m_taskCount {0};
+    /// 休眠中的线程数
+    std::atomic<size_t> m_idleThreadCount {0};
+    /// 唤醒时轮流选择的起点
+    std::atomic<uint32_t> m_wakeCursor {0};
+    /// 是否正在停止
+    std::atomic<bool> m_stopping {false};
+};
+
+}
+
+#endif
@@ -0,0 +1,174 @@
+#include "stack.h"
+#include "Thread/mutex.h"
+#include <atomic>
+#include <vector>
+#include <new>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace gameserver{
+
+namespace {
+
+struct Stack {
+    void* stack;
+    size_t size;
+};
+
+/// 线程缓存上限
+std::atomic<size_t> s_thread_limit(StackPool::DEFAULT_THREAD_CACHE);
+/// 全局缓存上限
+std::atomic<size_t> s_global_limit(StackPool::DEFAULT_GLOBAL_CACHE);
+/// 映射着的栈数
+std::atomic<size_t> s_mapped(0);
+/// mmap次数
+std::atomic<uint64_t> s_map_count(0);
+
+size_t PageSize() {
+    static const size_t s_page = sysconf(_SC_PAGESIZE);
+    return s_page;
+}
+
+void* MapStack(size_t size) {
+    size_t page = PageSize();
+    void* base = mmap(nullptr, size + page, PROT_READ | PROT_WRITE
+                      ,MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if(base == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    // 栈向低地址增长, 保护页放在最低处
+    if(mprotect(base, page, PROT_NONE)) {
+        munmap(base, size + page);
+        throw std::bad_alloc();
+    }
+    s_mapped.fetch_add(1, std::memory_order_relaxed);
+    s_map_count.fetch_add(1, std::memory_order_relaxed);
+    return (char*)base + page;
+}
+
+void UnmapStack(void* stack, size_t size) {
+    size_t page = PageSize();
+    munmap((char*)stack - page, size + page);
+    s_mapped.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 全局缓存
+ */
+class GlobalCache {
+public:
+    bool pop(size_t size, Stack& out) {
+        Spinlock::Lock lock(m_mutex);
+        for(size_t i = m_stacks.size(); i > 0; --i) {
+            if(m_stacks[i - 1].size == size) {
+                out = m_stacks[i - 1];
+                m_stacks[i - 1] = m_stacks.back();
+                m_stacks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool push(const Stack& stack) {
+        Spinlock::Lock lock(m_mutex);
+        if(m_stacks.size() >= s_global_limit.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        m_stacks.push_back(stack);
+        return true;
+    }
+
+    size_t size() {
+        Spinlock::Lock lock(m_mutex);
+        return m_stacks.size();
+    }
+private:
+    Spinlock m_mutex;
+    std::vector<Stack> m_stacks;
+};
+
+GlobalCache& GetGlobalCache() {
+    // 不析构, 其他静态对象析构时还可能释放协程
+    static GlobalCache* s_cache = new GlobalCache;
+    return *s_cache;
+}
+
+/**
+ * @brief 线程缓存, 线程退出时交给全局缓存
+ */
+struct ThreadCache {
+    std::vector<Stack> stacks;
+    static thread_local bool t_dead;
+
+    ~ThreadCache() {
+        t_dead = true;
+        for(auto& s : stacks) {
+            if(!GetGlobalCache().push(s)) {
+                UnmapStack(s.stack, s.size);
+            }
+        }
+    }
+};
+
+thread_local bool ThreadCache::t_dead = false;
+
+ThreadCache* GetThreadCache() {
+    static thread_local ThreadCache t_cache;
+    // 线程退出时t_cache析构之后, 再析构的线程局部对象释放的栈直接走全局缓存
+    return ThreadCache::t_dead ? nullptr : &t_cache;
+}
+
+}
+
+void* StackPool::Alloc(size_t& size) {
+    size_t page = PageSize();
+    size = (size + page - 1) / page * page;
+    ThreadCache* cache = GetThreadCache();
+    if(cache) {
+        auto& stacks = cache->stacks;
+        for(size_t i = stacks.size(); i > 0; --i) {
+            if(stacks[i - 1].size == size) {
+                void* p = stacks[i - 1].stack;
+                stacks[i - 1] = stacks.back();
+                stacks.pop_back();
+                return p;
+            }
+        }
+    }
+    Stack s;
+    if(GetGlobalCache().pop(size, s)) {
+        return s.stack;
+    }
+    return MapStack(size);
+}
+
+void StackPool::Free(void* stack, size_t size) {
+    ThreadCache* cache = GetThreadCache();
+    if(cache && cache->stacks.size() < s_thread_limit.load(std::memory_order_relaxed)) {
+        cache->stacks.push_back(Stack{stack, size});
+        return;
+    }
+    if(!GetGlobalCache().push(Stack{stack, size})) {
+        UnmapStack(stack, size);
+    }
+}
+
+void StackPool::SetCacheLimit(size_t per_thread, size_t global) {
+    s_thread_limit.store(per_thread, std::memory_order_relaxed);
+    s_global_limit.store(global, std::memory_order_relaxed);
+}
+
+size_t StackPool::GetMapped() {
+    return s_mapped.load(std::memory_order_relaxed);
+}
+
+size_t StackPool::GetGlobalCached() {
+    return GetGlobalCache().size();
+}
+
+uint64_t StackPool::GetMapCount() {
+    return s_map_count.load(std::memory_order_relaxed);
+}
+
+}
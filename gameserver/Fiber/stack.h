@@ -0,0 +1,63 @@
+#ifndef __GAMESERVER_STACK_H__
+#define __GAMESERVER_STACK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace gameserver{
+
+/**
+ * @brief 协程栈池
+ * @details 栈用mmap分配, 低地址一侧多映射一页PROT_NONE的保护页, 栈溢出时立即SIGSEGV,
+ *          不会悄悄写坏相邻的内存. 只映射不写的页不占物理内存.
+ *          释放的栈先放回线程缓存, 满了再放回全局缓存(加锁), 都满了才munmap;
+ *          分配时按相同顺序找大小相同的栈. 稳定运行时创建协程不做系统调用
+ */
+class StackPool {
+public:
+    /// 默认栈大小
+    static const size_t DEFAULT_SIZE = 128 * 1024;
+    /// 每个线程默认最多缓存的栈数
+    static const size_t DEFAULT_THREAD_CACHE = 16;
+    /// 全局默认最多缓存的栈数
+    static const size_t DEFAULT_GLOBAL_CACHE = 256;
+
+    /**
+     * @brief 分配栈
+     * @param[in, out] size 栈大小, 向上取整到页大小
+     * @return 可用区域的低地址(保护页之上)
+     * @exception std::bad_alloc mmap失败
+     */
+    static void* Alloc(size_t& size);
+
+    /**
+     * @brief 释放栈
+     * @param[in] stack Alloc的返回值
+     * @param[in] size Alloc返回的大小
+     */
+    static void Free(void* stack, size_t size);
+
+    /**
+     * @brief 设置缓存上限, 0表示不缓存
+     */
+    static void SetCacheLimit(size_t per_thread, size_t global);
+
+    /**
+     * @brief 当前映射着的栈数(使用中的加缓存的)
+     */
+    static size_t GetMapped();
+
+    /**
+     * @brief 全局缓存中的栈数
+     */
+    static size_t GetGlobalCached();
+
+    /**
+     * @brief 进程启动以来mmap的次数
+     */
+    static uint64_t GetMapCount();
+};
+
+}
+
+#endif
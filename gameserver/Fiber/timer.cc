@@ -0,0 +1,358 @@
+#include "timer.h"
+#include "Util/macro.h"
+#include "Util/util.h"
+#include <string.h>
+#include <algorithm>
+
+namespace gameserver{
+
+Timer::Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager* manager)
+    :m_recurring(recurring)
+    ,m_ms(ms)
+    ,m_cb(cb)
+    ,m_manager(manager) {
+}
+
+bool Timer::cancel() {
+    // 在锁外释放
+    Timer::ptr self;
+    std::function<void()> cb;
+    TimerManager::MutexType::Lock lock(m_manager->m_mutex);
+    if(!m_self) {
+        return false;
+    }
+    m_manager->unlink(this);
+    --m_manager->m_count;
+    cb.swap(m_cb);
+    self.swap(m_self);
+    return true;
+}
+
+bool Timer::refresh() {
+    TimerManager::MutexType::Lock lock(m_manager->m_mutex);
+    if(!m_self) {
+        return false;
+    }
+    m_manager->unlink(this);
+    m_next = m_manager->nowMS() + m_ms;
+    m_manager->link(this);
+    return true;
+}
+
+bool Timer::reset(uint64_t ms, bool from_now) {
+    if(ms == m_ms && !from_now) {
+        return true;
+    }
+    bool at_front = false;
+    {
+        TimerManager::MutexType::Lock lock(m_manager->m_mutex);
+        if(!m_self) {
+            return false;
+        }
+        m_manager->unlink(this);
+        uint64_t start = from_now ? m_manager->nowMS() : m_next - m_ms;
+        m_ms = ms;
+        m_next = start + m_ms;
+        m_manager->link(this);
+        if(m_next < m_manager->m_nextWake) {
+            m_manager->m_nextWake = m_next;
+            at_front = true;
+        }
+    }
+    if(at_front) {
+        m_manager->onTimerInsertedAtFront();
+    }
+    return true;
+}
+
+TimerManager::TimerManager() {
+    memset(m_root, 0, sizeof(m_root));
+    memset(m_levels, 0, sizeof(m_levels));
+    memset(m_rootBitmap, 0, sizeof(m_rootBitmap));
+    memset(m_levelBitmap, 0, sizeof(m_levelBitmap));
+}
+
+TimerManager::~TimerManager() {
+    std::vector<Timer::ptr> timers;
+    {
+        MutexType::Lock lock(m_mutex);
+        for(size_t i = 0; i < ROOT_SIZE; ++i) {
+            for(Timer* t = m_root[i]; t; t = t->m_nextNode) {
+                timers.push_back(std::move(t->m_self));
+            }
+        }
+        for(int l = 0; l < LEVELS - 1; ++l) {
+            for(size_t i = 0; i < LEVEL_SIZE; ++i) {
+                for(Timer* t = m_levels[l][i]; t; t = t->m_nextNode) {
+                    timers.push_back(std::move(t->m_self));
+                }
+            }
+        }
+    }
+}
+
+uint64_t TimerManager::nowMS() {
+    return GetMonotonicMS();
+}
+
+Timer::ptr TimerManager::addTimer(uint64_t ms, std::function<void()> cb, bool recurring) {
+    Timer::ptr timer(new Timer(ms, cb, recurring, this));
+    bool at_front = false;
+    {
+        MutexType::Lock lock(m_mutex);
+        uint64_t now = nowMS();
+        timer->m_next = now + ms;
+        timer->m_self = timer;
+        if(!m_count && m_current < now) {
+            m_current = now;
+        }
+        at_front = insert(timer.get());
+    }
+    if(at_front) {
+        onTimerInsertedAtFront();
+    }
+    return timer;
+}
+
+Timer::ptr TimerManager::addConditionTimer(uint64_t ms, std::function<void()> cb
+                                    ,std::weak_ptr<void> cond, bool recurring) {
+    Timer::ptr timer(new Timer(ms, cb, recurring, this));
+    timer->m_hasCond = true;
+    timer->m_cond = cond;
+    bool at_front = false;
+    {
+        MutexType::Lock lock(m_mutex);
+        uint64_t now = nowMS();
+        timer->m_next = now + ms;
+        timer->m_self = timer;
+        if(!m_count && m_current < now) {
+            m_current = now;
+        }
+        at_front = insert(timer.get());
+    }
+    if(at_front) {
+        onTimerInsertedAtFront();
+    }
+    return timer;
+}
+
+Timer::ptr TimerManager::addFlushTimer(uint64_t ms, LogHandler::ptr handler) {
+    // 条件定时器执行回调时持有handler, 裸指针是安全的
+    LogHandler* h = handler.get();
+    return addConditionTimer(ms, [h]() {
+        h->flush();
+    }, handler, true);
+}
+
+bool TimerManager::insert(Timer* timer) {
+    link(timer);
+    ++m_count;
+    if(timer->m_next < m_nextWake) {
+        m_nextWake = timer->m_next;
+        return true;
+    }
+    return false;
+}
+
+void TimerManager::link(Timer* timer) {
+    uint64_t expires = std::max(timer->m_next, m_current);
+    uint64_t delta = expires - m_current;
+    Timer** head = nullptr;
+    if(delta < ROOT_SIZE) {
+        timer->m_level = 0;
+        timer->m_index = expires & (ROOT_SIZE - 1);
+        head = &m_root[timer->m_index];
+        m_rootBitmap[timer->m_index / 64] |= 1ull << (timer->m_index % 64);
+    } else {
+        // 超出范围的放在最高层, 下放时按真实到期时间重新计算
+        const uint64_t max_delta = (1ull << (ROOT_BITS + (LEVELS - 1) * LEVEL_BITS)) - 1;
+        if(delta > max_delta) {
+            expires = m_current + max_delta;
+            delta = max_delta;
+        }
+        int level = 1;
+        while(delta >= (1ull << (ROOT_BITS + level * LEVEL_BITS))) {
+            ++level;
+        }
+        timer->m_level = level;
+        timer->m_index = (expires >> (ROOT_BITS + (level - 1) * LEVEL_BITS)) & (LEVEL_SIZE - 1);
+        head = &m_levels[level - 1][timer->m_index];
+        m_levelBitmap[level - 1] |= 1ull << timer->m_index;
+    }
+    timer->m_prevNode = nullptr;
+    timer->m_nextNode = *head;
+    if(*head) {
+        (*head)->m_prevNode = timer;
+    }
+    *head = timer;
+}
+
+void TimerManager::unlink(Timer* timer) {
+    if(timer->m_level < 0) {
+        return;
+    }
+    Timer** head = timer->m_level == 0 ? &m_root[timer->m_index]
+                    : &m_levels[timer->m_level - 1][timer->m_index];
+    if(timer->m_prevNode) {
+        timer->m_prevNode->m_nextNode = timer->m_nextNode;
+    } else {
+        *head = timer->m_nextNode;
+    }
+    if(timer->m_nextNode) {
+        timer->m_nextNode->m_prevNode = timer->m_prevNode;
+    }
+    if(!*head) {
+        if(timer->m_level == 0) {
+            m_rootBitmap[timer->m_index / 64] &= ~(1ull << (timer->m_index % 64));
+        } else {
+            m_levelBitmap[timer->m_level - 1] &= ~(1ull << timer->m_index);
+        }
+    }
+    timer->m_level = -1;
+    timer->m_prevNode = nullptr;
+    timer->m_nextNode = nullptr;
+}
+
+void TimerManager::cascade(int level, size_t index) {
+    if(!(m_levelBitmap[level - 1] & (1ull << index))) {
+        return;
+    }
+    Timer* t = m_levels[level - 1][index];
+    m_levels[level - 1][index] = nullptr;
+    m_levelBitmap[level - 1] &= ~(1ull << index);
+    while(t) {
+        Timer* next = t->m_nextNode;
+        link(t);
+        t = next;
+    }
+}
+
+int TimerManager::findRoot(size_t from) const {
+    for(size_t w = from / 64; w < ROOT_SIZE / 64; ++w) {
+        uint64_t bits = m_rootBitmap[w];
+        if(w == from / 64) {
+            bits &= ~0ull << (from % 64);
+        }
+        if(bits) {
+            return w * 64 + __builtin_ctzll(bits);
+        }
+    }
+    return -1;
+}
+
+void TimerManager::tick(uint64_t now, std::vector<std::function<void()> >& cbs, std::vector<Timer::ptr>& dead) {
+    size_t idx = m_current & (ROOT_SIZE - 1);
+    if(idx == 0) {
+        // 第0层转完一圈, 依次下放上层的当前槽, 上层也转完一圈时继续往上
+        for(int level = 1; level < LEVELS; ++level) {
+            size_t index = (m_current >> (ROOT_BITS + (level - 1) * LEVEL_BITS)) & (LEVEL_SIZE - 1);
+            cascade(level, index);
+            if(index) {
+                break;
+            }
+        }
+    }
+    Timer* t = m_root[idx];
+    m_root[idx] = nullptr;
+    m_rootBitmap[idx / 64] &= ~(1ull << (idx % 64));
+    // 先推进, 循环定时器重新放入时不会落回正在处理的槽
+    ++m_current;
+    while(t) {
+        Timer* next = t->m_nextNode;
+        t->m_level = -1;
+        t->m_prevNode = nullptr;
+        t->m_nextNode = nullptr;
+        expire(t, now, cbs, dead);
+        t = next;
+    }
+}
+
+void TimerManager::expire(Timer* timer, uint64_t now, std::vector<std::function<void()> >& cbs, std::vector<Timer::ptr>& dead) {
+    if(timer->m_hasCond) {
+        std::shared_ptr<void> owner = timer->m_cond.lock();
+        if(!owner) {
+            --m_count;
+            dead.push_back(std::move(timer->m_self));
+            return;
+        }
+        std::function<void()> cb = timer->m_cb;
+        cbs.push_back([owner, cb]() {
+            cb();
+        });
+    } else if(timer->m_recurring) {
+        cbs.push_back(timer->m_cb);
+    } else {
+        cbs.push_back(std::move(timer->m_cb));
+    }
+
+    if(timer->m_recurring) {
+        timer->m_next = now + timer->m_ms;
+        link(timer);
+    } else {
+        --m_count;
+        timer->m_cb = nullptr;
+        dead.push_back(std::move(timer->m_self));
+    }
+}
+
+void TimerManager::listExpiredCbs(std::vector<std::function<void()> >& cbs) {
+    std::vector<Timer::ptr> dead;
+    MutexType::Lock lock(m_mutex);
+    uint64_t now = nowMS();
+    while(m_count && m_current <= now) {
+        size_t idx = m_current & (ROOT_SIZE - 1);
+        if(idx) {
+            // 跳过第0层的空槽, 最多跳到这一圈结束(需要下放)或now之后
+            int slot = findRoot(idx);
+            uint64_t next = slot >= 0 ? (m_current & ~(uint64_t)(ROOT_SIZE - 1)) + slot
+                                      : (m_current | (ROOT_SIZE - 1)) + 1;
+            if(next > m_current) {
+                m_current = std::min(next, now + 1);
+                continue;
+            }
+        }
+        tick(now, cbs, dead);
+    }
+    if(!m_count && m_current <= now) {
+        m_current = now + 1;
+    }
+    lock.unlock();
+}
+
+uint64_t TimerManager::getNextTimer() {
+    MutexType::Lock lock(m_mutex);
+    if(!m_count) {
+        m_nextWake = ~0ull;
+        return ~0ull;
+    }
+    uint64_t now = nowMS();
+    uint64_t next = m_current;
+    size_t idx = m_current & (ROOT_SIZE - 1);
+    if(idx) {
+        int slot = findRoot(idx);
+        if(slot >= 0) {
+            next = (m_current & ~(uint64_t)(ROOT_SIZE - 1)) + slot;
+        } else {
+            // 这一圈没有了, 到下一圈开始时要下放第1层的槽;
+            // 那个槽是空的(也不会连带下放更高层)时, 可以直接等到下一圈里最早的槽
+            next = (m_current | (ROOT_SIZE - 1)) + 1;
+            size_t index = (next >> ROOT_BITS) & (LEVEL_SIZE - 1);
+            slot = findRoot(0);
+            if(slot >= 0 && index && !(m_levelBitmap[0] & (1ull << index))) {
+                next += slot;
+            }
+        }
+    }
+    m_nextWake = next;
+    return next > now ? next - now : 0;
+}
+
+bool TimerManager::hasTimer() {
+    return m_count > 0;
+}
+
+size_t TimerManager::getTimerCount() {
+    return m_count;
+}
+
+}
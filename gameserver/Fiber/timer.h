@@ -0,0 +1,224 @@
+#ifndef __GAMESERVER_TIMER_H__
+#define __GAMESERVER_TIMER_H__
+
+#include <memory>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <stdint.h>
+#include "Thread/mutex.h"
+#include "Log/log.h"
+
+namespace gameserver{
+
+class TimerManager;
+
+/**
+ * @brief 定时器
+ * @details 由TimerManager::addTimer()创建. 在时间轮里时定时器持有自己(m_self),
+ *          用户不保留Timer::ptr也会按时执行; 挂在槽的侵入式双向链表上, 取消是O(1)
+ */
+class Timer : public std::enable_shared_from_this<Timer> {
+friend class TimerManager;
+public:
+    typedef std::shared_ptr<Timer> ptr;
+
+    /**
+     * @brief 取消定时器
+     * @return 定时器还在等待时返回true
+     */
+    bool cancel();
+
+    /**
+     * @brief 从现在起重新计时, 间隔不变
+     */
+    bool refresh();
+
+    /**
+     * @brief 重新设置间隔
+     * @param[in] ms 新的间隔(毫秒)
+     * @param[in] from_now 是否从现在开始计时, 否则从上次开始计时的时间算
+     */
+    bool reset(uint64_t ms, bool from_now);
+
+    /**
+     * @brief 到期时间(单调时钟毫秒)
+     */
+    uint64_t getNext() const { return m_next;}
+
+    /**
+     * @brief 间隔(毫秒)
+     */
+    uint64_t getInterval() const { return m_ms;}
+
+    bool isRecurring() const { return m_recurring;}
+private:
+    /**
+     * @brief 构造函数
+     * @param[in] ms 间隔
+     * @param[in] cb 回调
+     * @param[in] recurring 是否循环
+     * @param[in] manager 所属的TimerManager
+     */
+    Timer(uint64_t ms, std::function<void()> cb, bool recurring, TimerManager* manager);
+private:
+    /// 是否循环
+    bool m_recurring = false;
+    /// 是否是条件定时器
+    bool m_hasCond = false;
+    /// 间隔
+    uint64_t m_ms = 0;
+    /// 到期时间
+    uint64_t m_next = 0;
+    /// 回调
+    std::function<void()> m_cb;
+    /// 条件, 对象释放后定时器不再执行
+    std::weak_ptr<void> m_cond;
+    TimerManager* m_manager = nullptr;
+    /// 所在的层和槽, 不在时间轮里时m_level为-1
+    int m_level = -1;
+    uint32_t m_index = 0;
+    /// 槽里链表的前后节点
+    Timer* m_prevNode = nullptr;
+    Timer* m_nextNode = nullptr;
+    /// 在时间轮里时持有自己
+    Timer::ptr m_self;
+};
+
+/**
+ * @brief 定时器管理器, 分层时间轮
+ * @details 时间单位1毫秒. 第0层256个槽, 每槽1毫秒; 第1到4层各64个槽,
+ *          每槽是下一层转一圈的时间, 总共覆盖2^32毫秒(约49天), 更远的定时器放在最高层, 到时再下放.
+ *          添加和取消都是O(1), 每个定时器从高层下放(cascade)最多4次.
+ *          每层用位图记录非空的槽, 推进时间和计算下次到期时跳过空槽.
+ *          线程安全, 回调在锁外执行
+ */
+class TimerManager {
+friend class Timer;
+public:
+    typedef Mutex MutexType;
+
+    TimerManager();
+    virtual ~TimerManager();
+
+    /**
+     * @brief 添加定时器
+     * @param[in] ms 间隔(毫秒)
+     * @param[in] cb 回调
+     * @param[in] recurring 是否循环
+     */
+    Timer::ptr addTimer(uint64_t ms, std::function<void()> cb, bool recurring = false);
+
+    /**
+     * @brief 添加条件定时器
+     * @details 到期时cond指向的对象已释放则不执行回调, 并删除定时器(循环的也不再继续);
+     *          执行回调期间持有该对象
+     * @param[in] cond 条件
+     */
+    Timer::ptr addConditionTimer(uint64_t ms, std::function<void()> cb
+                                ,std::weak_ptr<void> cond, bool recurring = false);
+
+    /**
+     * @brief 定时刷新日志Handler, Handler释放后定时器自动删除
+     * @details 补上FlushPolicy::intervalMs只在写入时检查的不足: 没有新日志时缓冲也会按时写出
+     */
+    Timer::ptr addFlushTimer(uint64_t ms, LogHandler::ptr handler);
+
+    /**
+     * @brief 距下一次需要推进时间轮的毫秒数
+     * @details 第0层有定时器时是最近那个的到期时间, 否则是第0层转完一圈(需要下放高层定时器)的时间;
+     *          没有定时器时返回~0ull
+     */
+    uint64_t getNextTimer();
+
+    /**
+     * @brief 推进到当前时间, 取出到期定时器的回调, 循环定时器重新计时
+     */
+    void listExpiredCbs(std::vector<std::function<void()> >& cbs);
+
+    /**
+     * @brief 是否有定时器
+     */
+    bool hasTimer();
+
+    /**
+     * @brief 定时器数量
+     */
+    size_t getTimerCount();
+protected:
+    /**
+     * @brief 有定时器插入到比上次getNextTimer()更早的位置时调用, 用于唤醒等待中的线程
+     */
+    virtual void onTimerInsertedAtFront() {}
+
+    /**
+     * @brief 当前时间(毫秒), 默认为单调时钟, 测试可以重写
+     */
+    virtual uint64_t nowMS();
+private:
+    /**
+     * @brief 放入时间轮, 调用方持有m_mutex
+     * @return 是否插到了上次计算的等待时间之前
+     */
+    bool insert(Timer* timer);
+
+    /**
+     * @brief 放进对应的槽, 调用方持有m_mutex
+     */
+    void link(Timer* timer);
+
+    /**
+     * @brief 从所在的槽里摘下, 调用方持有m_mutex
+     */
+    void unlink(Timer* timer);
+
+    /**
+     * @brief 把level层index槽的定时器重新放入(下放到低层), 调用方持有m_mutex
+     */
+    void cascade(int level, size_t index);
+
+    /**
+     * @brief 第0层从from开始第一个非空槽, 没有时返回-1
+     */
+    int findRoot(size_t from) const;
+
+    /**
+     * @brief 处理m_current这一毫秒: 需要时下放高层, 取出第0层到期的定时器, 调用方持有m_mutex
+     * @param[out] dead 删除的定时器, 调用方在锁外释放
+     */
+    void tick(uint64_t now, std::vector<std::function<void()> >& cbs, std::vector<Timer::ptr>& dead);
+
+    /**
+     * @brief 处理一个到期的定时器, 调用方持有m_mutex
+     */
+    void expire(Timer* timer, uint64_t now, std::vector<std::function<void()> >& cbs, std::vector<Timer::ptr>& dead);
+private:
+    /// 第0层槽数的位数
+    static const int ROOT_BITS = 8;
+    /// 第1到4层槽数的位数
+    static const int LEVEL_BITS = 6;
+    /// 层数
+    static const int LEVELS = 5;
+    static const size_t ROOT_SIZE = 1 << ROOT_BITS;
+    static const size_t LEVEL_SIZE = 1 << LEVEL_BITS;
+
+    MutexType m_mutex;
+    /// 第0层
+    Timer* m_root[ROOT_SIZE];
+    /// 第1到4层
+    Timer* m_levels[LEVELS - 1][LEVEL_SIZE];
+    /// 第0层非空槽的位图
+    uint64_t m_rootBitmap[ROOT_SIZE / 64];
+    /// 第1到4层非空槽的位图
+    uint64_t m_levelBitmap[LEVELS - 1];
+    /// 下一个要处理的毫秒, 之前的都已处理
+    uint64_t m_current = 0;
+    /// 上次getNextTimer()算出的唤醒时间, 早于它的新定时器需要onTimerInsertedAtFront()
+    uint64_t m_nextWake = ~0ull;
+    /// 定时器数量, 在锁内修改, hasTimer()不加锁读
+    std::atomic<size_t> m_count {0};
+};
+
+}
+
+#endif
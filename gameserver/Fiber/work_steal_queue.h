@@ -0,0 +1,162 @@
+#ifndef __GAMESERVER_WORK_STEAL_QUEUE_H__
+#define __GAMESERVER_WORK_STEAL_QUEUE_H__
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "Util/noncopyable.h"
+
+namespace gameserver{
+
+/**
+ * @brief 工作窃取队列(Chase-Lev)
+ * @details 只有所有者线程push/pop(在底部, 后进先出, 缓存热),
+ *          其他线程steal(在顶部, 先进先出), 都不加锁; 只有取最后一个元素时所有者和窃取者CAS竞争.
+ *          满了按2倍扩容, 旧数组可能还在被窃取者读, 保留到队列析构时释放.
+ *          内存序按 Lê, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models"
+ * @tparam T 元素类型, 需要能放进std::atomic(一般是指针)
+ */
+template<class T>
+class WorkStealQueue : Noncopyable {
+public:
+    /**
+     * @brief 构造函数
+     * @param[in] capacity 初始容量, 取整到2的幂
+     */
+    WorkStealQueue(size_t capacity = 256)
+        :m_top(0)
+        ,m_bottom(0) {
+        size_t cap = 1;
+        while(cap < capacity) {
+            cap <<= 1;
+        }
+        m_array.store(new Array(cap), std::memory_order_relaxed);
+    }
+
+    ~WorkStealQueue() {
+        delete m_array.load(std::memory_order_relaxed);
+        for(auto a : m_garbage) {
+            delete a;
+        }
+    }
+
+    /**
+     * @brief 所有者在底部放入
+     */
+    void push(T item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        Array* a = m_array.load(std::memory_order_relaxed);
+        if(b - t > (int64_t)a->capacity - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 所有者从底部取出
+     * @return 队列为空(或最后一个被窃取)时返回false
+     */
+    bool pop(T& item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* a = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        if(t > b) {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = a->get(b);
+        if(t == b) {
+            // 最后一个, 和窃取者竞争
+            bool won = m_top.compare_exchange_strong(t, t + 1
+                        ,std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 其他线程从顶部窃取
+     * @return 队列为空或竞争失败时返回false
+     */
+    bool steal(T& item) {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+        if(t >= b) {
+            return false;
+        }
+        Array* a = m_array.load(std::memory_order_acquire);
+        item = a->get(t);
+        return m_top.compare_exchange_strong(t, t + 1
+                    ,std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 元素个数, 并发修改时只是近似值
+     */
+    size_t size() const {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? (size_t)(b - t) : 0;
+    }
+
+    bool empty() const { return size() == 0;}
+private:
+    /**
+     * @brief 环形数组
+     */
+    struct Array {
+        size_t capacity;
+        size_t mask;
+        std::atomic<T>* items;
+
+        Array(size_t cap)
+            :capacity(cap)
+            ,mask(cap - 1)
+            ,items(new std::atomic<T>[cap]) {
+        }
+
+        ~Array() {
+            delete[] items;
+        }
+
+        void put(int64_t i, T v) {
+            items[i & mask].store(v, std::memory_order_relaxed);
+        }
+
+        T get(int64_t i) const {
+            return items[i & mask].load(std::memory_order_relaxed);
+        }
+    };
+
+    Array* grow(Array* a, int64_t t, int64_t b) {
+        Array* n = new Array(a->capacity * 2);
+        for(int64_t i = t; i < b; ++i) {
+            n->put(i, a->get(i));
+        }
+        m_garbage.push_back(a);
+        m_array.store(n, std::memory_order_release);
+        return n;
+    }
+private:
+    /// 顶部(窃取端)
+    std::atomic<int64_t> m_top;
+    char m_pad[64];
+    /// 底部(所有者端)
+    std::atomic<int64_t> m_bottom;
+    /// 当前数组
+    std::atomic<Array*> m_array;
+    /// 扩容前的数组, 只由所有者修改
+    std::vector<Array*> m_garbage;
+};
+
+}
+
+#endif
@@ -0,0 +1,387 @@
+#include "async_log.h"
+#include "Thread/thread.h"
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace gameserver{
+
+/**
+ * @brief 异步Handler的队列和后台线程
+ * @details 后台线程运行时持有自身的shared_ptr, 外层Handler先析构也不会悬空
+ */
+class AsyncLogWorker : public std::enable_shared_from_this<AsyncLogWorker> {
+public:
+    typedef std::shared_ptr<AsyncLogWorker> ptr;
+
+    /**
+     * @brief 队列中的一条日志
+     */
+    struct Item {
+        std::shared_ptr<Logger> logger;
+        LogLevel::Level level = LogLevel::UNKNOW;
+        /// 事件拷贝, 槽位复用时内容缓冲也复用
+        LogEvent event;
+        /// 被包装的Handler没有格式器时使用
+        LogFormatter::ptr formatter;
+
+        /**
+         * @brief 释放引用, 否则槽位会一直持有Logger
+         */
+        void clear() {
+            logger.reset();
+            formatter.reset();
+            event = LogEvent();
+        }
+    };
+
+    AsyncLogWorker(size_t capacity, AsyncLogHandler::OverflowPolicy policy, size_t batch)
+        :m_queue(capacity)
+        ,m_policy(policy)
+        ,m_batch(batch ? batch : 1)
+        ,m_sleeping(false)
+        ,m_blocked(0)
+        ,m_stopping(false)
+        ,m_flushRequest(0)
+        ,m_droppedNewest(0)
+        ,m_droppedOldest(0) {
+    }
+
+    void start() {
+        m_thread.reset(new Thread(std::bind(&AsyncLogWorker::run, this, shared_from_this()), "log_async"));
+    }
+
+    void push(const std::shared_ptr<Logger>& logger, LogLevel::Level level
+              ,const LogEvent& event, const LogFormatter::ptr& formatter);
+    void flush();
+    void stop();
+    void run(ptr self);
+
+    void addHandler(LogHandler::ptr handler) {
+        std::lock_guard<std::mutex> lock(m_handlersMutex);
+        m_handlers.push_back(handler);
+    }
+
+    void delHandler(LogHandler::ptr handler) {
+        std::lock_guard<std::mutex> lock(m_handlersMutex);
+        for(auto it = m_handlers.begin(); it != m_handlers.end(); ++it) {
+            if(*it == handler) {
+                m_handlers.erase(it);
+                break;
+            }
+        }
+    }
+
+    void clearHandler() {
+        std::lock_guard<std::mutex> lock(m_handlersMutex);
+        m_handlers.clear();
+    }
+
+    uint64_t getDroppedNewest() const { return m_droppedNewest;}
+    uint64_t getDroppedOldest() const { return m_droppedOldest;}
+    size_t getQueueSize() const { return m_queue.size();}
+private:
+    /**
+     * @brief 把一条日志交给被包装的Handler, 调用方持有m_handlersMutex
+     */
+    void dispatch(const std::shared_ptr<Logger>& logger, LogLevel::Level level
+                  ,const LogEvent& event, const LogFormatter::ptr& formatter);
+
+    /**
+     * @brief 处理并清理一个槽位, 调用方持有m_handlersMutex
+     */
+    void consume(Item& item) {
+        dispatch(item.logger, item.level, item.event, item.formatter);
+        item.clear();
+    }
+
+    /**
+     * @brief 刷新被包装的Handler, 调用方持有m_handlersMutex
+     */
+    void flushHandlers();
+
+    /**
+     * @brief 唤醒可能在休眠的后台线程
+     */
+    void notify();
+private:
+    /// 日志队列
+    RingQueue<Item> m_queue;
+    /// 队列满时的处理策略
+    AsyncLogHandler::OverflowPolicy m_policy;
+    /// 每批最多处理的日志数
+    size_t m_batch;
+    /// 被包装的Handler
+    std::list<LogHandler::ptr> m_handlers;
+    /// 保护m_handlers
+    std::mutex m_handlersMutex;
+    /// 后台线程
+    Thread::ptr m_thread;
+
+    /// 休眠/唤醒用的锁
+    std::mutex m_mutex;
+    /// 后台线程等待新日志
+    std::condition_variable m_cond;
+    /// 生产者等待队列空位(BLOCK)
+    std::condition_variable m_notFull;
+    /// 调用flush的线程等待写出完成
+    std::condition_variable m_flushed;
+    /// 后台线程是否在休眠
+    std::atomic<bool> m_sleeping;
+    /// 在等待空位的生产者数量
+    std::atomic<uint32_t> m_blocked;
+    /// 是否停止
+    std::atomic<bool> m_stopping;
+    /// 后台线程是否退出
+    bool m_stopped = false;
+
+    /// 请求刷新的序号
+    std::atomic<uint64_t> m_flushRequest;
+    /// 已完成刷新的序号
+    uint64_t m_flushDone = 0;
+
+    /// 被丢弃的新日志数
+    std::atomic<uint64_t> m_droppedNewest;
+    /// 被丢弃的旧日志数
+    std::atomic<uint64_t> m_droppedOldest;
+};
+
+void AsyncLogWorker::push(const std::shared_ptr<Logger>& logger, LogLevel::Level level
+                          ,const LogEvent& event, const LogFormatter::ptr& formatter) {
+    if(m_stopping) {
+        std::lock_guard<std::mutex> lock(m_handlersMutex);
+        dispatch(logger, level, event, formatter);
+        return;
+    }
+
+    auto fill = [&](Item& slot) {
+        slot.logger = logger;
+        slot.level = level;
+        slot.event = event;
+        slot.formatter = formatter;
+    };
+    if(!m_queue.tryEmplace(fill)) {
+        switch(m_policy) {
+            case AsyncLogHandler::DROP_NEWEST:
+                ++m_droppedNewest;
+                return;
+            case AsyncLogHandler::DROP_OLDEST:
+                do {
+                    if(m_queue.tryConsume([](Item& slot) { slot.clear();})) {
+                        ++m_droppedOldest;
+                    }
+                } while(!m_queue.tryEmplace(fill));
+                break;
+            case AsyncLogHandler::BLOCK:
+            default:
+                ++m_blocked;
+                while(!m_queue.tryEmplace(fill)) {
+                    if(m_stopping) {
+                        --m_blocked;
+                        std::lock_guard<std::mutex> lock(m_handlersMutex);
+                        dispatch(logger, level, event, formatter);
+                        return;
+                    }
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cond.notify_one();
+                    m_notFull.wait_for(lock, std::chrono::milliseconds(1));
+                }
+                --m_blocked;
+                break;
+        }
+    }
+    // 与stop()里的栅栏配对: 要么stop()最后的清空看到这条日志, 要么这里看到m_stopping, 自己清空
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_stopping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_handlersMutex);
+        while(m_queue.tryConsume([this](Item& slot) { consume(slot);})) {
+        }
+        return;
+    }
+    notify();
+}
+
+void AsyncLogWorker::notify() {
+    // 与run()里的休眠检查配对, 保证入队和m_sleeping的读写不会乱序
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(m_sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cond.notify_one();
+    }
+}
+
+void AsyncLogWorker::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if(m_stopped) {
+        lock.unlock();
+        std::lock_guard<std::mutex> hlock(m_handlersMutex);
+        flushHandlers();
+        return;
+    }
+    uint64_t req = ++m_flushRequest;
+    m_cond.notify_one();
+    m_flushed.wait(lock, [this, req]() {
+        return m_flushDone >= req || m_stopped;
+    });
+}
+
+void AsyncLogWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_stopping) {
+            return;
+        }
+        m_stopping = true;
+        m_cond.notify_one();
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(!m_thread || !m_thread->joinable()) {
+        return;
+    }
+    if(Thread::GetThis() == m_thread.get()) {
+        // 最后一个引用在后台线程上释放, 由后台线程写完剩余日志后自行退出, Thread析构时detach
+        return;
+    }
+    m_thread->join();
+
+    // 与stop并发入队的日志
+    std::lock_guard<std::mutex> lock(m_handlersMutex);
+    while(m_queue.tryConsume([this](Item& slot) { consume(slot);})) {
+    }
+    flushHandlers();
+}
+
+void AsyncLogWorker::dispatch(const std::shared_ptr<Logger>& logger, LogLevel::Level level
+                              ,const LogEvent& event, const LogFormatter::ptr& formatter) {
+    bool timed = MetricsSampleTick();
+    for(auto& i : m_handlers) {
+        // 被包装的Handler没有自己的格式器时用入队时的格式器, 不写进Handler, Logger换格式器后仍然跟随
+        i->meteredLog(logger, level, event, timed, formatter);
+    }
+}
+
+void AsyncLogWorker::flushHandlers() {
+    for(auto& i : m_handlers) {
+        i->flush();
+    }
+}
+
+void AsyncLogWorker::run(ptr self) {
+    auto consumer = [this](Item& slot) { consume(slot);};
+    while(true) {
+        // 先取刷新序号再清空队列, 之前入队的日志一定在本轮被写出
+        uint64_t req = m_flushRequest.load(std::memory_order_acquire);
+        size_t n = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_handlersMutex);
+            while(n < m_batch && m_queue.tryConsume(consumer)) {
+                ++n;
+            }
+        }
+        if(n && m_blocked) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_notFull.notify_all();
+        }
+        if(n == m_batch) {
+            continue;
+        }
+        if(!m_queue.empty()) {
+            // 有生产者占了槽位还没写完
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(req != m_flushDone) {
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> hlock(m_handlersMutex);
+                flushHandlers();
+            }
+            lock.lock();
+            m_flushDone = req;
+            m_flushed.notify_all();
+            continue;
+        }
+        if(m_stopping) {
+            break;
+        }
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_queue.empty() && !m_stopping
+                && m_flushRequest.load(std::memory_order_relaxed) == m_flushDone) {
+            m_cond.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> hlock(m_handlersMutex);
+        flushHandlers();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+    m_flushDone = m_flushRequest;
+    m_flushed.notify_all();
+}
+
+AsyncLogHandler::AsyncLogHandler(size_t capacity, OverflowPolicy policy, size_t batch)
+    :m_policy(policy)
+    ,m_worker(new AsyncLogWorker(capacity, policy, batch)) {
+    m_worker->start();
+}
+
+AsyncLogHandler::~AsyncLogHandler() {
+    stop();
+}
+
+void AsyncLogHandler::log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) {
+    if(level < getLevel()) {
+        return;
+    }
+    m_worker->push(logger, level, event, getFormatter());
+}
+
+void AsyncLogHandler::logWith(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event
+                              ,const LogFormatter::ptr& formatter) {
+    if(level < getLevel()) {
+        return;
+    }
+    LogFormatter::ptr fmt = getFormatter();
+    m_worker->push(logger, level, event, fmt ? fmt : formatter);
+}
+
+void AsyncLogHandler::flush() {
+    m_worker->flush();
+}
+
+void AsyncLogHandler::stop() {
+    m_worker->stop();
+}
+
+void AsyncLogHandler::addHandler(LogHandler::ptr handler) {
+    m_worker->addHandler(handler);
+}
+
+void AsyncLogHandler::delHandler(LogHandler::ptr handler) {
+    m_worker->delHandler(handler);
+}
+
+void AsyncLogHandler::clearHandler() {
+    m_worker->clearHandler();
+}
+
+uint64_t AsyncLogHandler::getDroppedNewest() const {
+    return m_worker->getDroppedNewest();
+}
+
+uint64_t AsyncLogHandler::getDroppedOldest() const {
+    return m_worker->getDroppedOldest();
+}
+
+size_t AsyncLogHandler::getQueueSize() const {
+    return m_worker->getQueueSize();
+}
+
+}
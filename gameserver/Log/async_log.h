@@ -0,0 +1,217 @@
+#ifndef __GAMESERVER_ASYNC_LOG_H__
+#define __GAMESERVER_ASYNC_LOG_H__
+
+#include "log.h"
+#include <atomic>
+
+namespace gameserver{
+
+/**
+ * @brief 有界无锁环形队列(Vyukov)
+ * @details 每个槽位带一个序号, 生产者和消费者各自CAS推进位置,
+ *          多生产者单消费者使用; 也允许生产者在队满时弹出最旧元素
+ */
+template<class T>
+class RingQueue {
+public:
+    /**
+     * @brief 构造函数
+     * @param[in] capacity 容量, 向上取整到2的幂
+     */
+    RingQueue(size_t capacity) {
+        size_t cap = 2;
+        while(cap < capacity) {
+            cap <<= 1;
+        }
+        m_mask = cap - 1;
+        m_cells = new Cell[cap];
+        for(size_t i = 0; i < cap; ++i) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    ~RingQueue() {
+        delete[] m_cells;
+    }
+
+    /**
+     * @brief 入队, 队满返回false
+     */
+    bool tryPush(T&& v) {
+        return tryEmplace([&v](T& slot) { slot = std::move(v);});
+    }
+
+    /**
+     * @brief 出队, 队空返回false
+     */
+    bool tryPop(T& v) {
+        return tryConsume([&v](T& slot) { v = std::move(slot);});
+    }
+
+    /**
+     * @brief 在槽位上直接填充元素, 队满返回false
+     * @param[in] fill 填充函数 void(T& slot)
+     */
+    template<class F>
+    bool tryEmplace(F&& fill) {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for(;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if(dif == 0) {
+                if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(dif < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->data);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 在槽位上直接处理队首元素, 队空返回false
+     * @param[in] consume 处理函数 void(T& slot), 槽位随后被复用
+     */
+    template<class F>
+    bool tryConsume(F&& consume) {
+        Cell* cell;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for(;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if(dif == 0) {
+                if(m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if(dif < 0) {
+                return false;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        consume(cell->data);
+        cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 近似的元素个数
+     */
+    size_t size() const {
+        size_t e = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t d = m_dequeuePos.load(std::memory_order_relaxed);
+        return e > d ? e - d : 0;
+    }
+
+    bool empty() const { return size() == 0;}
+    size_t capacity() const { return m_mask + 1;}
+private:
+    RingQueue(const RingQueue&) = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+private:
+    /// 槽位数组
+    Cell* m_cells;
+    /// 容量掩码
+    size_t m_mask;
+    /// 入队位置
+    std::atomic<size_t> m_enqueuePos;
+    /// 填充, 入队位置和出队位置不在同一缓存行
+    char m_pad[64];
+    /// 出队位置
+    std::atomic<size_t> m_dequeuePos;
+};
+
+class AsyncLogWorker;
+
+/**
+ * @brief 异步输出的Handler
+ * @details 调用线程只把日志事件拷贝进无锁队列的预分配槽位, 由后台线程成批取出,
+ *          再交给被包装的Handler格式化和写出.
+ *          队列中的日志事件持有Logger, Logger又持有本Handler,
+ *          所以队列和后台线程放在单独的AsyncLogWorker里,
+ *          本Handler在后台线程上析构时也能安全退出
+ */
+class AsyncLogHandler : public LogHandler{
+public:
+    typedef std::shared_ptr<AsyncLogHandler> ptr;
+
+    /**
+     * @brief 队列满时的处理策略
+     */
+    enum OverflowPolicy {
+        /// 阻塞等待后台线程腾出位置
+        BLOCK = 0,
+        /// 丢弃新日志
+        DROP_NEWEST = 1,
+        /// 丢弃最旧的日志
+        DROP_OLDEST = 2
+    };
+
+    /**
+     * @brief 构造函数
+     * @param[in] capacity 队列容量
+     * @param[in] policy 队列满时的处理策略
+     * @param[in] batch 后台线程每批最多处理的日志数
+     */
+    AsyncLogHandler(size_t capacity = 8192, OverflowPolicy policy = BLOCK, size_t batch = 256);
+    ~AsyncLogHandler();
+
+    virtual void log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) override;
+
+    /**
+     * @brief 被另一个AsyncLogHandler包装时, 没有自己的格式器就把给定的格式器随日志入队
+     */
+    virtual void logWith(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event
+                         ,const LogFormatter::ptr& formatter) override;
+
+    /**
+     * @brief 等待已入队的日志全部写出, 并刷新被包装的Handler
+     */
+    virtual void flush() override;
+
+    void addHandler(LogHandler::ptr handler);
+    void delHandler(LogHandler::ptr handler);
+    void clearHandler();
+
+    /**
+     * @brief 写完队列中剩余的日志后停止后台线程
+     * @details 停止后的日志在调用线程上同步写出
+     */
+    void stop();
+
+    OverflowPolicy getPolicy() const { return m_policy;}
+    /// 被丢弃的新日志数
+    uint64_t getDroppedNewest() const;
+    /// 被丢弃的旧日志数
+    uint64_t getDroppedOldest() const;
+    /// 丢弃的日志总数
+    virtual uint64_t getDropped() const override { return getDroppedNewest() + getDroppedOldest();}
+    /// 当前队列中的日志数
+    size_t getQueueSize() const;
+    virtual size_t getQueueDepth() const override { return getQueueSize();}
+    virtual std::string getName() const override { return "async";}
+private:
+    /// 队列满时的处理策略
+    OverflowPolicy m_policy;
+    /// 队列和后台线程
+    std::shared_ptr<AsyncLogWorker> m_worker;
+};
+
+}
+
+#endif
@@ -0,0 +1,662 @@
+#include "binlog.h"
+#include "log_format.h"
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <stdlib.h>
+#include <string.h>
+
+namespace gameserver{
+
+/// 文件头
+static const char BINLOG_MAGIC[8] = {'G', 'S', 'B', 'I', 'N', 'L', 'O', 'G'};
+/// 文件格式版本
+static const uint32_t BINLOG_VERSION = 1;
+/// 调用点登记记录
+static const char RECORD_DICT = 'D';
+/// 一段事件
+static const char RECORD_CHUNK = 'C';
+
+namespace binlog{
+
+StagingBuffer::StagingBuffer(size_t size, uint32_t serial, uint32_t thread_id)
+    :m_dropped(0)
+    ,m_abandoned(false)
+    ,m_data((char*)malloc(size))
+    ,m_size(size)
+    ,m_serial(serial)
+    ,m_threadId(thread_id)
+    ,m_end(size)
+    ,m_producerPos(0)
+    ,m_consumerPos(0) {
+}
+
+StagingBuffer::~StagingBuffer() {
+    free(m_data);
+}
+
+char* StagingBuffer::reserve(size_t n) {
+    // 读写位置相等表示空, 所以写入后不能追上读位置
+    size_t w = m_producerPos.load(std::memory_order_relaxed);
+    size_t r = m_consumerPos.load(std::memory_order_acquire);
+    if(w >= r) {
+        if(w + n < m_size) {
+            m_reserved = w;
+            return m_data + w;
+        }
+        if(n < r) {
+            // 尾部放不下, 记下数据结尾后从头写
+            m_end.store(w, std::memory_order_relaxed);
+            m_reserved = 0;
+            return m_data;
+        }
+        return nullptr;
+    }
+    if(w + n < r) {
+        m_reserved = w;
+        return m_data + w;
+    }
+    return nullptr;
+}
+
+const char* StagingBuffer::peek(size_t& len) {
+    size_t r = m_consumerPos.load(std::memory_order_relaxed);
+    size_t w = m_producerPos.load(std::memory_order_acquire);
+    if(w < r) {
+        size_t end = m_end.load(std::memory_order_relaxed);
+        if(r < end) {
+            len = end - r;
+            return m_data + r;
+        }
+        r = 0;
+        m_consumerPos.store(0, std::memory_order_release);
+    }
+    len = w - r;
+    return m_data + r;
+}
+
+/**
+ * @brief 线程退出时标记本线程的环, 由BinLogWriter读完后回收
+ */
+struct ThreadBuffers {
+    ~ThreadBuffers() {
+        for(auto& i : items) {
+            i.second->m_abandoned = true;
+        }
+    }
+
+    std::vector<std::pair<uint64_t, StagingBuffer::ptr> > items;
+};
+
+static thread_local ThreadBuffers t_buffers;
+/// 最近一次使用的Writer编号和环, 常见情况只有一个Writer
+static thread_local uint64_t t_lastWriter = 0;
+static thread_local StagingBuffer* t_lastBuffer = nullptr;
+
+}
+
+/// 调用点表, 平凡类型, 零初始化, 不受静态初始化顺序影响
+static BinLogRegistry::Entry s_entries[BinLogRegistry::MAX_ENTRIES];
+static std::atomic<uint32_t> s_entryCount(0);
+static std::mutex s_registerMutex;
+
+uint32_t BinLogRegistry::Register(LogLevel::Level level, const char* fmt, const char* file, int32_t line) {
+    std::lock_guard<std::mutex> lock(s_registerMutex);
+    uint32_t id = s_entryCount.load(std::memory_order_relaxed);
+    if(id >= MAX_ENTRIES) {
+        return MAX_ENTRIES;
+    }
+    Entry& entry = s_entries[id];
+    entry.level = level;
+    entry.fmt = fmt;
+    entry.file = file;
+    entry.line = line;
+    entry.signature.store(nullptr, std::memory_order_relaxed);
+    s_entryCount.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+BinLogRegistry::Entry* BinLogRegistry::Get(uint32_t id) {
+    if(id >= s_entryCount.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &s_entries[id];
+}
+
+uint32_t BinLogRegistry::Count() {
+    return s_entryCount.load(std::memory_order_acquire);
+}
+
+static std::atomic<uint64_t> s_writerId(0);
+
+BinLogWriter::BinLogWriter(const std::string& filename, size_t buffer_size
+                           ,uint32_t flush_interval_ms)
+    :m_id(++s_writerId)
+    ,m_bufferSize(buffer_size)
+    ,m_interval(flush_interval_ms)
+    ,m_bytesWritten(0)
+    ,m_stopping(false)
+    ,m_rounds(0) {
+    m_file = fopen(filename.c_str(), "wb");
+    if(m_file) {
+        writeAll(BINLOG_MAGIC, sizeof(BINLOG_MAGIC));
+        writeAll(&BINLOG_VERSION, sizeof(BINLOG_VERSION));
+    }
+    m_thread.reset(new Thread(std::bind(&BinLogWriter::run, this), "log_binlog"));
+}
+
+BinLogWriter::~BinLogWriter() {
+    stop();
+}
+
+binlog::StagingBuffer* BinLogWriter::getBuffer() {
+    if(binlog::t_lastWriter == m_id) {
+        return binlog::t_lastBuffer;
+    }
+    binlog::StagingBuffer::ptr buf;
+    auto& items = binlog::t_buffers.items;
+    for(auto it = items.begin(); it != items.end();) {
+        if(it->first == m_id) {
+            buf = it->second;
+            ++it;
+        } else if(it->second.use_count() == 1) {
+            // Writer已经放弃了这个环
+            it = items.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if(!buf) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buf.reset(new binlog::StagingBuffer(m_bufferSize, m_nextSerial++, GetThreadId()));
+        m_buffers.push_back(buf);
+        items.push_back(std::make_pair(m_id, buf));
+    }
+    binlog::t_lastWriter = m_id;
+    binlog::t_lastBuffer = buf.get();
+    return buf.get();
+}
+
+void BinLogWriter::run() {
+    while(true) {
+        size_t n = drain();
+        ++m_rounds;
+        m_flushCond.notify_all();
+        if(n == 0) {
+            if(m_stopping) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            m_cond.wait_for(lock, std::chrono::milliseconds(m_interval));
+        }
+    }
+}
+
+void BinLogWriter::flush() {
+    // 等两轮: 正在进行的一轮可能在本次调用之前就读过环了
+    uint64_t target = m_rounds + 2;
+    std::unique_lock<std::mutex> lock(m_waitMutex);
+    m_cond.notify_one();
+    while(m_rounds < target && !m_stopping) {
+        m_flushCond.wait_for(lock, std::chrono::milliseconds(m_interval));
+        m_cond.notify_one();
+    }
+}
+
+void BinLogWriter::stop() {
+    if(!m_thread || !m_thread->joinable()) {
+        return;
+    }
+    m_stopping = true;
+    m_cond.notify_one();
+    m_thread->join();
+    if(m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(auto& i : m_buffers) {
+        m_droppedRetired += i->m_dropped;
+    }
+    m_buffers.clear();
+}
+
+uint64_t BinLogWriter::getDropped() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t v = m_droppedRetired;
+    for(auto& i : m_buffers) {
+        v += i->m_dropped;
+    }
+    return v;
+}
+
+void BinLogWriter::writeAll(const void* data, size_t len) {
+    if(m_file) {
+        fwrite(data, 1, len, m_file);
+        m_bytesWritten += len;
+    }
+}
+
+static void WriteString(std::string& out, const char* str) {
+    char tmp[10];
+    size_t len = strlen(str);
+    out.append(tmp, binlog::PutVarint(tmp, len) - tmp);
+    out.append(str, len);
+}
+
+void BinLogWriter::writeDictionary() {
+    uint32_t count = BinLogRegistry::Count();
+    if(m_dictWritten.size() < count) {
+        m_dictWritten.resize(count, false);
+    }
+    std::string out;
+    for(uint32_t i = 0; i < count; ++i) {
+        if(m_dictWritten[i]) {
+            continue;
+        }
+        BinLogRegistry::Entry* entry = BinLogRegistry::Get(i);
+        const char* sig = entry->signature.load(std::memory_order_acquire);
+        if(!sig) {
+            // 还没有写过日志的调用点, 不知道参数类型, 以后再写
+            continue;
+        }
+        uint8_t level = entry->level;
+        int32_t line = entry->line;
+        out.append(&RECORD_DICT, 1);
+        out.append((const char*)&i, sizeof(i));
+        out.append((const char*)&level, sizeof(level));
+        out.append((const char*)&line, sizeof(line));
+        WriteString(out, entry->file);
+        WriteString(out, entry->fmt);
+        WriteString(out, sig);
+        m_dictWritten[i] = true;
+    }
+    writeAll(out.data(), out.size());
+}
+
+size_t BinLogWriter::drain() {
+    struct Pending {
+        binlog::StagingBuffer::ptr buf;
+        const char* data;
+        size_t len;
+    };
+    std::vector<Pending> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto it = m_buffers.begin(); it != m_buffers.end();) {
+            binlog::StagingBuffer::ptr& buf = *it;
+            // 先读abandoned再peek, 线程退出前写的都能读到
+            bool abandoned = buf->m_abandoned;
+            size_t len = 0;
+            const char* data = buf->peek(len);
+            if(len) {
+                pending.push_back(Pending{buf, data, len});
+            } else if(abandoned) {
+                m_droppedRetired += buf->m_dropped;
+                it = m_buffers.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+    if(pending.empty()) {
+        return 0;
+    }
+    // 事件引用的调用点要先登记, 解码时才知道参数类型
+    writeDictionary();
+    size_t total = 0;
+    for(auto& i : pending) {
+        uint32_t serial = i.buf->getSerial();
+        uint32_t tid = i.buf->getThreadId();
+        uint32_t len = i.len;
+        writeAll(&RECORD_CHUNK, 1);
+        writeAll(&serial, sizeof(serial));
+        writeAll(&tid, sizeof(tid));
+        writeAll(&len, sizeof(len));
+        writeAll(i.data, i.len);
+        i.buf->consume(i.len);
+        total += i.len;
+    }
+    if(m_file) {
+        fflush(m_file);
+    }
+    return total;
+}
+
+namespace {
+
+/**
+ * @brief 从内存中读取事件
+ */
+class Reader {
+public:
+    Reader(const char* data, size_t len)
+        :m_cur(data)
+        ,m_end(data + len) {
+    }
+
+    bool varint(uint64_t& v) {
+        v = 0;
+        for(int shift = 0; shift < 64 && m_cur < m_end; shift += 7) {
+            uint8_t b = *m_cur++;
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if(!(b & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool raw(void* out, size_t len) {
+        if((size_t)(m_end - m_cur) < len) {
+            return false;
+        }
+        memcpy(out, m_cur, len);
+        m_cur += len;
+        return true;
+    }
+
+    bool string(std::string& out) {
+        uint64_t len;
+        if(!varint(len) || (uint64_t)(m_end - m_cur) < len) {
+            return false;
+        }
+        out.assign(m_cur, len);
+        m_cur += len;
+        return true;
+    }
+
+    bool done() const { return m_cur >= m_end;}
+private:
+    const char* m_cur;
+    const char* m_end;
+};
+
+/**
+ * @brief 解码后的参数
+ */
+struct DecodedArg {
+    char type;
+    uint64_t u;
+    double d;
+    std::string s;
+};
+
+struct DictEntry {
+    bool valid = false;
+    uint8_t level = 0;
+    int32_t line = 0;
+    std::string file;
+    std::string fmt;
+    std::string sig;
+};
+
+static bool ReadFileString(FILE* in, std::string& out) {
+    uint64_t len = 0;
+    for(int shift = 0; ; shift += 7) {
+        int c = fgetc(in);
+        if(c == EOF || shift >= 64) {
+            return false;
+        }
+        len |= (uint64_t)(c & 0x7f) << shift;
+        if(!(c & 0x80)) {
+            break;
+        }
+    }
+    out.resize(len);
+    return len == 0 || fread(&out[0], 1, len, in) == len;
+}
+
+/**
+ * @brief 取整数参数的值, 有符号整数按zigzag还原
+ */
+static uint64_t ArgToInt(const DecodedArg& arg) {
+    if(arg.type == binlog::ARG_INT) {
+        return (uint64_t)(-(int64_t)(arg.u & 1) ^ (int64_t)(arg.u >> 1));
+    }
+    if(arg.type == binlog::ARG_UINT) {
+        return arg.u;
+    }
+    return 0;
+}
+
+/**
+ * @brief 按原格式说明输出一个参数
+ * @details 整数按原长度修饰符截断后输出, 与直接printf的结果一致
+ */
+static void FormatArg(LogStream& os, std::string spec, const std::string& mod, char conv, const DecodedArg& arg) {
+    char buf[512];
+    int n = -1;
+    switch(conv) {
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c': {
+            if(arg.type == binlog::ARG_DOUBLE || arg.type == binlog::ARG_STRING) {
+                break;
+            }
+            bool is_signed = conv == 'd' || conv == 'i';
+            uint64_t v = ArgToInt(arg);
+            if(conv == 'c') {
+                n = snprintf(buf, sizeof(buf), (spec + conv).c_str(), (int)v);
+            } else if(mod == "hh") {
+                n = snprintf(buf, sizeof(buf), (spec + "hh" + conv).c_str()
+                             ,is_signed ? (int)(signed char)v : (int)(unsigned char)v);
+            } else if(mod == "h") {
+                n = snprintf(buf, sizeof(buf), (spec + "h" + conv).c_str()
+                             ,is_signed ? (int)(short)v : (int)(unsigned short)v);
+            } else if(mod.empty()) {
+                if(is_signed) {
+                    n = snprintf(buf, sizeof(buf), (spec + conv).c_str(), (int)v);
+                } else {
+                    n = snprintf(buf, sizeof(buf), (spec + conv).c_str(), (unsigned)v);
+                }
+            } else {
+                // l ll z j t q 在64位下都是64位
+                if(is_signed) {
+                    n = snprintf(buf, sizeof(buf), (spec + "ll" + conv).c_str(), (long long)v);
+                } else {
+                    n = snprintf(buf, sizeof(buf), (spec + "ll" + conv).c_str(), (unsigned long long)v);
+                }
+            }
+            break;
+        }
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if(arg.type == binlog::ARG_DOUBLE) {
+                n = snprintf(buf, sizeof(buf), (spec + conv).c_str(), arg.d);
+            }
+            break;
+        case 's':
+            if(arg.type == binlog::ARG_STRING) {
+                if(spec == "%") {
+                    os.append(arg.s);
+                    return;
+                }
+                n = snprintf(buf, sizeof(buf), (spec + conv).c_str(), arg.s.c_str());
+            }
+            break;
+        case 'p':
+            if(arg.type == binlog::ARG_POINTER) {
+                n = snprintf(buf, sizeof(buf), (spec + conv).c_str(), (void*)(uintptr_t)arg.u);
+            }
+            break;
+        default:
+            break;
+    }
+    if(n < 0) {
+        os.append("<?>");
+    } else {
+        os.append(buf, std::min((size_t)n, sizeof(buf) - 1));
+    }
+}
+
+/**
+ * @brief 用登记的格式串和解码出的参数拼出日志内容
+ */
+static void FormatMessage(LogStream& os, const std::string& fmt, const std::vector<DecodedArg>& args) {
+    size_t argi = 0;
+    for(size_t i = 0; i < fmt.size(); ++i) {
+        if(fmt[i] != '%') {
+            os.append(fmt[i]);
+            continue;
+        }
+        if(i + 1 < fmt.size() && fmt[i + 1] == '%') {
+            os.append('%');
+            ++i;
+            continue;
+        }
+        // %[标志][宽度][.精度][长度]转换
+        std::string spec = "%";
+        size_t j = i + 1;
+        while(j < fmt.size() && strchr("-+ #0123456789.*", fmt[j])) {
+            if(fmt[j] != '*') {
+                spec.append(1, fmt[j++]);
+                continue;
+            }
+            // *宽度/*精度: 按printf的规则先消耗一个int参数
+            ++j;
+            int v = argi < args.size() ? (int)ArgToInt(args[argi++]) : 0;
+            if(spec[spec.size() - 1] == '.') {
+                if(v < 0) {
+                    // 负精度等于没给精度
+                    spec.resize(spec.size() - 1);
+                } else {
+                    spec += std::to_string(v);
+                }
+            } else if(v < 0) {
+                // 负宽度等于'-'标志加宽度
+                spec += "-" + std::to_string(-(int64_t)v);
+            } else {
+                spec += std::to_string(v);
+            }
+        }
+        std::string mod;
+        while(j < fmt.size() && strchr("hlLqjzt", fmt[j])) {
+            mod.append(1, fmt[j++]);
+        }
+        if(j >= fmt.size()) {
+            os.append(spec + mod);
+            break;
+        }
+        char conv = fmt[j];
+        i = j;
+        if(argi < args.size()) {
+            FormatArg(os, spec, mod, conv, args[argi++]);
+        } else {
+            os.append("<?>");
+        }
+    }
+}
+
+}
+
+int64_t BinLogDecoder::Decode(FILE* in, std::ostream& out) {
+    char magic[sizeof(BINLOG_MAGIC)];
+    uint32_t version = 0;
+    if(fread(magic, 1, sizeof(magic), in) != sizeof(magic)
+            || memcmp(magic, BINLOG_MAGIC, sizeof(magic))
+            || fread(&version, 1, sizeof(version), in) != sizeof(version)
+            || version != BINLOG_VERSION) {
+        return -1;
+    }
+
+    TimestampFormat time_format("%Y-%m-%d %H:%M:%S.%f");
+    std::vector<DictEntry> dict;
+    /// 每个环上一条事件的时间
+    std::map<uint32_t, uint64_t> last_time;
+    std::vector<char> chunk;
+    std::vector<DecodedArg> args;
+    LogStream line;
+    int64_t count = 0;
+    int tag;
+    while((tag = fgetc(in)) != EOF) {
+        if(tag == RECORD_DICT) {
+            uint32_t id;
+            DictEntry entry;
+            if(fread(&id, 1, sizeof(id), in) != sizeof(id)
+                    || fread(&entry.level, 1, sizeof(entry.level), in) != sizeof(entry.level)
+                    || fread(&entry.line, 1, sizeof(entry.line), in) != sizeof(entry.line)
+                    || !ReadFileString(in, entry.file)
+                    || !ReadFileString(in, entry.fmt)
+                    || !ReadFileString(in, entry.sig)
+                    || id >= BinLogRegistry::MAX_ENTRIES) {
+                return -1;
+            }
+            if(dict.size() <= id) {
+                dict.resize(id + 1);
+            }
+            entry.valid = true;
+            dict[id] = std::move(entry);
+        } else if(tag == RECORD_CHUNK) {
+            uint32_t serial, tid, len;
+            if(fread(&serial, 1, sizeof(serial), in) != sizeof(serial)
+                    || fread(&tid, 1, sizeof(tid), in) != sizeof(tid)
+                    || fread(&len, 1, sizeof(len), in) != sizeof(len)) {
+                return -1;
+            }
+            chunk.resize(len);
+            if(len && fread(&chunk[0], 1, len, in) != len) {
+                return -1;
+            }
+            uint64_t& last = last_time[serial];
+            Reader reader(chunk.data(), chunk.size());
+            while(!reader.done()) {
+                uint64_t id, delta, fid;
+                if(!reader.varint(id) || !reader.varint(delta) || !reader.varint(fid)
+                        || id >= dict.size() || !dict[id].valid) {
+                    return -1;
+                }
+                const DictEntry& entry = dict[id];
+                args.resize(entry.sig.size());
+                for(size_t i = 0; i < entry.sig.size(); ++i) {
+                    DecodedArg& arg = args[i];
+                    arg.type = entry.sig[i];
+                    bool ok = false;
+                    switch(arg.type) {
+                        case binlog::ARG_INT:
+                        case binlog::ARG_UINT:
+                        case binlog::ARG_POINTER:
+                            ok = reader.varint(arg.u);
+                            break;
+                        case binlog::ARG_DOUBLE:
+                            ok = reader.raw(&arg.d, sizeof(arg.d));
+                            break;
+                        case binlog::ARG_STRING:
+                            ok = reader.string(arg.s);
+                            break;
+                        default:
+                            break;
+                    }
+                    if(!ok) {
+                        return -1;
+                    }
+                }
+                last += delta;
+                line.clear();
+                time_format.format(line, last / 1000000, last % 1000000);
+                line << '\t' << tid << '\t' << fid
+                     << "\t[" << LogLevel::ToString((LogLevel::Level)entry.level) << "]\t"
+                     << entry.file << ':' << entry.line << '\t';
+                FormatMessage(line, entry.fmt, args);
+                line.append('\n');
+                out.write(line.data(), line.size());
+                ++count;
+            }
+        } else {
+            return -1;
+        }
+    }
+    return count;
+}
+
+}
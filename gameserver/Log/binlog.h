@@ -0,0 +1,480 @@
+#ifndef __GAMESERVER_BINLOG_H__
+#define __GAMESERVER_BINLOG_H__
+
+#include "log.h"
+#include "Util/util.h"
+#include "Thread/thread.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <type_traits>
+#include <stdio.h>
+
+/**
+ * @brief 二进制日志(延迟格式化)
+ * @details 调用点的格式串只在第一次执行时登记, 得到一个静态id;
+ *          之后每条日志只写 id, 时间, 协程id 和参数的原始字节(整数用varint),
+ *          格式化推迟到离线解码工具(binlog_decode)里做.
+ *
+ *          文件格式:
+ *          "GSBINLOG" u32版本
+ *          'D' u32 id, u8 级别, u32 行号, 文件名, 格式串, 参数类型串   (字符串都是varint长度+字节)
+ *          'C' u32 环编号, u32 线程id, u32 字节数, 事件...                         (一个线程的一段连续事件)
+ *          事件: varint id, varint 与本线程上一条事件的时间差(微秒), varint 协程id, 参数
+ */
+
+/**
+ * @brief 写一条二进制日志
+ * @param[in] writer BinLogWriter::ptr
+ * @param[in] level 日志级别
+ * @param[in] fmt printf格式串, 必须是字面量
+ * @details 参数最多20个; std::string按%s检查和记录
+ */
+#define GAMESERVER_BINLOG(writer, level, fmt, ...) \
+    do { \
+        if(false) { \
+            gameserver::binlog::CheckFormat(fmt GAMESERVER_BINLOG_PRINTF_ARGS( \
+                GAMESERVER_BINLOG_COUNT(0, ##__VA_ARGS__), ##__VA_ARGS__)); \
+        } \
+        if((writer)->isEnabled(level)) { \
+            static const uint32_t gs_binlog_id = \
+                gameserver::BinLogRegistry::Register(level, fmt, __FILE__, __LINE__); \
+            (writer)->log(gs_binlog_id, ##__VA_ARGS__); \
+        } \
+    } while(0)
+
+/**
+ * @brief 把参数逐个换成printf能检查的类型(std::string换成const char*), 交给CheckFormat
+ */
+#define GAMESERVER_BINLOG_PRINTF_ARGS(n, ...) GAMESERVER_BINLOG_CAT(GAMESERVER_BINLOG_ARGS_, n)(__VA_ARGS__)
+#define GAMESERVER_BINLOG_CAT(a, b) GAMESERVER_BINLOG_CAT_(a, b)
+#define GAMESERVER_BINLOG_CAT_(a, b) a##b
+/// 第一个参数是占位的0, 参数个数在宏展开时算出, 无参数时为0
+#define GAMESERVER_BINLOG_COUNT(...) GAMESERVER_BINLOG_COUNT_(__VA_ARGS__, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define GAMESERVER_BINLOG_COUNT_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, N, ...) N
+#define GAMESERVER_BINLOG_ARG(x) , gameserver::binlog::PrintfArg(x)
+#define GAMESERVER_BINLOG_ARGS_0()
+#define GAMESERVER_BINLOG_ARGS_1(a) GAMESERVER_BINLOG_ARG(a)
+#define GAMESERVER_BINLOG_ARGS_2(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_1(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_3(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_2(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_4(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_3(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_5(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_4(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_6(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_5(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_7(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_6(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_8(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_7(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_9(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_8(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_10(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_9(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_11(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_10(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_12(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_11(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_13(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_12(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_14(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_13(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_15(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_14(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_16(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_15(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_17(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_16(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_18(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_17(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_19(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_18(__VA_ARGS__)
+#define GAMESERVER_BINLOG_ARGS_20(a, ...) GAMESERVER_BINLOG_ARG(a) GAMESERVER_BINLOG_ARGS_19(__VA_ARGS__)
+
+#define GAMESERVER_BINLOG_DEBUG(writer, fmt, ...) GAMESERVER_BINLOG(writer, gameserver::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define GAMESERVER_BINLOG_INFO(writer, fmt, ...) GAMESERVER_BINLOG(writer, gameserver::LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define GAMESERVER_BINLOG_WARN(writer, fmt, ...) GAMESERVER_BINLOG(writer, gameserver::LogLevel::WARN, fmt, ##__VA_ARGS__)
+#define GAMESERVER_BINLOG_ERROR(writer, fmt, ...) GAMESERVER_BINLOG(writer, gameserver::LogLevel::ERROR, fmt, ##__VA_ARGS__)
+#define GAMESERVER_BINLOG_FATAL(writer, fmt, ...) GAMESERVER_BINLOG(writer, gameserver::LogLevel::FATAL, fmt, ##__VA_ARGS__)
+
+namespace gameserver{
+
+namespace binlog{
+
+/**
+ * @brief 只用于编译期检查格式串和参数是否匹配
+ */
+static inline void CheckFormat(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static inline void CheckFormat(const char* fmt, ...) {}
+
+/**
+ * @brief 格式检查时参数的类型, 除std::string外原样传给printf
+ */
+template<class T>
+inline const T& PrintfArg(const T& v) { return v;}
+inline const char* PrintfArg(const std::string& v) { return v.c_str();}
+
+/**
+ * @brief 参数类型码
+ */
+enum ArgType {
+    /// 有符号整数, zigzag varint
+    ARG_INT = 'i',
+    /// 无符号整数, varint
+    ARG_UINT = 'u',
+    /// 浮点数, 8字节
+    ARG_DOUBLE = 'd',
+    /// 字符串, varint长度 + 字节
+    ARG_STRING = 's',
+    /// 指针, varint
+    ARG_POINTER = 'p'
+};
+
+inline char* PutVarint(char* p, uint64_t v) {
+    while(v >= 0x80) {
+        *p++ = (char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (char)v;
+    return p;
+}
+
+inline uint64_t ZigZag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+/**
+ * @brief 参数编码, 按类型特化
+ * @details code 类型码; bound() 编码长度上限; encode() 写入并返回结尾
+ */
+template<class T, class Enable = void>
+struct Arg;
+
+template<class T>
+struct Arg<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type> {
+    static const char code = ARG_INT;
+    static size_t bound(T v) { return 10;}
+    static char* encode(char* p, T v) { return PutVarint(p, ZigZag(v));}
+};
+
+template<class T>
+struct Arg<T, typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type> {
+    static const char code = ARG_UINT;
+    static size_t bound(T v) { return 10;}
+    static char* encode(char* p, T v) { return PutVarint(p, v);}
+};
+
+template<class T>
+struct Arg<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+    static const char code = ARG_INT;
+    static size_t bound(T v) { return 10;}
+    static char* encode(char* p, T v) { return PutVarint(p, ZigZag((int64_t)v));}
+};
+
+template<class T>
+struct Arg<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static const char code = ARG_DOUBLE;
+    static size_t bound(T v) { return sizeof(double);}
+    static char* encode(char* p, T v) {
+        double d = v;
+        memcpy(p, &d, sizeof(d));
+        return p + sizeof(d);
+    }
+};
+
+template<class T>
+struct Arg<T*, typename std::enable_if<!std::is_same<typename std::remove_cv<T>::type, char>::value>::type> {
+    static const char code = ARG_POINTER;
+    static size_t bound(T* v) { return 10;}
+    static char* encode(char* p, T* v) { return PutVarint(p, (uintptr_t)v);}
+};
+
+template<class T>
+struct Arg<T*, typename std::enable_if<std::is_same<typename std::remove_cv<T>::type, char>::value>::type> {
+    static const char code = ARG_STRING;
+    static size_t bound(const char* v) { return 10 + (v ? strlen(v) : 6);}
+    static char* encode(char* p, const char* v) {
+        if(!v) {
+            v = "(null)";
+        }
+        size_t len = strlen(v);
+        p = PutVarint(p, len);
+        memcpy(p, v, len);
+        return p + len;
+    }
+};
+
+template<>
+struct Arg<std::string> {
+    static const char code = ARG_STRING;
+    static size_t bound(const std::string& v) { return 10 + v.size();}
+    static char* encode(char* p, const std::string& v) {
+        p = PutVarint(p, v.size());
+        memcpy(p, v.data(), v.size());
+        return p + v.size();
+    }
+};
+
+/**
+ * @brief 参数类型串, 每个调用点登记一次
+ */
+template<class... Args>
+struct Signature {
+    static const char* get() {
+        static const char s[] = {Arg<Args>::code..., '\0'};
+        return s;
+    }
+};
+
+inline size_t Bound() { return 0;}
+
+template<class T, class... Rest>
+size_t Bound(const T& v, const Rest&... rest) {
+    return Arg<typename std::decay<T>::type>::bound(v) + Bound(rest...);
+}
+
+inline char* Encode(char* p) { return p;}
+
+template<class T, class... Rest>
+char* Encode(char* p, const T& v, const Rest&... rest) {
+    return Encode(Arg<typename std::decay<T>::type>::encode(p, v), rest...);
+}
+
+/**
+ * @brief 单生产者单消费者的字节环
+ * @details 日志线程写, BinLogWriter的后台线程读, 每条事件在环里连续存放
+ */
+class StagingBuffer {
+public:
+    typedef std::shared_ptr<StagingBuffer> ptr;
+    StagingBuffer(size_t size, uint32_t serial, uint32_t thread_id);
+    ~StagingBuffer();
+
+    /**
+     * @brief 预留n字节连续空间, 空间不足返回nullptr
+     */
+    char* reserve(size_t n);
+
+    /**
+     * @brief 提交最近一次reserve写入的n字节
+     */
+    void commit(size_t n) {
+        m_producerPos.store(m_reserved + n, std::memory_order_release);
+    }
+
+    /**
+     * @brief 消费者取可读的一段
+     * @param[out] len 可读字节数
+     */
+    const char* peek(size_t& len);
+
+    /**
+     * @brief 消费者释放peek得到的len字节
+     */
+    void consume(size_t len) {
+        m_consumerPos.store(m_consumerPos.load(std::memory_order_relaxed) + len
+                            , std::memory_order_release);
+    }
+
+    uint32_t getSerial() const { return m_serial;}
+    uint32_t getThreadId() const { return m_threadId;}
+    size_t size() const { return m_size;}
+public:
+    /// 生产者使用: 本线程上一条事件的时间(微秒)
+    uint64_t m_lastTime = 0;
+    /// 写满丢弃的事件数
+    std::atomic<uint64_t> m_dropped;
+    /// 所属线程已退出, 读完后可回收
+    std::atomic<bool> m_abandoned;
+private:
+    /// 环形缓冲
+    char* m_data;
+    /// 缓冲大小
+    size_t m_size;
+    /// 环的编号, 解码时按它累加时间差
+    uint32_t m_serial;
+    /// 所属线程
+    uint32_t m_threadId;
+    /// 最近一次reserve的起点
+    size_t m_reserved = 0;
+    /// 回绕前的数据结尾
+    std::atomic<size_t> m_end;
+    /// 写位置
+    std::atomic<size_t> m_producerPos;
+    /// 填充, 读写位置不在同一缓存行
+    char m_pad[64];
+    /// 读位置
+    std::atomic<size_t> m_consumerPos;
+};
+
+}
+
+/**
+ * @brief 二进制日志调用点登记表
+ */
+class BinLogRegistry {
+public:
+    /// 最多登记的调用点
+    static const uint32_t MAX_ENTRIES = 65536;
+
+    struct Entry {
+        LogLevel::Level level;
+        const char* fmt;
+        const char* file;
+        int32_t line;
+        /// 参数类型串, 第一次写日志时设置
+        std::atomic<const char*> signature;
+    };
+
+    /**
+     * @brief 登记调用点, 返回id
+     */
+    static uint32_t Register(LogLevel::Level level, const char* fmt, const char* file, int32_t line);
+
+    /**
+     * @brief 取调用点, id无效返回nullptr
+     */
+    static Entry* Get(uint32_t id);
+
+    /**
+     * @brief 已登记的调用点数
+     */
+    static uint32_t Count();
+};
+
+/**
+ * @brief 二进制日志输出
+ * @details 每个线程一个StagingBuffer, 写日志只编码到本线程的环里;
+ *          后台线程轮询各线程的环, 成块写入文件.
+ *          环满时丢弃并计数, 不阻塞调用线程
+ */
+class BinLogWriter {
+public:
+    typedef std::shared_ptr<BinLogWriter> ptr;
+
+    /**
+     * @brief 构造函数
+     * @param[in] filename 输出文件
+     * @param[in] buffer_size 每个线程的环大小
+     * @param[in] flush_interval_ms 后台线程空闲时的轮询间隔
+     */
+    BinLogWriter(const std::string& filename, size_t buffer_size = 1 << 20
+                 ,uint32_t flush_interval_ms = 10);
+    ~BinLogWriter();
+
+    bool isEnabled(LogLevel::Level level) const { return level >= m_level.load(std::memory_order_relaxed);}
+    void setLevel(LogLevel::Level val) { m_level.store(val, std::memory_order_relaxed);}
+    LogLevel::Level getLevel() const { return (LogLevel::Level)m_level.load(std::memory_order_relaxed);}
+
+    /**
+     * @brief 写一条日志, 一般通过GAMESERVER_BINLOG调用
+     */
+    template<class... Args>
+    void log(uint32_t id, const Args&... args) {
+        BinLogRegistry::Entry* entry = BinLogRegistry::Get(id);
+        if(!entry) {
+            return;
+        }
+        if(!entry->signature.load(std::memory_order_relaxed)) {
+            entry->signature.store(binlog::Signature<typename std::decay<Args>::type...>::get()
+                                   ,std::memory_order_release);
+        }
+        binlog::StagingBuffer* buf = getBuffer();
+        uint64_t sec;
+        uint32_t usec;
+        GetCoarseTime(sec, usec);
+        uint64_t now = sec * 1000000 + usec;
+        char* p = buf->reserve(30 + binlog::Bound(args...));
+        if(!p) {
+            ++buf->m_dropped;
+            return;
+        }
+        char* begin = p;
+        p = binlog::PutVarint(p, id);
+        p = binlog::PutVarint(p, now - buf->m_lastTime);
+        p = binlog::PutVarint(p, GetFiberId());
+        p = binlog::Encode(p, args...);
+        buf->m_lastTime = now;
+        buf->commit(p - begin);
+    }
+
+    /**
+     * @brief 等待当前已提交的日志全部写入文件
+     */
+    void flush();
+
+    /**
+     * @brief 写完剩余日志后停止后台线程, 关闭文件
+     */
+    void stop();
+
+    /**
+     * @brief 环满丢弃的日志数
+     */
+    uint64_t getDropped();
+
+    /**
+     * @brief 已写入文件的字节数
+     */
+    uint64_t getBytesWritten() const { return m_bytesWritten;}
+private:
+    /**
+     * @brief 取本线程在本Writer上的环, 没有则创建
+     */
+    binlog::StagingBuffer* getBuffer();
+
+    /**
+     * @brief 后台线程主循环
+     */
+    void run();
+
+    /**
+     * @brief 把各线程环里的数据写入文件
+     * @return 写出的字节数
+     */
+    size_t drain();
+
+    /**
+     * @brief 写出还没写过的调用点登记
+     */
+    void writeDictionary();
+
+    void writeAll(const void* data, size_t len);
+private:
+    /// Writer的唯一编号, 线程缓存用它而不是指针作键
+    uint64_t m_id;
+    /// 级别, 写线程和setLevel并发访问
+    std::atomic<int> m_level {LogLevel::DEBUG};
+    /// 输出文件
+    FILE* m_file = nullptr;
+    /// 每个线程的环大小
+    size_t m_bufferSize;
+    /// 空闲轮询间隔
+    uint32_t m_interval;
+    /// 已写入的字节
+    std::atomic<uint64_t> m_bytesWritten;
+    /// 已回收的环丢弃的日志数
+    uint64_t m_droppedRetired = 0;
+    /// 保护m_buffers
+    std::mutex m_mutex;
+    /// 各线程的环
+    std::vector<binlog::StagingBuffer::ptr> m_buffers;
+    /// 下一个环的编号
+    uint32_t m_nextSerial = 0;
+    /// 已写出登记的调用点
+    std::vector<bool> m_dictWritten;
+    /// 后台线程
+    Thread::ptr m_thread;
+    /// 后台线程空闲等待
+    std::mutex m_waitMutex;
+    std::condition_variable m_cond;
+    /// flush等待一轮写出完成
+    std::condition_variable m_flushCond;
+    /// 是否停止
+    std::atomic<bool> m_stopping;
+    /// 完成的写出轮数, flush等待它前进
+    std::atomic<uint64_t> m_rounds;
+};
+
+/**
+ * @brief 二进制日志解码
+ */
+class BinLogDecoder {
+public:
+    /**
+     * @brief 解码一个文件, 每条日志输出一行文本
+     * @param[in] in 输入文件
+     * @param[in] out 文本输出
+     * @return 解码出的日志条数, 文件格式错误返回-1
+     */
+    static int64_t Decode(FILE* in, std::ostream& out);
+};
+
+}
+
+#endif
@@ -0,0 +1,403 @@
+#include "flight_recorder.h"
+#include "Util/util.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <algorithm>
+
+namespace gameserver{
+
+const size_t FlightRecorder::SLOT_SIZE;
+const size_t FlightRecorder::MESSAGE_SIZE;
+const int FlightRecorder::OFF;
+std::atomic<int> FlightRecorder::s_level(FlightRecorder::OFF);
+
+namespace {
+
+/**
+ * @brief 一条记录, 正好一个槽位
+ */
+struct Slot {
+    /// 写入中为奇数, 写完为 2 * (位置 + 1)
+    std::atomic<uint64_t> seq;
+    /// 时间(微秒)
+    uint64_t time;
+    /// 文件名, 指向__FILE__字面量
+    const char* file;
+    uint32_t threadId;
+    uint32_t fiberId;
+    int32_t line;
+    /// 消息原长, 大于MESSAGE_SIZE表示被截断
+    uint16_t len;
+    uint8_t level;
+    uint8_t pad;
+    char message[FlightRecorder::MESSAGE_SIZE];
+};
+
+static_assert(sizeof(Slot) == FlightRecorder::SLOT_SIZE, "flight recorder slot size");
+
+/**
+ * @brief 一个线程的环
+ */
+struct Ring {
+    /// 使用中的线程id, 0表示空闲
+    std::atomic<uint32_t> owner;
+    /// 槽位数
+    uint32_t capacity;
+    /// 下一个写入位置, 只有所属线程写
+    std::atomic<uint64_t> pos;
+    /// 链表下一个, 环只增不删
+    Ring* next;
+    Slot* slots;
+};
+
+/// 所有的环
+static std::atomic<Ring*> s_rings(nullptr);
+/// 新建环的槽位数
+static std::atomic<uint32_t> s_slots(1024);
+/// 转储文件
+static char s_path[512];
+/// 是否正在转储
+static std::atomic<bool> s_dumping(false);
+/// 本地时间与UTC的偏移(秒), 开启时取一次, 信号处理函数里不能调用localtime
+static std::atomic<int64_t> s_gmtoff(0);
+
+static Ring* ClaimRing() {
+    uint32_t tid = GetThreadId();
+    uint32_t slots = s_slots.load(std::memory_order_relaxed);
+    for(Ring* r = s_rings.load(std::memory_order_acquire); r; r = r->next) {
+        uint32_t expected = 0;
+        if(r->capacity == slots && r->owner.load(std::memory_order_relaxed) == 0
+                && r->owner.compare_exchange_strong(expected, tid, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+    Ring* r = new Ring;
+    r->owner.store(tid, std::memory_order_relaxed);
+    r->capacity = slots;
+    r->pos.store(0, std::memory_order_relaxed);
+    r->slots = new Slot[slots];
+    for(uint32_t i = 0; i < slots; ++i) {
+        r->slots[i].seq.store(0, std::memory_order_relaxed);
+    }
+    r->next = s_rings.load(std::memory_order_relaxed);
+    while(!s_rings.compare_exchange_weak(r->next, r, std::memory_order_release)) {
+    }
+    return r;
+}
+
+/// 是否已安装信号处理函数, 之后领取环的线程顺便设置备用信号栈
+static std::atomic<bool> s_installed(false);
+/// 每个线程备用信号栈的大小
+static const size_t ALTSTACK_SIZE = SIGSTKSZ * 4;
+
+/**
+ * @brief 线程退出时释放环和备用信号栈
+ */
+struct RingHolder {
+    Ring* ring = nullptr;
+    /// 本线程的备用信号栈, 没有设置过为nullptr
+    char* altstack = nullptr;
+    ~RingHolder() {
+        if(ring) {
+            ring->owner.store(0, std::memory_order_release);
+        }
+        if(altstack) {
+            // 先取消再释放, 之后的信号不会落到已释放的内存上
+            stack_t ss;
+            memset(&ss, 0, sizeof(ss));
+            ss.ss_flags = SS_DISABLE;
+            sigaltstack(&ss, nullptr);
+            delete[] altstack;
+        }
+    }
+};
+
+static thread_local RingHolder t_ring;
+
+/**
+ * @brief 给当前线程设置备用信号栈, 栈溢出的SIGSEGV需要它才能执行处理函数
+ * @details sigaltstack只对调用线程生效; 线程已经有备用栈(如别的库设置的)时不覆盖
+ */
+static void SetupAltStack() {
+    RingHolder& h = t_ring;
+    if(h.altstack) {
+        return;
+    }
+    stack_t old;
+    if(sigaltstack(nullptr, &old) == 0 && !(old.ss_flags & SS_DISABLE)) {
+        return;
+    }
+    h.altstack = new char[ALTSTACK_SIZE];
+    stack_t ss;
+    ss.ss_sp = h.altstack;
+    ss.ss_size = ALTSTACK_SIZE;
+    ss.ss_flags = 0;
+    if(sigaltstack(&ss, nullptr) != 0) {
+        delete[] h.altstack;
+        h.altstack = nullptr;
+    }
+}
+
+/**
+ * @brief 只用write的输出缓冲
+ */
+class DumpWriter {
+public:
+    DumpWriter(int fd)
+        :m_fd(fd) {
+    }
+
+    ~DumpWriter() {
+        flush();
+    }
+
+    void append(const char* data, size_t len) {
+        while(len) {
+            size_t n = std::min(len, sizeof(m_buf) - m_len);
+            memcpy(m_buf + m_len, data, n);
+            m_len += n;
+            data += n;
+            len -= n;
+            if(m_len == sizeof(m_buf)) {
+                flush();
+            }
+        }
+    }
+
+    void append(const char* str) { append(str, strlen(str));}
+
+    void append(char c) { append(&c, 1);}
+
+    /**
+     * @brief 十进制整数, 不足width位补0
+     */
+    void appendUInt(uint64_t v, int width = 0) {
+        char tmp[24];
+        int n = 0;
+        do {
+            tmp[n++] = '0' + v % 10;
+            v /= 10;
+        } while(v);
+        while(n < width) {
+            tmp[n++] = '0';
+        }
+        while(n) {
+            append(tmp[--n]);
+        }
+    }
+
+    /**
+     * @brief 本地时间 YYYY-mm-dd HH:MM:SS.uuuuuu
+     */
+    void appendTime(uint64_t us) {
+        int64_t sec = (int64_t)(us / 1000000) + s_gmtoff.load(std::memory_order_relaxed);
+        int64_t days = sec / 86400;
+        int64_t rem = sec % 86400;
+        // 公历日期, 见 Howard Hinnant, civil_from_days
+        days += 719468;
+        int64_t era = days / 146097;
+        int64_t doe = days - era * 146097;
+        int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        int64_t mp = (5 * doy + 2) / 153;
+        int64_t d = doy - (153 * mp + 2) / 5 + 1;
+        int64_t m = mp < 10 ? mp + 3 : mp - 9;
+        int64_t y = yoe + era * 400 + (m <= 2);
+        appendUInt(y, 4);
+        append('-');
+        appendUInt(m, 2);
+        append('-');
+        appendUInt(d, 2);
+        append(' ');
+        appendUInt(rem / 3600, 2);
+        append(':');
+        appendUInt(rem / 60 % 60, 2);
+        append(':');
+        appendUInt(rem % 60, 2);
+        append('.');
+        appendUInt(us % 1000000, 6);
+    }
+
+    void flush() {
+        const char* p = m_buf;
+        while(m_len) {
+            ssize_t n = write(m_fd, p, m_len);
+            if(n < 0 && errno == EINTR) {
+                continue;
+            }
+            if(n <= 0) {
+                break;
+            }
+            p += n;
+            m_len -= n;
+        }
+        m_len = 0;
+    }
+private:
+    int m_fd;
+    size_t m_len = 0;
+    char m_buf[4096];
+};
+
+static const int s_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+static struct sigaction s_oldActions[sizeof(s_signals) / sizeof(s_signals[0])];
+
+static void SignalHandler(int sig) {
+    const char* reason = "signal";
+    switch(sig) {
+#define XX(name) case name: reason = #name; break;
+    XX(SIGSEGV);
+    XX(SIGBUS);
+    XX(SIGFPE);
+    XX(SIGILL);
+    XX(SIGABRT);
+#undef XX
+    }
+    FlightRecorder::Dump(reason);
+    for(size_t i = 0; i < sizeof(s_signals) / sizeof(s_signals[0]); ++i) {
+        if(s_signals[i] == sig) {
+            sigaction(sig, &s_oldActions[i], nullptr);
+        }
+    }
+    raise(sig);
+}
+
+}
+
+void FlightRecorder::Enable(LogLevel::Level level, size_t slots) {
+    time_t now = time(0);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    s_gmtoff.store(tm.tm_gmtoff, std::memory_order_relaxed);
+    s_slots.store(slots ? slots : 1, std::memory_order_relaxed);
+    s_level.store(level, std::memory_order_relaxed);
+}
+
+void FlightRecorder::Disable() {
+    s_level.store(OFF, std::memory_order_relaxed);
+}
+
+void FlightRecorder::Record(LogLevel::Level level, const LogEvent& event) {
+    Ring* r = t_ring.ring;
+    if(!r) {
+        r = t_ring.ring = ClaimRing();
+        if(s_installed.load(std::memory_order_relaxed)) {
+            SetupAltStack();
+        }
+    }
+    uint64_t pos = r->pos.load(std::memory_order_relaxed);
+    Slot& s = r->slots[pos % r->capacity];
+    s.seq.store(2 * pos + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    size_t len = event.getSS().size();
+    s.time = event.getTime() * 1000000 + event.getUsec();
+    s.file = event.getFile();
+    s.threadId = event.getThreadId();
+    s.fiberId = event.getFiberId();
+    s.line = event.getLine();
+    s.len = len > 0xffff ? 0xffff : len;
+    s.level = level;
+    memcpy(s.message, event.getSS().data(), std::min(len, MESSAGE_SIZE));
+    s.seq.store(2 * pos + 2, std::memory_order_release);
+    r->pos.store(pos + 1, std::memory_order_release);
+}
+
+void FlightRecorder::SetDumpPath(const std::string& path) {
+    size_t n = std::min(path.size(), sizeof(s_path) - 1);
+    // 改写期间首字节为0, 同时发生的转储会跳过而不是打开写了一半的路径
+    s_path[0] = '\0';
+    if(n) {
+        memcpy(s_path + 1, path.c_str() + 1, n - 1);
+        s_path[n] = '\0';
+        s_path[0] = path[0];
+    }
+}
+
+int64_t FlightRecorder::Dump(const char* reason) {
+    if(!s_path[0]) {
+        return -1;
+    }
+    int fd = open(s_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        return -1;
+    }
+    int64_t n = DumpTo(fd, reason);
+    close(fd);
+    return n;
+}
+
+int64_t FlightRecorder::DumpTo(int fd, const char* reason) {
+    if(s_dumping.exchange(true, std::memory_order_acquire)) {
+        return -1;
+    }
+    int64_t count = 0;
+    {
+        DumpWriter w(fd);
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        w.append("=== flight recorder dump: ");
+        w.append(reason ? reason : "");
+        w.append(" at ");
+        w.appendTime((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+        w.append(" ===\n");
+        for(Ring* r = s_rings.load(std::memory_order_acquire); r; r = r->next) {
+            uint64_t end = r->pos.load(std::memory_order_acquire);
+            uint64_t begin = end > r->capacity ? end - r->capacity : 0;
+            for(uint64_t pos = begin; pos < end; ++pos) {
+                const Slot& s = r->slots[pos % r->capacity];
+                if(s.seq.load(std::memory_order_acquire) != 2 * pos + 2) {
+                    continue;
+                }
+                Slot copy;
+                memcpy((char*)&copy + sizeof(copy.seq), (const char*)&s + sizeof(s.seq)
+                       ,sizeof(Slot) - sizeof(s.seq));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(s.seq.load(std::memory_order_relaxed) != 2 * pos + 2) {
+                    // 读的时候被覆盖了
+                    continue;
+                }
+                w.appendTime(copy.time);
+                w.append('\t');
+                w.appendUInt(copy.threadId);
+                w.append('\t');
+                w.appendUInt(copy.fiberId);
+                w.append("\t[");
+                w.append(LogLevel::ToString((LogLevel::Level)copy.level));
+                w.append("]\t");
+                w.append(copy.file ? copy.file : "?");
+                w.append(':');
+                w.appendUInt(copy.line);
+                w.append('\t');
+                w.append(copy.message, std::min((size_t)copy.len, MESSAGE_SIZE));
+                if(copy.len > MESSAGE_SIZE) {
+                    w.append("...");
+                }
+                w.append('\n');
+                ++count;
+            }
+        }
+    }
+    s_dumping.store(false, std::memory_order_release);
+    return count;
+}
+
+void FlightRecorder::InstallSignalHandler() {
+    SetupAltStack();
+    if(s_installed.exchange(true)) {
+        return;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = SignalHandler;
+    sa.sa_flags = SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+    for(size_t i = 0; i < sizeof(s_signals) / sizeof(s_signals[0]); ++i) {
+        sigaction(s_signals[i], &sa, &s_oldActions[i]);
+    }
+}
+
+}
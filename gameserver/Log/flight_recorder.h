@@ -0,0 +1,86 @@
+#ifndef __GAMESERVER_FLIGHT_RECORDER_H__
+#define __GAMESERVER_FLIGHT_RECORDER_H__
+
+#include "log.h"
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+namespace gameserver{
+
+/**
+ * @brief 日志飞行记录器
+ * @details 每个线程一个固定大小的环, 按槽位保存最近的日志事件(时间, 线程, 协程, 级别,
+ *          文件行号, 消息前若干字节), 与Logger和Handler的级别无关,
+ *          开启后被Logger过滤掉的DEBUG日志也会记下来.
+ *          槽位用序号做seqlock: 写线程只写自己的环, 不加锁, 没有原子读改写;
+ *          读者(转储)检查序号前后一致, 丢弃正在写的槽位.
+ *          FATAL日志, 崩溃信号(InstallSignalHandler)或显式调用Dump时写到文件,
+ *          转储只用open/write/close, 可以在信号处理函数里调用.
+ *          线程退出后环留给新线程复用, 在被覆盖前仍会被转储.
+ */
+class FlightRecorder {
+public:
+    /// 每个槽位的字节数
+    static const size_t SLOT_SIZE = 256;
+    /// 每个槽位能保存的消息字节数, 超出截断
+    static const size_t MESSAGE_SIZE = SLOT_SIZE - 40;
+    /// 未开启时的级别
+    static const int OFF = 0x7fffffff;
+
+    /**
+     * @brief 开启记录
+     * @param[in] level 记录不低于level的日志
+     * @param[in] slots 每个线程的槽位数, 只影响之后新建的环
+     */
+    static void Enable(LogLevel::Level level = LogLevel::DEBUG, size_t slots = 1024);
+
+    /**
+     * @brief 停止记录, 已记录的内容保留
+     */
+    static void Disable();
+
+    /**
+     * @brief 级别level的日志是否记录, 日志宏在创建事件前调用
+     */
+    static bool IsEnabled(LogLevel::Level level) {
+        return level >= s_level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 记录一条日志到本线程的环
+     */
+    static void Record(LogLevel::Level level, const LogEvent& event);
+
+    /**
+     * @brief 设置转储文件, 追加写入
+     */
+    static void SetDumpPath(const std::string& path);
+
+    /**
+     * @brief 转储到SetDumpPath设置的文件, 可在信号处理函数里调用
+     * @param[in] reason 写在转储开头的原因
+     * @return 转储的日志条数, 没有设置文件, 打开失败或另一个转储正在进行时返回-1
+     */
+    static int64_t Dump(const char* reason = "request");
+
+    /**
+     * @brief 转储到已打开的文件描述符, 可在信号处理函数里调用
+     */
+    static int64_t DumpTo(int fd, const char* reason);
+
+    /**
+     * @brief 安装SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT的处理函数
+     * @details 收到信号时转储, 恢复原来的处理方式后重新发出信号.
+     *          为调用线程和之后领取环的线程各设置备用信号栈, 栈溢出时也能转储, 线程退出时释放.
+     *          其他线程也可以调用本函数给自己设置备用信号栈
+     */
+    static void InstallSignalHandler();
+private:
+    /// 记录的最低级别, OFF为不记录
+    static std::atomic<int> s_level;
+};
+
+}
+
+#endif
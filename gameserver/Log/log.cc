@@ -1,9 +1,18 @@
 #include "log.h"
+#include "log_format.h"
+#include "log_json.h"
+#include "Util/util.h"
+#include "Thread/rcu.h"
+#include "Thread/thread.h"
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <functional>
+#include <algorithm>
 #include <time.h>
 #include <string.h>
+#include <stdio.h>
+#include <math.h>
 
 namespace gameserver{
 
@@ -23,23 +32,184 @@ const char* LogLevel::ToString(LogLevel::Level level){
     return "UNKNOW";
 }
 
+LogLevel::Level LogLevel::FromString(const std::string& str) {
+#define XX(level, v) \
+    if(str == #v) { \
+        return LogLevel::level; \
+    }
+    XX(DEBUG, debug);
+    XX(INFO, info);
+    XX(WARN, warn);
+    XX(ERROR, error);
+    XX(FATAL, fatal);
+
+    XX(DEBUG, DEBUG);
+    XX(INFO, INFO);
+    XX(WARN, WARN);
+    XX(ERROR, ERROR);
+    XX(FATAL, FATAL);
+    return LogLevel::UNKNOW;
+#undef XX
+}
+
+/**
+ * @brief 格式化用的线程局部缓冲, 容量增长后一直复用
+ */
+static LogStream& GetFormatBuffer() {
+    static thread_local LogStream s_buf;
+    s_buf.clear();
+    return s_buf;
+}
+
+/**
+ * @brief 被替换的格式器交给RCU回收, Logger::log可能还在用
+ */
+static void RetireFormatter(LogFormatter::ptr& old) {
+    if(old) {
+        RcuDomain::GetInstance()->retire(new LogFormatter::ptr(std::move(old)));
+    }
+}
+
+LogFormatter::ptr LogHandler::swapFormatter(const LogFormatter::ptr& val) {
+    LogFormatter::ptr old = m_formatter;
+    m_formatter = val;
+    m_current.store(val.get(), std::memory_order_release);
+    return old;
+}
+
+void LogHandler::setFormatter(LogFormatter::ptr val) {
+    LogFormatter::ptr old;
+    {
+        MutexType::Lock lock(m_mutex);
+        old = swapFormatter(val);
+        m_hasFormatter = val != nullptr;
+    }
+    RetireFormatter(old);
+}
+
 LogFormatter::ptr LogHandler::getFormatter() {
-    // MutexType
+    MutexType::Lock lock(m_mutex);
     return m_formatter;
 }
 
+void LogHandler::setFlushPolicy(const FlushPolicy& val) {
+    MutexType::Lock lock(m_mutex);
+    m_flushBytes.store(val.bytes, std::memory_order_relaxed);
+    m_flushIntervalMs.store(val.intervalMs, std::memory_order_relaxed);
+    m_flushLevel.store(val.level, std::memory_order_relaxed);
+}
+
+FlushPolicy LogHandler::getFlushPolicy() {
+    MutexType::Lock lock(m_mutex);
+    return FlushPolicy::Buffered(m_flushBytes.load(std::memory_order_relaxed)
+                                 ,m_flushIntervalMs.load(std::memory_order_relaxed)
+                                 ,(LogLevel::Level)m_flushLevel.load(std::memory_order_relaxed));
+}
+
+void LogHandler::logWith(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event
+                         ,const LogFormatter::ptr& formatter) {
+    LogFormatter::ptr fmt = getFormatter();
+    if(!fmt) {
+        fmt = formatter;
+    }
+    if(!m_writer || !fmt) {
+        log(logger, level, event);
+        return;
+    }
+    LogStream& buf = GetFormatBuffer();
+    fmt->format(buf, logger, level, event);
+    write(level, buf.data(), buf.size());
+}
+
+void LogHandler::meteredLog(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event, bool timed
+                            ,const LogFormatter::ptr& formatter) {
+    if(level < getLevel()) {
+        return;
+    }
+    m_events.add();
+    uint64_t begin = timed ? MetricsNow() : 0;
+    if(formatter) {
+        logWith(logger, level, event, formatter);
+    } else {
+        log(logger, level, event);
+    }
+    if(timed) {
+        m_writeTime.record(MetricsNow() - begin);
+    }
+}
+
+void LogHandler::meteredWrite(LogLevel::Level level, const char* data, size_t len, bool timed) {
+    m_events.add();
+    m_bytes.add(len);
+    if(timed) {
+        uint64_t begin = MetricsNow();
+        write(level, data, len);
+        m_writeTime.record(MetricsNow() - begin);
+    } else {
+        write(level, data, len);
+    }
+}
+
+LogHandlerMetrics LogHandler::getMetrics() const {
+    LogHandlerMetrics m;
+    m.name = getName();
+    m.events = m_events.get();
+    m.bytes = m_bytes.get();
+    m.dropped = getDropped();
+    m.queueDepth = getQueueDepth();
+    m.writeTime = m_writeTime.snapshot();
+    return m;
+}
+
+static uint64_t GetCoarseMS() {
+    uint64_t sec;
+    uint32_t usec;
+    GetCoarseTime(sec, usec);
+    return sec * 1000 + usec / 1000;
+}
+
+bool LogHandler::needFlush(LogLevel::Level level, size_t len) {
+    m_unflushed += len;
+    uint32_t bytes = m_flushBytes.load(std::memory_order_relaxed);
+    int flush_level = m_flushLevel.load(std::memory_order_relaxed);
+    if((bytes && m_unflushed >= bytes)
+            || (flush_level != LogLevel::UNKNOW && level >= flush_level)) {
+        resetFlush();
+        return true;
+    }
+    uint32_t interval = m_flushIntervalMs.load(std::memory_order_relaxed);
+    if(interval) {
+        uint64_t now = GetCoarseMS();
+        if(!m_lastFlush) {
+            m_lastFlush = now;
+        } else if(now - m_lastFlush >= interval) {
+            m_unflushed = 0;
+            m_lastFlush = now;
+            return true;
+        }
+    }
+    return false;
+}
+
+void LogHandler::resetFlush() {
+    m_unflushed = 0;
+    if(m_flushIntervalMs.load(std::memory_order_relaxed)) {
+        m_lastFlush = GetCoarseMS();
+    }
+}
+
 class MessageFormatItem : public LogFormatter::FormatItem {
 public:
     MessageFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << event->getContent();
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        os.write(event.getSS().data(), event.getSS().size());
     }
 };
 
 class LevelFormatItem : public LogFormatter::FormatItem {
 public:
     LevelFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
         os << LogLevel::ToString(level);
     }
 };
@@ -47,86 +217,81 @@ public:
 class ElapseFormatItem : public LogFormatter::FormatItem {
 public:
     ElapseFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << event->getElapse();
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        os << event.getElapse();
     }
 };
 
 class NameFormatItem : public LogFormatter::FormatItem {
 public:
     NameFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << event->getLogger()->getName();
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        os << event.getLogger()->getName();
     }
 };
 
 class ThreadIdFormatItem : public LogFormatter::FormatItem {
 public:
     ThreadIdFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << event->getThreadId();
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        os << event.getThreadId();
     }
 };
 
 class FiberIdFormatItem : public LogFormatter::FormatItem {
 public:
     FiberIdFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << event->getFiberId();
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        os << event.getFiberId();
     }
 };
 
 class ThreadNameFormatItem : public LogFormatter::FormatItem {
 public:
     ThreadNameFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << event->getThreadName();
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        os << event.getThreadName();
     }
 };
 
 class DateTimeFormatItem : public LogFormatter::FormatItem {
 public:
     DateTimeFormatItem(const std::string& format = "%Y-%m-%d %H:%M:%S")
-        :m_format(format) {
-        if(m_format.empty()) {
-            m_format = "%Y-%m-%d %H:%M:%S";
-        }
+        :m_format(format.empty() ? "%Y-%m-%d %H:%M:%S" : format) {
     }
 
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        struct tm tm;
-        time_t time = event->getTime();
-        //time库
-        localtime_r(&time, &tm);
-        char buf[64];
-        strftime(buf, sizeof(buf), m_format.c_str(), &tm);
-        os << buf;
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        static thread_local LogStream s_buf;
+        s_buf.clear();
+        m_format.format(s_buf, event.getTime(), event.getUsec());
+        os.write(s_buf.data(), s_buf.size());
     }
 private:
-    std::string m_format;
+    TimestampFormat m_format;
 };
 
 class FilenameFormatItem : public LogFormatter::FormatItem {
 public:
     FilenameFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << event->getFile();
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        os << event.getFile();
     }
 };
 
 class LineFormatItem : public LogFormatter::FormatItem {
 public:
     LineFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << event->getLine();
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        os << event.getLine();
     }
 };
 
 class NewLineFormatItem : public LogFormatter::FormatItem {
 public:
     NewLineFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
-        os << std::endl;
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
+        // 不用std::endl, 何时刷新由Handler的刷新策略决定
+        os << '\n';
     }
 };
 
@@ -135,7 +300,7 @@ class StringFormatItem : public LogFormatter::FormatItem {
 public:
     StringFormatItem(const std::string& str)
         :m_string(str) {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
         os << m_string;
     }
 private:
@@ -145,127 +310,724 @@ private:
 class TabFormatItem : public LogFormatter::FormatItem {
 public:
     TabFormatItem(const std::string& str = "") {}
-    void format(std::ostream& os, Logger::ptr logger, LogLevel::Level level, LogEvent::ptr event) override {
+    void format(std::ostream& os, const Logger::ptr& logger, LogLevel::Level level, const LogEvent& event) override {
         os << "\t";
     }
 private:
     std::string m_string;
 };
 
+/**
+ * @brief 线程局部的定长块空闲链表
+ * @details 每种T一条链表; 在其他线程释放的块进入释放线程的链表.
+ *          线程退出后不再缓存, 直接走operator new/delete
+ */
+template<class T>
+class PoolFreeList {
+public:
+    /// 每个线程最多缓存的空闲块
+    static const size_t MAX_FREE = 1024;
+
+    static void* Alloc() {
+        if(!t_dead && t_list.m_head) {
+            Node* n = t_list.m_head;
+            t_list.m_head = n->next;
+            --t_list.m_count;
+            return n;
+        }
+        return ::operator new(sizeof(T));
+    }
+
+    static void Free(void* p) {
+        if(!t_dead && t_list.m_count < MAX_FREE) {
+            Node* n = (Node*)p;
+            n->next = t_list.m_head;
+            t_list.m_head = n;
+            ++t_list.m_count;
+            return;
+        }
+        ::operator delete(p);
+    }
+private:
+    struct Node {
+        Node* next;
+    };
+
+    ~PoolFreeList() {
+        t_dead = true;
+        while(m_head) {
+            Node* n = m_head;
+            m_head = n->next;
+            ::operator delete(n);
+        }
+    }
+private:
+    Node* m_head = nullptr;
+    size_t m_count = 0;
+
+    static thread_local PoolFreeList t_list;
+    /// 本线程的链表已析构
+    static thread_local bool t_dead;
+};
+
+template<class T>
+thread_local PoolFreeList<T> PoolFreeList<T>::t_list;
+template<class T>
+thread_local bool PoolFreeList<T>::t_dead = false;
+
+/**
+ * @brief 从PoolFreeList分配的allocator, 供allocate_shared使用
+ */
+template<class T>
+class PoolAllocator {
+public:
+    typedef T value_type;
+
+    PoolAllocator() {}
+    template<class U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if(n == 1) {
+            return (T*)PoolFreeList<T>::Alloc();
+        }
+        return (T*)::operator new(n * sizeof(T));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if(n == 1) {
+            PoolFreeList<T>::Free(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    template<class U>
+    bool operator==(const PoolAllocator<U>&) const { return true;}
+    template<class U>
+    bool operator!=(const PoolAllocator<U>&) const { return false;}
+};
+
+LogEvent::LogEvent() {
+}
+
 LogEvent::LogEvent(std::shared_ptr<Logger> logger
             ,const char* file, int32_t line, uint32_t elapse
             ,uint32_t thread_id, uint32_t fiber_id, uint64_t time
-            ,const std::string& thread_name)
+            ,const char* thread_name, uint32_t usec)
     :m_file(file)
     ,m_line(line)
     ,m_elapse(elapse)
     ,m_threadId(thread_id)
     ,m_fiberId(fiber_id)
     ,m_time(time)
-    ,m_threadName(thread_name)
-    ,m_logger(logger){}
+    ,m_usec(usec)
+    ,m_threadName(thread_name ? thread_name : "")
+    ,m_logger(logger){
     // ,m_level(level) {}
+}
+
+LogEvent::ptr LogEvent::Create(std::shared_ptr<Logger> logger
+            ,const char* file, int32_t line, uint32_t elapse
+            ,uint32_t thread_id, uint32_t fiber_id, uint64_t time
+            ,const char* thread_name, uint32_t usec) {
+    return std::allocate_shared<LogEvent>(PoolAllocator<LogEvent>()
+            ,logger, file, line, elapse, thread_id, fiber_id, time, thread_name, usec);
+}
+
+void LogEvent::format(const char* fmt, ...) {
+    va_list al;
+    va_start(al, fmt);
+    format(fmt, al);
+    va_end(al);
+}
+
+void LogEvent::format(const char* fmt, va_list al) {
+    // 先按剩余内联空间写一次, 不够再按实际长度扩容重写
+    va_list al2;
+    va_copy(al2, al);
+    size_t avail = m_ss.capacity() - m_ss.size();
+    int len = vsnprintf(m_ss.reserve(0), avail, fmt, al);
+    if(len >= 0) {
+        if((size_t)len >= avail) {
+            vsnprintf(m_ss.reserve(len + 1), len + 1, fmt, al2);
+        }
+        m_ss.commit(len);
+    }
+    va_end(al2);
+}
+
+/**
+ * @brief 字段名编码成 ,"key": 写到线程缓冲, 值写完后整段追加到事件
+ */
+static LogStream& BeginField(const char* key) {
+    static thread_local LogStream t_buf;
+    t_buf.clear();
+    t_buf.append(',');
+    json::AppendString(t_buf, key);
+    t_buf.append(':');
+    return t_buf;
+}
+
+void LogEvent::addField(const char* key, const char* value) {
+    LogStream& buf = BeginField(key);
+    if(value) {
+        json::AppendString(buf, value);
+    } else {
+        buf.append("null", 4);
+    }
+    m_fields.append(buf.data(), buf.size());
+}
+
+void LogEvent::addField(const char* key, const std::string& value) {
+    LogStream& buf = BeginField(key);
+    json::AppendString(buf, value);
+    m_fields.append(buf.data(), buf.size());
+}
+
+void LogEvent::addField(const char* key, bool value) {
+    LogStream& buf = BeginField(key);
+    buf.append(value ? "true" : "false");
+    m_fields.append(buf.data(), buf.size());
+}
+
+void LogEvent::addField(const char* key, int64_t value) {
+    LogStream& buf = BeginField(key);
+    buf.appendInt(value);
+    m_fields.append(buf.data(), buf.size());
+}
+
+void LogEvent::addField(const char* key, uint64_t value) {
+    LogStream& buf = BeginField(key);
+    buf.appendUInt(value);
+    m_fields.append(buf.data(), buf.size());
+}
+
+void LogEvent::addField(const char* key, double value) {
+    LogStream& buf = BeginField(key);
+    // JSON没有NaN和无穷大
+    if(isfinite(value)) {
+        buf.appendDouble(value);
+    } else {
+        buf.append("null", 4);
+    }
+    m_fields.append(buf.data(), buf.size());
+}
 
 
 // Logger
+struct Logger::Config {
+    /// 日志目标集合
+    std::vector<LogHandler::ptr> handlers;
+    /// 日志格式器
+    LogFormatter::ptr formatter;
+};
+
 Logger::Logger (const std::string& name)
     :m_name(name) 
-    ,m_level(LogLevel::DEBUG) {
+    ,m_level(LogLevel::DEBUG)
+    ,m_config(new Config)
+    ,m_limitMask(0) {
+    for(int i = 0; i <= LogLevel::FATAL; ++i) {
+        m_limitRate[i].store(0, std::memory_order_relaxed);
+        m_limitBurst[i].store(0, std::memory_order_relaxed);
+        m_limitSample[i].store(0, std::memory_order_relaxed);
+    }
     // shared_ptr.reset()包含两个操作。当智能指针中有值的时候，调用reset()会使引用计数减1.当调用reset（new xxx())重新赋值时，智能指针首先是生成新对象，然后将就对象的引用计数减1（当然，如果发现引用计数为0时，则析构旧对象），然后将新对象的指针交给智能指针保管。
-    m_formatter.reset(new LogFormatter("%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%l%T%m%n"));
+    m_config.load()->formatter.reset(new LogFormatter(LogFormatter::DEFAULT_PATTERN));
+}
+
+Logger::~Logger() {
+    // 还能调用析构说明没有log()在进行
+    delete m_config.load();
+}
+
+void Logger::publish(Config* config) {
+    Config* old = m_config.exchange(config, std::memory_order_acq_rel);
+    RcuDomain::GetInstance()->retire(old);
+}
+
+void Logger::setFormatter(LogFormatter::ptr val) {
+    MutexType::Lock lock(m_mutex);
+    Config* config = new Config(*m_config.load(std::memory_order_relaxed));
+    config->formatter = val;
+
+    for(auto& i : config->handlers) {
+        LogFormatter::ptr old;
+        {
+            LogHandler::MutexType::Lock ll(i->m_mutex);
+            if(!i->m_hasFormatter) {
+                old = i->swapFormatter(val);
+            }
+        }
+        RetireFormatter(old);
+    }
+    publish(config);
+}
+
+void Logger::setFormatter(const std::string& val) {
+    LogFormatter::ptr new_val(new LogFormatter(val));
+    if(new_val->isError()) {
+        std::cout << "Logger setFormatter name=" << m_name
+                  << " value=" << val << " invalid formatter"
+                  << std::endl;
+        return;
+    }
+    setFormatter(new_val);
 }
 
 LogFormatter::ptr Logger::getFormatter() {
-    //Mutex
-    return m_formatter;
+    RcuReadLock lock;
+    return m_config.load(std::memory_order_acquire)->formatter;
 }
 
 void Logger::addHandler(LogHandler::ptr handler){
-    //MutexType::Lock lock(m_mutex);
-    if(!handler->getFormatter()) {
-        //MutexType::Lock ll(handler->m_mutex);
-        handler->m_formatter = m_formatter;  // 通过友元申明，调用的是Logger类里的m_formatter
+    MutexType::Lock lock(m_mutex);
+    Config* config = new Config(*m_config.load(std::memory_order_relaxed));
+    {
+        LogHandler::MutexType::Lock ll(handler->m_mutex);
+        if(!handler->m_formatter) {
+            handler->swapFormatter(config->formatter);  // 通过友元申明，调用的是Logger类里的m_formatter
+        }
     }
-    m_handlers.push_back(handler);
+    config->handlers.push_back(handler);
+    publish(config);
 }
 
 void Logger::delHandler(LogHandler::ptr handler){
-    for(auto it = m_handlers.begin(); it != m_handlers.end(); ++it) {
+    MutexType::Lock lock(m_mutex);
+    Config* config = new Config(*m_config.load(std::memory_order_relaxed));
+    for(auto it = config->handlers.begin(); it != config->handlers.end(); ++it) {
         if (*it == handler) {
-            m_handlers.erase(it);
+            config->handlers.erase(it);
             break;
         }
     }
+    publish(config);
 }
 
-void Logger::log(LogLevel::Level level, LogEvent::ptr event){
-    if(level >= m_level) {
-        auto self = shared_from_this();
-        //MutexType::Lock lock(m_mutex);
-        if(!m_handlers.empty()) {
-            for(auto& i : m_handlers) {
-                i->log(self, level, event);
-            }
+void Logger::clearHandler(){
+    MutexType::Lock lock(m_mutex);
+    Config* config = new Config(*m_config.load(std::memory_order_relaxed));
+    config->handlers.clear();
+    publish(config);
+}
+
+void Logger::log(LogLevel::Level level, const LogEvent& event){
+    // 事件一般就是本日志器创建的, 借用它持有的引用
+    if(event.getLogger().get() == this) {
+        doLog(event.getLogger(), level, event);
+    } else {
+        doLog(shared_from_this(), level, event);
+    }
+}
+
+void Logger::doLog(const Logger::ptr& self, LogLevel::Level level, const LogEvent& event) {
+    if(!isEnabled(level)) {
+        m_filtered.add();
+        return;
+    }
+    m_accepted.add();
+    {
+        // 读区内快照不会被释放, 配置修改不会阻塞这里
+        RcuReadLock lock;
+        const Config* config = m_config.load(std::memory_order_acquire);
+        if(!config->handlers.empty()) {
+            dispatch(self, config->handlers, level, event);
         } else if(m_root) {
-            m_root->log(level, event);
+            m_root->doLog(m_root, level, event);
         }
     }
 }
 
-void Logger::debug(LogEvent::ptr event){
+namespace {
+
+/**
+ * @brief 一条日志在各格式器下的输出, 每个格式器只格式化一次
+ */
+struct RenderCache {
+    /// 一条日志最多缓存的格式器个数, 再多的Handler走log()
+    static const size_t MAX_FORMATTERS = 4;
+    LogFormatter* formatters[MAX_FORMATTERS];
+    LogStream bufs[MAX_FORMATTERS];
+    size_t size = 0;
+    /// 正在使用, Handler里再写日志时不能覆盖
+    bool busy = false;
+};
+
+struct RenderGuard {
+    RenderGuard(RenderCache& cache)
+        :cache(cache)
+        ,owner(!cache.busy) {
+        if(owner) {
+            cache.busy = true;
+            cache.size = 0;
+        }
+    }
+    ~RenderGuard() {
+        if(owner) {
+            cache.busy = false;
+        }
+    }
+    RenderCache& cache;
+    bool owner;
+};
+
+}
+
+static thread_local RenderCache t_render;
+
+void Logger::dispatch(const Logger::ptr& self, const std::vector<LogHandler::ptr>& handlers
+                      ,LogLevel::Level level, const LogEvent& event) {
+    RenderGuard guard(t_render);
+    RenderCache& cache = t_render;
+    bool timed = MetricsSampleTick();
+    for(auto& i : handlers) {
+        // 调用方在RCU读区里, 格式器不会被释放
+        LogFormatter* fmt = i->m_current.load(std::memory_order_acquire);
+        if(!guard.owner || !i->isWriter() || !fmt) {
+            i->meteredLog(self, level, event, timed);
+            continue;
+        }
+        if(level < i->getLevel()) {
+            continue;
+        }
+        size_t k = 0;
+        while(k < cache.size && cache.formatters[k] != fmt) {
+            ++k;
+        }
+        if(k == cache.size) {
+            if(k == RenderCache::MAX_FORMATTERS) {
+                i->meteredLog(self, level, event, timed);
+                continue;
+            }
+            cache.formatters[k] = fmt;
+            cache.bufs[k].clear();
+            uint64_t begin = timed ? MetricsNow() : 0;
+            fmt->format(cache.bufs[k], self, level, event);
+            if(timed) {
+                self->m_formatTime.record(MetricsNow() - begin);
+            }
+            ++cache.size;
+        }
+        i->meteredWrite(level, cache.bufs[k].data(), cache.bufs[k].size(), timed);
+    }
+}
+
+void Logger::debug(const LogEvent::ptr& event){
     log(LogLevel::DEBUG, event);
 }
 
-void Logger::info(LogEvent::ptr event){
+void Logger::info(const LogEvent::ptr& event){
     log(LogLevel::INFO, event);
 }
 
-void Logger::warn(LogEvent::ptr event){
+void Logger::warn(const LogEvent::ptr& event){
     log(LogLevel::WARN, event);
 }
 
-void Logger::error(LogEvent::ptr event){
+void Logger::error(const LogEvent::ptr& event){
     log(LogLevel::ERROR, event);
 }
 
-void Logger::fatal(LogEvent::ptr event){
+void Logger::fatal(const LogEvent::ptr& event){
     log(LogLevel::FATAL, event);
 }
 
+LoggerMetrics Logger::getMetrics() {
+    LoggerMetrics m;
+    m.name = m_name;
+    m.accepted = m_accepted.get();
+    m.filtered = m_filtered.get();
+    m.dropped = m_dropped.get();
+    m.formatTime = m_formatTime.snapshot();
+    std::vector<LogHandler::ptr> handlers;
+    {
+        MutexType::Lock lock(m_mutex);
+        handlers = m_config.load(std::memory_order_relaxed)->handlers;
+    }
+    for(auto& i : handlers) {
+        m.handlers.push_back(i->getMetrics());
+    }
+    return m;
+}
+
+void Logger::setRateLimit(LogLevel::Level level, uint32_t rate, uint32_t burst, uint32_t sample) {
+    if((int)level < 0 || level > LogLevel::FATAL) {
+        return;
+    }
+    m_limitRate[level].store(rate, std::memory_order_relaxed);
+    m_limitBurst[level].store(burst, std::memory_order_relaxed);
+    m_limitSample[level].store(sample, std::memory_order_relaxed);
+    if(rate || sample > 1) {
+        m_limitMask.fetch_or(1u << level, std::memory_order_release);
+    } else {
+        m_limitMask.fetch_and(~(1u << level), std::memory_order_release);
+    }
+}
+
+void Logger::clearRateLimit(LogLevel::Level level) {
+    setRateLimit(level, 0, 0, 1);
+}
+
+void Logger::getRateLimit(LogLevel::Level level, uint32_t& rate, uint32_t& burst, uint32_t& sample) const {
+    rate = m_limitRate[level].load(std::memory_order_relaxed);
+    burst = m_limitBurst[level].load(std::memory_order_relaxed);
+    sample = m_limitSample[level].load(std::memory_order_relaxed);
+}
+
+static uint64_t GetMonotonicNS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/// 同一调用点两次汇总的最小间隔(纳秒)
+static std::atomic<uint64_t> s_reportInterval(1000000000ull);
+/// 有过丢弃的调用点, 只增不删
+static std::atomic<LogSite*> s_sites(nullptr);
+/// 下次顺带扫描s_sites的时间(纳秒)
+static std::atomic<uint64_t> s_nextSweep(0);
+
+LogSite::LogSite(const char* file, int32_t line)
+    :m_file(file)
+    ,m_line(line)
+    ,m_seen(0)
+    ,m_tat(0)
+    ,m_suppressed(0)
+    ,m_lastReport(GetMonotonicNS())
+    ,m_loggerRaw(nullptr)
+    ,m_level(LogLevel::UNKNOW)
+    ,m_registered(false)
+    ,m_next(nullptr) {
+}
+
+void LogSite::SetReportInterval(uint32_t ms) {
+    s_reportInterval.store(ms * 1000000ull, std::memory_order_relaxed);
+}
+
+void LogSite::ReportAll(bool force) {
+    uint64_t now = GetMonotonicNS();
+    for(LogSite* site = s_sites.load(std::memory_order_acquire); site; site = site->m_next) {
+        site->report(now, force);
+    }
+}
+
+void LogSite::suppress(const std::shared_ptr<Logger>& logger, LogLevel::Level level) {
+    // 先记下日志器再计数, 汇总不会把这条算到之前的日志器上
+    if(__builtin_expect(m_loggerRaw.load(std::memory_order_relaxed) != logger.get(), 0)) {
+        Spinlock::Lock lock(m_mutex);
+        m_logger = logger;
+        m_loggerRaw.store(logger.get(), std::memory_order_relaxed);
+    }
+    if(__builtin_expect(m_level.load(std::memory_order_relaxed) != level, 0)) {
+        m_level.store(level, std::memory_order_relaxed);
+    }
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    logger->m_dropped.add();
+    if(__builtin_expect(!m_registered.load(std::memory_order_relaxed), 0)
+            && !m_registered.exchange(true, std::memory_order_relaxed)) {
+        m_next = s_sites.load(std::memory_order_relaxed);
+        while(!s_sites.compare_exchange_weak(m_next, this, std::memory_order_release
+                                             ,std::memory_order_relaxed)) {
+        }
+    }
+}
+
+void LogSite::report(uint64_t now, bool force) {
+    if(m_suppressed.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    // CAS推进上次汇总时间, 同一间隔内只有一个线程输出
+    uint64_t last = m_lastReport.load(std::memory_order_relaxed);
+    do {
+        if(!force && now - last < s_reportInterval.load(std::memory_order_relaxed)) {
+            return;
+        }
+    } while(!m_lastReport.compare_exchange_weak(last, std::max(now, last), std::memory_order_relaxed));
+    uint64_t n = m_suppressed.exchange(0, std::memory_order_relaxed);
+    Logger::ptr logger;
+    {
+        Spinlock::Lock lock(m_mutex);
+        logger = m_logger;
+    }
+    if(!n || !logger) {
+        return;
+    }
+    uint64_t sec;
+    uint32_t usec;
+    GetCoarseTime(sec, usec);
+    LogEvent::ptr event = LogEvent::Create(logger, m_file, m_line, 0, GetThreadId()
+                                           ,GetFiberId(), sec, Thread::GetName(), usec);
+    event->getSS() << "suppressed " << n << " messages in the last "
+                   << (now > last ? now - last : 0) / 1000000 << "ms";
+    logger->log((LogLevel::Level)m_level.load(std::memory_order_relaxed), *event);
+}
+
+bool LogSite::allow(const std::shared_ptr<Logger>& logger, LogLevel::Level level) {
+    uint32_t rate, burst, sample;
+    logger->getRateLimit(level, rate, burst, sample);
+    uint64_t now = GetMonotonicNS();
+    bool pass = true;
+    if(sample > 1 && m_seen.fetch_add(1, std::memory_order_relaxed) % sample != 0) {
+        pass = false;
+    } else if(rate) {
+        // GCRA: 每条占用interval, 理论到达时间比现在超前不超过burst条就放行
+        uint64_t interval = 1000000000ull / rate;
+        uint64_t limit = interval * (burst ? burst : 1);
+        uint64_t tat = m_tat.load(std::memory_order_relaxed);
+        while(true) {
+            uint64_t next = std::max(tat, now) + interval;
+            if(next - now > limit) {
+                pass = false;
+                break;
+            }
+            if(m_tat.compare_exchange_weak(tat, next, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+    if(!pass) {
+        suppress(logger, level);
+    }
+    // 汇总在放行的日志之前输出
+    if(__builtin_expect(m_suppressed.load(std::memory_order_relaxed) != 0, 0)) {
+        report(now, false);
+    }
+    // 顺带汇总风暴已经结束的其他调用点
+    uint64_t sweep = s_nextSweep.load(std::memory_order_relaxed);
+    if(__builtin_expect(now >= sweep, 0)
+            && s_nextSweep.compare_exchange_strong(sweep, now + s_reportInterval.load(std::memory_order_relaxed)
+                                                   ,std::memory_order_relaxed)) {
+        ReportAll(false);
+    }
+    return pass;
+}
+
+LogEventWrap::LogEventWrap(const Logger::ptr& logger, LogLevel::Level level, const char* file, int32_t line)
+    :m_level(level) {
+    uint64_t sec;
+    uint32_t usec;
+    GetCoarseTime(sec, usec);
+    m_event = LogEvent::Create(logger, file, line, 0, GetThreadId(), GetFiberId(), sec, Thread::GetName(), usec);
+}
+
+LogEventWrap::~LogEventWrap() {
+    bool record = FlightRecorder::IsEnabled(m_level);
+    if(record) {
+        FlightRecorder::Record(m_level, *m_event);
+    }
+    m_event->getLogger()->log(m_level, *m_event);
+    if(record && m_level == LogLevel::FATAL) {
+        FlightRecorder::Dump("FATAL");
+    }
+}
+
 // Handler
 FileLogHandler::FileLogHandler(const std::string& filename)
     :m_filename(filename){
+    m_writer = true;
     reopen();
 }
 
-void FileLogHandler::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) {
-    if(level >= m_level) {
-        m_filestream << m_formatter->format(logger, level, event);
+void FileLogHandler::log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) {
+    if(level >= getLevel()) {
+        // 在锁外格式化到线程缓冲, 锁内只写文件流
+        LogStream& buf = GetFormatBuffer();
+        getFormatter()->format(buf, logger, level, event);
+        write(level, buf.data(), buf.size());
     }
 }
 
+void FileLogHandler::write(LogLevel::Level level, const char* data, size_t len) {
+    MutexType::Lock lock(m_mutex);
+    m_filestream.write(data, len);
+    if(needFlush(level, len)) {
+        m_filestream.flush();
+    }
+}
+
+void FileLogHandler::flush() {
+    MutexType::Lock lock(m_mutex);
+    m_filestream.flush();
+    resetFlush();
+}
+
 bool FileLogHandler::reopen() {
-    if(m_filestream){
-        m_filestream.close();
+    // 在锁外打开新文件, 打不开时继续写原来的文件
+    std::ofstream stream(m_filename, std::ios::app);
+    if(!stream) {
+        return false;
     }
-    m_filestream.open(m_filename);
-    return !!m_filestream;  // !! 意思是非0转为1，0还是0
+    {
+        MutexType::Lock lock(m_mutex);
+        m_filestream.swap(stream);
+    }
+    // 原来的文件在锁外刷新并关闭
+    return true;
+}
+
+StdoutLogHandler::StdoutLogHandler() {
+    m_writer = true;
 }
 
-void StdoutLogHandler::log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) {
-    if(level >= m_level) {
+void StdoutLogHandler::log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) {
+    if(level >= getLevel()) {
+        LogStream& buf = GetFormatBuffer();
+        getFormatter()->format(buf, logger, level, event);
+        write(level, buf.data(), buf.size());
+    }
+}
 
-        m_formatter->format(std::cout, logger, level, event);
+void StdoutLogHandler::write(LogLevel::Level level, const char* data, size_t len) {
+    MutexType::Lock lock(m_mutex);
+    std::cout.write(data, len);
+    if(needFlush(level, len)) {
+        std::cout.flush();
     }
 }
 
+void StdoutLogHandler::flush() {
+    MutexType::Lock lock(m_mutex);
+    std::cout.flush();
+    resetFlush();
+}
+
 //Formatter
-LogFormatter::LogFormatter(const std::string& pattern)
-    :m_pattern(pattern) {
+constexpr const char* LogFormatter::DEFAULT_PATTERN;
+constexpr const char* LogFormatter::JSON_PATTERN;
+
+/**
+ * @brief 常用格式对应的编译期格式
+ */
+static const struct {
+    const char* pattern;
+    LogFormatter::FastFormat format;
+} s_static_formats[] = {
+    {LogFormatter::DEFAULT_PATTERN, &DefaultLogFormat::format},
+    {LogFormatter::JSON_PATTERN, &JsonLogFormat::format},
+};
+
+LogFormatter::LogFormatter(const std::string& pattern, FastFormat fast)
+    :m_pattern(pattern)
+    ,m_fast(fast) {
     init();
+    if(!m_fast && !m_error) {
+        for(auto& i : s_static_formats) {
+            if(m_pattern == i.pattern) {
+                m_fast = i.format;
+                break;
+            }
+        }
+    }
 }
 
-std::string LogFormatter::format(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event){
+std::string LogFormatter::format(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event){
+    if(m_fast) {
+        LogStream& buf = GetFormatBuffer();
+        m_fast(buf, level, event);
+        return buf.str();
+    }
     std::stringstream ss;
     for(auto& i : m_items){
         i->format(ss, logger,level, event);
@@ -273,13 +1035,37 @@ std::string LogFormatter::format(std::shared_ptr<Logger> logger, LogLevel::Level
     return ss.str();
 }
 
-std::ostream& LogFormatter::format(std::ostream& ofs, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event){
+std::ostream& LogFormatter::format(std::ostream& ofs, const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event){
+    if(m_fast) {
+        LogStream& buf = GetFormatBuffer();
+        m_fast(buf, level, event);
+        ofs.write(buf.data(), buf.size());
+        return ofs;
+    }
     for(auto& i : m_items) {
         i->format(ofs, logger, level, event);
     }
     return ofs;
 }
 
+void LogFormatter::format(LogStream& os, const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event){
+    if(m_fast) {
+        m_fast(os, level, event);
+        return;
+    }
+    static thread_local std::stringstream s_ss;
+    s_ss.str("");
+    for(auto& i : m_items) {
+        i->format(s_ss, logger, level, event);
+    }
+    // 直接从streambuf读出, s_ss.str()每次都会分配一个string
+    char tmp[256];
+    std::streamsize n;
+    while((n = s_ss.rdbuf()->sgetn(tmp, sizeof(tmp))) > 0) {
+        os.append(tmp, n);
+    }
+}
+
 //日志格式的解析（log4j），参照c++20，format实现
 //三种格式： %xxx %xxx{xxx} %% 
 //%xxx %xxx{xxx} %%
@@ -297,6 +1083,7 @@ void LogFormatter::init() {
             // %%的情况，只输出一个%
             if(m_pattern[i + 1] == '%') {
                 nstr.append(1, '%');
+                ++i;  // 跳过第二个%
                 continue;
             }
         }
@@ -401,5 +1188,116 @@ void LogFormatter::init() {
     // std::cout << m_items.size() << std::endl;
 }
 
+// LoggerManager
+namespace {
+
+/**
+ * @brief 线程局部的日志器查找缓存
+ */
+struct LoggerCache {
+    /// 所属管理器编号
+    uint64_t owner = 0;
+    /// 名称到日志器
+    std::unordered_map<std::string, Logger::ptr> loggers;
+    /// 名称的地址到日志器, 一般是字面量; 同一地址可能换了内容, 命中后还要比较名称
+    std::unordered_map<const char*, Logger::ptr> literals;
+};
+
+/// literals超过这个数就清空, 传入的是不断变化的缓冲地址时不会无限增长
+static const size_t LITERAL_CACHE_LIMIT = 1024;
+
+}
+
+static thread_local LoggerCache t_loggerCache;
+static std::atomic<uint64_t> s_loggerManagerId(0);
+
+LoggerManager::LoggerManager()
+    :m_id(++s_loggerManagerId) {
+    m_root.reset(new Logger);
+    m_root->addHandler(LogHandler::ptr(new StdoutLogHandler));
+
+    m_loggers[m_root->m_name] = m_root;
+}
+
+Logger::ptr LoggerManager::getLogger(const std::string& name) {
+    LoggerCache& cache = t_loggerCache;
+    if(cache.owner == m_id) {
+        auto it = cache.loggers.find(name);
+        if(it != cache.loggers.end()) {
+            return it->second;
+        }
+    } else {
+        cache.loggers.clear();
+        cache.literals.clear();
+        cache.owner = m_id;
+    }
+
+    Logger::ptr logger;
+    {
+        Mutex::Lock lock(m_mutex);
+        logger = getLoggerLocked(name);
+    }
+    cache.loggers.emplace(name, logger);
+    return logger;
+}
+
+Logger::ptr LoggerManager::getLogger(const char* name) {
+    if(!*name) {
+        return m_root;
+    }
+    LoggerCache& cache = t_loggerCache;
+    if(cache.owner == m_id) {
+        auto it = cache.literals.find(name);
+        if(it != cache.literals.end() && strcmp(it->second->getName().c_str(), name) == 0) {
+            return it->second;
+        }
+    }
+    Logger::ptr logger = getLogger(std::string(name));
+    if(cache.literals.size() >= LITERAL_CACHE_LIMIT) {
+        cache.literals.clear();
+    }
+    cache.literals[name] = logger;
+    return logger;
+}
+
+Logger::ptr LoggerManager::findLogger(const std::string& name) {
+    Mutex::Lock lock(m_mutex);
+    auto it = m_loggers.find(name);
+    return it == m_loggers.end() ? nullptr : it->second;
+}
+
+std::vector<LoggerMetrics> LoggerManager::getMetrics() {
+    std::vector<Logger::ptr> loggers;
+    {
+        Mutex::Lock lock(m_mutex);
+        loggers.push_back(m_root);
+        for(auto& i : m_loggers) {
+            if(i.second != m_root) {
+                loggers.push_back(i.second);
+            }
+        }
+    }
+    std::vector<LoggerMetrics> metrics;
+    for(auto& i : loggers) {
+        metrics.push_back(i->getMetrics());
+    }
+    return metrics;
+}
+
+Logger::ptr LoggerManager::getLoggerLocked(const std::string& name) {
+    if(name.empty()) {
+        return m_root;
+    }
+    auto it = m_loggers.find(name);
+    if(it != m_loggers.end()) {
+        return it->second;
+    }
+
+    Logger::ptr logger(new Logger(name));
+    size_t pos = name.rfind('.');
+    logger->m_root = pos == std::string::npos ? m_root : getLoggerLocked(name.substr(0, pos));
+    m_loggers[name] = logger;
+    return logger;
+}
 
 }
@@ -7,7 +7,96 @@
 #include <list>
 #include <fstream>
 #include <sstream>
+#include <stdarg.h>
 #include <vector>
+#include <atomic>
+#include <map>
+#include <type_traits>
+#include "log_stream.h"
+#include "Util/singleton.h"
+#include "Thread/mutex.h"
+#include "Util/metrics.h"
+
+/**
+ * @brief 编译期最低日志级别, 低于它的日志语句在编译期被去掉
+ * @details 数值同LogLevel::Level, 例如 -DGAMESERVER_LOG_MIN_LEVEL=2 去掉所有DEBUG日志
+ */
+#ifndef GAMESERVER_LOG_MIN_LEVEL
+#define GAMESERVER_LOG_MIN_LEVEL 0
+#endif
+
+/**
+ * @brief 调用点是否放行, Logger对该级别设置了限流时才检查调用点的状态
+ * @details 每个宏展开处有一个静态的LogSite
+ */
+#define GAMESERVER_LOG_SITE_ALLOWED(logger, level) \
+    (__builtin_expect(!(logger)->hasRateLimit(level), 1) \
+        || []() -> gameserver::LogSite& { \
+               static gameserver::LogSite gs_log_site(__FILE__, __LINE__); \
+               return gs_log_site; \
+           }().allow(logger, level))
+
+/**
+ * @brief 使用流式方式将日志级别level的日志写入到logger
+ * @details 先比较级别(编译期常量比较和relaxed原子读), 通过后才创建日志事件,
+ *          被过滤的语句不会对<<右边的表达式求值.
+ *          飞行记录器(FlightRecorder)要记录的级别即使Logger不输出也会创建事件.
+ *          被调用点限流或采样丢弃的语句同样不求值
+ */
+#define GAMESERVER_LOG_LEVEL(logger, level) \
+    if((level) < GAMESERVER_LOG_MIN_LEVEL || __builtin_expect(!(logger)->isEnabled(level) \
+            && !gameserver::FlightRecorder::IsEnabled(level), 0) \
+            || !GAMESERVER_LOG_SITE_ALLOWED(logger, level)) {} else \
+        gameserver::LogEventWrap(logger, level, __FILE__, __LINE__).getSS()
+
+#define GAMESERVER_LOG_DEBUG(logger) GAMESERVER_LOG_LEVEL(logger, gameserver::LogLevel::DEBUG)
+#define GAMESERVER_LOG_INFO(logger) GAMESERVER_LOG_LEVEL(logger, gameserver::LogLevel::INFO)
+#define GAMESERVER_LOG_WARN(logger) GAMESERVER_LOG_LEVEL(logger, gameserver::LogLevel::WARN)
+#define GAMESERVER_LOG_ERROR(logger) GAMESERVER_LOG_LEVEL(logger, gameserver::LogLevel::ERROR)
+#define GAMESERVER_LOG_FATAL(logger) GAMESERVER_LOG_LEVEL(logger, gameserver::LogLevel::FATAL)
+
+/**
+ * @brief 使用格式化方式将日志级别level的日志写入到logger
+ */
+#define GAMESERVER_LOG_FMT_LEVEL(logger, level, fmt, ...) \
+    if((level) < GAMESERVER_LOG_MIN_LEVEL || __builtin_expect(!(logger)->isEnabled(level) \
+            && !gameserver::FlightRecorder::IsEnabled(level), 0) \
+            || !GAMESERVER_LOG_SITE_ALLOWED(logger, level)) {} else \
+        gameserver::LogEventWrap(logger, level, __FILE__, __LINE__).getEvent()->format(fmt, ##__VA_ARGS__)
+
+#define GAMESERVER_LOG_FMT_DEBUG(logger, fmt, ...) GAMESERVER_LOG_FMT_LEVEL(logger, gameserver::LogLevel::DEBUG, fmt, ##__VA_ARGS__)
+#define GAMESERVER_LOG_FMT_INFO(logger, fmt, ...) GAMESERVER_LOG_FMT_LEVEL(logger, gameserver::LogLevel::INFO, fmt, ##__VA_ARGS__)
+#define GAMESERVER_LOG_FMT_WARN(logger, fmt, ...) GAMESERVER_LOG_FMT_LEVEL(logger, gameserver::LogLevel::WARN, fmt, ##__VA_ARGS__)
+#define GAMESERVER_LOG_FMT_ERROR(logger, fmt, ...) GAMESERVER_LOG_FMT_LEVEL(logger, gameserver::LogLevel::ERROR, fmt, ##__VA_ARGS__)
+#define GAMESERVER_LOG_FMT_FATAL(logger, fmt, ...) GAMESERVER_LOG_FMT_LEVEL(logger, gameserver::LogLevel::FATAL, fmt, ##__VA_ARGS__)
+
+/**
+ * @brief 带结构化字段的流式日志
+ * @details 用法: GAMESERVER_LOG_FIELDS_INFO(logger).with("uid", uid).with("room", name) << "login";
+ *          字段由JSON格式(见log_json.h)输出, 文本格式忽略字段.
+ *          过滤规则同GAMESERVER_LOG_LEVEL, 被过滤时with()的参数也不求值
+ */
+#define GAMESERVER_LOG_FIELDS_LEVEL(logger, level) \
+    if((level) < GAMESERVER_LOG_MIN_LEVEL || __builtin_expect(!(logger)->isEnabled(level) \
+            && !gameserver::FlightRecorder::IsEnabled(level), 0) \
+            || !GAMESERVER_LOG_SITE_ALLOWED(logger, level)) {} else \
+        gameserver::LogEventWrap(logger, level, __FILE__, __LINE__)
+
+#define GAMESERVER_LOG_FIELDS_DEBUG(logger) GAMESERVER_LOG_FIELDS_LEVEL(logger, gameserver::LogLevel::DEBUG)
+#define GAMESERVER_LOG_FIELDS_INFO(logger) GAMESERVER_LOG_FIELDS_LEVEL(logger, gameserver::LogLevel::INFO)
+#define GAMESERVER_LOG_FIELDS_WARN(logger) GAMESERVER_LOG_FIELDS_LEVEL(logger, gameserver::LogLevel::WARN)
+#define GAMESERVER_LOG_FIELDS_ERROR(logger) GAMESERVER_LOG_FIELDS_LEVEL(logger, gameserver::LogLevel::ERROR)
+#define GAMESERVER_LOG_FIELDS_FATAL(logger) GAMESERVER_LOG_FIELDS_LEVEL(logger, gameserver::LogLevel::FATAL)
+
+/**
+ * @brief 获取主日志器
+ */
+#define GAMESERVER_LOG_ROOT() gameserver::LoggerMgr::GetInstance()->getRoot()
+
+/**
+ * @brief 获取name的日志器
+ */
+#define GAMESERVER_LOG_NAME(name) gameserver::LoggerMgr::GetInstance()->getLogger(name)
 
 namespace gameserver{
 
@@ -50,11 +139,27 @@ public:
 class LogEvent{
 public:
     typedef std::shared_ptr<LogEvent> ptr;  // smart pointer enable copy
+
+    LogEvent();
     // std::shared_ptr<Logger> logger, LogLevel::Level level
+    /**
+     * @brief 构造函数
+     * @param[in] thread_name 线程名称, 不拷贝, 必须在事件输出前一直有效(驻留的名称或字面量)
+     */
     LogEvent(std::shared_ptr<Logger> logger
             ,const char* file, int32_t line, uint32_t elapse
             ,uint32_t thread_id, uint32_t fiber_id, uint64_t time
-            ,const std::string& thread_name);
+            ,const char* thread_name, uint32_t usec = 0);
+
+    /**
+     * @brief 从线程局部的对象池创建日志事件
+     * @details 事件对象和shared_ptr控制块一起从池中分配, 消息写入内联缓冲,
+     *          稳定运行时不再分配内存
+     */
+    static LogEvent::ptr Create(std::shared_ptr<Logger> logger
+            ,const char* file, int32_t line, uint32_t elapse
+            ,uint32_t thread_id, uint32_t fiber_id, uint64_t time
+            ,const char* thread_name, uint32_t usec = 0);
 
     const char* getFile() const { return m_file;}
     int32_t getLine() const { return m_line;}
@@ -62,14 +167,41 @@ public:
     uint32_t getThreadId() const { return m_threadId;}
     uint32_t getFiberId() const { return m_fiberId;}
     uint64_t getTime() const { return m_time;}
-    const std::string& getThreadName() const { return m_threadName;}
+    uint32_t getUsec() const { return m_usec;}
+    const char* getThreadName() const { return m_threadName;}
     std::string getContent() const { return m_ss.str();}
-    std::shared_ptr<Logger> getLogger() const { return m_logger;}
+    const std::shared_ptr<Logger>& getLogger() const { return m_logger;}
     LogLevel::Level getLevel() const { return m_level;}
-    std::stringstream& getSS() { return m_ss;}
+    LogStream& getSS() { return m_ss;}
+    const LogStream& getSS() const { return m_ss;}
 
-    void format(const char* fmt, ...); //格式化写入日志内容
+    void format(const char* fmt, ...) __attribute__((format(printf, 2, 3))); //格式化写入日志内容
     void format(const char* fmt, va_list al);
+
+    /**
+     * @brief 添加结构化字段, 按JSON编码保存, 由JSON格式原样输出
+     * @param[in] key 字段名
+     * @param[in] value 字段值, 字符串转义后加引号, 数值和布尔值直接输出
+     */
+    void addField(const char* key, const char* value);
+    void addField(const char* key, const std::string& value);
+    void addField(const char* key, bool value);
+    void addField(const char* key, int64_t value);
+    void addField(const char* key, uint64_t value);
+    void addField(const char* key, double value);
+
+    template<class T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    addField(const char* key, T value) { addField(key, (int64_t)value);}
+
+    template<class T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+    addField(const char* key, T value) { addField(key, (uint64_t)value);}
+
+    /**
+     * @brief 已编码的字段, 每个字段为 ,"key":value
+     */
+    const std::string& getFields() const { return m_fields;}
 private:
     /// 文件名
     const char* m_file = nullptr;
@@ -81,22 +213,32 @@ private:
     uint32_t m_threadId = 0;
     /// 协程ID
     uint32_t m_fiberId = 0;
-    /// 时间戳
+    /// 时间戳(秒)
     uint64_t m_time = 0;
-    /// 线程名称
-    std::string m_threadName;
+    /// 时间戳的微秒部分
+    uint32_t m_usec = 0;
+    /// 线程名称, 只保存指针, 指向驻留的名称(Thread::GetName())或字面量
+    const char* m_threadName = "";
     /// 日志内容流
-    std::stringstream m_ss;
+    LogStream m_ss;
+    /// 已编码的结构化字段, 没有字段时不分配内存
+    std::string m_fields;
     /// 日志器
     std::shared_ptr<Logger> m_logger;
     /// 日志等级
-    LogLevel::Level m_level;
+    LogLevel::Level m_level = LogLevel::UNKNOW;
 };
 
 //输出格式
 class LogFormatter{
 public:
     typedef std::shared_ptr<LogFormatter> ptr;
+    /// 编译期格式的格式化函数
+    typedef void (*FastFormat)(LogStream& os, LogLevel::Level level, const LogEvent& event);
+    /// 默认格式
+    static constexpr const char* DEFAULT_PATTERN = "%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%l%T%m%n";
+    /// JSON格式, 见JsonLogFormat
+    static constexpr const char* JSON_PATTERN = "json";
     /**
      * @brief 构造函数
      * @param[in] pattern 格式模板
@@ -115,11 +257,25 @@ public:
      *  %N 线程名称
      *
      *  默认格式 "%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%l%T%m%n"
+     *  模板为"json"时每条日志输出一个JSON对象(见log_json.h)
+     *
+     *  格式与编译期格式(见log_format.h)一致时走编译期格式, 否则逐项解析输出
+     */
+    LogFormatter(const std::string& pattern, FastFormat fast = nullptr);
+
+    std::string format(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event);
+    std::ostream& format(std::ostream& ofs, const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event);
+    /**
+     * @brief 格式化日志追加到字符缓冲
      */
-    LogFormatter(const std::string& pattern);
+    void format(LogStream& os, const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event);
 
-    std::string format(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event);
-    std::ostream& format(std::ostream& ofs, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event);
+    const std::string& getPattern() const { return m_pattern;}
+    bool isError() const { return m_error;}
+    /**
+     * @brief 是否走编译期格式
+     */
+    bool isStatic() const { return m_fast != nullptr;}
 public:
     //日志内容项格式化
     class FormatItem {
@@ -133,7 +289,7 @@ public:
          */
         typedef std::shared_ptr<FormatItem> ptr;
         virtual ~FormatItem() {}
-        virtual void format(std::ostream& os, std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) = 0;
+        virtual void format(std::ostream& os, const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) = 0;
     };
     void init();
 private:
@@ -143,72 +299,449 @@ private:
     std::vector<FormatItem::ptr> m_items;
     /// 是否有错误
     bool m_error = false;
+    /// 编译期格式, 为空时使用m_items
+    FastFormat m_fast = nullptr;
+
+};
+
+/**
+ * @brief Handler的计量快照
+ */
+struct LogHandlerMetrics {
+    /// Handler名称
+    std::string name;
+    /// 交给Handler的日志数
+    uint64_t events = 0;
+    /// 写入的字节数, 只统计接受已格式化日志(write)的部分
+    uint64_t bytes = 0;
+    /// Handler自己丢弃的日志数(异步队列满, 映射段未就绪等)
+    uint64_t dropped = 0;
+    /// 异步Handler队列中的日志数
+    uint64_t queueDepth = 0;
+    /// 写入耗时(纳秒, 取样)
+    HistogramSnapshot writeTime;
+};
 
+/**
+ * @brief Logger的计量快照
+ */
+struct LoggerMetrics {
+    /// 日志器名称
+    std::string name;
+    /// 通过级别检查的日志数
+    uint64_t accepted = 0;
+    /// 调用log()后被级别过滤的日志数, 日志宏在创建事件前过滤的不计
+    uint64_t filtered = 0;
+    /// 被调用点限流或采样丢弃的日志数
+    uint64_t dropped = 0;
+    /// 格式化耗时(纳秒, 取样)
+    HistogramSnapshot formatTime;
+    /// 各Handler
+    std::vector<LogHandlerMetrics> handlers;
+};
+
+/**
+ * @brief Handler的刷新策略
+ * @details 满足任一条件时刷新:
+ *          未刷新的字节数达到bytes;
+ *          距上次刷新超过intervalMs毫秒(写入时检查, 没有新日志时不会触发, 需要时调用flush());
+ *          日志级别不低于level.
+ *          条件为0或UNKNOW表示不启用, 都不启用时只在缓冲满或调用flush()时写出
+ */
+struct FlushPolicy {
+    /// 未刷新字节数阈值
+    uint32_t bytes = 0;
+    /// 刷新间隔(毫秒)
+    uint32_t intervalMs = 0;
+    /// 不低于该级别的日志立即刷新
+    LogLevel::Level level = LogLevel::UNKNOW;
+
+    /**
+     * @brief 每条日志都刷新
+     */
+    static FlushPolicy PerLine() {
+        FlushPolicy p;
+        p.bytes = 1;
+        return p;
+    }
+
+    /**
+     * @brief 按字节数/时间/级别刷新
+     */
+    static FlushPolicy Buffered(uint32_t bytes, uint32_t interval_ms, LogLevel::Level level = LogLevel::UNKNOW) {
+        FlushPolicy p;
+        p.bytes = bytes;
+        p.intervalMs = interval_ms;
+        p.level = level;
+        return p;
+    }
+
+    /**
+     * @brief 默认策略: 64K字节或1秒, WARN及以上立即刷新
+     */
+    static FlushPolicy Default() {
+        return Buffered(64 * 1024, 1000, LogLevel::WARN);
+    }
 };
 
 // 输出处理
-class LogHandler{
+class LogHandler : public CacheAligned {
 friend class Logger;
 public:
     typedef std::shared_ptr<LogHandler> ptr;
+    /// 保护格式器和刷新计数, 默认的写路径也用它; 文件和标准输出的写入是系统调用, 可能阻塞, 用互斥量.
+    /// 临界区只有memcpy的Handler(如mmap, 网络)另用自旋锁保护写路径
+    typedef Mutex MutexType;
     virtual ~LogHandler () {}  // destructer
 
-    virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) = 0;
+    virtual void log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) = 0;
+
+    /**
+     * @brief 用给定的格式器输出日志, Handler有自己的格式器时用自己的
+     * @details AsyncLogHandler用入队时的格式器调用被包装的Handler, 不改动它们的格式器.
+     *          默认实现: isWriter()的Handler格式化后调用write(), 其余调用log();
+     *          不接受已格式化日志又依赖Logger格式器的Handler需要重写
+     */
+    virtual void logWith(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event
+                         ,const LogFormatter::ptr& formatter);
+
+    /**
+     * @brief 写入已格式化的日志
+     * @details Logger对使用同一格式器的Handler只格式化一次, 再把结果交给各Handler的write;
+     *          只有isWriter()为true的Handler会这样调用, 其余仍调用log()
+     */
+    virtual void write(LogLevel::Level level, const char* data, size_t len) {}
 
-    void setFormatter(LogFormatter::ptr val) {m_formatter = val;}
+    /**
+     * @brief 将缓冲中的日志刷到目标
+     */
+    virtual void flush() {}
+
+    /**
+     * @brief 设置日志格式器, 设置后不再跟随Logger的格式器
+     */
+    void setFormatter(LogFormatter::ptr val);
     LogFormatter::ptr getFormatter();
 
+    LogLevel::Level getLevel() const { return (LogLevel::Level)m_level.load(std::memory_order_relaxed);}
+    void setLevel(LogLevel::Level val) { m_level.store(val, std::memory_order_relaxed);}
+
+    /**
+     * @brief 是否接受已格式化的日志(write)
+     */
+    bool isWriter() const { return m_writer;}
+
+    void setFlushPolicy(const FlushPolicy& val);
+    FlushPolicy getFlushPolicy();
+
+    /**
+     * @brief 名称, 用于计量输出
+     */
+    virtual std::string getName() const { return "handler";}
+
+    /**
+     * @brief Handler自己丢弃的日志数
+     */
+    virtual uint64_t getDropped() const { return 0;}
+
+    /**
+     * @brief 排队等待写出的日志数, 同步Handler为0
+     */
+    virtual size_t getQueueDepth() const { return 0;}
+
+    /**
+     * @brief 调用log()并计量, Logger和AsyncLogHandler通过它调用Handler
+     * @param[in] timed 是否计时
+     * @param[in] formatter 非空时改调logWith()
+     */
+    void meteredLog(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event, bool timed
+                    ,const LogFormatter::ptr& formatter = nullptr);
+
+    /**
+     * @brief 调用write()并计量
+     */
+    void meteredWrite(LogLevel::Level level, const char* data, size_t len, bool timed);
+
+    /**
+     * @brief 计量快照
+     */
+    LogHandlerMetrics getMetrics() const;
+
 protected:
-    /// 日志级别
-    LogLevel::Level m_level = LogLevel::DEBUG;
+    /**
+     * @brief 记下写入的字节数并按刷新策略判断是否要刷新, 调用方持有写路径的锁
+     */
+    bool needFlush(LogLevel::Level level, size_t len);
+
+    /**
+     * @brief 刷新后重置计数, 调用方持有写路径的锁
+     */
+    void resetFlush();
+private:
+    /**
+     * @brief 替换格式器, 调用方持有m_mutex
+     * @return 被替换的格式器, 调用方在锁外交给RCU回收
+     */
+    LogFormatter::ptr swapFormatter(const LogFormatter::ptr& val);
+
+protected:
+    /// 日志级别, 写线程不加锁读取
+    std::atomic<int> m_level {LogLevel::DEBUG};
     /// 是否有自己的日志格式器
     bool m_hasFormatter = false;
+    /// 是否接受已格式化的日志
+    bool m_writer = false;
     /// Mutex
-
+    MutexType m_mutex;
     /// 日志格式器
     LogFormatter::ptr m_formatter;
+    /// 当前格式器, Logger::log在RCU读区里读取, 被替换的格式器延迟回收
+    std::atomic<LogFormatter*> m_current{nullptr};
+    /// 刷新策略, 写路径不一定持有m_mutex, 各项分开原子读取
+    std::atomic<uint32_t> m_flushBytes {FlushPolicy::Default().bytes};
+    std::atomic<uint32_t> m_flushIntervalMs {FlushPolicy::Default().intervalMs};
+    std::atomic<int> m_flushLevel {FlushPolicy::Default().level};
+    /// 上次刷新后写入的字节数
+    uint64_t m_unflushed = 0;
+    /// 上次刷新时间(毫秒)
+    uint64_t m_lastFlush = 0;
+    /// 交给Handler的日志数
+    ShardedCounter m_events;
+    /// 写入字节数
+    ShardedCounter m_bytes;
+    /// 写入耗时
+    LatencyHistogram m_writeTime;
 };
 
 //日志类
-class Logger : public std::enable_shared_from_this<Logger>{  //可以使用shared_from_this成员函数获取自身的shared_ptr指针
+class Logger : public std::enable_shared_from_this<Logger>, public CacheAligned {  //可以使用shared_from_this成员函数获取自身的shared_ptr指针
+friend class LoggerManager;
+friend class LogSite;
 public:
     typedef std::shared_ptr<Logger> ptr;
+    /// 只在修改配置时使用, log()不加锁
+    typedef Mutex MutexType;
 
     // 在cpp文件里完成
     Logger (const std::string& name = "root");
+    ~Logger();
 
-    void log(LogLevel::Level level, LogEvent::ptr event);
-    void debug(LogEvent::ptr event);
-    void info(LogEvent::ptr event);
-    void warn(LogEvent::ptr event);
-    void error(LogEvent::ptr event);
-    void fatal(LogEvent::ptr event);
+    void log(LogLevel::Level level, const LogEvent& event);
+    void log(LogLevel::Level level, const LogEvent::ptr& event) { log(level, *event);}
+    void debug(const LogEvent::ptr& event);
+    void info(const LogEvent::ptr& event);
+    void warn(const LogEvent::ptr& event);
+    void error(const LogEvent::ptr& event);
+    void fatal(const LogEvent::ptr& event);
 
     void addHandler(LogHandler::ptr handler);
     void delHandler(LogHandler::ptr handler);
     void clearHandler();
 
-    LogLevel::Level getLevel() const { return m_level;}
-    void setLevel(LogLevel::Level val) { m_level = val;}
+    LogLevel::Level getLevel() const { return (LogLevel::Level)m_level.load(std::memory_order_relaxed);}
+    void setLevel(LogLevel::Level val) { m_level.store(val, std::memory_order_relaxed);}
+    /**
+     * @brief 级别level的日志是否输出, 日志宏在创建事件前调用
+     */
+    bool isEnabled(LogLevel::Level level) const { return level >= m_level.load(std::memory_order_relaxed);}
     const std::string& getName() const { return m_name;}
     void setFormatter(LogFormatter::ptr val);
     void setFormatter(const std::string& val);
     LogFormatter::ptr getFormatter();
+    /**
+     * @brief 没有Handler时转发到的上级日志器
+     */
+    const Logger::ptr& getParent() const { return m_root;}
+
+    /**
+     * @brief 设置级别level的调用点限流, 对每个调用点(文件:行号)分别计算
+     * @param[in] level 日志级别, 只影响这一级
+     * @param[in] rate 每秒放行的条数, 0为不限
+     * @param[in] burst 突发允许的条数, 0按1算
+     * @param[in] sample 每sample条取1条, 在限流之前; 0或1为不采样
+     * @details 被丢弃的条数按调用点汇总成一行, 以被丢弃日志的级别输出, 同一调用点每个汇报间隔
+     *          最多一行(见LogSite::SetReportInterval); 风暴结束后剩下的条数由LogSite::ReportAll输出
+     */
+    void setRateLimit(LogLevel::Level level, uint32_t rate, uint32_t burst = 0, uint32_t sample = 1);
+    void clearRateLimit(LogLevel::Level level);
+
+    /**
+     * @brief 级别level是否设置了限流, 日志宏在创建事件前调用
+     */
+    bool hasRateLimit(LogLevel::Level level) const {
+        return m_limitMask.load(std::memory_order_relaxed) & (1u << level);
+    }
+
+    /**
+     * @brief 取级别level的限流设置
+     */
+    void getRateLimit(LogLevel::Level level, uint32_t& rate, uint32_t& burst, uint32_t& sample) const;
+
+    /**
+     * @brief 计量快照, 包括当前各Handler
+     */
+    LoggerMetrics getMetrics();
+
+
+private:
+    /**
+     * @brief Handler列表和格式器的不可变快照
+     */
+    struct Config;
 
+    /**
+     * @brief 发布新快照, 旧快照等读者离开后回收, 调用方持有m_mutex
+     */
+    void publish(Config* config);
+
+    /**
+     * @brief 写日志, self是调用方借出的自身引用, 避免每条日志都增减引用计数
+     */
+    void doLog(const Logger::ptr& self, LogLevel::Level level, const LogEvent& event);
 
+    /**
+     * @brief 把日志交给各Handler, 使用同一格式器的Handler只格式化一次, 调用方在RCU读区里
+     */
+    static void dispatch(const Logger::ptr& self, const std::vector<LogHandler::ptr>& handlers
+                         ,LogLevel::Level level, const LogEvent& event);
 private:
     /// 日志名称
     std::string m_name;
-    /// 日志级别
-    LogLevel::Level m_level;
+    /// 日志级别, 日志宏在任意线程读取
+    std::atomic<int> m_level;
     /// Mutex
-
-    /// 日志目标集合
-    std::list<LogHandler::ptr> m_handlers;
-    /// 日志格式器
-    LogFormatter::ptr m_formatter;
-    /// 主日志器
+    MutexType m_mutex;
+    /// 当前配置, log()在RCU读区里读取; 修改时复制一份改完再原子替换
+    std::atomic<Config*> m_config;
+    /// 上级日志器, 自己没有Handler时转发给它; net.http的上级是net, 顶层的上级是root
     Logger::ptr m_root;
+    /// 设置了限流的级别, 每级一位
+    std::atomic<uint32_t> m_limitMask;
+    /// 各级别每秒放行条数
+    std::atomic<uint32_t> m_limitRate[LogLevel::FATAL + 1];
+    /// 各级别突发条数
+    std::atomic<uint32_t> m_limitBurst[LogLevel::FATAL + 1];
+    /// 各级别采样间隔
+    std::atomic<uint32_t> m_limitSample[LogLevel::FATAL + 1];
+    /// 通过级别检查的日志数
+    ShardedCounter m_accepted;
+    /// 被级别过滤的日志数
+    ShardedCounter m_filtered;
+    /// 被限流丢弃的日志数
+    ShardedCounter m_dropped;
+    /// 格式化耗时
+    LatencyHistogram m_formatTime;
+};
+
+/**
+ * @brief 日志调用点的限流和采样状态
+ * @details 日志宏为每个调用点生成一个静态对象, 只在Logger设置了限流时使用.
+ *          限流用GCRA(等价于令牌桶): 只保存一个理论到达时间, 放行时CAS推进,
+ *          丢弃时只读不写; 采样和丢弃计数是调用点上的relaxed原子计数, 都不加锁.
+ *          同一调用点用不同的Logger时共用状态.
+ *          有丢弃的调用点加入一个全局链表, 距上次汇总超过间隔时输出一行"suppressed N messages",
+ *          由该调用点自己的日志, 其他限流调用点的日志(顺带扫描链表)或ReportAll触发
+ */
+class LogSite {
+public:
+    LogSite(const char* file, int32_t line);
+
+    /**
+     * @brief 本条日志是否放行
+     * @details 距上次汇总超过间隔且有被丢弃的日志时, 先输出一行汇总
+     */
+    bool allow(const std::shared_ptr<Logger>& logger, LogLevel::Level level);
+
+    /**
+     * @brief 还没汇总输出的丢弃条数
+     */
+    uint64_t getSuppressed() const { return m_suppressed.load(std::memory_order_relaxed);}
+
+    /**
+     * @brief 输出各调用点还没汇总的丢弃条数
+     * @param[in] force 为true时不管距上次汇总多久都输出, 如退出前
+     * @details 风暴结束后调用点不再有日志, 剩下的条数靠这里输出; 应定时调用, 如IOManager的循环定时器
+     */
+    static void ReportAll(bool force = false);
+
+    /**
+     * @brief 设置同一调用点两次汇总的最小间隔(毫秒), 默认1000
+     */
+    static void SetReportInterval(uint32_t ms);
+private:
+    /**
+     * @brief 记下一条丢弃的日志
+     */
+    void suppress(const std::shared_ptr<Logger>& logger, LogLevel::Level level);
+
+    /**
+     * @brief 距上次汇总超过间隔(或force)且有丢弃时输出一行汇总
+     */
+    void report(uint64_t now, bool force);
+private:
+    /// 文件名
+    const char* m_file;
+    /// 行号
+    int32_t m_line;
+    /// 经过采样的条数
+    std::atomic<uint64_t> m_seen;
+    /// 理论到达时间(纳秒, 单调时钟)
+    std::atomic<uint64_t> m_tat;
+    /// 上次汇总后丢弃的条数
+    std::atomic<uint64_t> m_suppressed;
+    /// 上次汇总的时间(纳秒)
+    std::atomic<uint64_t> m_lastReport;
+    /// 保护m_logger
+    Spinlock m_mutex;
+    /// 最近丢弃日志的日志器, 汇总输出到这里; 持有引用, 裸指针不会因为地址复用而误判相同
+    std::shared_ptr<Logger> m_logger;
+    /// m_logger的裸指针, 丢弃时先比较它, 相同就不加锁
+    std::atomic<Logger*> m_loggerRaw;
+    /// 最近丢弃日志的级别, 汇总用这个级别
+    std::atomic<int> m_level;
+    /// 是否已经加入全局链表
+    std::atomic<bool> m_registered;
+    /// 全局链表的下一个
+    LogSite* m_next;
+};
+
+/**
+ * @brief 日志事件包装器, 析构时把事件写入日志器
+ * @details 日志宏创建的临时对象, 语句结束时交给飞行记录器和日志器,
+ *          FATAL日志输出后转储飞行记录器
+ */
+class LogEventWrap {
+public:
+    /**
+     * @brief 创建日志事件, 填入当前线程id, 协程id和时间
+     */
+    LogEventWrap(const Logger::ptr& logger, LogLevel::Level level, const char* file, int32_t line);
+    ~LogEventWrap();
+
+    const LogEvent::ptr& getEvent() const { return m_event;}
+    LogStream& getSS() { return m_event->getSS();}
+
+    /**
+     * @brief 添加结构化字段
+     */
+    template<class T>
+    LogEventWrap& with(const char* key, const T& value) {
+        m_event->addField(key, value);
+        return *this;
+    }
+
+    /**
+     * @brief 写入日志内容, 之后按LogStream使用
+     */
+    template<class T>
+    LogStream& operator<<(const T& value) {
+        return m_event->getSS() << value;
+    }
+private:
+    /// 日志级别
+    LogLevel::Level m_level;
+    /// 日志事件
+    LogEvent::ptr m_event;
 };
 
 //handlers
@@ -218,8 +751,12 @@ private:
 class StdoutLogHandler : public LogHandler{
 public:
     typedef std::shared_ptr<StdoutLogHandler> ptr;
+    StdoutLogHandler();
     // 需要实现的函数
-    virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
+    virtual void log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) override;
+    virtual void write(LogLevel::Level level, const char* data, size_t len) override;
+    virtual void flush() override;
+    virtual std::string getName() const override { return "stdout";}
 
 private:
 
@@ -232,11 +769,15 @@ class FileLogHandler : public LogHandler{
 public:
     typedef std::shared_ptr<FileLogHandler> ptr;
     FileLogHandler(const std::string& filename);
-    virtual void log(std::shared_ptr<Logger> logger, LogLevel::Level level, LogEvent::ptr event) override;
-
+    virtual void log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) override;
+    virtual void write(LogLevel::Level level, const char* data, size_t len) override;
+    virtual void flush() override;
+    virtual std::string getName() const override { return "file:" + m_filename;}
 
     /**
-     * @brief 重新打开日志文件
+     * @brief 重新打开日志文件, 追加写入
+     * @details 写路径不检查文件是否被外部轮转或删除, 轮转后由定时器或信号处理(如SIGHUP)调用.
+     *          新文件在锁外打开, 打开失败时继续写原来的文件
      * @return 成功返回true
      */
     bool reopen();
@@ -245,10 +786,67 @@ private:
     std::string m_filename;
     /// 文件流
     std::ofstream m_filestream;
-    /// 上次重新打开时间
-    uint64_t m_lastTime = 0;
 };
 
+/**
+ * @brief 日志器管理类
+ * @details 按名字管理日志器, 名字用'.'分级, 如net.http的上级是net, 顶层日志器的上级是root.
+ *          日志器只增不删, 所以每个线程缓存查找结果, 命中时只做一次字符串哈希(字面量只哈希指针),
+ *          不加锁也没有原子操作; 未命中时加锁查找或创建
+ */
+class LoggerManager {
+public:
+    LoggerManager();
+
+    /**
+     * @brief 获取日志器, 不存在则创建(连同各级上级)
+     * @param[in] name 日志器名称
+     */
+    Logger::ptr getLogger(const std::string& name);
+
+    /**
+     * @brief 获取日志器, 同getLogger(const std::string&)
+     * @details 给GAMESERVER_LOG_NAME("xxx")这样的字面量用: 线程缓存按指针查找并比较名称确认,
+     *          命中时不构造临时std::string, 不分配内存
+     */
+    Logger::ptr getLogger(const char* name);
+
+    /**
+     * @brief 查找日志器, 不存在返回nullptr
+     */
+    Logger::ptr findLogger(const std::string& name);
+
+    /**
+     * @brief 返回主日志器
+     */
+    const Logger::ptr& getRoot() const { return m_root;}
+
+    /**
+     * @brief 所有日志器的计量快照, 主日志器在最前
+     */
+    std::vector<LoggerMetrics> getMetrics();
+private:
+    /**
+     * @brief 加锁后查找或创建, 调用方持有m_mutex
+     */
+    Logger::ptr getLoggerLocked(const std::string& name);
+private:
+    /// 管理器编号, 线程缓存用它判断是否属于本管理器
+    uint64_t m_id;
+    /// Mutex
+    Mutex m_mutex;
+    /// 日志器容器
+    std::map<std::string, Logger::ptr> m_loggers;
+    /// 主日志器
+    Logger::ptr m_root;
+};
+
+/// 日志器管理类单例模式
+typedef gameserver::Singleton<LoggerManager> LoggerMgr;
+
 }
 
-#endif
\ No newline at end of file
+// 日志宏用到FlightRecorder::IsEnabled
+#include "flight_recorder.h"
+
+#endif
@@ -0,0 +1,133 @@
+#include "log_format.h"
+#include <atomic>
+
+namespace gameserver{
+
+/// 每个线程的缓存槽位数, 按格式id取模
+static const uint32_t TIMESTAMP_SLOTS = 8;
+/// 时区偏移的刷新周期(秒), 夏令时切换都在整点或半点
+static const uint64_t TIMEZONE_REFRESH = 900;
+/// 一次最多缓存的子格式个数
+static const uint32_t TIMESTAMP_MAX_SUBS = 4;
+
+struct TimestampFormat::Slot {
+    /// 格式id, 0表示空
+    uint32_t id;
+    /// 缓存的秒
+    uint64_t sec;
+    /// 渲染结果长度
+    uint32_t len;
+    /// 渲染出的子格式个数
+    uint32_t nsubs;
+    /// 子格式在buf中的偏移
+    uint32_t offsets[TIMESTAMP_MAX_SUBS];
+    /// 渲染结果, 子格式位置先填0
+    char buf[128];
+};
+
+/**
+ * @brief 线程缓存的时区
+ */
+struct TimeZoneCache {
+    /// 偏移生效的时段, sec / TIMEZONE_REFRESH
+    uint64_t period;
+    /// 与UTC的偏移(秒)
+    long gmtoff;
+    /// 时区名
+    const char* zone;
+    /// 是否夏令时
+    int isdst;
+};
+
+static thread_local TimeZoneCache t_zone = {(uint64_t)-1, 0, nullptr, 0};
+
+static std::atomic<uint32_t> s_timestamp_id(1);
+
+/**
+ * @brief 用缓存的时区偏移分解时间
+ */
+static void LocalTime(uint64_t sec, struct tm& tm) {
+    uint64_t period = sec / TIMEZONE_REFRESH;
+    if(period != t_zone.period) {
+        time_t t = sec;
+        localtime_r(&t, &tm);
+        t_zone.period = period;
+        t_zone.gmtoff = tm.tm_gmtoff;
+        t_zone.zone = tm.tm_zone;
+        t_zone.isdst = tm.tm_isdst;
+        return;
+    }
+    time_t t = sec + t_zone.gmtoff;
+    gmtime_r(&t, &tm);
+    tm.tm_gmtoff = t_zone.gmtoff;
+    tm.tm_zone = t_zone.zone;
+    tm.tm_isdst = t_zone.isdst;
+}
+
+TimestampFormat::TimestampFormat(const std::string& fmt)
+    :m_format(fmt)
+    ,m_id(s_timestamp_id++) {
+    std::string piece;
+    for(size_t i = 0; i < fmt.size(); ++i) {
+        if(fmt[i] == '%' && i + 1 < fmt.size()) {
+            char c = fmt[i + 1];
+            if((c == 'L' || c == 'f') && m_subs.size() < TIMESTAMP_MAX_SUBS) {
+                m_pieces.push_back(piece);
+                piece.clear();
+                m_subs.push_back(c == 'L' ? 3 : 6);
+                ++i;
+                continue;
+            }
+            piece.append(fmt, i, 2);
+            ++i;
+            continue;
+        }
+        piece.append(1, fmt[i]);
+    }
+    m_pieces.push_back(piece);
+}
+
+void TimestampFormat::render(Slot& slot, uint64_t sec) const {
+    struct tm tm;
+    LocalTime(sec, tm);
+    size_t len = 0;
+    slot.nsubs = 0;
+    for(size_t i = 0; i < m_pieces.size(); ++i) {
+        if(!m_pieces[i].empty()) {
+            len += strftime(slot.buf + len, sizeof(slot.buf) - len, m_pieces[i].c_str(), &tm);
+        }
+        if(i < m_subs.size()) {
+            if(len + m_subs[i] > sizeof(slot.buf)) {
+                break;
+            }
+            slot.offsets[i] = len;
+            memset(slot.buf + len, '0', m_subs[i]);
+            len += m_subs[i];
+            ++slot.nsubs;
+        }
+    }
+    slot.len = len;
+    slot.sec = sec;
+    slot.id = m_id;
+}
+
+void TimestampFormat::format(LogStream& os, uint64_t sec, uint32_t usec) const {
+    static thread_local Slot t_slots[TIMESTAMP_SLOTS];
+    Slot& slot = t_slots[m_id % TIMESTAMP_SLOTS];
+    if(slot.id != m_id || slot.sec != sec) {
+        render(slot, sec);
+    }
+    char* p = os.reserve(slot.len);
+    memcpy(p, slot.buf, slot.len);
+    for(size_t i = 0; i < slot.nsubs; ++i) {
+        uint32_t v = m_subs[i] == 3 ? usec / 1000 : usec;
+        char* d = p + slot.offsets[i] + m_subs[i];
+        for(int j = 0; j < m_subs[i]; ++j) {
+            *--d = '0' + v % 10;
+            v /= 10;
+        }
+    }
+    os.commit(slot.len);
+}
+
+}
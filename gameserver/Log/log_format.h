@@ -0,0 +1,287 @@
+#ifndef __GAMESERVER_LOG_FORMAT_H__
+#define __GAMESERVER_LOG_FORMAT_H__
+
+#include "log.h"
+#include "log_stream.h"
+#include <time.h>
+#include <vector>
+
+namespace gameserver{
+
+/**
+ * @brief 按秒缓存渲染结果的时间格式
+ * @details strftime格式之外支持两个子格式:
+ *          %L 毫秒(3位), %f 微秒(6位)
+ *          每个线程缓存最近一秒的渲染结果, 同一秒内只memcpy前缀再填入毫秒/微秒数字.
+ *          换秒时用缓存的时区偏移做gmtime_r, 不再每次localtime_r;
+ *          时区偏移每15分钟重新取一次, 以跟上夏令时切换
+ */
+class TimestampFormat {
+public:
+    TimestampFormat(const std::string& fmt);
+
+    /**
+     * @brief 渲染时间
+     * @param[out] os 输出缓冲
+     * @param[in] sec 秒
+     * @param[in] usec 微秒部分
+     */
+    void format(LogStream& os, uint64_t sec, uint32_t usec) const;
+
+    const std::string& getFormat() const { return m_format;}
+private:
+    /// 线程缓存的槽位
+    struct Slot;
+
+    /**
+     * @brief 把一秒的前缀渲染到线程缓存
+     */
+    void render(Slot& slot, uint64_t sec) const;
+private:
+    /// 原始格式
+    std::string m_format;
+    /// 按%L/%f切开的strftime片段, 片段数比子格式数多1
+    std::vector<std::string> m_pieces;
+    /// 子格式的位数, 3或6
+    std::vector<int> m_subs;
+    /// 线程缓存的键
+    uint32_t m_id;
+};
+
+/**
+ * @brief 编译期确定的日志格式
+ * @details 运行期解析的LogFormatter每个字段一次虚函数调用加一次ostream输出.
+ *          这里每个字段是一个类型, 整个格式是一个类型列表,
+ *          StaticLogFormatter::format展开后是一串内联的缓冲写入.
+ *          每个字段提供:
+ *          write() 写入字段内容
+ *          match() constexpr, 匹配格式模板开头, 返回消耗的字符数, 不匹配返回0
+ */
+namespace logfmt{
+
+/**
+ * @brief 模板p是否以lit开头, 是则返回lit的长度, 否则返回0
+ */
+constexpr size_t prefix(const char* p, const char* lit, size_t n = 0) {
+    return lit[n] == '\0' ? n
+        : (p[n] != lit[n] ? 0 : prefix(p, lit, n + 1));
+}
+
+/**
+ * @brief 普通字符
+ */
+template<char C>
+struct Char {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.append(C);
+    }
+    static constexpr size_t match(const char* p) {
+        return C == '%' ? prefix(p, "%%") : (p[0] == C ? 1 : 0);
+    }
+};
+
+/// %T 制表符
+struct Tab {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.append('\t');
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%T");}
+};
+
+/// %n 换行
+struct NewLine {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.append('\n');
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%n");}
+};
+
+/// %m 消息
+struct Message {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.append(event.getSS().data(), event.getSS().size());
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%m");}
+};
+
+/// %p 日志级别
+struct Level {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.append(LogLevel::ToString(level));
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%p");}
+};
+
+/// %r 累计毫秒数
+struct Elapse {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.appendUInt(event.getElapse());
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%r");}
+};
+
+/// %c 日志名称
+struct Name {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.append(event.getLogger()->getName());
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%c");}
+};
+
+/// %t 线程id
+struct ThreadId {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.appendUInt(event.getThreadId());
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%t");}
+};
+
+/// %N 线程名称
+struct ThreadName {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.append(event.getThreadName());
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%N");}
+};
+
+/// %F 协程id
+struct FiberId {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.appendUInt(event.getFiberId());
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%F");}
+};
+
+/// %f 文件名
+struct File {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.append(event.getFile());
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%f");}
+};
+
+/// %l 行号
+struct Line {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        os.appendInt(event.getLine());
+    }
+    static constexpr size_t match(const char* p) { return prefix(p, "%l");}
+};
+
+/**
+ * @brief %d{%Y-%m-%d %H:%M:%S} 或 %d
+ */
+struct DateTime {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        static const TimestampFormat s_format("%Y-%m-%d %H:%M:%S");
+        s_format.format(os, event.getTime(), event.getUsec());
+    }
+    static constexpr size_t match(const char* p) {
+        return prefix(p, "%d{%Y-%m-%d %H:%M:%S}") ? prefix(p, "%d{%Y-%m-%d %H:%M:%S}")
+            : (prefix(p, "%d") && p[2] != '{' ? 2 : 0);
+    }
+};
+
+/**
+ * @brief %d{%Y-%m-%d %H:%M:%S.%L} 带毫秒
+ */
+struct DateTimeMs {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        static const TimestampFormat s_format("%Y-%m-%d %H:%M:%S.%L");
+        s_format.format(os, event.getTime(), event.getUsec());
+    }
+    static constexpr size_t match(const char* p) {
+        return prefix(p, "%d{%Y-%m-%d %H:%M:%S.%L}");
+    }
+};
+
+/**
+ * @brief 字段类型列表是否正好匹配整个格式模板
+ */
+template<class... Items>
+struct PatternMatcher;
+
+template<>
+struct PatternMatcher<> {
+    static constexpr bool match(const char* p) { return p[0] == '\0';}
+};
+
+template<class Item, class... Rest>
+struct PatternMatcher<Item, Rest...> {
+    static constexpr bool match(const char* p) {
+        return Item::match(p) != 0 && PatternMatcher<Rest...>::match(p + Item::match(p));
+    }
+};
+
+/**
+ * @brief 依次写出各字段
+ */
+template<class... Items>
+struct Writer;
+
+template<>
+struct Writer<> {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {}
+};
+
+template<class Item, class... Rest>
+struct Writer<Item, Rest...> {
+    static void write(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        Item::write(os, level, event);
+        Writer<Rest...>::write(os, level, event);
+    }
+};
+
+}
+
+/**
+ * @brief 编译期确定的日志格式器
+ * @details 用法:
+ *          typedef StaticLogFormatter<logfmt::Level, logfmt::Tab, logfmt::Message, logfmt::NewLine> MyFormat;
+ *          static_assert(MyFormat::Matches("%p%T%m%n"), "pattern mismatch");
+ *          logger->setFormatter(MyFormat::Create("%p%T%m%n"));
+ */
+template<class... Items>
+class StaticLogFormatter {
+public:
+    /**
+     * @brief 格式化日志到缓冲
+     */
+    static void format(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+        logfmt::Writer<Items...>::write(os, level, event);
+    }
+
+    /**
+     * @brief 字段类型列表是否与格式模板一致, 可用于static_assert
+     */
+    static constexpr bool Matches(const char* pattern) {
+        return logfmt::PatternMatcher<Items...>::match(pattern);
+    }
+
+    /**
+     * @brief 创建使用本格式的LogFormatter
+     * @details pattern与字段类型列表不一致时退回运行期解析
+     */
+    static LogFormatter::ptr Create(const std::string& pattern) {
+        return LogFormatter::ptr(new LogFormatter(pattern
+                    , Matches(pattern.c_str()) ? &StaticLogFormatter::format : nullptr));
+    }
+};
+
+/**
+ * @brief 默认格式 "%d{%Y-%m-%d %H:%M:%S}%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%l%T%m%n"
+ */
+typedef StaticLogFormatter<logfmt::DateTime, logfmt::Tab
+        , logfmt::ThreadId, logfmt::Tab
+        , logfmt::ThreadName, logfmt::Tab
+        , logfmt::FiberId, logfmt::Tab
+        , logfmt::Char<'['>, logfmt::Level, logfmt::Char<']'>, logfmt::Tab
+        , logfmt::Char<'['>, logfmt::Name, logfmt::Char<']'>, logfmt::Tab
+        , logfmt::File, logfmt::Char<':'>, logfmt::Line, logfmt::Tab
+        , logfmt::Message, logfmt::NewLine> DefaultLogFormat;
+
+static_assert(DefaultLogFormat::Matches(LogFormatter::DEFAULT_PATTERN), "DefaultLogFormat mismatch");
+
+}
+
+#endif
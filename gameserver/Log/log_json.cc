@@ -0,0 +1,195 @@
+#include "log_json.h"
+#include "log_format.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GAMESERVER_JSON_X86 1
+#endif
+
+namespace gameserver{
+
+namespace json{
+
+/**
+ * @brief 需要转义的字符表, 0为不需要, 否则为\后的字符, 'u'表示\u00XX
+ */
+struct EscapeTable {
+    char table[256];
+    EscapeTable() {
+        memset(table, 0, sizeof(table));
+        for(int i = 0; i < 0x20; ++i) {
+            table[i] = 'u';
+        }
+        table[(unsigned char)'"'] = '"';
+        table[(unsigned char)'\\'] = '\\';
+        table[(unsigned char)'\b'] = 'b';
+        table[(unsigned char)'\f'] = 'f';
+        table[(unsigned char)'\n'] = 'n';
+        table[(unsigned char)'\r'] = 'r';
+        table[(unsigned char)'\t'] = 't';
+    }
+};
+
+/**
+ * @brief 转义表, 函数内静态变量, 其他静态对象初始化时写日志也能用
+ */
+static const EscapeTable& GetEscapeTable() {
+    static const EscapeTable s_table;
+    return s_table;
+}
+
+size_t FindEscapeScalar(const char* p, size_t n) {
+    const char* table = GetEscapeTable().table;
+    for(size_t i = 0; i < n; ++i) {
+        if(table[(unsigned char)p[i]]) {
+            return i;
+        }
+    }
+    return n;
+}
+
+#if defined(GAMESERVER_JSON_X86) && defined(__SSE2__)
+
+size_t FindEscapeSSE2(const char* p, size_t n) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1f);
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        // 无符号 x <= 0x1f 等价于 max(x, 0x1f) == 0x1f
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, slash))
+                                ,_mm_cmpeq_epi8(_mm_max_epu8(x, ctrl), ctrl));
+        int mask = _mm_movemask_epi8(m);
+        if(mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + FindEscapeScalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+size_t FindEscapeAVX2(const char* p, size_t n) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i slash = _mm256_set1_epi8('\\');
+    const __m256i ctrl = _mm256_set1_epi8(0x1f);
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, slash))
+                                   ,_mm256_cmpeq_epi8(_mm256_max_epu8(x, ctrl), ctrl));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(m);
+        if(mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + FindEscapeSSE2(p + i, n - i);
+}
+
+bool HasAVX2() {
+    static const bool s_has = __builtin_cpu_supports("avx2");
+    return s_has;
+}
+
+#else
+
+size_t FindEscapeSSE2(const char* p, size_t n) {
+    return FindEscapeScalar(p, n);
+}
+
+size_t FindEscapeAVX2(const char* p, size_t n) {
+    return FindEscapeScalar(p, n);
+}
+
+bool HasAVX2() {
+    return false;
+}
+
+#endif
+
+typedef size_t (*FindEscapeFunc)(const char* p, size_t n);
+
+/**
+ * @brief 启动时选一次实现
+ */
+static FindEscapeFunc ResolveFindEscape() {
+#if defined(GAMESERVER_JSON_X86) && defined(__SSE2__)
+    if(HasAVX2()) {
+        return &FindEscapeAVX2;
+    }
+    return &FindEscapeSSE2;
+#else
+    return &FindEscapeScalar;
+#endif
+}
+
+static FindEscapeFunc GetFindEscape() {
+    static const FindEscapeFunc s_func = ResolveFindEscape();
+    return s_func;
+}
+
+size_t FindEscape(const char* p, size_t n) {
+    return GetFindEscape()(p, n);
+}
+
+const char* GetImpl() {
+    FindEscapeFunc func = GetFindEscape();
+    if(func == &FindEscapeScalar) {
+        return "scalar";
+    }
+    return func == &FindEscapeAVX2 ? "avx2" : "sse2";
+}
+
+void Escape(LogStream& os, const char* p, size_t n) {
+    static const char s_hex[] = "0123456789abcdef";
+    FindEscapeFunc find = GetFindEscape();
+    const char* table = GetEscapeTable().table;
+    while(n) {
+        // 不需要转义的部分整段拷贝
+        size_t k = find(p, n);
+        os.append(p, k);
+        if(k == n) {
+            break;
+        }
+        unsigned char c = p[k];
+        char e = table[c];
+        if(e == 'u') {
+            char buf[6] = {'\\', 'u', '0', '0', s_hex[c >> 4], s_hex[c & 0xf]};
+            os.append(buf, sizeof(buf));
+        } else {
+            char buf[2] = {'\\', e};
+            os.append(buf, sizeof(buf));
+        }
+        p += k + 1;
+        n -= k + 1;
+    }
+}
+
+}
+
+void JsonLogFormat::format(LogStream& os, LogLevel::Level level, const LogEvent& event) {
+    static const TimestampFormat s_format("%Y-%m-%dT%H:%M:%S.%f");
+    os.append("{\"time\":\"", 9);
+    s_format.format(os, event.getTime(), event.getUsec());
+    os.append("\",\"level\":\"", 11);
+    os.append(LogLevel::ToString(level));
+    os.append("\",\"logger\":", 11);
+    json::AppendString(os, event.getLogger()->getName());
+    os.append(",\"file\":", 8);
+    json::AppendString(os, event.getFile() ? event.getFile() : "");
+    os.append(",\"line\":", 8);
+    os.appendInt(event.getLine());
+    os.append(",\"thread\":", 10);
+    os.appendUInt(event.getThreadId());
+    os.append(",\"thread_name\":", 15);
+    json::AppendString(os, event.getThreadName());
+    os.append(",\"fiber\":", 9);
+    os.appendUInt(event.getFiberId());
+    os.append(",\"msg\":", 7);
+    json::AppendString(os, event.getSS().data(), event.getSS().size());
+    const std::string& fields = event.getFields();
+    os.append(fields.data(), fields.size());
+    os.append("}\n", 2);
+}
+
+}
@@ -0,0 +1,93 @@
+#ifndef __GAMESERVER_LOG_JSON_H__
+#define __GAMESERVER_LOG_JSON_H__
+
+#include "log.h"
+#include "log_stream.h"
+
+namespace gameserver{
+
+namespace json{
+
+/**
+ * @brief 查找第一个需要转义的字符(控制字符, 双引号, 反斜杠)
+ * @return 下标, 没有时返回n
+ * @details 运行时按CPU选择AVX2/SSE2/逐字节实现, 每次16或32字节比较.
+ *          非ASCII字节原样输出, 不校验UTF-8
+ */
+size_t FindEscape(const char* p, size_t n);
+
+/**
+ * @brief 逐字节查表实现
+ */
+size_t FindEscapeScalar(const char* p, size_t n);
+
+/**
+ * @brief SSE2实现, 不支持时退回逐字节
+ */
+size_t FindEscapeSSE2(const char* p, size_t n);
+
+/**
+ * @brief AVX2实现, CPU不支持时不能调用, 见HasAVX2()
+ */
+size_t FindEscapeAVX2(const char* p, size_t n);
+
+/**
+ * @brief CPU是否支持AVX2(且编译器能生成)
+ */
+bool HasAVX2();
+
+/**
+ * @brief FindEscape使用的实现名称, "avx2" "sse2" 或 "scalar"
+ */
+const char* GetImpl();
+
+/**
+ * @brief 转义后写入, 不带两边的引号
+ */
+void Escape(LogStream& os, const char* p, size_t n);
+
+/**
+ * @brief 写入带引号的JSON字符串
+ */
+inline void AppendString(LogStream& os, const char* p, size_t n) {
+    os.append('"');
+    Escape(os, p, n);
+    os.append('"');
+}
+
+inline void AppendString(LogStream& os, const char* str) {
+    AppendString(os, str, strlen(str));
+}
+
+inline void AppendString(LogStream& os, const std::string& str) {
+    AppendString(os, str.data(), str.size());
+}
+
+}
+
+/**
+ * @brief JSON格式, 每条日志一行一个对象
+ * @details 字段依次为:
+ *          {"time":"2026-10-16T12:00:00.123456","level":"INFO","logger":"root",
+ *           "file":"main.cc","line":12,"thread":1234,"thread_name":"main","fiber":0,
+ *           "msg":"...",<LogEvent::addField添加的字段>}
+ *          时间为本地时间, 精确到微秒. 用户字段按添加顺序输出, 不检查与固定字段重名.
+ *          LogFormatter的模板为"json"(LogFormatter::JSON_PATTERN)时使用本格式
+ */
+struct JsonLogFormat {
+    /**
+     * @brief 格式化日志到缓冲
+     */
+    static void format(LogStream& os, LogLevel::Level level, const LogEvent& event);
+
+    /**
+     * @brief 创建JSON格式的LogFormatter
+     */
+    static LogFormatter::ptr Create() {
+        return LogFormatter::ptr(new LogFormatter(LogFormatter::JSON_PATTERN));
+    }
+};
+
+}
+
+#endif
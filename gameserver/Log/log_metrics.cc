@@ -0,0 +1,89 @@
+#include "log_metrics.h"
+#include <sstream>
+#include <chrono>
+
+namespace gameserver{
+
+LogMetricsReporter::LogMetricsReporter(Logger::ptr target, uint32_t interval_ms)
+    :m_target(target)
+    ,m_interval(interval_ms) {
+    if(!m_target) {
+        m_target = GAMESERVER_LOG_NAME("system.log_metrics");
+    }
+    if(m_interval) {
+        m_thread.reset(new Thread(std::bind(&LogMetricsReporter::run, this), "log_metrics"));
+    }
+}
+
+LogMetricsReporter::~LogMetricsReporter() {
+    stop();
+}
+
+void LogMetricsReporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cond.notify_one();
+    if(m_thread && m_thread->joinable()) {
+        m_thread->join();
+    }
+}
+
+void LogMetricsReporter::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(!m_stopping) {
+        if(m_cond.wait_for(lock, std::chrono::milliseconds(m_interval)
+                           ,[this]() { return m_stopping;})) {
+            break;
+        }
+        lock.unlock();
+        report();
+        lock.lock();
+    }
+}
+
+void LogMetricsReporter::report() {
+    std::vector<LoggerMetrics> all = LoggerMgr::GetInstance()->getMetrics();
+    for(auto& m : all) {
+        for(auto& line : ToLines(m)) {
+            GAMESERVER_LOG_INFO(m_target) << line;
+        }
+    }
+}
+
+std::string LogMetricsReporter::ToString(const HistogramSnapshot& hist) {
+    std::stringstream ss;
+    ss << "count:" << hist.count
+       << ",mean:" << hist.mean()
+       << ",p50:" << hist.percentile(0.5)
+       << ",p99:" << hist.percentile(0.99)
+       << ",p999:" << hist.percentile(0.999)
+       << ",max:" << hist.max;
+    return ss.str();
+}
+
+std::vector<std::string> LogMetricsReporter::ToLines(const LoggerMetrics& metrics) {
+    std::vector<std::string> lines;
+    std::stringstream ss;
+    ss << "logger=" << metrics.name
+       << " accepted=" << metrics.accepted
+       << " filtered=" << metrics.filtered
+       << " dropped=" << metrics.dropped
+       << " format_ns=" << ToString(metrics.formatTime);
+    lines.push_back(ss.str());
+    for(auto& h : metrics.handlers) {
+        ss.str("");
+        ss << "logger=" << metrics.name
+           << " handler=" << h.name
+           << " events=" << h.events
+           << " bytes=" << h.bytes
+           << " dropped=" << h.dropped
+           << " queue=" << h.queueDepth
+           << " write_ns=" << ToString(h.writeTime);
+        lines.push_back(ss.str());
+    }
+    return lines;
+}
+
+}
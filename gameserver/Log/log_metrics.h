@@ -0,0 +1,67 @@
+#ifndef __GAMESERVER_LOG_METRICS_H__
+#define __GAMESERVER_LOG_METRICS_H__
+
+#include "log.h"
+#include "Thread/thread.h"
+#include <mutex>
+#include <condition_variable>
+
+namespace gameserver{
+
+/**
+ * @brief 定期把所有日志器的计量写到专用日志器
+ * @details 每个日志器一行, 每个Handler一行, key=value格式, 方便告警规则匹配:
+ *          logger=net accepted=.. filtered=.. dropped=.. format_ns=count:..,mean:..,p50:..,p99:..,p999:..,max:..
+ *          logger=net handler=file:net.log events=.. bytes=.. dropped=.. queue=.. write_ns=...
+ */
+class LogMetricsReporter {
+public:
+    typedef std::shared_ptr<LogMetricsReporter> ptr;
+
+    /**
+     * @brief 构造函数, 启动后台线程
+     * @param[in] target 写入的日志器, 为空时用"system.log_metrics"
+     * @param[in] interval_ms 间隔, 0为不启动后台线程, 只能手动report()
+     */
+    LogMetricsReporter(Logger::ptr target = nullptr, uint32_t interval_ms = 60000);
+    ~LogMetricsReporter();
+
+    /**
+     * @brief 立即输出一次
+     */
+    void report();
+
+    /**
+     * @brief 停止后台线程
+     */
+    void stop();
+
+    const Logger::ptr& getTarget() const { return m_target;}
+
+    /**
+     * @brief 一个日志器的计量转成文本, 每行一项, 不带换行结尾
+     */
+    static std::vector<std::string> ToLines(const LoggerMetrics& metrics);
+
+    /**
+     * @brief 直方图转成 count:..,mean:..,p50:..,p99:..,p999:..,max:..
+     */
+    static std::string ToString(const HistogramSnapshot& hist);
+private:
+    void run();
+private:
+    /// 写入的日志器
+    Logger::ptr m_target;
+    /// 间隔
+    uint32_t m_interval;
+    /// 后台线程
+    Thread::ptr m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    /// 是否停止
+    bool m_stopping = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,129 @@
+#include "log_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace gameserver{
+
+/// 两位数字表, 每次转换两位
+static const char s_digits[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+LogStream::LogStream()
+    :m_data(m_inline)
+    ,m_size(0)
+    ,m_cap(INLINE_SIZE) {
+}
+
+LogStream::~LogStream() {
+    if(m_data != m_inline) {
+        free(m_data);
+    }
+}
+
+LogStream::LogStream(const LogStream& rhs)
+    :m_data(m_inline)
+    ,m_size(0)
+    ,m_cap(INLINE_SIZE) {
+    append(rhs.m_data, rhs.m_size);
+}
+
+LogStream& LogStream::operator=(const LogStream& rhs) {
+    if(this != &rhs) {
+        m_size = 0;
+        append(rhs.m_data, rhs.m_size);
+    }
+    return *this;
+}
+
+void LogStream::grow(size_t n) {
+    size_t cap = m_cap * 2;
+    while(cap < n) {
+        cap *= 2;
+    }
+    if(m_data == m_inline) {
+        char* data = (char*)malloc(cap);
+        memcpy(data, m_inline, m_size);
+        m_data = data;
+    } else {
+        m_data = (char*)realloc(m_data, cap);
+    }
+    m_cap = cap;
+}
+
+void LogStream::appendUInt(uint64_t v) {
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    while(v >= 100) {
+        uint32_t i = (v % 100) * 2;
+        v /= 100;
+        *--p = s_digits[i + 1];
+        *--p = s_digits[i];
+    }
+    if(v < 10) {
+        *--p = '0' + (char)v;
+    } else {
+        uint32_t i = v * 2;
+        *--p = s_digits[i + 1];
+        *--p = s_digits[i];
+    }
+    append(p, end - p);
+}
+
+void LogStream::appendInt(int64_t v) {
+    if(v < 0) {
+        append('-');
+        appendUInt(0 - (uint64_t)v);
+    } else {
+        appendUInt(v);
+    }
+}
+
+void LogStream::appendPadded(uint32_t v, int width) {
+    char* p = reserve(width) + width;
+    for(int i = 0; i < width; ++i) {
+        *--p = '0' + v % 10;
+        v /= 10;
+    }
+    commit(width);
+}
+
+void LogStream::appendDouble(double v, int precision) {
+    char* p = reserve(32);
+    int n = snprintf(p, 32, "%.*g", precision, v);
+    commit(n > 0 ? n : 0);
+}
+
+void LogStream::resetFormat() {
+    m_flags = DEFAULT_FLAGS;
+    m_precision = 6;
+    m_width = 0;
+    m_fill = ' ';
+    m_plain = true;
+}
+
+void LogStream::appendPointer(const void* ptr) {
+    static const char s_hex[] = "0123456789abcdef";
+    uintptr_t v = (uintptr_t)ptr;
+    char buf[2 + sizeof(v) * 2];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    do {
+        *--p = s_hex[v & 0xf];
+        v >>= 4;
+    } while(v);
+    *--p = 'x';
+    *--p = '0';
+    append(p, end - p);
+}
+
+}
@@ -0,0 +1,211 @@
+#ifndef __GAMESERVER_LOG_STREAM_H__
+#define __GAMESERVER_LOG_STREAM_H__
+
+#include <string>
+#include <sstream>
+#include <ios>
+#include <ostream>
+#include <string.h>
+#include <stdint.h>
+
+namespace gameserver{
+
+/**
+ * @brief 日志字符缓冲
+ * @details 直接往char缓冲里写, 不经过std::ostream和locale.
+ *          小于内联容量时不分配内存, 超出后转到堆上并保留容量以便复用.
+ *          operator<<的输出与std::ostringstream相同: 浮点数默认6位有效数字(%g), bool输出1/0;
+ *          std::setprecision, std::fixed, std::hex, std::setw, std::boolalpha等操纵符记在本对象上,
+ *          格式状态不是默认值时按std::ostream的规则格式化(慢路径), clear()恢复默认格式
+ */
+class LogStream {
+public:
+    /// 内联缓冲大小
+    static const size_t INLINE_SIZE = 256;
+
+    LogStream();
+    ~LogStream();
+    LogStream(const LogStream& rhs);
+    LogStream& operator=(const LogStream& rhs);
+
+    const char* data() const { return m_data;}
+    size_t size() const { return m_size;}
+    bool empty() const { return m_size == 0;}
+    size_t capacity() const { return m_cap;}
+    std::string str() const { return std::string(m_data, m_size);}
+
+    /**
+     * @brief 清空内容并恢复默认格式, 保留容量
+     */
+    void clear() {
+        m_size = 0;
+        if(!m_plain) {
+            resetFormat();
+        }
+    }
+
+    /**
+     * @brief 恢复默认格式: 十进制, 6位精度, 无宽度
+     */
+    void resetFormat();
+
+    void append(const char* data, size_t len) {
+        if(m_size + len > m_cap) {
+            grow(m_size + len);
+        }
+        memcpy(m_data + m_size, data, len);
+        m_size += len;
+    }
+
+    void append(const char* str) { append(str, strlen(str));}
+    void append(const std::string& str) { append(str.data(), str.size());}
+
+    void append(char c) {
+        if(m_size + 1 > m_cap) {
+            grow(m_size + 1);
+        }
+        m_data[m_size++] = c;
+    }
+
+    /**
+     * @brief 写入无符号整数
+     */
+    void appendUInt(uint64_t v);
+
+    /**
+     * @brief 写入有符号整数
+     */
+    void appendInt(int64_t v);
+
+    /**
+     * @brief 写入定长整数, 不足width位前面补0
+     */
+    void appendPadded(uint32_t v, int width);
+
+    /**
+     * @brief 写入浮点数, 格式同%.{precision}g
+     */
+    void appendDouble(double v, int precision = 12);
+
+    /**
+     * @brief 按当前格式状态经std::ostream写入, 并记下v带来的格式变化(操纵符)
+     */
+    template<class T>
+    LogStream& appendStream(const T& v) {
+        static thread_local std::ostringstream s_ss;
+        s_ss.str("");
+        s_ss.flags(m_flags);
+        s_ss.precision(m_precision);
+        s_ss.width(m_width);
+        s_ss.fill(m_fill);
+        s_ss << v;
+        append(s_ss.str());
+        m_flags = s_ss.flags();
+        m_precision = s_ss.precision();
+        m_width = s_ss.width();
+        m_fill = s_ss.fill();
+        m_plain = m_flags == DEFAULT_FLAGS && m_precision == 6 && m_width == 0 && m_fill == ' ';
+        return *this;
+    }
+
+    /**
+     * @brief 写入十六进制指针值
+     */
+    void appendPointer(const void* p);
+
+    /**
+     * @brief 预留n字节可写空间
+     * @return 可写入的位置, 写完后调用commit
+     */
+    char* reserve(size_t n) {
+        if(m_size + n > m_cap) {
+            grow(m_size + n);
+        }
+        return m_data + m_size;
+    }
+
+    void commit(size_t n) { m_size += n;}
+
+    LogStream& operator<<(bool v) { if(m_plain) append(v ? '1' : '0'); else appendStream(v); return *this;}
+    LogStream& operator<<(char v) { if(m_plain) append(v); else appendStream(v); return *this;}
+    LogStream& operator<<(signed char v) { if(m_plain) append((char)v); else appendStream(v); return *this;}
+    LogStream& operator<<(unsigned char v) { if(m_plain) append((char)v); else appendStream(v); return *this;}
+    LogStream& operator<<(short v) { if(m_plain) appendInt(v); else appendStream(v); return *this;}
+    LogStream& operator<<(unsigned short v) { if(m_plain) appendUInt(v); else appendStream(v); return *this;}
+    LogStream& operator<<(int v) { if(m_plain) appendInt(v); else appendStream(v); return *this;}
+    LogStream& operator<<(unsigned int v) { if(m_plain) appendUInt(v); else appendStream(v); return *this;}
+    LogStream& operator<<(long v) { if(m_plain) appendInt(v); else appendStream(v); return *this;}
+    LogStream& operator<<(unsigned long v) { if(m_plain) appendUInt(v); else appendStream(v); return *this;}
+    LogStream& operator<<(long long v) { if(m_plain) appendInt(v); else appendStream(v); return *this;}
+    LogStream& operator<<(unsigned long long v) { if(m_plain) appendUInt(v); else appendStream(v); return *this;}
+    LogStream& operator<<(float v) { if(m_plain) appendDouble(v, 6); else appendStream(v); return *this;}
+    LogStream& operator<<(double v) { if(m_plain) appendDouble(v, 6); else appendStream(v); return *this;}
+    LogStream& operator<<(const void* v) { if(m_plain) appendPointer(v); else appendStream(v); return *this;}
+    LogStream& operator<<(const char* v) {
+        if(!v) {
+            // std::ostream遇到空指针会置badbit, 日志里输出占位
+            v = "(null)";
+        }
+        if(m_plain) append(v); else appendStream(v);
+        return *this;
+    }
+    LogStream& operator<<(const std::string& v) { if(m_plain) append(v); else appendStream(v); return *this;}
+
+    /**
+     * @brief std::hex, std::fixed, std::boolalpha等不带参数的操纵符
+     */
+    LogStream& operator<<(std::ios_base& (*manip)(std::ios_base&)) { return appendStream(manip);}
+
+    /**
+     * @brief std::endl写换行, std::flush和std::ends不做事, 其他作用于std::ostream的操纵符经std::ostream写入
+     * @details 日志的刷盘由LogHandler决定, 这里不刷; std::ends的'\0'不写进日志
+     */
+    LogStream& operator<<(std::ostream& (*manip)(std::ostream&)) {
+        typedef std::ostream& (*OstreamManip)(std::ostream&);
+        if(manip == static_cast<OstreamManip>(std::endl)) {
+            append('\n');
+            return *this;
+        }
+        if(manip == static_cast<OstreamManip>(std::flush)
+                || manip == static_cast<OstreamManip>(std::ends)) {
+            return *this;
+        }
+        return appendStream(manip);
+    }
+private:
+    /**
+     * @brief 扩容到至少n字节
+     */
+    void grow(size_t n);
+private:
+    /// 当前缓冲
+    char* m_data;
+    /// 已写入字节数
+    size_t m_size;
+    /// 当前缓冲容量
+    size_t m_cap;
+    /// 内联缓冲
+    char m_inline[INLINE_SIZE];
+
+    /// std::ostringstream的默认格式标志
+    static const std::ios_base::fmtflags DEFAULT_FLAGS = std::ios_base::skipws | std::ios_base::dec;
+    /// 格式状态是否为默认值, 是时走快路径
+    bool m_plain = true;
+    /// 以下为操纵符设置的格式状态, 含义同std::ios_base
+    std::ios_base::fmtflags m_flags = DEFAULT_FLAGS;
+    std::streamsize m_precision = 6;
+    std::streamsize m_width = 0;
+    char m_fill = ' ';
+};
+
+/**
+ * @brief 其他类型和std::setprecision, std::setw等带参数的操纵符经std::ostream写入, 用法与std::stringstream保持一致
+ */
+template<class T>
+LogStream& operator<<(LogStream& os, const T& v) {
+    return os.appendStream(v);
+}
+
+}
+
+#endif
@@ -0,0 +1,309 @@
+#include "mmap_log.h"
+#include "Util/util.h"
+#include "log_stream.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <algorithm>
+
+namespace gameserver{
+
+/**
+ * @brief 本地时间的下一个滚动边界
+ */
+static uint64_t NextBoundary(uint64_t now, uint32_t interval) {
+    time_t t = now;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    int64_t off = tm.tm_gmtoff;
+    return ((now + off) / interval + 1) * interval - off;
+}
+
+/**
+ * @brief 把段压进待处理栈, 写线程在m_writeMutex下调用, 只有一个生产者
+ */
+static void PushSegment(std::atomic<MmapSegment*>& head, MmapSegment* seg, MmapSegment* MmapSegment::*link) {
+    MmapSegment* old = head.load(std::memory_order_relaxed);
+    do {
+        seg->*link = old;
+    } while(!head.compare_exchange_weak(old, seg, std::memory_order_release, std::memory_order_relaxed));
+}
+
+MmapFileLogHandler::MmapFileLogHandler(const std::string& basename, size_t segment_size
+                                       ,uint32_t roll_interval)
+    :m_basename(basename)
+    ,m_segmentSize(segment_size)
+    ,m_rollInterval(roll_interval)
+    ,m_dropped(0)
+    ,m_segments(0)
+    ,m_seq(0)
+    ,m_next(nullptr)
+    ,m_activated(nullptr)
+    ,m_retired(nullptr)
+    ,m_syncRequest(0) {
+    m_writer = true;
+    uint64_t now = time(0);
+    if(m_rollInterval) {
+        m_rollAt = NextBoundary(now, m_rollInterval);
+    }
+    // 第一段同步创建, 之后的由后台线程预先准备
+    m_current = createSegment();
+    if(m_current) {
+        m_current->openTime = now;
+        nameSegment(m_current);
+        m_live.push_back(m_current);
+        ++m_segments;
+    }
+    m_thread.reset(new Thread(std::bind(&MmapFileLogHandler::run, this), "log_mmap"));
+}
+
+MmapFileLogHandler::~MmapFileLogHandler() {
+    {
+        std::lock_guard<std::mutex> lock(m_bgMutex);
+        m_stopping = true;
+    }
+    m_bgCond.notify_one();
+    m_thread->join();
+    if(m_current) {
+        closeSegment(m_current);
+        m_current = nullptr;
+    }
+    MmapSegment* next = m_next.exchange(nullptr);
+    if(next) {
+        // 没用过的预分配段
+        munmap(next->base, next->size);
+        close(next->fd);
+        unlink(next->path.c_str());
+        delete next;
+    }
+}
+
+MmapSegment* MmapFileLogHandler::createSegment() {
+    MmapSegment* seg = new MmapSegment;
+    seg->path = m_basename + ".next." + std::to_string(m_seq++);
+    seg->size = m_segmentSize;
+    seg->fd = open(seg->path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(seg->fd < 0) {
+        delete seg;
+        return nullptr;
+    }
+    // 预分配磁盘块, 写映射时不会因为磁盘满收到SIGBUS; 文件系统不支持时退回ftruncate
+    int rt = posix_fallocate(seg->fd, 0, seg->size);
+    if(rt == EINVAL || rt == EOPNOTSUPP) {
+        rt = ftruncate(seg->fd, seg->size);
+    }
+    if(rt == 0) {
+        void* p = mmap(nullptr, seg->size, PROT_READ | PROT_WRITE, MAP_SHARED, seg->fd, 0);
+        if(p != MAP_FAILED) {
+            seg->base = (char*)p;
+            return seg;
+        }
+    }
+    close(seg->fd);
+    unlink(seg->path.c_str());
+    delete seg;
+    return nullptr;
+}
+
+void MmapFileLogHandler::nameSegment(MmapSegment* seg) {
+    time_t t = seg->openTime;
+    struct tm tm;
+    localtime_r(&t, &tm);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", &tm);
+    size_t pos = seg->path.rfind('.');
+    std::string path = m_basename + "." + buf + seg->path.substr(pos);
+    if(rename(seg->path.c_str(), path.c_str()) == 0) {
+        std::lock_guard<std::mutex> lock(m_bgMutex);
+        seg->path = path;
+    }
+}
+
+void MmapFileLogHandler::closeSegment(MmapSegment* seg) {
+    msync(seg->base, seg->size, MS_SYNC);
+    munmap(seg->base, seg->size);
+    // 去掉预分配的空白尾部
+    int rt = ftruncate(seg->fd, seg->used);
+    (void)rt;
+    close(seg->fd);
+    delete seg;
+}
+
+bool MmapFileLogHandler::rollLocked(uint64_t now) {
+    MmapSegment* next = m_next.exchange(nullptr, std::memory_order_acquire);
+    if(!next) {
+        return false;
+    }
+    next->openTime = now;
+    // 先交出新段再交出旧段, 后台线程按相反的顺序取, 不会关闭一个还没改名的段
+    PushSegment(m_activated, next, &MmapSegment::nextActivated);
+    if(m_current) {
+        PushSegment(m_retired, m_current, &MmapSegment::nextRetired);
+    }
+    m_current = next;
+    ++m_segments;
+    while(m_rollInterval && now >= m_rollAt) {
+        m_rollAt += m_rollInterval;
+    }
+    return true;
+}
+
+uint64_t MmapFileLogHandler::requestSyncLocked() {
+    if(m_current) {
+        m_current->syncPos.store(m_current->used, std::memory_order_relaxed);
+    }
+    return m_syncRequest.fetch_add(1, std::memory_order_release) + 1;
+}
+
+void MmapFileLogHandler::notify() {
+    // 后台线程在m_bgMutex下检查条件, 加一次锁保证它要么已经看到修改, 要么已经在等待
+    {
+        std::lock_guard<std::mutex> lock(m_bgMutex);
+    }
+    m_bgCond.notify_one();
+}
+
+void MmapFileLogHandler::log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) {
+    if(level >= getLevel()) {
+        static thread_local LogStream s_buf;
+        s_buf.clear();
+        getFormatter()->format(s_buf, logger, level, event);
+        write(level, s_buf.data(), s_buf.size());
+    }
+}
+
+void MmapFileLogHandler::write(LogLevel::Level level, const char* data, size_t len) {
+    if(len > m_segmentSize) {
+        ++m_dropped;
+        return;
+    }
+    bool wake = false;
+    WriteMutexType::Lock lock(m_writeMutex);
+    uint64_t now = 0;
+    if(m_rollInterval) {
+        uint64_t sec;
+        uint32_t usec;
+        GetCoarseTime(sec, usec);
+        now = sec;
+        if(now >= m_rollAt) {
+            if(m_current && m_current->used == 0) {
+                // 这段时间没有日志, 不产生空文件
+                while(now >= m_rollAt) {
+                    m_rollAt += m_rollInterval;
+                }
+            } else {
+                // 下一段没准备好就先写在当前段里
+                wake = rollLocked(now);
+            }
+        }
+    }
+    if(!m_current || m_current->used + len > m_current->size) {
+        if(!now) {
+            now = time(0);
+        }
+        if(!rollLocked(now)) {
+            ++m_dropped;
+            lock.unlock();
+            if(wake) {
+                notify();
+            }
+            return;
+        }
+        wake = true;
+    }
+    memcpy(m_current->base + m_current->used, data, len);
+    m_current->used += len;
+    if(needFlush(level, len)) {
+        requestSyncLocked();
+        wake = true;
+    }
+    lock.unlock();
+    if(wake) {
+        notify();
+    }
+}
+
+void MmapFileLogHandler::flush() {
+    uint64_t id;
+    {
+        WriteMutexType::Lock lock(m_writeMutex);
+        id = requestSyncLocked();
+        resetFlush();
+    }
+    std::unique_lock<std::mutex> lock(m_bgMutex);
+    m_bgCond.notify_one();
+    m_doneCond.wait(lock, [this, id]() { return m_syncDone >= id;});
+}
+
+std::string MmapFileLogHandler::getCurrentPath() {
+    // 先取m_bgMutex: 写线程持有m_writeMutex时从不等m_bgMutex
+    std::lock_guard<std::mutex> bg_lock(m_bgMutex);
+    WriteMutexType::Lock lock(m_writeMutex);
+    if(!m_current) {
+        return "";
+    }
+    return m_current->path;
+}
+
+void MmapFileLogHandler::run() {
+    std::unique_lock<std::mutex> lock(m_bgMutex);
+    while(true) {
+        m_bgCond.wait(lock, [this]() {
+            return m_stopping || !m_next.load(std::memory_order_relaxed)
+                || m_activated.load(std::memory_order_relaxed) || m_retired.load(std::memory_order_relaxed)
+                || m_syncDone != m_syncRequest.load(std::memory_order_relaxed);
+        });
+        bool need_next = !m_next.load(std::memory_order_relaxed) && !m_stopping;
+        lock.unlock();
+
+        // 先取待关闭的再取待改名的: 段总是先进待改名栈, 所以待关闭的段一定已经取到过
+        MmapSegment* retired = m_retired.exchange(nullptr, std::memory_order_acquire);
+        MmapSegment* activated = m_activated.exchange(nullptr, std::memory_order_acquire);
+        uint64_t sync_request = m_syncRequest.load(std::memory_order_acquire);
+        for(MmapSegment* seg = activated; seg; seg = seg->nextActivated) {
+            nameSegment(seg);
+            m_live.push_back(seg);
+        }
+        // 先同步再关闭: 请求里的段可能同时待关闭
+        for(auto& seg : m_live) {
+            size_t pos = seg->syncPos.load(std::memory_order_relaxed);
+            if(pos > seg->synced) {
+                msync(seg->base, pos, MS_SYNC);
+                seg->synced = pos;
+            }
+        }
+        for(MmapSegment* seg = retired; seg;) {
+            MmapSegment* next = seg->nextRetired;
+            m_live.erase(std::find(m_live.begin(), m_live.end(), seg));
+            closeSegment(seg);
+            seg = next;
+        }
+        MmapSegment* next = need_next ? createSegment() : nullptr;
+        if(next) {
+            m_next.store(next, std::memory_order_release);
+        }
+
+        lock.lock();
+        if(m_syncDone != sync_request) {
+            m_syncDone = sync_request;
+            m_doneCond.notify_all();
+        }
+        if(need_next && !next) {
+            // 创建失败(如磁盘满), 过一会再试, 期间写线程丢弃放不下的日志
+            m_bgCond.wait_for(lock, std::chrono::seconds(1));
+        }
+        if(m_stopping && !m_activated.load(std::memory_order_relaxed)
+                && !m_retired.load(std::memory_order_relaxed)
+                && m_syncDone == m_syncRequest.load(std::memory_order_relaxed)) {
+            break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,173 @@
+#ifndef __GAMESERVER_MMAP_LOG_H__
+#define __GAMESERVER_MMAP_LOG_H__
+
+#include "log.h"
+#include "Thread/thread.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace gameserver{
+
+/**
+ * @brief 映射到内存的日志文件段
+ */
+struct MmapSegment {
+    /// 文件路径
+    std::string path;
+    /// 文件描述符
+    int fd = -1;
+    /// 映射起始地址
+    char* base = nullptr;
+    /// 段大小
+    size_t size = 0;
+    /// 已写入字节数
+    size_t used = 0;
+    /// 开始写入的时间(秒), 文件名用它
+    uint64_t openTime = 0;
+    /// 请求msync到的位置, 写线程设置, 后台线程读取
+    std::atomic<size_t> syncPos {0};
+    /// 后台线程已经msync到的位置
+    size_t synced = 0;
+    /// 待改名栈里的下一个
+    MmapSegment* nextActivated = nullptr;
+    /// 待关闭栈里的下一个
+    MmapSegment* nextRetired = nullptr;
+};
+
+/**
+ * @brief 写入内存映射文件的Handler
+ * @details 文件按段预分配(fallocate)并映射, 写日志只是把格式化好的一行memcpy到映射里.
+ *          一段写满, 或到了按时间滚动的整点边界, 就换到后台线程预先准备好的下一段;
+ *          用完的段由后台线程msync, munmap, 截断到实际长度后关闭, 刷新也由后台线程做.
+ *          写线程从不等待磁盘: 下一段还没准备好(如磁盘满)时丢弃该行并计数.
+ *          写线程持有的是自旋锁, 与后台线程之间只通过原子变量交接段和同步请求,
+ *          释放自旋锁之后才唤醒后台线程.
+ *
+ *          文件名: <basename>.<YYYYmmdd-HHMMSS>.<序号>
+ */
+class MmapFileLogHandler : public LogHandler {
+public:
+    typedef std::shared_ptr<MmapFileLogHandler> ptr;
+
+    /**
+     * @brief 构造函数
+     * @param[in] basename 文件名前缀, 可以带目录
+     * @param[in] segment_size 每段大小
+     * @param[in] roll_interval 按时间滚动的间隔(秒), 按本地时间对齐, 如3600为整点, 0为不按时间滚动
+     */
+    MmapFileLogHandler(const std::string& basename, size_t segment_size = 64 << 20
+                       ,uint32_t roll_interval = 0);
+    ~MmapFileLogHandler();
+
+    virtual void log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) override;
+    virtual void write(LogLevel::Level level, const char* data, size_t len) override;
+
+    /**
+     * @brief 把已写入的内容同步到磁盘, 阻塞到完成
+     */
+    virtual void flush() override;
+
+    /**
+     * @brief 因下一段未就绪或一行超过段大小而丢弃的行数
+     */
+    virtual uint64_t getDropped() const override { return m_dropped;}
+
+    virtual std::string getName() const override { return "mmap:" + m_basename;}
+
+    /**
+     * @brief 已经用过的段数(含当前段)
+     */
+    uint64_t getSegmentCount() const { return m_segments;}
+
+    /**
+     * @brief 当前段的文件路径
+     */
+    std::string getCurrentPath();
+private:
+    /**
+     * @brief 创建并映射一段
+     * @return 失败返回nullptr
+     */
+    MmapSegment* createSegment();
+
+    /**
+     * @brief 按开始写入的时间给段改名
+     */
+    void nameSegment(MmapSegment* seg);
+
+    /**
+     * @brief 同步, 解除映射, 截断并关闭一段
+     */
+    void closeSegment(MmapSegment* seg);
+
+    /**
+     * @brief 请求后台线程msync当前段已写入的部分, 调用方持有m_writeMutex, 释放后调用notify()
+     * @return 请求序号
+     */
+    uint64_t requestSyncLocked();
+
+    /**
+     * @brief 切换到预先准备好的下一段, 调用方持有m_writeMutex, 成功时释放后调用notify()
+     * @return 没有可用的段返回false
+     */
+    bool rollLocked(uint64_t now);
+
+    /**
+     * @brief 唤醒后台线程, 不能在持有m_writeMutex时调用
+     */
+    void notify();
+
+    /**
+     * @brief 后台线程
+     */
+    void run();
+private:
+    /// 文件名前缀
+    std::string m_basename;
+    /// 段大小
+    size_t m_segmentSize;
+    /// 时间滚动间隔(秒)
+    uint32_t m_rollInterval;
+    /// 写路径只有memcpy, 用自旋锁
+    typedef Spinlock WriteMutexType;
+    WriteMutexType m_writeMutex;
+    /// 当前段, 写线程在m_writeMutex下使用
+    MmapSegment* m_current = nullptr;
+    /// 到这个时间(秒)滚动到下一段
+    uint64_t m_rollAt = 0;
+    /// 丢弃的行数
+    std::atomic<uint64_t> m_dropped;
+    /// 用过的段数
+    std::atomic<uint64_t> m_segments;
+    /// 文件序号
+    std::atomic<uint64_t> m_seq;
+
+    /// 准备好的下一段, 后台线程放入, 写线程取走
+    std::atomic<MmapSegment*> m_next;
+    /// 开始写入, 待改名的段, 写线程压栈, 后台线程整个取走
+    std::atomic<MmapSegment*> m_activated;
+    /// 待关闭的段, 同上
+    std::atomic<MmapSegment*> m_retired;
+    /// flush请求序号
+    std::atomic<uint64_t> m_syncRequest;
+    /// 后台线程持有的未关闭的段, 同步请求对它们msync
+    std::vector<MmapSegment*> m_live;
+
+    /// 后台线程等待, 保护以下成员和段的路径
+    std::mutex m_bgMutex;
+    std::condition_variable m_bgCond;
+    /// flush等待后台完成
+    std::condition_variable m_doneCond;
+    /// 后台完成的flush序号
+    uint64_t m_syncDone = 0;
+    /// 停止后台线程
+    bool m_stopping = false;
+    /// 后台线程
+    Thread::ptr m_thread;
+};
+
+}
+
+#endif
@@ -0,0 +1,577 @@
+#include "net_log.h"
+#include "Util/util.h"
+#include "log_stream.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <endian.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <chrono>
+
+namespace gameserver{
+
+/// 一次sendmmsg最多的报文数
+static const int UDP_BATCH = 64;
+/// IPv4 UDP报文最大长度
+static const size_t UDP_MAX_PAYLOAD = 65507;
+/// syslog报文头最大长度: PRI, 时间, HOSTNAME(255), APP-NAME(48), PROCID
+static const size_t SYSLOG_HEADER_MAX = 400;
+/// socket缓冲满时重试发送的间隔(毫秒), 期间写线程的唤醒也会触发重试
+static const uint32_t BLOCKED_RETRY_MS = 5;
+/// 溢出文件每读过这么多就释放前面的磁盘空间
+static const uint64_t SPILL_PUNCH_SIZE = 1024 * 1024;
+
+/**
+ * @brief 日志级别对应的syslog severity
+ */
+static int SyslogSeverity(uint8_t level) {
+    switch(level) {
+        case LogLevel::FATAL:
+            return 2;
+        case LogLevel::ERROR:
+            return 3;
+        case LogLevel::WARN:
+            return 4;
+        case LogLevel::INFO:
+            return 6;
+        default:
+            return 7;
+    }
+}
+
+NetworkLogHandler::NetworkLogHandler(Transport transport, const std::string& ip, uint16_t port
+                                     ,const NetworkLogOptions& options)
+    :m_transport(transport)
+    ,m_options(options)
+    ,m_ip(ip)
+    ,m_port(port)
+    ,m_front(new ByteArray)
+    ,m_incoming(new ByteArray)
+    ,m_pending(new ByteArray)
+    ,m_backoff(options.reconnectMinMs)
+    ,m_spillRead(0)
+    ,m_spillWrite(0)
+    ,m_connected(false)
+    ,m_enqueued(0)
+    ,m_dropped(0)
+    ,m_lost(0)
+    ,m_sent(0)
+    ,m_sentBytes(0)
+    ,m_writes(0)
+    ,m_connects(0)
+    ,m_spilled(0) {
+    m_writer = true;
+    if(m_options.maxBatchBytes == 0) {
+        m_options.maxBatchBytes = 1024 * 1024;
+    }
+    std::string hostname = m_options.hostname;
+    if(hostname.empty()) {
+        char buf[256] = {0};
+        gethostname(buf, sizeof(buf) - 1);
+        hostname = buf;
+    }
+    std::string app = m_options.appName;
+    // RFC 5424: 字段不能为空, 也不能超长
+    m_syslogTail = " " + (hostname.empty() ? std::string("-") : hostname.substr(0, 255))
+                 + " " + (app.empty() ? std::string("-") : app.substr(0, 48))
+                 + " " + std::to_string(getpid()) + " - - ";
+    if(!m_options.spillPath.empty()) {
+        m_spillFd = open(m_options.spillPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        m_spillBuf.resize(std::max<size_t>(256 * 1024, m_options.maxRecordSize + RECORD_HEADER_SIZE));
+    }
+    m_thread.reset(new Thread(std::bind(&NetworkLogHandler::run, this), "log_net"));
+}
+
+NetworkLogHandler::~NetworkLogHandler() {
+    {
+        std::lock_guard<std::mutex> lock(m_bgMutex);
+        m_stopping = true;
+    }
+    m_bgCond.notify_one();
+    m_thread->join();
+    if(m_sock >= 0) {
+        close(m_sock);
+    }
+    if(m_spillFd >= 0) {
+        close(m_spillFd);
+        unlink(m_options.spillPath.c_str());
+    }
+    delete m_front;
+    delete m_incoming;
+    delete m_pending;
+}
+
+std::string NetworkLogHandler::getName() const {
+    return std::string(m_transport == TCP ? "net:tcp://" : "net:udp://")
+        + m_ip + ":" + std::to_string(m_port);
+}
+
+void NetworkLogHandler::log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) {
+    if(level >= getLevel()) {
+        static thread_local LogStream s_buf;
+        s_buf.clear();
+        getFormatter()->format(s_buf, logger, level, event);
+        write(level, s_buf.data(), s_buf.size());
+    }
+}
+
+void NetworkLogHandler::write(LogLevel::Level level, const char* data, size_t len) {
+    if(len > m_options.maxRecordSize) {
+        len = m_options.maxRecordSize;
+    }
+    uint64_t sec;
+    uint32_t usec;
+    GetCoarseTime(sec, usec);
+    char head[RECORD_HEADER_SIZE];
+    uint32_t size = htobe32(len + RECORD_HEADER_SIZE - 4);
+    uint64_t ms = htobe64(sec * 1000 + usec / 1000);
+    memcpy(head, &size, 4);
+    head[4] = (char)level;
+    memcpy(head + 5, &ms, 8);
+
+    bool wake;
+    {
+        WriteMutexType::Lock lock(m_writeMutex);
+        if(m_front->getReadSize() + RECORD_HEADER_SIZE + len > m_options.bufferSize) {
+            ++m_dropped;
+            return;
+        }
+        m_front->write(head, RECORD_HEADER_SIZE);
+        m_front->write(data, len);
+        ++m_frontRecords;
+        ++m_enqueued;
+        wake = needFlush(level, len + RECORD_HEADER_SIZE);
+    }
+    if(wake) {
+        {
+            std::lock_guard<std::mutex> lock(m_bgMutex);
+            m_wake = true;
+        }
+        m_bgCond.notify_one();
+    }
+}
+
+void NetworkLogHandler::flush() {
+    {
+        WriteMutexType::Lock lock(m_writeMutex);
+        resetFlush();
+    }
+    std::unique_lock<std::mutex> lock(m_bgMutex);
+    uint64_t id = ++m_flushRequest;
+    m_wake = true;
+    m_bgCond.notify_one();
+    m_doneCond.wait_for(lock, std::chrono::milliseconds(m_options.flushTimeoutMs)
+                        ,[this, id]() { return m_flushDone >= id;});
+}
+
+bool NetworkLogHandler::takeIncoming() {
+    size_t pending = m_pending->getReadSize();
+    bool spill_on = m_spillFd >= 0;
+    {
+        WriteMutexType::Lock lock(m_writeMutex);
+        size_t size = m_front->getReadSize();
+        if(size == 0) {
+            return true;
+        }
+        // 不用溢出文件时, 待发送的数据超过上限就先留在写线程的缓冲里, 写满后写线程丢弃新日志
+        if(!spill_on && pending && pending + size > m_options.bufferSize) {
+            return false;
+        }
+        std::swap(m_front, m_incoming);
+        m_incomingRecords = m_frontRecords;
+        m_frontRecords = 0;
+    }
+    size_t size = m_incoming->getReadSize();
+    // 断开或收集器太慢时写溢出文件; 溢出文件里有数据时新日志也要排在后面
+    if(spill_on && (!m_connected || m_spillWrite > m_spillRead
+                    || (pending && pending + size > m_options.bufferSize))) {
+        spill();
+    } else if(pending == 0) {
+        std::swap(m_pending, m_incoming);
+    } else {
+        m_iovs.clear();
+        m_incoming->getReadBuffers(m_iovs);
+        for(auto& i : m_iovs) {
+            m_pending->write(i.iov_base, i.iov_len);
+        }
+        m_incoming->clear();
+    }
+    m_incomingRecords = 0;
+    return true;
+}
+
+void NetworkLogHandler::spill() {
+    size_t size = m_incoming->getReadSize();
+    if(m_spillWrite - m_spillRead + size > m_options.spillSize) {
+        m_lost += m_incomingRecords;
+        m_incoming->clear();
+        return;
+    }
+    m_iovs.clear();
+    m_incoming->getReadBuffers(m_iovs);
+    size_t done = 0;
+    size_t idx = 0;
+    while(idx < m_iovs.size()) {
+        int cnt = std::min<size_t>(m_iovs.size() - idx, IOV_MAX);
+        ssize_t n = pwritev(m_spillFd, &m_iovs[idx], cnt, m_spillWrite + done);
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n <= 0) {
+            // 磁盘满等错误, 这批日志丢弃, 写了一半的部分之后会被覆盖
+            m_lost += m_incomingRecords;
+            m_incoming->clear();
+            return;
+        }
+        done += n;
+        while(n > 0) {
+            if((size_t)n >= m_iovs[idx].iov_len) {
+                n -= m_iovs[idx].iov_len;
+                ++idx;
+            } else {
+                m_iovs[idx].iov_base = (char*)m_iovs[idx].iov_base + n;
+                m_iovs[idx].iov_len -= n;
+                n = 0;
+            }
+        }
+    }
+    m_spillWrite += size;
+    m_spilled += m_incomingRecords;
+    m_spillRecords += m_incomingRecords;
+    m_incoming->clear();
+}
+
+bool NetworkLogHandler::loadSpill() {
+    uint64_t avail = m_spillWrite - m_spillRead;
+    if(!avail) {
+        return false;
+    }
+    size_t want = std::min<uint64_t>(avail, m_spillBuf.size());
+    ssize_t n = pread(m_spillFd, &m_spillBuf[0], want, m_spillRead);
+    // 只取完整的记录
+    size_t off = 0;
+    uint64_t records = 0;
+    while(n > 0 && off + 4 <= (size_t)n) {
+        uint32_t len;
+        memcpy(&len, &m_spillBuf[off], 4);
+        len = be32toh(len);
+        if(off + 4 + len > (size_t)n) {
+            break;
+        }
+        off += 4 + len;
+        ++records;
+    }
+    if(off == 0) {
+        // 读失败或文件内容不对, 放弃溢出文件里的日志
+        m_lost += m_spillRecords;
+        m_spillRecords = 0;
+        m_spillRead = m_spillWrite.load();
+    } else {
+        m_pending->write(&m_spillBuf[0], off);
+        m_spillRead += off;
+        m_spillRecords -= records;
+    }
+    if(m_spillRead == m_spillWrite) {
+        // 读完了从头开始写
+        int rt = ftruncate(m_spillFd, 0);
+        (void)rt;
+        m_spillRead = 0;
+        m_spillWrite = 0;
+        m_spillPunched = 0;
+    } else if(m_spillRead - m_spillPunched >= SPILL_PUNCH_SIZE) {
+        // 释放已经读过的部分占用的磁盘, 文件大小不变
+        uint64_t end = m_spillRead & ~(uint64_t)4095;
+        fallocate(m_spillFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, m_spillPunched, end - m_spillPunched);
+        m_spillPunched = end;
+    }
+    return off > 0;
+}
+
+bool NetworkLogHandler::connect() {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_port);
+    int fd = -1;
+    int rt = -1;
+    if(inet_pton(AF_INET, m_ip.c_str(), &addr.sin_addr) == 1) {
+        fd = socket(AF_INET, (m_transport == TCP ? SOCK_STREAM : SOCK_DGRAM) | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+    if(fd >= 0) {
+        rt = ::connect(fd, (sockaddr*)&addr, sizeof(addr));
+        if(rt && errno == EINPROGRESS) {
+            pollfd pfd = {fd, POLLOUT, 0};
+            if(poll(&pfd, 1, m_options.connectTimeoutMs) == 1) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                rt = err ? -1 : 0;
+            }
+        }
+    }
+    if(rt) {
+        if(fd >= 0) {
+            close(fd);
+        }
+        m_nextConnect = GetMonotonicMS() + m_backoff;
+        m_backoff = std::min(m_backoff * 2, m_options.reconnectMaxMs);
+        return false;
+    }
+    if(m_transport == TCP) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    m_sock = fd;
+    m_connected = true;
+    m_backoff = m_options.reconnectMinMs;
+    ++m_connects;
+    return true;
+}
+
+void NetworkLogHandler::disconnect() {
+    if(m_sock >= 0) {
+        close(m_sock);
+        m_sock = -1;
+    }
+    m_connected = false;
+    // 发了一半的记录在新连接上无法接续
+    if(m_frameLeft) {
+        m_pending->skip(m_frameLeft);
+        m_frameLeft = 0;
+        ++m_lost;
+    }
+    m_nextConnect = GetMonotonicMS() + m_backoff;
+    m_backoff = std::min(m_backoff * 2, m_options.reconnectMaxMs);
+}
+
+void NetworkLogHandler::consume(size_t n) {
+    size_t pos = 0;
+    while(pos < n) {
+        if(m_frameLeft == 0) {
+            uint32_t len;
+            m_pending->peek(&len, 4, pos);
+            m_frameLeft = be32toh(len) + 4;
+        }
+        size_t take = std::min(m_frameLeft, n - pos);
+        pos += take;
+        m_frameLeft -= take;
+        if(m_frameLeft == 0) {
+            ++m_sent;
+        }
+    }
+    m_pending->skip(n);
+}
+
+void NetworkLogHandler::send() {
+    if(m_transport == TCP) {
+        // 收集器关闭的连接在写之前发现, 避免把数据写进已经关闭的连接
+        pollfd pfd = {m_sock, POLLIN | POLLRDHUP, 0};
+        if(poll(&pfd, 1, 0) > 0) {
+            if(pfd.revents & (POLLRDHUP | POLLHUP | POLLERR)) {
+                disconnect();
+                return;
+            }
+            char buf[256];
+            while(recv(m_sock, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+            }
+        }
+    }
+    m_blocked = false;
+    while(m_connected) {
+        if(!m_pending->getReadSize() && !loadSpill()) {
+            break;
+        }
+        if(!(m_transport == TCP ? sendTcp() : sendUdp())) {
+            break;
+        }
+    }
+}
+
+bool NetworkLogHandler::sendTcp() {
+    while(m_pending->getReadSize()) {
+        m_iovs.clear();
+        m_pending->getReadBuffers(m_iovs, m_options.maxBatchBytes);
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &m_iovs[0];
+        msg.msg_iovlen = std::min<size_t>(m_iovs.size(), IOV_MAX);
+        ssize_t n = sendmsg(m_sock, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(n > 0) {
+            consume(n);
+            m_sentBytes += n;
+            ++m_writes;
+            continue;
+        }
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // 收集器太慢, 回到主循环收取新日志(必要时写进溢出文件), 稍后重试
+            m_blocked = true;
+            return false;
+        }
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+size_t NetworkLogHandler::formatSyslogHeader(char* buf, uint8_t level, uint64_t ms) {
+    uint64_t sec = ms / 1000;
+    if(sec != m_cachedSecond) {
+        time_t t = sec;
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        strftime(m_cachedTime, sizeof(m_cachedTime), "%Y-%m-%dT%H:%M:%S", &tm);
+        m_cachedSecond = sec;
+    }
+    int n = snprintf(buf, SYSLOG_HEADER_MAX, "<%u>1 %s.%03uZ%s"
+                     ,m_options.facility * 8 + SyslogSeverity(level), m_cachedTime
+                     ,(uint32_t)(ms % 1000), m_syslogTail.c_str());
+    return std::min<size_t>(n, SYSLOG_HEADER_MAX - 1);
+}
+
+bool NetworkLogHandler::sendUdp() {
+    mmsghdr msgs[UDP_BATCH];
+    char heads[UDP_BATCH][SYSLOG_HEADER_MAX];
+    size_t sizes[UDP_BATCH];
+    size_t first[UDP_BATCH];
+    while(m_pending->getReadSize()) {
+        size_t total = m_pending->getReadSize();
+        size_t off = 0;
+        int cnt = 0;
+        m_iovs.clear();
+        while(cnt < UDP_BATCH && off < total) {
+            char head[RECORD_HEADER_SIZE];
+            m_pending->peek(head, RECORD_HEADER_SIZE, off);
+            uint32_t len;
+            uint64_t ms;
+            memcpy(&len, head, 4);
+            memcpy(&ms, head + 5, 8);
+            len = be32toh(len);
+            size_t text = len - (RECORD_HEADER_SIZE - 4);
+            if(text) {
+                char c;
+                m_pending->peek(&c, 1, off + RECORD_HEADER_SIZE + text - 1);
+                if(c == '\n') {
+                    --text;
+                }
+            }
+            size_t h = formatSyslogHeader(heads[cnt], head[4], be64toh(ms));
+            text = std::min(text, UDP_MAX_PAYLOAD - h);
+            first[cnt] = m_iovs.size();
+            iovec iov;
+            iov.iov_base = heads[cnt];
+            iov.iov_len = h;
+            m_iovs.push_back(iov);
+            if(text) {
+                m_pending->getReadBuffers(m_iovs, text, off + RECORD_HEADER_SIZE);
+            }
+            sizes[cnt] = len + 4;
+            off += len + 4;
+            ++cnt;
+        }
+        for(int i = 0; i < cnt; ++i) {
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_iov = &m_iovs[first[i]];
+            msgs[i].msg_hdr.msg_iovlen = (i + 1 < cnt ? first[i + 1] : m_iovs.size()) - first[i];
+        }
+        int n = sendmmsg(m_sock, msgs, cnt, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(n > 0) {
+            size_t bytes = 0;
+            for(int i = 0; i < n; ++i) {
+                bytes += sizes[i];
+                m_sentBytes += msgs[i].msg_len;
+            }
+            consume(bytes);
+            ++m_writes;
+            continue;
+        }
+        if(n < 0 && errno == EINTR) {
+            continue;
+        }
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            m_blocked = true;
+            return false;
+        }
+        if(n < 0 && (errno == ECONNREFUSED || errno == ENETUNREACH || errno == EHOSTUNREACH)) {
+            // 收集器不在, 日志留着等重连
+            disconnect();
+            return false;
+        }
+        // 其他错误(如报文太大)丢弃第一条
+        m_pending->skip(sizes[0]);
+        ++m_lost;
+    }
+    return true;
+}
+
+void NetworkLogHandler::run() {
+    while(true) {
+        uint64_t flush_request;
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(m_bgMutex);
+            bool busy = m_connected && hasPending() && !m_blocked;
+            if(!busy && !m_wake && !m_stopping && m_flushDone == m_flushRequest) {
+                uint64_t wait = m_options.intervalMs;
+                if(m_blocked) {
+                    wait = std::min<uint64_t>(wait, BLOCKED_RETRY_MS);
+                } else if(!m_connected) {
+                    uint64_t now = GetMonotonicMS();
+                    wait = std::min<uint64_t>(wait, m_nextConnect > now ? m_nextConnect - now : 0);
+                }
+                m_bgCond.wait_for(lock, std::chrono::milliseconds(wait));
+            }
+            m_wake = false;
+            flush_request = m_flushRequest;
+            stopping = m_stopping;
+        }
+
+        bool drained = takeIncoming();
+        if(!m_connected && GetMonotonicMS() >= m_nextConnect) {
+            connect();
+        }
+        if(m_connected) {
+            send();
+        }
+        // 写线程的缓冲取空并且都发出了, 或者连不上(日志留在缓冲和溢出文件里), flush就完成
+        if(flush_request != m_flushDone && (!m_connected || (drained && !hasPending()))) {
+            std::lock_guard<std::mutex> lock(m_bgMutex);
+            m_flushDone = flush_request;
+            m_doneCond.notify_all();
+        }
+        if(stopping) {
+            break;
+        }
+    }
+
+    // 停止前在限定时间内尽量发完
+    uint64_t deadline = GetMonotonicMS() + m_options.stopTimeoutMs;
+    while(GetMonotonicMS() < deadline) {
+        bool drained = takeIncoming();
+        if(drained && !hasPending()) {
+            break;
+        }
+        if(!m_connected && GetMonotonicMS() >= m_nextConnect) {
+            connect();
+        }
+        if(m_connected) {
+            send();
+        }
+        if(!m_connected || m_blocked) {
+            usleep(BLOCKED_RETRY_MS * 1000);
+        }
+    }
+}
+
+}
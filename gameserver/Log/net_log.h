@@ -0,0 +1,249 @@
+#ifndef __GAMESERVER_NET_LOG_H__
+#define __GAMESERVER_NET_LOG_H__
+
+#include "log.h"
+#include "Thread/thread.h"
+#include "Net/bytearray.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace gameserver{
+
+/**
+ * @brief NetworkLogHandler的参数
+ */
+struct NetworkLogOptions {
+    /// 内存里待发送的数据上限(字节), 写线程的缓冲和后台线程的缓冲各一份
+    size_t bufferSize = 4 * 1024 * 1024;
+    /// 溢出文件路径, 为空时不用溢出文件, 内存满后丢弃新日志
+    std::string spillPath;
+    /// 溢出文件上限(字节)
+    uint64_t spillSize = 64 * 1024 * 1024;
+    /// 单条日志最大字节数, 超过的截断
+    uint32_t maxRecordSize = 16 * 1024;
+    /// 一次writev/sendmmsg最多发送的字节数
+    size_t maxBatchBytes = 1024 * 1024;
+    /// 后台线程没有被唤醒时的发送间隔(毫秒)
+    uint32_t intervalMs = 50;
+    /// 连接超时(毫秒)
+    uint32_t connectTimeoutMs = 1000;
+    /// 重连间隔从reconnectMinMs开始每次失败翻倍, 不超过reconnectMaxMs
+    uint32_t reconnectMinMs = 100;
+    uint32_t reconnectMaxMs = 10 * 1000;
+    /// flush()最多等待的时间(毫秒)
+    uint32_t flushTimeoutMs = 1000;
+    /// 析构时把剩余日志发出去最多等待的时间(毫秒)
+    uint32_t stopTimeoutMs = 1000;
+    /// syslog的facility, 默认local0
+    uint32_t facility = 16;
+    /// syslog的APP-NAME
+    std::string appName = "gameserver";
+    /// syslog的HOSTNAME, 为空时用gethostname()
+    std::string hostname;
+};
+
+/**
+ * @brief 发送到远端日志收集器的Handler
+ * @details 写线程只把格式化好的日志加上记录头追加到内存缓冲(自旋锁内一次memcpy), 从不做网络IO;
+ *          缓冲满时丢弃新日志并计数. 后台线程定时(或缓冲积累到刷新策略的字节数, 遇到WARN及以上时被唤醒)
+ *          整体换走写线程的缓冲, 用一次writev(TCP)或sendmmsg(UDP)成批发出.
+ *
+ *          内存缓冲里的记录格式, 也是TCP上的帧格式(整数都是网络字节序):
+ *              uint32 长度(不含这4字节) | uint8 日志级别 | uint64 毫秒时间戳 | 格式化后的日志
+ *          UDP每条日志一个RFC 5424 syslog报文:
+ *              <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID - - MSG
+ *
+ *          连接断开(TCP被关闭或重置, UDP收到ICMP端口不可达)后按退避间隔重连;
+ *          断开期间以及收集器太慢(后台缓冲超过bufferSize)时, 新日志追加到溢出文件(有上限),
+ *          恢复后先按顺序发完溢出文件再发新日志. 发到一半断开的那条日志丢弃(帧不完整).
+ *          只支持IPv4地址, 不做域名解析
+ */
+class NetworkLogHandler : public LogHandler {
+public:
+    typedef std::shared_ptr<NetworkLogHandler> ptr;
+
+    /**
+     * @brief 传输方式
+     */
+    enum Transport {
+        /// 按长度分帧的TCP流
+        TCP = 0,
+        /// RFC 5424 syslog over UDP
+        UDP_SYSLOG = 1
+    };
+
+    /// 记录头长度: 长度, 级别, 时间戳
+    static const size_t RECORD_HEADER_SIZE = 13;
+
+    /**
+     * @brief 构造函数
+     * @param[in] transport 传输方式
+     * @param[in] ip 收集器IPv4地址
+     * @param[in] port 收集器端口
+     * @param[in] options 参数
+     */
+    NetworkLogHandler(Transport transport, const std::string& ip, uint16_t port
+                      ,const NetworkLogOptions& options = NetworkLogOptions());
+
+    /**
+     * @brief 在stopTimeoutMs内尽量发完剩余日志, 发不完的丢弃, 删除溢出文件
+     */
+    ~NetworkLogHandler();
+
+    virtual void log(const std::shared_ptr<Logger>& logger, LogLevel::Level level, const LogEvent& event) override;
+    virtual void write(LogLevel::Level level, const char* data, size_t len) override;
+
+    /**
+     * @brief 唤醒后台线程发送, 等到缓冲发完, 或连接断开, 或flushTimeoutMs超时
+     */
+    virtual void flush() override;
+
+    /**
+     * @brief 丢弃的日志数: 缓冲满被拒绝的, 加上溢出文件满, 发送中断开和UDP发送失败丢弃的
+     */
+    virtual uint64_t getDropped() const override { return m_dropped + m_lost;}
+
+    /**
+     * @brief 已接受但还没发出的日志数(含溢出文件里的)
+     */
+    virtual size_t getQueueDepth() const override { return m_enqueued - m_sent - m_lost;}
+
+    virtual std::string getName() const override;
+
+    Transport getTransport() const { return m_transport;}
+
+    /**
+     * @brief 是否已连接(UDP为socket可用)
+     */
+    bool isConnected() const { return m_connected;}
+
+    /// 写线程接受的日志数
+    uint64_t getEnqueued() const { return m_enqueued;}
+    /// 完整发出的日志数
+    uint64_t getSent() const { return m_sent;}
+    /// 发送的字节数
+    uint64_t getSentBytes() const { return m_sentBytes;}
+    /// writev/sendmmsg调用次数
+    uint64_t getWrites() const { return m_writes;}
+    /// 建立连接的次数
+    uint64_t getConnects() const { return m_connects;}
+    /// 写入溢出文件的日志数
+    uint64_t getSpilled() const { return m_spilled;}
+    /// 溢出文件里待发送的字节数
+    uint64_t getSpillBytes() const { return m_spillWrite - m_spillRead;}
+private:
+    /**
+     * @brief 后台线程
+     */
+    void run();
+
+    /**
+     * @brief 取走写线程的缓冲, 放进待发送缓冲或溢出文件
+     * @return 写线程缓冲是否已经空了
+     */
+    bool takeIncoming();
+
+    /**
+     * @brief 把m_incoming追加到溢出文件, 放不下时丢弃
+     */
+    void spill();
+
+    /**
+     * @brief 从溢出文件读取完整的记录到待发送缓冲
+     * @return 是否读到
+     */
+    bool loadSpill();
+
+    bool connect();
+    void disconnect();
+
+    /**
+     * @brief 发送待发送缓冲和溢出文件, 直到发完, 发不动(socket缓冲满)或断开
+     */
+    void send();
+    bool sendTcp();
+    bool sendUdp();
+
+    /**
+     * @brief 待发送缓冲头部的n字节已经发出, 统计完整发出的记录
+     */
+    void consume(size_t n);
+
+    /**
+     * @brief 生成syslog报文头, 返回长度
+     */
+    size_t formatSyslogHeader(char* buf, uint8_t level, uint64_t ms);
+
+    bool hasPending() const { return m_pending->getReadSize() || m_spillWrite > m_spillRead;}
+private:
+    Transport m_transport;
+    NetworkLogOptions m_options;
+    std::string m_ip;
+    uint16_t m_port;
+
+    /// 写路径只有memcpy, 用自旋锁
+    typedef Spinlock WriteMutexType;
+    WriteMutexType m_writeMutex;
+    /// 写线程的缓冲和其中的记录数, m_writeMutex保护
+    ByteArray* m_front;
+    uint64_t m_frontRecords = 0;
+
+    /// 以下只在后台线程使用
+    /// 换下来的写线程缓冲
+    ByteArray* m_incoming;
+    uint64_t m_incomingRecords = 0;
+    /// 待发送缓冲, 从记录边界开始
+    ByteArray* m_pending;
+    /// 待发送缓冲头部那条记录还没发出的字节数, 0表示在记录边界
+    size_t m_frameLeft = 0;
+    int m_sock = -1;
+    /// 上次发送时socket缓冲满了
+    bool m_blocked = false;
+    /// 下次可以重连的时间(单调毫秒)和当前退避间隔
+    uint64_t m_nextConnect = 0;
+    uint32_t m_backoff;
+    /// 溢出文件及读写位置
+    int m_spillFd = -1;
+    std::atomic<uint64_t> m_spillRead;
+    std::atomic<uint64_t> m_spillWrite;
+    /// 溢出文件开头已经释放了磁盘空间的字节数
+    uint64_t m_spillPunched = 0;
+    /// 溢出文件里的记录数
+    uint64_t m_spillRecords = 0;
+    std::vector<char> m_spillBuf;
+    std::vector<iovec> m_iovs;
+    /// syslog报文头中时间之后的固定部分, 缓存的时间字符串
+    std::string m_syslogTail;
+    uint64_t m_cachedSecond = ~0ull;
+    char m_cachedTime[32];
+
+    std::atomic<bool> m_connected;
+    std::atomic<uint64_t> m_enqueued;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_lost;
+    std::atomic<uint64_t> m_sent;
+    std::atomic<uint64_t> m_sentBytes;
+    std::atomic<uint64_t> m_writes;
+    std::atomic<uint64_t> m_connects;
+    std::atomic<uint64_t> m_spilled;
+
+    /// 保护以下后台线程相关的成员
+    std::mutex m_bgMutex;
+    std::condition_variable m_bgCond;
+    /// flush等待后台完成
+    std::condition_variable m_doneCond;
+    bool m_wake = false;
+    bool m_stopping = false;
+    /// flush请求序号
+    uint64_t m_flushRequest = 0;
+    /// 后台完成的flush序号
+    uint64_t m_flushDone = 0;
+    /// 后台线程
+    Thread::ptr m_thread;
+};
+
+}
+
+#endif
@@ -0,0 +1,620 @@
+#include "bytearray.h"
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace gameserver{
+
+namespace {
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+const bool HOST_LITTLE_ENDIAN = true;
+#else
+const bool HOST_LITTLE_ENDIAN = false;
+#endif
+
+inline uint8_t ByteSwap(uint8_t v) { return v;}
+inline uint16_t ByteSwap(uint16_t v) { return __builtin_bswap16(v);}
+inline uint32_t ByteSwap(uint32_t v) { return __builtin_bswap32(v);}
+inline uint64_t ByteSwap(uint64_t v) { return __builtin_bswap64(v);}
+
+/**
+ * @brief 主机字节序和指定字节序互转
+ */
+template<class T>
+inline T ToOrder(T v, bool little) {
+    return little == HOST_LITTLE_ENDIAN ? v : ByteSwap(v);
+}
+
+inline uint64_t EncodeZigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+inline int64_t DecodeZigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+/// varint最长字节数
+const int MAX_VARINT32 = 5;
+const int MAX_VARINT64 = 10;
+
+/**
+ * @brief 线程局部的默认大小空闲块链表
+ * @details 在其他线程释放的块进入释放线程的链表; 线程退出后不再缓存
+ */
+class BlockCache {
+public:
+    /// 每个线程最多缓存的块数
+    static const size_t MAX_CACHED = 256;
+
+    struct Node {
+        Node* next;
+    };
+
+    static void* Alloc() {
+        if(!t_dead && t_cache.m_head) {
+            Node* n = t_cache.m_head;
+            t_cache.m_head = n->next;
+            --t_cache.m_count;
+            return n;
+        }
+        return nullptr;
+    }
+
+    static bool Free(void* p) {
+        if(t_dead || t_cache.m_count >= MAX_CACHED) {
+            return false;
+        }
+        Node* n = (Node*)p;
+        n->next = t_cache.m_head;
+        t_cache.m_head = n;
+        ++t_cache.m_count;
+        return true;
+    }
+
+    static size_t Count() {
+        return t_dead ? 0 : t_cache.m_count;
+    }
+private:
+    ~BlockCache() {
+        t_dead = true;
+        while(m_head) {
+            Node* n = m_head;
+            m_head = n->next;
+            ::operator delete(n);
+        }
+    }
+private:
+    Node* m_head = nullptr;
+    size_t m_count = 0;
+
+    static thread_local BlockCache t_cache;
+    /// 本线程的缓存已析构
+    static thread_local bool t_dead;
+};
+
+thread_local BlockCache BlockCache::t_cache;
+thread_local bool BlockCache::t_dead = false;
+
+}
+
+ByteArray::ByteArray(size_t block_size)
+    :m_blockSize(block_size ? block_size : DEFAULT_BLOCK_SIZE) {
+}
+
+ByteArray::~ByteArray() {
+    clear();
+}
+
+size_t ByteArray::GetCachedBlocks() {
+    return BlockCache::Count();
+}
+
+ByteArray::Block* ByteArray::allocBlock() {
+    void* p = nullptr;
+    if(m_blockSize == DEFAULT_BLOCK_SIZE) {
+        p = BlockCache::Alloc();
+    }
+    if(!p) {
+        p = ::operator new(sizeof(Block) + m_blockSize);
+    }
+    Block* block = (Block*)p;
+    block->next = nullptr;
+    ++m_blockCount;
+    return block;
+}
+
+void ByteArray::freeBlock(Block* block) {
+    --m_blockCount;
+    if(m_blockSize == DEFAULT_BLOCK_SIZE && BlockCache::Free(block)) {
+        return;
+    }
+    ::operator delete(block);
+}
+
+void ByteArray::clear() {
+    while(m_head) {
+        Block* b = m_head;
+        m_head = b->next;
+        freeBlock(b);
+    }
+    m_tail = m_writeBlock = nullptr;
+    m_readOffset = m_writeOffset = 0;
+    m_size = 0;
+}
+
+void ByteArray::nextWriteBlock() {
+    if(!m_writeBlock) {
+        m_head = m_tail = m_writeBlock = allocBlock();
+        m_readOffset = m_writeOffset = 0;
+        return;
+    }
+    if(!m_writeBlock->next) {
+        m_tail->next = allocBlock();
+        m_tail = m_tail->next;
+    }
+    m_writeBlock = m_writeBlock->next;
+    m_writeOffset = 0;
+}
+
+void ByteArray::consume(size_t size) {
+    m_size -= size;
+    while(size) {
+        size_t end = m_head == m_writeBlock ? m_writeOffset : m_blockSize;
+        size_t n = std::min(size, end - m_readOffset);
+        m_readOffset += n;
+        size -= n;
+        if(m_readOffset == m_blockSize && m_head != m_writeBlock) {
+            Block* b = m_head;
+            m_head = b->next;
+            freeBlock(b);
+            m_readOffset = 0;
+        }
+    }
+    if(!m_size && m_head) {
+        // 读空了, 读写位置都回到写入块的开头, 块留着给后面的写入
+        while(m_head != m_writeBlock) {
+            Block* b = m_head;
+            m_head = b->next;
+            freeBlock(b);
+        }
+        m_readOffset = m_writeOffset = 0;
+    }
+}
+
+void ByteArray::write(const void* buf, size_t size) {
+    const char* p = (const char*)buf;
+    while(size) {
+        if(!m_writeBlock || m_writeOffset == m_blockSize) {
+            nextWriteBlock();
+        }
+        size_t n = std::min(size, m_blockSize - m_writeOffset);
+        memcpy(m_writeBlock->data() + m_writeOffset, p, n);
+        m_writeOffset += n;
+        m_size += n;
+        p += n;
+        size -= n;
+    }
+}
+
+void ByteArray::writeAt(size_t offset, const void* buf, size_t size) {
+    if(offset > m_size || size > m_size - offset) {
+        throw std::out_of_range("ByteArray::writeAt out of range");
+    }
+    const char* p = (const char*)buf;
+    Block* b = m_head;
+    size_t off = m_readOffset + offset;
+    while(off >= m_blockSize && size) {
+        off -= m_blockSize;
+        b = b->next;
+    }
+    while(size) {
+        size_t n = std::min(size, m_blockSize - off);
+        memcpy(b->data() + off, p, n);
+        p += n;
+        size -= n;
+        b = b->next;
+        off = 0;
+    }
+}
+
+void ByteArray::peek(void* buf, size_t size, size_t offset) const {
+    if(offset > m_size || size > m_size - offset) {
+        throw std::out_of_range("ByteArray::peek not enough data");
+    }
+    char* p = (char*)buf;
+    const Block* b = m_head;
+    size_t off = m_readOffset + offset;
+    while(off >= m_blockSize && size) {
+        off -= m_blockSize;
+        b = b->next;
+    }
+    while(size) {
+        size_t n = std::min(size, m_blockSize - off);
+        memcpy(p, const_cast<Block*>(b)->data() + off, n);
+        p += n;
+        size -= n;
+        b = b->next;
+        off = 0;
+    }
+}
+
+void ByteArray::read(void* buf, size_t size) {
+    peek(buf, size);
+    consume(size);
+}
+
+void ByteArray::skip(size_t size) {
+    if(size > m_size) {
+        throw std::out_of_range("ByteArray::skip not enough data");
+    }
+    consume(size);
+}
+
+template<class T>
+void ByteArray::writeFixed(T v) {
+    if(m_writeBlock && m_blockSize - m_writeOffset >= sizeof(T)) {
+        memcpy(m_writeBlock->data() + m_writeOffset, &v, sizeof(T));
+        m_writeOffset += sizeof(T);
+        m_size += sizeof(T);
+        return;
+    }
+    write(&v, sizeof(T));
+}
+
+template<class T>
+T ByteArray::readFixed() {
+    T v;
+    if(m_size >= sizeof(T) && m_blockSize - m_readOffset >= sizeof(T)) {
+        memcpy(&v, m_head->data() + m_readOffset, sizeof(T));
+    } else {
+        peek(&v, sizeof(T));
+    }
+    consume(sizeof(T));
+    return v;
+}
+
+void ByteArray::writeFint8(int8_t value) {
+    writeFixed((uint8_t)value);
+}
+
+void ByteArray::writeFuint8(uint8_t value) {
+    writeFixed(value);
+}
+
+void ByteArray::writeFint16(int16_t value) {
+    writeFixed(ToOrder((uint16_t)value, m_littleEndian));
+}
+
+void ByteArray::writeFuint16(uint16_t value) {
+    writeFixed(ToOrder(value, m_littleEndian));
+}
+
+void ByteArray::writeFint32(int32_t value) {
+    writeFixed(ToOrder((uint32_t)value, m_littleEndian));
+}
+
+void ByteArray::writeFuint32(uint32_t value) {
+    writeFixed(ToOrder(value, m_littleEndian));
+}
+
+void ByteArray::writeFint64(int64_t value) {
+    writeFixed(ToOrder((uint64_t)value, m_littleEndian));
+}
+
+void ByteArray::writeFuint64(uint64_t value) {
+    writeFixed(ToOrder(value, m_littleEndian));
+}
+
+void ByteArray::writeVarint(uint64_t v) {
+    char tmp[MAX_VARINT64];
+    char* p;
+    // 当前块放得下最长编码时直接写进块里
+    bool direct = m_writeBlock && m_blockSize - m_writeOffset >= (size_t)MAX_VARINT64;
+    char* begin = direct ? m_writeBlock->data() + m_writeOffset : tmp;
+    p = begin;
+    while(v >= 0x80) {
+        *p++ = (char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (char)v;
+    if(direct) {
+        m_writeOffset += p - begin;
+        m_size += p - begin;
+    } else {
+        write(tmp, p - tmp);
+    }
+}
+
+uint64_t ByteArray::readVarint(int max_bytes) {
+    char tmp[MAX_VARINT64];
+    size_t n = std::min(m_size, (size_t)max_bytes);
+    const char* p;
+    size_t head_end = m_head == m_writeBlock ? m_writeOffset : m_blockSize;
+    if(m_head && head_end - m_readOffset >= n) {
+        p = m_head->data() + m_readOffset;
+    } else {
+        peek(tmp, n);
+        p = tmp;
+    }
+    uint64_t v = 0;
+    for(size_t i = 0; i < n; ++i) {
+        uint8_t c = (uint8_t)p[i];
+        v |= (uint64_t)(c & 0x7f) << (7 * i);
+        if(!(c & 0x80)) {
+            consume(i + 1);
+            return v;
+        }
+    }
+    throw std::out_of_range(n < (size_t)max_bytes ? "ByteArray::readVarint not enough data"
+                                                  : "ByteArray::readVarint too long");
+}
+
+void ByteArray::writeInt32(int32_t value) {
+    writeVarint(EncodeZigzag(value));
+}
+
+void ByteArray::writeUint32(uint32_t value) {
+    writeVarint(value);
+}
+
+void ByteArray::writeInt64(int64_t value) {
+    writeVarint(EncodeZigzag(value));
+}
+
+void ByteArray::writeUint64(uint64_t value) {
+    writeVarint(value);
+}
+
+void ByteArray::writeFloat(float value) {
+    uint32_t v;
+    memcpy(&v, &value, sizeof(value));
+    writeFuint32(v);
+}
+
+void ByteArray::writeDouble(double value) {
+    uint64_t v;
+    memcpy(&v, &value, sizeof(value));
+    writeFuint64(v);
+}
+
+void ByteArray::writeStringF16(const std::string& value) {
+    writeFuint16(value.size());
+    write(value.c_str(), value.size());
+}
+
+void ByteArray::writeStringF32(const std::string& value) {
+    writeFuint32(value.size());
+    write(value.c_str(), value.size());
+}
+
+void ByteArray::writeStringF64(const std::string& value) {
+    writeFuint64(value.size());
+    write(value.c_str(), value.size());
+}
+
+void ByteArray::writeStringVint(const std::string& value) {
+    writeUint64(value.size());
+    write(value.c_str(), value.size());
+}
+
+void ByteArray::writeStringWithoutLength(const std::string& value) {
+    write(value.c_str(), value.size());
+}
+
+int8_t ByteArray::readFint8() {
+    return (int8_t)readFixed<uint8_t>();
+}
+
+uint8_t ByteArray::readFuint8() {
+    return readFixed<uint8_t>();
+}
+
+int16_t ByteArray::readFint16() {
+    return (int16_t)ToOrder(readFixed<uint16_t>(), m_littleEndian);
+}
+
+uint16_t ByteArray::readFuint16() {
+    return ToOrder(readFixed<uint16_t>(), m_littleEndian);
+}
+
+int32_t ByteArray::readFint32() {
+    return (int32_t)ToOrder(readFixed<uint32_t>(), m_littleEndian);
+}
+
+uint32_t ByteArray::readFuint32() {
+    return ToOrder(readFixed<uint32_t>(), m_littleEndian);
+}
+
+int64_t ByteArray::readFint64() {
+    return (int64_t)ToOrder(readFixed<uint64_t>(), m_littleEndian);
+}
+
+uint64_t ByteArray::readFuint64() {
+    return ToOrder(readFixed<uint64_t>(), m_littleEndian);
+}
+
+int32_t ByteArray::readInt32() {
+    return (int32_t)DecodeZigzag(readVarint(MAX_VARINT32));
+}
+
+uint32_t ByteArray::readUint32() {
+    return (uint32_t)readVarint(MAX_VARINT32);
+}
+
+int64_t ByteArray::readInt64() {
+    return DecodeZigzag(readVarint(MAX_VARINT64));
+}
+
+uint64_t ByteArray::readUint64() {
+    return readVarint(MAX_VARINT64);
+}
+
+float ByteArray::readFloat() {
+    uint32_t v = readFuint32();
+    float value;
+    memcpy(&value, &v, sizeof(v));
+    return value;
+}
+
+double ByteArray::readDouble() {
+    uint64_t v = readFuint64();
+    double value;
+    memcpy(&value, &v, sizeof(v));
+    return value;
+}
+
+template<class T>
+std::string ByteArray::readString() {
+    T len;
+    peek(&len, sizeof(len));
+    len = ToOrder(len, m_littleEndian);
+    if(len > m_size - sizeof(len)) {
+        throw std::out_of_range("ByteArray::readString not enough data");
+    }
+    consume(sizeof(len));
+    std::string buff(len, '\0');
+    read(&buff[0], len);
+    return buff;
+}
+
+std::string ByteArray::readStringF16() {
+    return readString<uint16_t>();
+}
+
+std::string ByteArray::readStringF32() {
+    return readString<uint32_t>();
+}
+
+std::string ByteArray::readStringF64() {
+    return readString<uint64_t>();
+}
+
+std::string ByteArray::readStringVint() {
+    // 先确认整个字符串都在, 否则长度也不消费
+    uint8_t tmp[MAX_VARINT64];
+    size_t n = std::min(m_size, (size_t)MAX_VARINT64);
+    peek(tmp, n);
+    uint64_t len = 0;
+    size_t used = 0;
+    for(size_t i = 0; i < n; ++i) {
+        len |= (uint64_t)(tmp[i] & 0x7f) << (7 * i);
+        if(!(tmp[i] & 0x80)) {
+            used = i + 1;
+            break;
+        }
+    }
+    if(!used || len > m_size - used) {
+        throw std::out_of_range("ByteArray::readStringVint not enough data");
+    }
+    consume(used);
+    std::string buff(len, '\0');
+    read(&buff[0], len);
+    return buff;
+}
+
+size_t ByteArray::getReadBuffers(std::vector<iovec>& buffers, size_t len, size_t offset) const {
+    if(offset >= m_size) {
+        return 0;
+    }
+    len = std::min(len, m_size - offset);
+    size_t size = len;
+    Block* b = m_head;
+    size_t off = m_readOffset + offset;
+    while(off >= m_blockSize) {
+        off -= m_blockSize;
+        b = b->next;
+    }
+    while(size) {
+        size_t n = std::min(size, m_blockSize - off);
+        iovec iov;
+        iov.iov_base = b->data() + off;
+        iov.iov_len = n;
+        buffers.push_back(iov);
+        size -= n;
+        b = b->next;
+        off = 0;
+    }
+    return len;
+}
+
+size_t ByteArray::getWriteBuffers(std::vector<iovec>& buffers, size_t len) {
+    if(!len) {
+        return 0;
+    }
+    if(!m_writeBlock) {
+        nextWriteBlock();
+    }
+    size_t free_size = m_blockSize - m_writeOffset;
+    for(Block* b = m_writeBlock->next; b; b = b->next) {
+        free_size += m_blockSize;
+    }
+    while(free_size < len) {
+        m_tail->next = allocBlock();
+        m_tail = m_tail->next;
+        free_size += m_blockSize;
+    }
+    size_t size = len;
+    Block* b = m_writeBlock;
+    size_t off = m_writeOffset;
+    while(size) {
+        size_t n = std::min(size, m_blockSize - off);
+        if(n) {
+            iovec iov;
+            iov.iov_base = b->data() + off;
+            iov.iov_len = n;
+            buffers.push_back(iov);
+            size -= n;
+        }
+        b = b->next;
+        off = 0;
+    }
+    return len;
+}
+
+void ByteArray::commit(size_t size) {
+    size_t free_size = m_writeBlock ? m_blockSize - m_writeOffset : 0;
+    for(Block* b = m_writeBlock ? m_writeBlock->next : nullptr; b && free_size < size; b = b->next) {
+        free_size += m_blockSize;
+    }
+    if(size > free_size) {
+        throw std::out_of_range("ByteArray::commit more than reserved");
+    }
+    m_size += size;
+    while(size) {
+        if(m_writeOffset == m_blockSize) {
+            m_writeBlock = m_writeBlock->next;
+            m_writeOffset = 0;
+        }
+        size_t n = std::min(size, m_blockSize - m_writeOffset);
+        m_writeOffset += n;
+        size -= n;
+    }
+}
+
+std::string ByteArray::toString() const {
+    std::string str(m_size, '\0');
+    if(m_size) {
+        peek(&str[0], m_size);
+    }
+    return str;
+}
+
+std::string ByteArray::toHexString() const {
+    static const char* s_hex = "0123456789abcdef";
+    std::string str = toString();
+    std::string out;
+    out.reserve(str.size() * 3 + str.size() / 32 + 1);
+    for(size_t i = 0; i < str.size(); ++i) {
+        if(i > 0 && i % 32 == 0) {
+            out.push_back('\n');
+        }
+        uint8_t c = (uint8_t)str[i];
+        out.push_back(s_hex[c >> 4]);
+        out.push_back(s_hex[c & 0xf]);
+        out.push_back(' ');
+    }
+    return out;
+}
+
+}
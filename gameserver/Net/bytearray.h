@@ -0,0 +1,269 @@
+#ifndef __GAMESERVER_BYTEARRAY_H__
+#define __GAMESERVER_BYTEARRAY_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace gameserver{
+
+/**
+ * @brief 二进制序列化缓冲, 由定长块串成的链表
+ * @details 写入追加到末尾, 读取从头部消费, 读完的块立即释放; 数据不做整体搬移, 扩容也不拷贝.
+ *          默认大小的块从线程缓存分配, 稳定运行时收发不调用malloc.
+ *          定长整数和浮点数按设置的字节序(默认大端, 即网络字节序);
+ *          Int32/Uint32/Int64/Uint64为varint, 有符号数先做zigzag, 与字节序无关.
+ *          getReadBuffers()/getWriteBuffers()把块直接交给writev/readv, 中间不拷贝.
+ *          不是线程安全的
+ */
+class ByteArray {
+public:
+    typedef std::shared_ptr<ByteArray> ptr;
+
+    /// 默认块大小, 这个大小的块走线程缓存
+    static const size_t DEFAULT_BLOCK_SIZE = 4096;
+
+    /**
+     * @brief 构造函数
+     * @param[in] block_size 块大小
+     */
+    ByteArray(size_t block_size = DEFAULT_BLOCK_SIZE);
+    ~ByteArray();
+
+    ByteArray(const ByteArray&) = delete;
+    ByteArray& operator=(const ByteArray&) = delete;
+
+    /**
+     * @brief 写定长整数, 按设置的字节序
+     */
+    void writeFint8(int8_t value);
+    void writeFuint8(uint8_t value);
+    void writeFint16(int16_t value);
+    void writeFuint16(uint16_t value);
+    void writeFint32(int32_t value);
+    void writeFuint32(uint32_t value);
+    void writeFint64(int64_t value);
+    void writeFuint64(uint64_t value);
+
+    /**
+     * @brief 写varint, 有符号数用zigzag编码, 绝对值小的数占的字节少
+     */
+    void writeInt32(int32_t value);
+    void writeUint32(uint32_t value);
+    void writeInt64(int64_t value);
+    void writeUint64(uint64_t value);
+
+    /**
+     * @brief 写浮点数, 按设置的字节序写IEEE 754的位
+     */
+    void writeFloat(float value);
+    void writeDouble(double value);
+
+    /**
+     * @brief 写字符串, 先写长度: F16/F32/F64为定长整数, Vint为varint
+     */
+    void writeStringF16(const std::string& value);
+    void writeStringF32(const std::string& value);
+    void writeStringF64(const std::string& value);
+    void writeStringVint(const std::string& value);
+
+    /**
+     * @brief 只写字符串内容, 不写长度
+     */
+    void writeStringWithoutLength(const std::string& value);
+
+    /**
+     * @brief 写原始字节
+     */
+    void write(const void* buf, size_t size);
+
+    /**
+     * @brief 覆盖已写入的数据, 用于先占位后回填(如包头的长度)
+     * @param[in] offset 相对当前读位置的偏移
+     * @exception std::out_of_range offset + size 超出可读数据
+     */
+    void writeAt(size_t offset, const void* buf, size_t size);
+
+    /**
+     * @brief 读定长整数
+     * @exception std::out_of_range 可读数据不够, 此时不消费任何数据
+     */
+    int8_t   readFint8();
+    uint8_t  readFuint8();
+    int16_t  readFint16();
+    uint16_t readFuint16();
+    int32_t  readFint32();
+    uint32_t readFuint32();
+    int64_t  readFint64();
+    uint64_t readFuint64();
+
+    /**
+     * @brief 读varint
+     * @exception std::out_of_range 可读数据不够或编码超长, 此时不消费任何数据
+     */
+    int32_t  readInt32();
+    uint32_t readUint32();
+    int64_t  readInt64();
+    uint64_t readUint64();
+
+    float    readFloat();
+    double   readDouble();
+
+    /**
+     * @brief 读带长度的字符串, 与对应的write配对
+     * @exception std::out_of_range 可读数据不够, 此时不消费任何数据
+     */
+    std::string readStringF16();
+    std::string readStringF32();
+    std::string readStringF64();
+    std::string readStringVint();
+
+    /**
+     * @brief 读原始字节并消费
+     * @exception std::out_of_range 可读数据不够
+     */
+    void read(void* buf, size_t size);
+
+    /**
+     * @brief 读原始字节, 不消费
+     * @param[in] offset 相对当前读位置的偏移
+     * @exception std::out_of_range 可读数据不够
+     */
+    void peek(void* buf, size_t size, size_t offset = 0) const;
+
+    /**
+     * @brief 丢弃开头的size个字节(如writev写出之后)
+     * @exception std::out_of_range 可读数据不够
+     */
+    void skip(size_t size);
+
+    /**
+     * @brief 清空, 块都还回线程缓存
+     */
+    void clear();
+
+    /**
+     * @brief 可读的数据, 用于writev
+     * @param[out] buffers 追加指向各块的iovec, 下一次修改之前有效
+     * @param[in] len 最多多少字节
+     * @param[in] offset 从当前读位置之后的offset开始
+     * @return 实际的字节数
+     */
+    size_t getReadBuffers(std::vector<iovec>& buffers, size_t len = ~(size_t)0, size_t offset = 0) const;
+
+    /**
+     * @brief 预留写入空间, 用于readv, 读到数据后用commit()确认
+     * @details 不够时在末尾追加块; 得到的iovec在下一次写入, commit或读取之前有效
+     * @param[out] buffers 追加指向空闲空间的iovec
+     * @param[in] len 需要的字节数
+     * @return len
+     */
+    size_t getWriteBuffers(std::vector<iovec>& buffers, size_t len);
+
+    /**
+     * @brief 确认getWriteBuffers()的空间里写入了size个字节
+     * @exception std::out_of_range size超出预留的空间
+     */
+    void commit(size_t size);
+
+    /**
+     * @brief 可读的字节数
+     */
+    size_t getReadSize() const { return m_size;}
+
+    /**
+     * @brief 块大小
+     */
+    size_t getBlockSize() const { return m_blockSize;}
+
+    /**
+     * @brief 已分配的总容量(包括读完未释放和预留的部分)
+     */
+    size_t getCapacity() const { return m_blockCount * m_blockSize;}
+
+    /**
+     * @brief 定长数据是否按小端读写
+     */
+    bool isLittleEndian() const { return m_littleEndian;}
+    void setIsLittleEndian(bool v) { m_littleEndian = v;}
+
+    /**
+     * @brief 可读数据拷贝成字符串, 不消费
+     */
+    std::string toString() const;
+
+    /**
+     * @brief 可读数据的十六进制表示, 每32个字节一行, 不消费
+     */
+    std::string toHexString() const;
+
+    /**
+     * @brief 本线程缓存的空闲块数
+     */
+    static size_t GetCachedBlocks();
+private:
+    /**
+     * @brief 块, 数据紧跟在结构之后
+     */
+    struct Block {
+        Block* next;
+        char* data() { return (char*)(this + 1);}
+    };
+
+    Block* allocBlock();
+    void freeBlock(Block* block);
+
+    /**
+     * @brief 写入位置所在的块没有空间时, 移到下一块(没有则追加)
+     */
+    void nextWriteBlock();
+
+    /**
+     * @brief 消费开头的size个字节, 调用方保证可读数据足够
+     */
+    void consume(size_t size);
+
+    /**
+     * @brief 写定长值, v已经是目标字节序
+     */
+    template<class T>
+    void writeFixed(T v);
+
+    /**
+     * @brief 读定长值, 返回目标字节序转换之前的原始值
+     */
+    template<class T>
+    T readFixed();
+
+    void writeVarint(uint64_t v);
+    uint64_t readVarint(int max_bytes);
+
+    template<class T>
+    std::string readString();
+private:
+    /// 块大小
+    size_t m_blockSize;
+    /// 可读的字节数
+    size_t m_size = 0;
+    /// 第一块, 读位置所在的块
+    Block* m_head = nullptr;
+    /// 读位置在第一块里的偏移
+    size_t m_readOffset = 0;
+    /// 写位置所在的块, 之后的块是getWriteBuffers()预留的空闲块
+    Block* m_writeBlock = nullptr;
+    /// 写位置在块里的偏移
+    size_t m_writeOffset = 0;
+    /// 最后一块
+    Block* m_tail = nullptr;
+    /// 块数
+    size_t m_blockCount = 0;
+    /// 是否小端
+    bool m_littleEndian = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+#include "http.h"
+#include <strings.h>
+#include <sstream>
+
+namespace gameserver{
+namespace http{
+
+bool StringView::equalsIgnoreCase(const StringView& o) const {
+    return size == o.size && (size == 0 || strncasecmp(data, o.data, size) == 0);
+}
+
+std::ostream& operator<<(std::ostream& os, const StringView& v) {
+    return os.write(v.data, v.size);
+}
+
+HttpMethod StringToHttpMethod(const StringView& m) {
+#define XX(num, name, string) \
+    if(m.size == sizeof(#string) - 1 && memcmp(m.data, #string, m.size) == 0) { \
+        return HttpMethod::name; \
+    }
+    HTTP_METHOD_MAP(XX);
+#undef XX
+    return HttpMethod::INVALID_METHOD;
+}
+
+static const char* s_method_string[] = {
+#define XX(num, name, string) #string,
+    HTTP_METHOD_MAP(XX)
+#undef XX
+};
+
+const char* HttpMethodToString(const HttpMethod& m) {
+    uint32_t idx = (uint32_t)m;
+    if(idx >= (sizeof(s_method_string) / sizeof(s_method_string[0]))) {
+        return "<unknown>";
+    }
+    return s_method_string[idx];
+}
+
+const char* HttpStatusToString(const HttpStatus& s) {
+    switch(s) {
+#define XX(code, name, msg) \
+        case HttpStatus::name: \
+            return #msg;
+        HTTP_STATUS_MAP(XX);
+#undef XX
+        default:
+            return "<unknown>";
+    }
+}
+
+void HttpMessage::clear() {
+    m_version = 0x11;
+    m_close = false;
+    m_chunked = false;
+    m_headers.clear();
+    m_body = Span();
+}
+
+HttpMessage::Header HttpMessage::getHeader(size_t i) const {
+    Header h;
+    h.name = view(m_headers[i].first);
+    h.value = view(m_headers[i].second);
+    return h;
+}
+
+StringView HttpMessage::getHeader(const StringView& name, const StringView& def) const {
+    for(auto& i : m_headers) {
+        if(view(i.first).equalsIgnoreCase(name)) {
+            return view(i.second);
+        }
+    }
+    return def;
+}
+
+bool HttpMessage::hasHeader(const StringView& name) const {
+    for(auto& i : m_headers) {
+        if(view(i.first).equalsIgnoreCase(name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HttpRequest::clear() {
+    HttpMessage::clear();
+    m_method = HttpMethod::GET;
+    m_uri = m_path = m_query = m_fragment = Span();
+}
+
+StringView HttpRequest::getParam(const StringView& key, const StringView& def) const {
+    StringView q = getQuery();
+    const char* p = q.data;
+    const char* end = q.data + q.size;
+    while(p < end) {
+        const char* amp = (const char*)memchr(p, '&', end - p);
+        if(!amp) {
+            amp = end;
+        }
+        const char* eq = (const char*)memchr(p, '=', amp - p);
+        const char* kend = eq ? eq : amp;
+        if(StringView(p, kend - p) == key) {
+            return eq ? StringView(eq + 1, amp - eq - 1) : StringView(amp, 0);
+        }
+        p = amp + 1;
+    }
+    return def;
+}
+
+std::string HttpRequest::toString() const {
+    std::stringstream ss;
+    ss << *this;
+    return ss.str();
+}
+
+std::ostream& operator<<(std::ostream& os, const HttpRequest& req) {
+    os << HttpMethodToString(req.getMethod()) << " "
+       << req.getUri() << " HTTP/"
+       << ((uint32_t)(req.getVersion() >> 4)) << "."
+       << ((uint32_t)(req.getVersion() & 0x0F)) << "\r\n";
+    for(size_t i = 0; i < req.getHeaderCount(); ++i) {
+        HttpMessage::Header h = req.getHeader(i);
+        os << h.name << ": " << h.value << "\r\n";
+    }
+    os << "\r\n" << req.getBody();
+    return os;
+}
+
+void HttpResponseView::clear() {
+    HttpMessage::clear();
+    m_status = HttpStatus::OK;
+    m_reason = Span();
+}
+
+HttpResponse::HttpResponse(uint8_t version, bool close)
+    :m_version(version)
+    ,m_close(close) {
+}
+
+void HttpResponse::reset(uint8_t version, bool close) {
+    m_status = HttpStatus::OK;
+    m_version = version;
+    m_close = close;
+    m_reason.clear();
+    m_headers.clear();
+    m_body.clear();
+}
+
+std::string HttpResponse::getHeader(const std::string& key, const std::string& def) const {
+    for(auto& i : m_headers) {
+        if(strcasecmp(i.first.c_str(), key.c_str()) == 0) {
+            return i.second;
+        }
+    }
+    return def;
+}
+
+void HttpResponse::setHeader(const std::string& key, const std::string& val) {
+    for(auto& i : m_headers) {
+        if(strcasecmp(i.first.c_str(), key.c_str()) == 0) {
+            i.second = val;
+            return;
+        }
+    }
+    m_headers.push_back(std::make_pair(key, val));
+}
+
+void HttpResponse::delHeader(const std::string& key) {
+    for(auto it = m_headers.begin(); it != m_headers.end(); ++it) {
+        if(strcasecmp(it->first.c_str(), key.c_str()) == 0) {
+            m_headers.erase(it);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 非负整数写成十进制, 返回结尾
+ */
+static char* FormatUint(char* p, uint64_t v) {
+    char tmp[24];
+    char* t = tmp;
+    do {
+        *t++ = '0' + v % 10;
+        v /= 10;
+    } while(v);
+    while(t != tmp) {
+        *p++ = *--t;
+    }
+    return p;
+}
+
+void HttpResponse::dump(ByteArray& ba, bool with_body) const {
+    char line[64];
+    char* p = line;
+    memcpy(p, m_version == 0x10 ? "HTTP/1.0 " : "HTTP/1.1 ", 9);
+    p += 9;
+    p = FormatUint(p, (uint32_t)m_status);
+    *p++ = ' ';
+    ba.write(line, p - line);
+    if(m_reason.empty()) {
+        const char* reason = HttpStatusToString(m_status);
+        ba.write(reason, strlen(reason));
+    } else {
+        ba.writeStringWithoutLength(m_reason);
+    }
+    ba.write("\r\n", 2);
+
+    for(auto& i : m_headers) {
+        // 这两个由下面生成
+        if(strcasecmp(i.first.c_str(), "content-length") == 0
+                || strcasecmp(i.first.c_str(), "connection") == 0) {
+            continue;
+        }
+        ba.writeStringWithoutLength(i.first);
+        ba.write(": ", 2);
+        ba.writeStringWithoutLength(i.second);
+        ba.write("\r\n", 2);
+    }
+    if(m_close) {
+        ba.write("Connection: close\r\n", 19);
+    } else if(m_version == 0x10) {
+        ba.write("Connection: keep-alive\r\n", 24);
+    }
+    uint32_t code = (uint32_t)m_status;
+    if(code >= 200 && code != 204 && code != 304) {
+        p = line;
+        memcpy(p, "Content-Length: ", 16);
+        p = FormatUint(p + 16, m_body.size());
+        memcpy(p, "\r\n\r\n", 4);
+        ba.write(line, p + 4 - line);
+        if(with_body) {
+            ba.writeStringWithoutLength(m_body);
+        }
+    } else {
+        ba.write("\r\n", 2);
+    }
+}
+
+std::string HttpResponse::toString() const {
+    ByteArray ba;
+    dump(ba);
+    return ba.toString();
+}
+
+std::ostream& operator<<(std::ostream& os, const HttpResponse& rsp) {
+    return os << rsp.toString();
+}
+
+}
+}
@@ -0,0 +1,345 @@
+#ifndef __GAMESERVER_HTTP_H__
+#define __GAMESERVER_HTTP_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+#include <string.h>
+#include "bytearray.h"
+
+namespace gameserver{
+namespace http{
+
+/* Request Methods */
+#define HTTP_METHOD_MAP(XX)         \
+  XX(0,  DELETE,      DELETE)       \
+  XX(1,  GET,         GET)          \
+  XX(2,  HEAD,        HEAD)         \
+  XX(3,  POST,        POST)         \
+  XX(4,  PUT,         PUT)          \
+  XX(5,  CONNECT,     CONNECT)      \
+  XX(6,  OPTIONS,     OPTIONS)      \
+  XX(7,  TRACE,       TRACE)        \
+  XX(8,  PATCH,       PATCH)        \
+
+/* Status Codes */
+#define HTTP_STATUS_MAP(XX)                                                 \
+  XX(100, CONTINUE,                        Continue)                        \
+  XX(101, SWITCHING_PROTOCOLS,             Switching Protocols)             \
+  XX(200, OK,                              OK)                              \
+  XX(201, CREATED,                         Created)                         \
+  XX(202, ACCEPTED,                        Accepted)                        \
+  XX(204, NO_CONTENT,                      No Content)                      \
+  XX(206, PARTIAL_CONTENT,                 Partial Content)                 \
+  XX(301, MOVED_PERMANENTLY,               Moved Permanently)               \
+  XX(302, FOUND,                           Found)                           \
+  XX(304, NOT_MODIFIED,                    Not Modified)                    \
+  XX(307, TEMPORARY_REDIRECT,              Temporary Redirect)              \
+  XX(308, PERMANENT_REDIRECT,              Permanent Redirect)              \
+  XX(400, BAD_REQUEST,                     Bad Request)                     \
+  XX(401, UNAUTHORIZED,                    Unauthorized)                    \
+  XX(403, FORBIDDEN,                       Forbidden)                       \
+  XX(404, NOT_FOUND,                       Not Found)                       \
+  XX(405, METHOD_NOT_ALLOWED,              Method Not Allowed)              \
+  XX(408, REQUEST_TIMEOUT,                 Request Timeout)                 \
+  XX(411, LENGTH_REQUIRED,                 Length Required)                 \
+  XX(413, PAYLOAD_TOO_LARGE,               Payload Too Large)               \
+  XX(414, URI_TOO_LONG,                    URI Too Long)                    \
+  XX(415, UNSUPPORTED_MEDIA_TYPE,          Unsupported Media Type)          \
+  XX(417, EXPECTATION_FAILED,              Expectation Failed)              \
+  XX(426, UPGRADE_REQUIRED,                Upgrade Required)                \
+  XX(429, TOO_MANY_REQUESTS,               Too Many Requests)               \
+  XX(431, REQUEST_HEADER_FIELDS_TOO_LARGE, Request Header Fields Too Large) \
+  XX(500, INTERNAL_SERVER_ERROR,           Internal Server Error)           \
+  XX(501, NOT_IMPLEMENTED,                 Not Implemented)                 \
+  XX(502, BAD_GATEWAY,                     Bad Gateway)                     \
+  XX(503, SERVICE_UNAVAILABLE,             Service Unavailable)             \
+  XX(504, GATEWAY_TIMEOUT,                 Gateway Timeout)                 \
+  XX(505, HTTP_VERSION_NOT_SUPPORTED,      HTTP Version Not Supported)      \
+
+/**
+ * @brief HTTP方法枚举
+ */
+enum class HttpMethod {
+#define XX(num, name, string) name = num,
+    HTTP_METHOD_MAP(XX)
+#undef XX
+    INVALID_METHOD
+};
+
+/**
+ * @brief HTTP状态枚举
+ */
+enum class HttpStatus {
+#define XX(code, name, desc) name = code,
+    HTTP_STATUS_MAP(XX)
+#undef XX
+};
+
+/**
+ * @brief 不拥有数据的字符串片段, 指向接收缓冲
+ */
+struct StringView {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    StringView() {}
+    StringView(const char* d, size_t s) :data(d), size(s) {}
+    StringView(const char* s) :data(s), size(strlen(s)) {}
+    StringView(const std::string& s) :data(s.c_str()), size(s.size()) {}
+
+    bool empty() const { return size == 0;}
+    std::string toString() const { return std::string(data, size);}
+
+    bool operator==(const StringView& o) const {
+        return size == o.size && (size == 0 || memcmp(data, o.data, size) == 0);
+    }
+    bool operator!=(const StringView& o) const { return !(*this == o);}
+
+    /**
+     * @brief 忽略大小写比较(ASCII)
+     */
+    bool equalsIgnoreCase(const StringView& o) const;
+};
+
+std::ostream& operator<<(std::ostream& os, const StringView& v);
+
+/**
+ * @brief 字符串转HTTP方法, 不认识的返回INVALID_METHOD
+ */
+HttpMethod StringToHttpMethod(const StringView& m);
+
+/**
+ * @brief HTTP方法转字符串
+ */
+const char* HttpMethodToString(const HttpMethod& m);
+
+/**
+ * @brief HTTP状态的原因短语
+ */
+const char* HttpStatusToString(const HttpStatus& s);
+
+class HttpParser;
+
+/**
+ * @brief 解析出的HTTP消息(请求或响应的公共部分)
+ * @details 由解析器填写, 起始行, 头部和消息体都是指向接收缓冲的片段, 不拷贝;
+ *          缓冲被修改(继续读入, 整理, 释放)之后不能再使用
+ */
+class HttpMessage {
+friend class HttpParser;
+public:
+    /**
+     * @brief 头部字段
+     */
+    struct Header {
+        StringView name;
+        StringView value;
+    };
+
+    /**
+     * @brief 版本, 0x11为HTTP/1.1, 0x10为HTTP/1.0
+     */
+    uint8_t getVersion() const { return m_version;}
+
+    /**
+     * @brief 收发完这个消息后是否关闭连接
+     * @details Connection: close, 或HTTP/1.0没有Connection: keep-alive, 或响应的消息体到连接关闭为止
+     */
+    bool isClose() const { return m_close;}
+
+    /**
+     * @brief 消息体是否是chunked编码(已在缓冲里原地解码)
+     */
+    bool isChunked() const { return m_chunked;}
+
+    size_t getHeaderCount() const { return m_headers.size();}
+
+    /**
+     * @brief 第i个头部字段, 按收到的顺序
+     */
+    Header getHeader(size_t i) const;
+
+    /**
+     * @brief 按名字(忽略大小写)取第一个头部字段的值
+     * @param[in] def 不存在时返回的值
+     */
+    StringView getHeader(const StringView& name, const StringView& def = StringView()) const;
+
+    bool hasHeader(const StringView& name) const;
+
+    /**
+     * @brief 消息体, chunked时是解码后的数据
+     */
+    StringView getBody() const { return view(m_body);}
+protected:
+    /**
+     * @brief 片段在消息里的偏移和长度, 缓冲整体移动后仍然有效
+     */
+    struct Span {
+        uint32_t off = 0;
+        uint32_t len = 0;
+    };
+
+    StringView view(const Span& s) const { return StringView(m_base + s.off, s.len);}
+
+    void clear();
+protected:
+    /// 消息在缓冲里的起始位置
+    const char* m_base = nullptr;
+    /// 版本
+    uint8_t m_version = 0x11;
+    /// 是否关闭连接
+    bool m_close = false;
+    /// 是否chunked
+    bool m_chunked = false;
+    /// 头部字段, 解析器复用时保留容量
+    std::vector<std::pair<Span, Span> > m_headers;
+    /// 消息体
+    Span m_body;
+};
+
+/**
+ * @brief 解析出的HTTP请求
+ */
+class HttpRequest : public HttpMessage {
+friend class HttpRequestParser;
+public:
+    HttpMethod getMethod() const { return m_method;}
+
+    /**
+     * @brief 请求行里的原始目标(路径, 查询和片段)
+     */
+    StringView getUri() const { return view(m_uri);}
+
+    /**
+     * @brief 路径, 绝对形式(http://host/path)时去掉了协议和主机
+     */
+    StringView getPath() const { return view(m_path);}
+
+    /**
+     * @brief ?之后#之前的部分, 不含?
+     */
+    StringView getQuery() const { return view(m_query);}
+
+    /**
+     * @brief #之后的部分
+     */
+    StringView getFragment() const { return view(m_fragment);}
+
+    /**
+     * @brief 查询参数的原始值(不做百分号解码)
+     * @param[in] def 不存在时返回的值
+     */
+    StringView getParam(const StringView& key, const StringView& def = StringView()) const;
+
+    /**
+     * @brief 请求头和消息体, 用于调试
+     */
+    std::string toString() const;
+private:
+    void clear();
+private:
+    HttpMethod m_method = HttpMethod::GET;
+    Span m_uri;
+    Span m_path;
+    Span m_query;
+    Span m_fragment;
+};
+
+/**
+ * @brief 解析出的HTTP响应(客户端使用)
+ */
+class HttpResponseView : public HttpMessage {
+friend class HttpResponseParser;
+public:
+    HttpStatus getStatus() const { return m_status;}
+
+    /**
+     * @brief 状态行里的原因短语
+     */
+    StringView getReason() const { return view(m_reason);}
+private:
+    void clear();
+private:
+    HttpStatus m_status = HttpStatus::OK;
+    Span m_reason;
+};
+
+/**
+ * @brief 要发送的HTTP响应
+ * @details 拥有自己的数据; dump()按HTTP/1.1格式写入ByteArray,
+ *          Content-Length和Connection由这里根据消息体和isClose()生成
+ */
+class HttpResponse {
+public:
+    typedef std::shared_ptr<HttpResponse> ptr;
+
+    /**
+     * @brief 构造函数
+     * @param[in] version 版本
+     * @param[in] close 是否关闭连接
+     */
+    HttpResponse(uint8_t version = 0x11, bool close = true);
+
+    /**
+     * @brief 清空, 用于连接上的下一个请求, 保留已分配的内存
+     */
+    void reset(uint8_t version, bool close);
+
+    HttpStatus getStatus() const { return m_status;}
+    void setStatus(HttpStatus v) { m_status = v;}
+
+    /**
+     * @brief 原因短语, 为空时使用状态的默认短语
+     */
+    const std::string& getReason() const { return m_reason;}
+    void setReason(const std::string& v) { m_reason = v;}
+
+    uint8_t getVersion() const { return m_version;}
+    void setVersion(uint8_t v) { m_version = v;}
+
+    bool isClose() const { return m_close;}
+    void setClose(bool v) { m_close = v;}
+
+    const std::string& getBody() const { return m_body;}
+    void setBody(const std::string& v) { m_body = v;}
+    void appendBody(const char* data, size_t size) { m_body.append(data, size);}
+
+    /**
+     * @brief 取头部字段(忽略大小写), 不存在时返回def
+     */
+    std::string getHeader(const std::string& key, const std::string& def = "") const;
+
+    /**
+     * @brief 设置头部字段, 已存在(忽略大小写)时替换
+     */
+    void setHeader(const std::string& key, const std::string& val);
+
+    void delHeader(const std::string& key);
+
+    /**
+     * @brief 序列化
+     * @param[in] with_body 是否写消息体, HEAD请求的响应不写(Content-Length仍按消息体)
+     */
+    void dump(ByteArray& ba, bool with_body = true) const;
+
+    std::string toString() const;
+private:
+    HttpStatus m_status = HttpStatus::OK;
+    uint8_t m_version;
+    bool m_close;
+    std::string m_reason;
+    std::vector<std::pair<std::string, std::string> > m_headers;
+    std::string m_body;
+};
+
+std::ostream& operator<<(std::ostream& os, const HttpRequest& req);
+std::ostream& operator<<(std::ostream& os, const HttpResponse& rsp);
+
+}
+}
+
+#endif
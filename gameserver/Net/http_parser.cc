@@ -0,0 +1,570 @@
+#include "http_parser.h"
+#include <algorithm>
+
+namespace gameserver{
+namespace http{
+
+/// chunk大小行(含扩展)的最大长度
+static const size_t MAX_CHUNK_LINE = 1024;
+
+namespace {
+
+/**
+ * @brief 头部字段名允许的字符(RFC 7230 tchar)
+ */
+struct TokenTable {
+    bool token[256];
+
+    TokenTable() {
+        const char* delims = "\"(),/:;<=>?@[\\]{}";
+        for(int c = 0; c < 256; ++c) {
+            token[c] = c > 0x20 && c < 0x7f && !strchr(delims, c);
+        }
+    }
+};
+
+const TokenTable s_table;
+
+inline bool IsSpace(char c) {
+    return c == ' ' || c == '\t';
+}
+
+/**
+ * @brief 去掉两端的空格和制表符
+ */
+inline StringView Trim(const char* b, const char* e) {
+    while(b < e && IsSpace(*b)) {
+        ++b;
+    }
+    while(e > b && IsSpace(e[-1])) {
+        --e;
+    }
+    return StringView(b, e - b);
+}
+
+}
+
+HttpParser::HttpParser(HttpMessage* msg, const Limits& limits)
+    :m_msg(msg)
+    ,m_limits(limits) {
+}
+
+void HttpParser::reset() {
+    m_state = START_LINE;
+    m_lineStart = 0;
+    m_scan = 0;
+    m_pos = 0;
+    m_bodyStart = 0;
+    m_bodyLen = 0;
+    m_remaining = 0;
+    m_contentLength = -1;
+    m_trailerStart = 0;
+    m_connClose = false;
+    m_connKeepAlive = false;
+    m_transferEncoding = false;
+    m_consumed = 0;
+    m_error = HttpStatus::OK;
+    m_errorString = "";
+    clearMessage();
+}
+
+bool HttpParser::fail(HttpStatus status, const char* str) {
+    m_state = FAILED;
+    m_error = status;
+    m_errorString = str;
+    return false;
+}
+
+int HttpParser::nextLine(const char* data, size_t size, size_t& begin, size_t& len, size_t limit) {
+    const char* nl = nullptr;
+    if(m_scan < size) {
+        nl = (const char*)memchr(data + m_scan, '\n', size - m_scan);
+    }
+    if(!nl) {
+        m_scan = size;
+        return size > limit ? -1 : 0;
+    }
+    size_t end = nl - data;
+    if(end > limit) {
+        return -1;
+    }
+    begin = m_lineStart;
+    len = end - begin;
+    if(len && data[end - 1] == '\r') {
+        --len;
+    }
+    m_lineStart = m_scan = end + 1;
+    return 1;
+}
+
+HttpParser::Result HttpParser::execute(char* data, size_t len) {
+    m_msg->m_base = data;
+    size_t begin = 0;
+    size_t n = 0;
+    while(true) {
+        switch(m_state) {
+            case START_LINE:
+                {
+                    int rt = nextLine(data, len, begin, n, m_limits.maxHeaderSize);
+                    if(rt == 0) {
+                        return NEED_MORE;
+                    }
+                    if(rt < 0) {
+                        fail(HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, "start line too long");
+                        return ERROR;
+                    }
+                    // 起始行之前的空行忽略(RFC 7230 3.5)
+                    if(n == 0) {
+                        break;
+                    }
+                    if(!parseStartLine(data + begin, n)) {
+                        return ERROR;
+                    }
+                    m_state = HEADER;
+                }
+                break;
+            case HEADER:
+                {
+                    int rt = nextLine(data, len, begin, n, m_limits.maxHeaderSize);
+                    if(rt == 0) {
+                        return NEED_MORE;
+                    }
+                    if(rt < 0) {
+                        fail(HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, "header too large");
+                        return ERROR;
+                    }
+                    if(n == 0) {
+                        m_pos = m_lineStart;
+                        m_msg->m_close = m_connClose || (m_msg->m_version == 0x10 && !m_connKeepAlive);
+                        onHeaderComplete();
+                        if(m_state == FAILED) {
+                            return ERROR;
+                        }
+                        break;
+                    }
+                    if(!parseHeader(data, begin, n)) {
+                        return ERROR;
+                    }
+                }
+                break;
+            case BODY:
+                {
+                    uint64_t avail = std::min((uint64_t)(len - m_pos), m_remaining);
+                    m_pos += avail;
+                    m_remaining -= avail;
+                    m_bodyLen += avail;
+                    if(m_remaining) {
+                        return NEED_MORE;
+                    }
+                    complete();
+                }
+                break;
+            case CHUNK_SIZE:
+                {
+                    int rt = nextLine(data, len, begin, n, m_lineStart + MAX_CHUNK_LINE);
+                    if(rt == 0) {
+                        return NEED_MORE;
+                    }
+                    if(rt < 0) {
+                        fail(HttpStatus::BAD_REQUEST, "chunk size line too long");
+                        return ERROR;
+                    }
+                    if(!parseChunkSize(data + begin, n)) {
+                        return ERROR;
+                    }
+                }
+                break;
+            case CHUNK_DATA:
+                {
+                    uint64_t avail = std::min((uint64_t)(len - m_pos), m_remaining);
+                    if(avail) {
+                        // 数据块往前移, 接在已解码的消息体后面
+                        char* dst = data + m_bodyStart + m_bodyLen;
+                        if(dst != data + m_pos) {
+                            memmove(dst, data + m_pos, avail);
+                        }
+                        m_pos += avail;
+                        m_remaining -= avail;
+                        m_bodyLen += avail;
+                    }
+                    if(m_remaining) {
+                        return NEED_MORE;
+                    }
+                    m_state = CHUNK_DATA_END;
+                    m_lineStart = m_scan = m_pos;
+                }
+                break;
+            case CHUNK_DATA_END:
+                {
+                    int rt = nextLine(data, len, begin, n, m_lineStart + 2);
+                    if(rt == 0) {
+                        return NEED_MORE;
+                    }
+                    if(rt < 0 || n != 0) {
+                        fail(HttpStatus::BAD_REQUEST, "missing CRLF after chunk data");
+                        return ERROR;
+                    }
+                    m_state = CHUNK_SIZE;
+                }
+                break;
+            case TRAILER:
+                {
+                    int rt = nextLine(data, len, begin, n, m_trailerStart + m_limits.maxHeaderSize);
+                    if(rt == 0) {
+                        return NEED_MORE;
+                    }
+                    if(rt < 0) {
+                        fail(HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, "trailer too large");
+                        return ERROR;
+                    }
+                    // trailer字段不保存
+                    if(n == 0) {
+                        m_pos = m_lineStart;
+                        complete();
+                    }
+                }
+                break;
+            case BODY_UNTIL_CLOSE:
+                m_bodyLen = len - m_bodyStart;
+                if(m_bodyLen > m_limits.maxBodySize) {
+                    fail(HttpStatus::PAYLOAD_TOO_LARGE, "body too large");
+                    return ERROR;
+                }
+                m_pos = len;
+                m_msg->m_body.off = m_bodyStart;
+                m_msg->m_body.len = m_bodyLen;
+                return NEED_MORE;
+            case DONE:
+                return COMPLETE;
+            case FAILED:
+                return ERROR;
+        }
+    }
+}
+
+bool HttpParser::parseVersion(const char* p, size_t len) {
+    if(len == 8 && memcmp(p, "HTTP/1.", 7) == 0 && (p[7] == '1' || p[7] == '0')) {
+        m_msg->m_version = p[7] == '1' ? 0x11 : 0x10;
+        return true;
+    }
+    if(len >= 5 && memcmp(p, "HTTP/", 5) == 0) {
+        return fail(HttpStatus::HTTP_VERSION_NOT_SUPPORTED, "unsupported http version");
+    }
+    return fail(HttpStatus::BAD_REQUEST, "invalid http version");
+}
+
+bool HttpParser::parseHeader(const char* data, size_t begin, size_t len) {
+    const char* line = data + begin;
+    if(IsSpace(line[0])) {
+        return fail(HttpStatus::BAD_REQUEST, "obsolete header line folding");
+    }
+    const char* colon = (const char*)memchr(line, ':', len);
+    if(!colon || colon == line) {
+        return fail(HttpStatus::BAD_REQUEST, "invalid header line");
+    }
+    size_t name_len = colon - line;
+    for(size_t i = 0; i < name_len; ++i) {
+        if(!s_table.token[(uint8_t)line[i]]) {
+            return fail(HttpStatus::BAD_REQUEST, "invalid header name");
+        }
+    }
+    if(m_msg->m_headers.size() >= m_limits.maxHeaders) {
+        return fail(HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE, "too many headers");
+    }
+    StringView name(line, name_len);
+    StringView value = Trim(colon + 1, line + len);
+    HttpMessage::Span n, v;
+    n.off = begin;
+    n.len = name_len;
+    v.off = value.data - data;
+    v.len = value.size;
+    m_msg->m_headers.push_back(std::make_pair(n, v));
+
+    // 影响消息边界和连接的字段
+    switch(name_len) {
+        case 14:
+            if(name.equalsIgnoreCase("content-length")) {
+                if(value.empty() || value.size > 18) {
+                    return fail(HttpStatus::BAD_REQUEST, "invalid content-length");
+                }
+                int64_t cl = 0;
+                for(size_t i = 0; i < value.size; ++i) {
+                    char c = value.data[i];
+                    if(c < '0' || c > '9') {
+                        return fail(HttpStatus::BAD_REQUEST, "invalid content-length");
+                    }
+                    cl = cl * 10 + (c - '0');
+                }
+                if(m_contentLength >= 0 && m_contentLength != cl) {
+                    return fail(HttpStatus::BAD_REQUEST, "conflicting content-length");
+                }
+                m_contentLength = cl;
+            }
+            break;
+        case 17:
+            if(name.equalsIgnoreCase("transfer-encoding")) {
+                // 最后一个编码是chunked时按chunked读, 其他编码不解
+                const char* last = value.data + value.size;
+                const char* p = last;
+                while(p > value.data && p[-1] != ',') {
+                    --p;
+                }
+                m_transferEncoding = true;
+                m_msg->m_chunked = Trim(p, last).equalsIgnoreCase("chunked");
+            }
+            break;
+        case 10:
+            if(name.equalsIgnoreCase("connection")) {
+                const char* p = value.data;
+                const char* end = value.data + value.size;
+                while(p < end) {
+                    const char* comma = (const char*)memchr(p, ',', end - p);
+                    if(!comma) {
+                        comma = end;
+                    }
+                    StringView token = Trim(p, comma);
+                    if(token.equalsIgnoreCase("close")) {
+                        m_connClose = true;
+                    } else if(token.equalsIgnoreCase("keep-alive")) {
+                        m_connKeepAlive = true;
+                    }
+                    p = comma + 1;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+bool HttpParser::parseChunkSize(const char* line, size_t len) {
+    uint64_t size = 0;
+    size_t i = 0;
+    for(; i < len; ++i) {
+        char c = line[i];
+        int d;
+        if(c >= '0' && c <= '9') {
+            d = c - '0';
+        } else if(c >= 'a' && c <= 'f') {
+            d = c - 'a' + 10;
+        } else if(c >= 'A' && c <= 'F') {
+            d = c - 'A' + 10;
+        } else {
+            break;
+        }
+        if(i >= 15) {
+            return fail(HttpStatus::BAD_REQUEST, "chunk size too long");
+        }
+        size = (size << 4) | d;
+    }
+    // 至少一位十六进制数, 后面只能是空白或扩展(;name=value, 忽略)
+    if(i == 0) {
+        return fail(HttpStatus::BAD_REQUEST, "invalid chunk size");
+    }
+    while(i < len && IsSpace(line[i])) {
+        ++i;
+    }
+    if(i < len && line[i] != ';') {
+        return fail(HttpStatus::BAD_REQUEST, "invalid chunk size");
+    }
+    m_pos = m_lineStart;
+    if(size == 0) {
+        m_state = TRAILER;
+        m_trailerStart = m_lineStart;
+        return true;
+    }
+    if(size > m_limits.maxBodySize - m_bodyLen) {
+        return fail(HttpStatus::PAYLOAD_TOO_LARGE, "body too large");
+    }
+    m_remaining = size;
+    m_state = CHUNK_DATA;
+    return true;
+}
+
+bool HttpParser::startBody() {
+    m_bodyStart = m_pos;
+    m_bodyLen = 0;
+    if(m_msg->m_chunked) {
+        m_state = CHUNK_SIZE;
+        m_lineStart = m_scan = m_pos;
+        return true;
+    }
+    if(m_contentLength > 0) {
+        if((uint64_t)m_contentLength > m_limits.maxBodySize) {
+            fail(HttpStatus::PAYLOAD_TOO_LARGE, "body too large");
+            return true;
+        }
+        m_remaining = m_contentLength;
+        m_state = BODY;
+        return true;
+    }
+    if(m_contentLength == 0) {
+        complete();
+        return true;
+    }
+    return false;
+}
+
+void HttpParser::complete() {
+    m_msg->m_body.off = m_bodyStart;
+    m_msg->m_body.len = m_bodyLen;
+    m_consumed = m_pos;
+    m_state = DONE;
+}
+
+HttpRequestParser::HttpRequestParser(const Limits& limits)
+    :HttpParser(&m_request, limits) {
+}
+
+void HttpRequestParser::clearMessage() {
+    m_request.clear();
+}
+
+bool HttpRequestParser::parseStartLine(const char* line, size_t len) {
+    const char* end = line + len;
+    const char* sp1 = (const char*)memchr(line, ' ', len);
+    if(!sp1 || sp1 == line) {
+        return fail(HttpStatus::BAD_REQUEST, "invalid request line");
+    }
+    const char* sp2 = end;
+    while(sp2 > sp1 && sp2[-1] != ' ') {
+        --sp2;
+    }
+    --sp2;
+    const char* uri = sp1 + 1;
+    if(sp2 <= uri || memchr(uri, ' ', sp2 - uri)) {
+        return fail(HttpStatus::BAD_REQUEST, "invalid request line");
+    }
+    m_request.m_method = StringToHttpMethod(StringView(line, sp1 - line));
+    if(m_request.m_method == HttpMethod::INVALID_METHOD) {
+        return fail(HttpStatus::NOT_IMPLEMENTED, "unknown method");
+    }
+    if(!parseVersion(sp2 + 1, end - sp2 - 1)) {
+        return false;
+    }
+
+    const char* base = m_request.m_base;
+    m_request.m_uri.off = uri - base;
+    m_request.m_uri.len = sp2 - uri;
+    // 绝对形式去掉协议和主机
+    const char* path = uri;
+    StringView target(uri, sp2 - uri);
+    if(target.size > 7 && (StringView(uri, 7).equalsIgnoreCase("http://")
+                || (target.size > 8 && StringView(uri, 8).equalsIgnoreCase("https://")))) {
+        const char* host = (const char*)memchr(uri, ':', sp2 - uri) + 3;
+        path = (const char*)memchr(host, '/', sp2 - host);
+        if(!path) {
+            path = sp2;
+        }
+    }
+    const char* hash = (const char*)memchr(path, '#', sp2 - path);
+    const char* path_end = hash ? hash : sp2;
+    const char* query = (const char*)memchr(path, '?', path_end - path);
+    m_request.m_path.off = path - base;
+    m_request.m_path.len = (query ? query : path_end) - path;
+    if(query) {
+        m_request.m_query.off = query + 1 - base;
+        m_request.m_query.len = path_end - query - 1;
+    }
+    if(hash) {
+        m_request.m_fragment.off = hash + 1 - base;
+        m_request.m_fragment.len = sp2 - hash - 1;
+    }
+    return true;
+}
+
+void HttpRequestParser::onHeaderComplete() {
+    if(m_transferEncoding) {
+        // 同时有Content-Length时可能是请求走私, 拒绝
+        if(m_contentLength >= 0) {
+            fail(HttpStatus::BAD_REQUEST, "both content-length and transfer-encoding");
+            return;
+        }
+        if(!m_request.m_chunked) {
+            fail(HttpStatus::NOT_IMPLEMENTED, "unsupported transfer-encoding");
+            return;
+        }
+    }
+    if(!startBody()) {
+        m_bodyStart = m_pos;
+        complete();
+    }
+}
+
+HttpResponseParser::HttpResponseParser(const Limits& limits)
+    :HttpParser(&m_response, limits) {
+}
+
+void HttpResponseParser::clearMessage() {
+    m_response.clear();
+}
+
+bool HttpResponseParser::parseStartLine(const char* line, size_t len) {
+    const char* end = line + len;
+    const char* sp1 = (const char*)memchr(line, ' ', len);
+    if(!sp1) {
+        return fail(HttpStatus::BAD_REQUEST, "invalid status line");
+    }
+    if(!parseVersion(line, sp1 - line)) {
+        return false;
+    }
+    const char* code = sp1 + 1;
+    if(end - code < 3 || (end - code > 3 && code[3] != ' ')) {
+        return fail(HttpStatus::BAD_REQUEST, "invalid status code");
+    }
+    int status = 0;
+    for(int i = 0; i < 3; ++i) {
+        if(code[i] < '0' || code[i] > '9') {
+            return fail(HttpStatus::BAD_REQUEST, "invalid status code");
+        }
+        status = status * 10 + (code[i] - '0');
+    }
+    if(status < 100) {
+        return fail(HttpStatus::BAD_REQUEST, "invalid status code");
+    }
+    m_response.m_status = (HttpStatus)status;
+    if(end - code > 4) {
+        m_response.m_reason.off = code + 4 - m_response.m_base;
+        m_response.m_reason.len = end - code - 4;
+    }
+    return true;
+}
+
+void HttpResponseParser::onHeaderComplete() {
+    int status = (int)m_response.m_status;
+    if(m_headRequest || status < 200 || status == 204 || status == 304) {
+        m_bodyStart = m_pos;
+        complete();
+        return;
+    }
+    // Transfer-Encoding优先于Content-Length; 不是chunked时读到连接关闭
+    if(m_transferEncoding) {
+        m_contentLength = -1;
+    }
+    if(!startBody()) {
+        m_response.m_close = true;
+        m_bodyStart = m_pos;
+        m_bodyLen = 0;
+        m_state = BODY_UNTIL_CLOSE;
+    }
+}
+
+HttpParser::Result HttpResponseParser::finish(char* data, size_t len) {
+    if(m_state != BODY_UNTIL_CLOSE) {
+        if(m_state == DONE) {
+            return COMPLETE;
+        }
+        fail(HttpStatus::BAD_REQUEST, "connection closed before message complete");
+        return ERROR;
+    }
+    Result rt = execute(data, len);
+    if(rt == ERROR) {
+        return rt;
+    }
+    complete();
+    return COMPLETE;
+}
+
+}
+}
@@ -0,0 +1,234 @@
+#ifndef __GAMESERVER_HTTP_PARSER_H__
+#define __GAMESERVER_HTTP_PARSER_H__
+
+#include "http.h"
+
+namespace gameserver{
+namespace http{
+
+/**
+ * @brief 增量的HTTP/1.x解析器(状态机)
+ * @details execute()每次传入当前消息从头开始的全部已收数据(缓冲可以在两次调用之间整体移动),
+ *          解析器记住已经处理到哪里, 只看新到的字节, 不重复扫描.
+ *          起始行和头部逐行解析, 结果是相对消息开头的偏移, 由HttpMessage给出指向缓冲的片段.
+ *          chunked消息体在缓冲里原地解码(把数据块往前移到一起), 所以execute()会修改传入的数据.
+ *          一个消息完成后getConsumed()是它占用的字节数, 之后的数据属于下一个消息(流水线),
+ *          reset()后从那里继续
+ */
+class HttpParser {
+public:
+    /**
+     * @brief execute()的结果
+     */
+    enum Result {
+        /// 消息完整
+        COMPLETE,
+        /// 需要更多数据
+        NEED_MORE,
+        /// 格式错误或超出限制, 见getError()
+        ERROR,
+    };
+
+    /**
+     * @brief 大小限制
+     */
+    struct Limits {
+        /// 起始行加头部的最大字节数(chunked的trailer另算一份)
+        size_t maxHeaderSize = 8 * 1024;
+        /// 最多头部字段数
+        size_t maxHeaders = 64;
+        /// 消息体(解码后)最大字节数
+        uint64_t maxBodySize = 8 * 1024 * 1024;
+    };
+
+    virtual ~HttpParser() {}
+
+    /**
+     * @brief 解析
+     * @param[in, out] data 当前消息开头, 与上次调用的数据相同(可以移动过位置), 后面可以多出新数据
+     * @param[in] len 数据长度
+     */
+    Result execute(char* data, size_t len);
+
+    /**
+     * @brief 完整的消息占用的字节数
+     */
+    size_t getConsumed() const { return m_consumed;}
+
+    /**
+     * @brief 头部是否已经解析完(用于Expect: 100-continue)
+     */
+    bool isHeaderComplete() const { return m_state > HEADER;}
+
+    /**
+     * @brief 出错时对应的HTTP状态: 400, 413, 431, 501, 505
+     */
+    HttpStatus getError() const { return m_error;}
+
+    /**
+     * @brief 出错原因
+     */
+    const char* getErrorString() const { return m_errorString;}
+
+    /**
+     * @brief 准备解析下一个消息
+     */
+    void reset();
+
+    const Limits& getLimits() const { return m_limits;}
+    void setLimits(const Limits& v) { m_limits = v;}
+protected:
+    HttpParser(HttpMessage* msg, const Limits& limits);
+
+    /**
+     * @brief 解析起始行
+     * @return 出错时调用fail()并返回false
+     */
+    virtual bool parseStartLine(const char* line, size_t len) = 0;
+
+    /**
+     * @brief 头部结束, 决定消息体怎么读
+     */
+    virtual void onHeaderComplete() = 0;
+
+    /**
+     * @brief 清空消息
+     */
+    virtual void clearMessage() = 0;
+
+    bool fail(HttpStatus status, const char* str);
+
+    /**
+     * @brief 解析 HTTP/1.x
+     */
+    bool parseVersion(const char* p, size_t len);
+
+    /**
+     * @brief 按Content-Length或chunked读消息体, 都没有时消息结束
+     * @return 是否有消息体的格式
+     */
+    bool startBody();
+
+    /**
+     * @brief 消息结束
+     */
+    void complete();
+protected:
+    enum State {
+        START_LINE,
+        HEADER,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_DATA_END,
+        TRAILER,
+        BODY_UNTIL_CLOSE,
+        DONE,
+        FAILED,
+    };
+
+    /**
+     * @brief 从m_lineStart开始取一行
+     * @param[out] begin 行首偏移
+     * @param[out] len 行长度, 不含\r\n
+     * @param[in] limit 行尾(换行符)的偏移不能超过的位置
+     * @return 1 取到; 0 需要更多数据; -1 超长
+     */
+    int nextLine(const char* data, size_t size, size_t& begin, size_t& len, size_t limit);
+
+    /**
+     * @brief 解析一行头部
+     */
+    bool parseHeader(const char* data, size_t begin, size_t len);
+
+    /**
+     * @brief 解析chunk大小行
+     */
+    bool parseChunkSize(const char* line, size_t len);
+protected:
+    HttpMessage* m_msg;
+    Limits m_limits;
+    State m_state = START_LINE;
+    /// 当前行开头
+    size_t m_lineStart = 0;
+    /// 已经找过换行的位置
+    size_t m_scan = 0;
+    /// 消息体里已处理到的位置
+    size_t m_pos = 0;
+    /// 消息体开头
+    size_t m_bodyStart = 0;
+    /// 消息体(解码后)长度
+    uint64_t m_bodyLen = 0;
+    /// 当前定长消息体或chunk剩余的字节数
+    uint64_t m_remaining = 0;
+    /// Content-Length, 没有时为-1
+    int64_t m_contentLength = -1;
+    /// trailer开始的位置
+    size_t m_trailerStart = 0;
+    /// Connection里有close/keep-alive
+    bool m_connClose = false;
+    bool m_connKeepAlive = false;
+    /// 有Transfer-Encoding
+    bool m_transferEncoding = false;
+    /// 完整消息的字节数
+    size_t m_consumed = 0;
+    HttpStatus m_error = HttpStatus::OK;
+    const char* m_errorString = "";
+};
+
+/**
+ * @brief 请求解析器
+ */
+class HttpRequestParser : public HttpParser {
+public:
+    typedef std::shared_ptr<HttpRequestParser> ptr;
+
+    HttpRequestParser(const Limits& limits = Limits());
+
+    /**
+     * @brief 解析出的请求, 片段指向最后一次execute()的数据
+     */
+    const HttpRequest& getRequest() const { return m_request;}
+protected:
+    bool parseStartLine(const char* line, size_t len) override;
+    void onHeaderComplete() override;
+    void clearMessage() override;
+private:
+    HttpRequest m_request;
+};
+
+/**
+ * @brief 响应解析器
+ * @details 没有Content-Length也不是chunked的响应, 消息体到连接关闭为止, 读到EOF时调用finish()
+ */
+class HttpResponseParser : public HttpParser {
+public:
+    typedef std::shared_ptr<HttpResponseParser> ptr;
+
+    HttpResponseParser(const Limits& limits = Limits());
+
+    /**
+     * @brief 对应的请求是HEAD, 响应没有消息体
+     */
+    void setHeadRequest(bool v) { m_headRequest = v;}
+
+    /**
+     * @brief 连接关闭, 结束到连接关闭为止的消息体
+     * @return 这种消息体时返回COMPLETE, 否则消息不完整返回ERROR
+     */
+    Result finish(char* data, size_t len);
+
+    const HttpResponseView& getResponse() const { return m_response;}
+protected:
+    bool parseStartLine(const char* line, size_t len) override;
+    void onHeaderComplete() override;
+    void clearMessage() override;
+private:
+    HttpResponseView m_response;
+    bool m_headRequest = false;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,274 @@
+#include "http_server.h"
+#include "Fiber/hook.h"
+#include "Fiber/fd_manager.h"
+#include "Log/log.h"
+#include "Util/util.h"
+#include <vector>
+#include <exception>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+namespace gameserver{
+namespace http{
+
+static Logger::ptr g_logger = GAMESERVER_LOG_NAME("system");
+
+/// 接收缓冲的初始大小
+static const size_t RECV_BUFFER_SIZE = 4096;
+/// 关闭连接前等对端数据的单次超时和总时间, 毫秒
+static const uint64_t LINGER_TIMEOUT = 500;
+static const uint64_t LINGER_TIME = 2000;
+
+HttpServer::HttpServer(bool keepalive, IOManager* worker, IOManager* accept_worker)
+    :m_keepalive(keepalive)
+    ,m_worker(worker)
+    ,m_acceptWorker(accept_worker)
+    ,m_dispatch(new ServletDispatch) {
+}
+
+HttpServer::~HttpServer() {
+    if(m_sock >= 0) {
+        close(m_sock);
+    }
+}
+
+bool HttpServer::bind(const std::string& ip, uint16_t port) {
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if(inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+        GAMESERVER_LOG_ERROR(g_logger) << "HttpServer::bind invalid ip=" << ip;
+        return false;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0) {
+        GAMESERVER_LOG_ERROR(g_logger) << "HttpServer::bind socket errno=" << errno
+            << " errstr=" << strerror(errno);
+        return false;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    socklen_t len = sizeof(addr);
+    if(::bind(fd, (sockaddr*)&addr, sizeof(addr)) || listen(fd, SOMAXCONN)
+            || getsockname(fd, (sockaddr*)&addr, &len)) {
+        GAMESERVER_LOG_ERROR(g_logger) << "HttpServer::bind " << ip << ":" << port
+            << " errno=" << errno << " errstr=" << strerror(errno);
+        close(fd);
+        return false;
+    }
+    // 不在hook线程上创建时socket()没有登记, 这里登记并设为系统非阻塞
+    FdMgr::GetInstance()->get(fd, true);
+    if(m_sock >= 0) {
+        close(m_sock);
+    }
+    m_sock = fd;
+    m_port = ntohs(addr.sin_port);
+    return true;
+}
+
+bool HttpServer::start() {
+    if(!m_isStop) {
+        return true;
+    }
+    if(m_sock < 0) {
+        GAMESERVER_LOG_ERROR(g_logger) << "HttpServer::start not bound";
+        return false;
+    }
+    if(!m_worker || !m_acceptWorker || !m_worker->isHookEnable() || !m_acceptWorker->isHookEnable()) {
+        GAMESERVER_LOG_ERROR(g_logger) << "HttpServer::start workers must enable hook";
+        return false;
+    }
+    m_isStop = false;
+    m_acceptWorker->schedule(std::bind(&HttpServer::startAccept, shared_from_this()));
+    return true;
+}
+
+void HttpServer::stop() {
+    m_isStop = true;
+    Mutex::Lock lock(m_mutex);
+    if(m_sock >= 0) {
+        shutdown(m_sock, SHUT_RDWR);
+    }
+    for(int fd : m_clients) {
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+size_t HttpServer::getConnectionCount() {
+    Mutex::Lock lock(m_mutex);
+    return m_clients.size();
+}
+
+void HttpServer::startAccept() {
+    auto self = shared_from_this();
+    while(!m_isStop) {
+        int fd = accept(m_sock, nullptr, nullptr);
+        if(fd < 0) {
+            if(m_isStop) {
+                break;
+            }
+            GAMESERVER_LOG_ERROR(g_logger) << "HttpServer accept errno=" << errno
+                << " errstr=" << strerror(errno);
+            if(errno == EINVAL || errno == EBADF) {
+                break;
+            }
+            // 句柄耗尽等错误稍等再试, 不空转
+            if(errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                usleep(10 * 1000);
+            }
+            continue;
+        }
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        if(m_recvTimeout) {
+            timeval tv = {(time_t)(m_recvTimeout / 1000), (suseconds_t)(m_recvTimeout % 1000 * 1000)};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        }
+        {
+            Mutex::Lock lock(m_mutex);
+            if(m_isStop) {
+                close(fd);
+                break;
+            }
+            m_clients.insert(fd);
+        }
+        m_worker->schedule(std::bind(&HttpServer::handleClient, self, fd));
+    }
+    Mutex::Lock lock(m_mutex);
+    close(m_sock);
+    m_sock = -1;
+}
+
+/**
+ * @brief 发送ByteArray里的全部数据
+ */
+static bool SendAll(int fd, ByteArray& out, std::vector<iovec>& iovs) {
+    while(out.getReadSize()) {
+        iovs.clear();
+        out.getReadBuffers(iovs);
+        int cnt = std::min<size_t>(iovs.size(), IOV_MAX);
+        ssize_t n = writev(fd, &iovs[0], cnt);
+        if(n <= 0) {
+            return false;
+        }
+        out.skip(n);
+    }
+    return true;
+}
+
+void HttpServer::handleClient(int fd) {
+    const HttpParser::Limits& limits = m_limits;
+    // 超过头部和消息体限制的数据一定是错误的请求, chunked的编码开销按消息体再算一份
+    const size_t max_buffer = limits.maxHeaderSize * 2 + limits.maxBodySize * 2;
+    std::vector<char> buf(std::min(RECV_BUFFER_SIZE, max_buffer));
+    size_t begin = 0;
+    size_t end = 0;
+    HttpRequestParser parser(limits);
+    HttpResponse rsp;
+    ByteArray out;
+    std::vector<iovec> iovs;
+    bool sent_continue = false;
+    bool closing = false;
+
+    while(true) {
+        // 缓冲里完整的请求都处理掉, 响应攒在一起发
+        while(begin < end && !closing) {
+            HttpParser::Result rt = parser.execute(&buf[begin], end - begin);
+            if(rt == HttpParser::NEED_MORE) {
+                const HttpRequest& req = parser.getRequest();
+                if(parser.isHeaderComplete() && !sent_continue && req.getVersion() == 0x11
+                        && req.getHeader("Expect").equalsIgnoreCase("100-continue")) {
+                    out.write("HTTP/1.1 100 Continue\r\n\r\n", 25);
+                    sent_continue = true;
+                }
+                break;
+            }
+            if(rt == HttpParser::ERROR) {
+                rsp.reset(0x11, true);
+                rsp.setStatus(parser.getError());
+                rsp.setHeader("Server", m_name);
+                rsp.setBody(parser.getErrorString());
+                rsp.dump(out);
+                closing = true;
+                break;
+            }
+            const HttpRequest& req = parser.getRequest();
+            rsp.reset(req.getVersion(), req.isClose() || !m_keepalive || m_isStop);
+            rsp.setHeader("Server", m_name);
+            try {
+                m_dispatch->handle(req, rsp);
+            } catch(std::exception& e) {
+                GAMESERVER_LOG_ERROR(g_logger) << "HttpServer servlet exception: " << e.what()
+                    << " request: " << HttpMethodToString(req.getMethod()) << " " << req.getUri();
+                rsp.reset(req.getVersion(), true);
+                rsp.setStatus(HttpStatus::INTERNAL_SERVER_ERROR);
+                rsp.setHeader("Server", m_name);
+            }
+            closing = rsp.isClose();
+            rsp.dump(out, req.getMethod() != HttpMethod::HEAD);
+            begin += parser.getConsumed();
+            parser.reset();
+            sent_continue = false;
+        }
+        if(out.getReadSize() && !SendAll(fd, out, iovs)) {
+            break;
+        }
+        if(closing || m_isStop) {
+            break;
+        }
+
+        // 整理接收缓冲: 没有剩余数据时从头开始, 写满时把未处理的数据移到开头, 仍然满时扩大
+        if(begin == end) {
+            begin = end = 0;
+        } else if(end == buf.size() && begin > 0) {
+            memmove(&buf[0], &buf[begin], end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        if(end == buf.size()) {
+            if(buf.size() >= max_buffer) {
+                rsp.reset(0x11, true);
+                rsp.setStatus(parser.isHeaderComplete() ? HttpStatus::PAYLOAD_TOO_LARGE
+                                    : HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE);
+                rsp.setHeader("Server", m_name);
+                rsp.dump(out);
+                closing = SendAll(fd, out, iovs);
+                break;
+            }
+            buf.resize(std::min(buf.size() * 2, max_buffer));
+        }
+        // 空闲超时(SO_RCVTIMEO)返回EAGAIN, 对端关闭返回0, stop()的shutdown也返回0
+        ssize_t n = read(fd, &buf[end], buf.size() - end);
+        if(n <= 0) {
+            break;
+        }
+        end += n;
+    }
+
+    if(closing && !m_isStop) {
+        // 接收缓冲里还有没读的数据(流水线里后面的请求)时close()会发RST, 对端可能丢掉已经发出的响应.
+        // 先关闭写端, 把对端剩下的数据读掉, 等它关闭或超时
+        shutdown(fd, SHUT_WR);
+        timeval tv = {0, (suseconds_t)(LINGER_TIMEOUT * 1000)};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        uint64_t deadline = GetMonotonicMS() + LINGER_TIME;
+        while(read(fd, &buf[0], buf.size()) > 0 && GetMonotonicMS() < deadline) {
+        }
+    }
+    {
+        Mutex::Lock lock(m_mutex);
+        m_clients.erase(fd);
+    }
+    close(fd);
+}
+
+}
+}
@@ -0,0 +1,115 @@
+#ifndef __GAMESERVER_HTTP_SERVER_H__
+#define __GAMESERVER_HTTP_SERVER_H__
+
+#include <memory>
+#include <string>
+#include <atomic>
+#include <unordered_set>
+#include "http_parser.h"
+#include "servlet.h"
+#include "Fiber/iomanager.h"
+#include "Thread/mutex.h"
+#include "Util/noncopyable.h"
+
+namespace gameserver{
+namespace http{
+
+/**
+ * @brief HTTP/1.1服务器, 每个连接一个协程
+ * @details 连接协程按阻塞方式读写(需要IOManager启用hook), 读到的数据放在一块连续的接收缓冲里,
+ *          HttpRequestParser直接在上面增量解析; 一次读到的所有流水线请求依次交给ServletDispatch,
+ *          响应序列化到同一个ByteArray, 用一次writev发出.
+ *          keepalive为true时按请求的Connection/版本保持连接, 空闲超过getRecvTimeout()关闭.
+ *          对象要由shared_ptr持有, 协程里保存引用, stop()之后最后一个连接结束时释放
+ */
+class HttpServer : public std::enable_shared_from_this<HttpServer>, Noncopyable {
+public:
+    typedef std::shared_ptr<HttpServer> ptr;
+
+    /**
+     * @brief 构造函数
+     * @param[in] keepalive 是否支持长连接
+     * @param[in] worker 处理连接的调度器
+     * @param[in] accept_worker 接受连接的调度器
+     */
+    HttpServer(bool keepalive = true
+               ,IOManager* worker = IOManager::GetThis()
+               ,IOManager* accept_worker = IOManager::GetThis());
+    virtual ~HttpServer();
+
+    /**
+     * @brief 绑定并监听
+     * @param[in] ip IPv4地址, 如"0.0.0.0"
+     * @param[in] port 端口, 0时由系统分配, 用getPort()取得
+     */
+    bool bind(const std::string& ip, uint16_t port);
+
+    /**
+     * @brief 开始接受连接, 两个调度器都要启用hook
+     */
+    bool start();
+
+    /**
+     * @brief 停止
+     * @details 可以在任意线程调用: shutdown监听socket和所有连接, 唤醒等在上面的协程,
+     *          由协程自己关闭(不在别的线程close正在等待的fd)
+     */
+    void stop();
+
+    bool isStop() const { return m_isStop;}
+    uint16_t getPort() const { return m_port;}
+
+    ServletDispatch::ptr getServletDispatch() const { return m_dispatch;}
+    void setServletDispatch(ServletDispatch::ptr v) { m_dispatch = v;}
+
+    /**
+     * @brief 连接空闲(等待下一个请求)的超时, 毫秒, 在start()之前设置
+     */
+    uint64_t getRecvTimeout() const { return m_recvTimeout;}
+    void setRecvTimeout(uint64_t v) { m_recvTimeout = v;}
+
+    const HttpParser::Limits& getLimits() const { return m_limits;}
+    void setLimits(const HttpParser::Limits& v) { m_limits = v;}
+
+    /**
+     * @brief 响应的Server字段
+     */
+    const std::string& getName() const { return m_name;}
+    void setName(const std::string& v) { m_name = v;}
+
+    /**
+     * @brief 当前连接数
+     */
+    size_t getConnectionCount();
+protected:
+    /**
+     * @brief 接受连接的协程
+     */
+    virtual void startAccept();
+
+    /**
+     * @brief 连接协程
+     */
+    virtual void handleClient(int fd);
+private:
+    /// 长连接
+    bool m_keepalive;
+    IOManager* m_worker;
+    IOManager* m_acceptWorker;
+    /// 监听socket
+    int m_sock = -1;
+    uint16_t m_port = 0;
+    std::atomic<bool> m_isStop {true};
+    uint64_t m_recvTimeout = 2 * 60 * 1000;
+    HttpParser::Limits m_limits;
+    std::string m_name = "gameserver/1.0";
+    ServletDispatch::ptr m_dispatch;
+    Mutex m_mutex;
+    /// 正在处理的连接
+    std::unordered_set<int> m_clients;
+};
+
+}
+}
+
+#endif
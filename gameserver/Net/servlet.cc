@@ -0,0 +1,98 @@
+#include "servlet.h"
+#include <fnmatch.h>
+
+namespace gameserver{
+namespace http{
+
+FunctionServlet::FunctionServlet(callback cb)
+    :Servlet("FunctionServlet")
+    ,m_cb(cb) {
+}
+
+int32_t FunctionServlet::handle(const HttpRequest& request, HttpResponse& response) {
+    return m_cb(request, response);
+}
+
+NotFoundServlet::NotFoundServlet(const std::string& name)
+    :Servlet("NotFoundServlet") {
+    m_content = "<html><head><title>404 Not Found</title></head><body><center><h1>404 Not Found</h1></center>"
+        "<hr><center>" + name + "</center></body></html>";
+}
+
+int32_t NotFoundServlet::handle(const HttpRequest& request, HttpResponse& response) {
+    response.setStatus(HttpStatus::NOT_FOUND);
+    response.setHeader("Content-Type", "text/html");
+    response.setBody(m_content);
+    return 0;
+}
+
+ServletDispatch::ServletDispatch()
+    :Servlet("ServletDispatch") {
+    m_default.reset(new NotFoundServlet("gameserver/1.0"));
+}
+
+int32_t ServletDispatch::handle(const HttpRequest& request, HttpResponse& response) {
+    auto slt = getMatchedServlet(request.getPath());
+    if(slt) {
+        return slt->handle(request, response);
+    }
+    return 0;
+}
+
+void ServletDispatch::addServlet(const std::string& uri, Servlet::ptr slt) {
+    RWMutexType::WriteLock lock(m_mutex);
+    m_datas[uri] = slt;
+}
+
+void ServletDispatch::addServlet(const std::string& uri, FunctionServlet::callback cb) {
+    addServlet(uri, std::make_shared<FunctionServlet>(cb));
+}
+
+void ServletDispatch::addGlobServlet(const std::string& uri, Servlet::ptr slt) {
+    RWMutexType::WriteLock lock(m_mutex);
+    for(auto& i : m_globs) {
+        if(i.first == uri) {
+            i.second = slt;
+            return;
+        }
+    }
+    m_globs.push_back(std::make_pair(uri, slt));
+}
+
+void ServletDispatch::addGlobServlet(const std::string& uri, FunctionServlet::callback cb) {
+    addGlobServlet(uri, std::make_shared<FunctionServlet>(cb));
+}
+
+void ServletDispatch::delServlet(const std::string& uri) {
+    RWMutexType::WriteLock lock(m_mutex);
+    m_datas.erase(uri);
+}
+
+void ServletDispatch::delGlobServlet(const std::string& uri) {
+    RWMutexType::WriteLock lock(m_mutex);
+    for(auto it = m_globs.begin(); it != m_globs.end(); ++it) {
+        if(it->first == uri) {
+            m_globs.erase(it);
+            return;
+        }
+    }
+}
+
+Servlet::ptr ServletDispatch::getMatchedServlet(const StringView& path) {
+    // 绝对形式没有路径时按 /
+    std::string uri = path.empty() ? std::string("/") : path.toString();
+    RWMutexType::ReadLock lock(m_mutex);
+    auto it = m_datas.find(uri);
+    if(it != m_datas.end()) {
+        return it->second;
+    }
+    for(auto& i : m_globs) {
+        if(!fnmatch(i.first.c_str(), uri.c_str(), 0)) {
+            return i.second;
+        }
+    }
+    return m_default;
+}
+
+}
+}
@@ -0,0 +1,113 @@
+#ifndef __GAMESERVER_SERVLET_H__
+#define __GAMESERVER_SERVLET_H__
+
+#include <memory>
+#include <functional>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "http.h"
+#include "Thread/mutex.h"
+
+namespace gameserver{
+namespace http{
+
+/**
+ * @brief 请求处理器
+ */
+class Servlet {
+public:
+    typedef std::shared_ptr<Servlet> ptr;
+
+    Servlet(const std::string& name)
+        :m_name(name) {}
+    virtual ~Servlet() {}
+
+    /**
+     * @brief 处理请求
+     * @details 在连接的协程里调用, 可以阻塞(hook); request的片段只在本次调用内有效
+     * @return 0表示成功
+     */
+    virtual int32_t handle(const HttpRequest& request, HttpResponse& response) = 0;
+
+    const std::string& getName() const { return m_name;}
+protected:
+    std::string m_name;
+};
+
+/**
+ * @brief 回调函数处理器
+ */
+class FunctionServlet : public Servlet {
+public:
+    typedef std::shared_ptr<FunctionServlet> ptr;
+    typedef std::function<int32_t (const HttpRequest& request, HttpResponse& response)> callback;
+
+    FunctionServlet(callback cb);
+    int32_t handle(const HttpRequest& request, HttpResponse& response) override;
+private:
+    callback m_cb;
+};
+
+/**
+ * @brief 默认的404处理器
+ */
+class NotFoundServlet : public Servlet {
+public:
+    typedef std::shared_ptr<NotFoundServlet> ptr;
+
+    NotFoundServlet(const std::string& name);
+    int32_t handle(const HttpRequest& request, HttpResponse& response) override;
+private:
+    std::string m_content;
+};
+
+/**
+ * @brief 按路径分发请求
+ * @details 先精确匹配, 再按添加顺序做通配匹配(fnmatch通配符), 都不匹配时用默认处理器.
+ *          路由表用读写锁保护, 运行中可以增删
+ */
+class ServletDispatch : public Servlet {
+public:
+    typedef std::shared_ptr<ServletDispatch> ptr;
+    typedef RWMutex RWMutexType;
+
+    ServletDispatch();
+    int32_t handle(const HttpRequest& request, HttpResponse& response) override;
+
+    /**
+     * @brief 添加精确匹配的处理器, 已存在时替换
+     */
+    void addServlet(const std::string& uri, Servlet::ptr slt);
+    void addServlet(const std::string& uri, FunctionServlet::callback cb);
+
+    /**
+     * @brief 添加通配匹配的处理器, 已存在时替换
+     */
+    void addGlobServlet(const std::string& uri, Servlet::ptr slt);
+    void addGlobServlet(const std::string& uri, FunctionServlet::callback cb);
+
+    void delServlet(const std::string& uri);
+    void delGlobServlet(const std::string& uri);
+
+    Servlet::ptr getDefault() const { return m_default;}
+    void setDefault(Servlet::ptr v) { m_default = v;}
+
+    /**
+     * @brief 取路径对应的处理器, 没有匹配时返回默认处理器
+     */
+    Servlet::ptr getMatchedServlet(const StringView& path);
+private:
+    RWMutexType m_mutex;
+    /// 精确匹配 uri -> servlet
+    std::unordered_map<std::string, Servlet::ptr> m_datas;
+    /// 通配匹配 uri -> servlet, 按添加顺序
+    std::vector<std::pair<std::string, Servlet::ptr> > m_globs;
+    /// 默认处理器
+    Servlet::ptr m_default;
+};
+
+}
+}
+
+#endif
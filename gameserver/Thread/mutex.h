@@ -0,0 +1,298 @@
+#ifndef __GAMESERVER_MUTEX_H__
+#define __GAMESERVER_MUTEX_H__
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <atomic>
+#include <stdint.h>
+#include "Util/noncopyable.h"
+
+namespace gameserver{
+
+/**
+ * @brief 信号量
+ */
+class Semaphore : Noncopyable {
+public:
+    /**
+     * @brief 构造函数
+     * @param[in] count 信号量初始值
+     */
+    Semaphore(uint32_t count = 0) {
+        sem_init(&m_semaphore, 0, count);
+    }
+
+    ~Semaphore() {
+        sem_destroy(&m_semaphore);
+    }
+
+    /**
+     * @brief 获取信号量, 被信号打断时继续等待
+     */
+    void wait() {
+        while(sem_wait(&m_semaphore) && errno == EINTR) {
+        }
+    }
+
+    /**
+     * @brief 释放信号量
+     */
+    void notify() {
+        sem_post(&m_semaphore);
+    }
+private:
+    sem_t m_semaphore;
+};
+
+/**
+ * @brief 局部锁的模板实现
+ */
+template<class T>
+struct ScopedLockImpl {
+public:
+    ScopedLockImpl(T& mutex)
+        :m_mutex(mutex) {
+        m_mutex.lock();
+        m_locked = true;
+    }
+
+    ~ScopedLockImpl() {
+        unlock();
+    }
+
+    void lock() {
+        if(!m_locked) {
+            m_mutex.lock();
+            m_locked = true;
+        }
+    }
+
+    void unlock() {
+        if(m_locked) {
+            m_mutex.unlock();
+            m_locked = false;
+        }
+    }
+private:
+    /// mutex
+    T& m_mutex;
+    /// 是否已上锁
+    bool m_locked;
+};
+
+/**
+ * @brief 局部读锁模板实现
+ */
+template<class T>
+struct ReadScopedLockImpl {
+public:
+    ReadScopedLockImpl(T& mutex)
+        :m_mutex(mutex) {
+        m_mutex.rdlock();
+        m_locked = true;
+    }
+
+    ~ReadScopedLockImpl() {
+        unlock();
+    }
+
+    void lock() {
+        if(!m_locked) {
+            m_mutex.rdlock();
+            m_locked = true;
+        }
+    }
+
+    void unlock() {
+        if(m_locked) {
+            m_mutex.unlock();
+            m_locked = false;
+        }
+    }
+private:
+    /// mutex
+    T& m_mutex;
+    /// 是否已上锁
+    bool m_locked;
+};
+
+/**
+ * @brief 局部写锁模板实现
+ */
+template<class T>
+struct WriteScopedLockImpl {
+public:
+    WriteScopedLockImpl(T& mutex)
+        :m_mutex(mutex) {
+        m_mutex.wrlock();
+        m_locked = true;
+    }
+
+    ~WriteScopedLockImpl() {
+        unlock();
+    }
+
+    void lock() {
+        if(!m_locked) {
+            m_mutex.wrlock();
+            m_locked = true;
+        }
+    }
+
+    void unlock() {
+        if(m_locked) {
+            m_mutex.unlock();
+            m_locked = false;
+        }
+    }
+private:
+    /// mutex
+    T& m_mutex;
+    /// 是否已上锁
+    bool m_locked;
+};
+
+/**
+ * @brief 互斥量
+ */
+class Mutex : Noncopyable {
+public:
+    typedef ScopedLockImpl<Mutex> Lock;
+
+    Mutex() {
+        pthread_mutex_init(&m_mutex, nullptr);
+    }
+
+    ~Mutex() {
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    void lock() {
+        pthread_mutex_lock(&m_mutex);
+    }
+
+    void unlock() {
+        pthread_mutex_unlock(&m_mutex);
+    }
+private:
+    pthread_mutex_t m_mutex;
+};
+
+/**
+ * @brief 空锁(用于调试, 或确定只有单线程使用的场景)
+ */
+class NullMutex : Noncopyable {
+public:
+    typedef ScopedLockImpl<NullMutex> Lock;
+    NullMutex() {}
+    ~NullMutex() {}
+    void lock() {}
+    void unlock() {}
+};
+
+/**
+ * @brief 读写互斥量
+ */
+class RWMutex : Noncopyable {
+public:
+    typedef ReadScopedLockImpl<RWMutex> ReadLock;
+    typedef WriteScopedLockImpl<RWMutex> WriteLock;
+
+    RWMutex() {
+        pthread_rwlock_init(&m_lock, nullptr);
+    }
+
+    ~RWMutex() {
+        pthread_rwlock_destroy(&m_lock);
+    }
+
+    void rdlock() {
+        pthread_rwlock_rdlock(&m_lock);
+    }
+
+    void wrlock() {
+        pthread_rwlock_wrlock(&m_lock);
+    }
+
+    void unlock() {
+        pthread_rwlock_unlock(&m_lock);
+    }
+private:
+    pthread_rwlock_t m_lock;
+};
+
+/**
+ * @brief 空读写锁(用于调试)
+ */
+class NullRWMutex : Noncopyable {
+public:
+    typedef ReadScopedLockImpl<NullRWMutex> ReadLock;
+    typedef WriteScopedLockImpl<NullRWMutex> WriteLock;
+    NullRWMutex() {}
+    ~NullRWMutex() {}
+    void rdlock() {}
+    void wrlock() {}
+    void unlock() {}
+};
+
+/**
+ * @brief 自旋锁
+ */
+class Spinlock : Noncopyable {
+public:
+    typedef ScopedLockImpl<Spinlock> Lock;
+
+    Spinlock() {
+        pthread_spin_init(&m_mutex, 0);
+    }
+
+    ~Spinlock() {
+        pthread_spin_destroy(&m_mutex);
+    }
+
+    void lock() {
+        pthread_spin_lock(&m_mutex);
+    }
+
+    void unlock() {
+        pthread_spin_unlock(&m_mutex);
+    }
+private:
+    pthread_spinlock_t m_mutex;
+};
+
+/**
+ * @brief 原子锁
+ * @details test-and-test-and-set: 先只读等待锁释放再尝试交换,
+ *          等待时不反复写缓存行, 竞争时比直接交换的自旋锁便宜
+ */
+class CASLock : Noncopyable {
+public:
+    typedef ScopedLockImpl<CASLock> Lock;
+
+    CASLock()
+        :m_locked(false) {
+    }
+
+    void lock() {
+        while(m_locked.exchange(true, std::memory_order_acquire)) {
+            while(m_locked.load(std::memory_order_relaxed)) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#endif
+            }
+        }
+    }
+
+    void unlock() {
+        m_locked.store(false, std::memory_order_release);
+    }
+private:
+    /// 是否已上锁
+    std::atomic<bool> m_locked;
+};
+
+}
+
+#endif
@@ -0,0 +1,125 @@
+#include "rcu.h"
+#include <thread>
+
+namespace gameserver{
+
+thread_local RcuDomain::Record* RcuDomain::t_record = nullptr;
+
+namespace {
+
+/**
+ * @brief 线程退出时归还读者记录
+ */
+struct RecordHolder {
+    ~RecordHolder() {
+        if(record) {
+            record->epoch.store(0, std::memory_order_release);
+            record->depth = 0;
+            record->inUse.store(false, std::memory_order_release);
+            RcuDomain::ClearThreadRecord();
+        }
+    }
+
+    RcuDomain::Record* record = nullptr;
+};
+
+static thread_local RecordHolder t_holder;
+
+}
+
+RcuDomain* RcuDomain::GetInstance() {
+    static RcuDomain* s_domain = new RcuDomain;
+    return s_domain;
+}
+
+RcuDomain::RcuDomain()
+    :m_epoch(1)
+    ,m_records(nullptr) {
+}
+
+RcuDomain::Record* RcuDomain::acquireRecord() {
+    Record* r = nullptr;
+    for(Record* i = m_records.load(std::memory_order_acquire); i; i = i->next) {
+        bool expected = false;
+        if(!i->inUse.load(std::memory_order_relaxed)
+                && i->inUse.compare_exchange_strong(expected, true)) {
+            r = i;
+            break;
+        }
+    }
+    if(!r) {
+        r = new Record;
+        r->epoch.store(0, std::memory_order_relaxed);
+        r->depth = 0;
+        r->inUse.store(true, std::memory_order_relaxed);
+        r->next = m_records.load(std::memory_order_relaxed);
+        while(!m_records.compare_exchange_weak(r->next, r, std::memory_order_release
+                    ,std::memory_order_relaxed)) {
+        }
+    }
+    t_record = r;
+    t_holder.record = r;
+    return r;
+}
+
+uint64_t RcuDomain::minActiveEpoch() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t min = UINT64_MAX;
+    for(Record* i = m_records.load(std::memory_order_acquire); i; i = i->next) {
+        uint64_t e = i->epoch.load(std::memory_order_acquire);
+        if(e && e < min) {
+            min = e;
+        }
+    }
+    return min;
+}
+
+void RcuDomain::retire(void* p, void (*deleter)(void*)) {
+    // 在读区里登记了不大于e的读者可能还拿着p
+    uint64_t e = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    {
+        Mutex::Lock lock(m_mutex);
+        m_retired.push_back(Retired{p, deleter, e});
+    }
+    collect();
+}
+
+size_t RcuDomain::collect() {
+    std::vector<Retired> frees;
+    {
+        Mutex::Lock lock(m_mutex);
+        if(m_retired.empty()) {
+            return 0;
+        }
+        uint64_t min = minActiveEpoch();
+        for(auto it = m_retired.begin(); it != m_retired.end();) {
+            if(it->epoch < min) {
+                frees.push_back(*it);
+                it = m_retired.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // 在锁外释放, 析构函数里可能再次retire
+    for(auto& i : frees) {
+        i.deleter(i.ptr);
+    }
+    return frees.size();
+}
+
+void RcuDomain::synchronize() {
+    // 此前retire的对象epoch都小于e, 等登记了不大于e的读者全部离开
+    uint64_t e = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    while(minActiveEpoch() <= e) {
+        std::this_thread::yield();
+    }
+    collect();
+}
+
+size_t RcuDomain::pending() {
+    Mutex::Lock lock(m_mutex);
+    return m_retired.size();
+}
+
+}
@@ -0,0 +1,151 @@
+#ifndef __GAMESERVER_RCU_H__
+#define __GAMESERVER_RCU_H__
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include "mutex.h"
+
+namespace gameserver{
+
+/**
+ * @brief 基于epoch的延迟回收(RCU)
+ * @details 读者进入读区时把全局epoch登记到本线程的记录里, 读取共享指针后直接使用,
+ *          不加锁, 不改引用计数, 写者从不阻塞读者.
+ *          写者原子替换指针后把旧对象交给retire(), 等所有可能读到旧对象的读者
+ *          (登记的epoch不大于替换时的epoch)离开读区后才释放.
+ *          回收在retire()/collect()里进行, 读者只有两次本线程的写和一次内存屏障
+ */
+class RcuDomain : Noncopyable {
+public:
+    /**
+     * @brief 每个线程一条的读者记录
+     */
+    struct Record {
+        /// 进入读区时的epoch, 0表示不在读区
+        std::atomic<uint64_t> epoch;
+        /// 读区嵌套深度, 只有本线程访问
+        uint32_t depth;
+        /// 是否有线程在使用
+        std::atomic<bool> inUse;
+        /// 链表下一条
+        Record* next;
+        /// 填充, 不同线程的记录不在同一缓存行
+        char pad[64];
+    };
+
+    /**
+     * @brief 全局实例, 不析构, 静态对象析构期间也可以使用
+     */
+    static RcuDomain* GetInstance();
+
+    /**
+     * @brief 进入读区, 可嵌套
+     */
+    Record* enter() {
+        Record* r = t_record ? t_record : acquireRecord();
+        if(r->depth++ == 0) {
+            r->epoch.store(m_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            // 登记epoch必须先于之后对共享指针的读取被写者看到
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        return r;
+    }
+
+    /**
+     * @brief 离开读区
+     */
+    void exit(Record* r) {
+        if(--r->depth == 0) {
+            r->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief 延迟释放p, 调用前p已经不能再从共享指针读到
+     */
+    template<class T>
+    void retire(T* p) {
+        retire(p, &DeleteObject<T>);
+    }
+
+    void retire(void* p, void (*deleter)(void*));
+
+    /**
+     * @brief 释放已经没有读者的对象
+     * @return 释放的个数
+     */
+    size_t collect();
+
+    /**
+     * @brief 等待当前所有读者离开读区后, 释放全部已retire的对象
+     * @details 会阻塞调用方, 不能在读区里调用
+     */
+    void synchronize();
+
+    /**
+     * @brief 等待释放的对象个数
+     */
+    size_t pending();
+
+    /**
+     * @brief 线程退出时解除本线程与记录的关联
+     */
+    static void ClearThreadRecord() { t_record = nullptr;}
+private:
+    RcuDomain();
+
+    template<class T>
+    static void DeleteObject(void* p) {
+        delete (T*)p;
+    }
+
+    /**
+     * @brief 为本线程取一条记录, 优先复用已退出线程的记录
+     */
+    Record* acquireRecord();
+
+    /**
+     * @brief 当前在读区的最小epoch, 没有读者返回UINT64_MAX
+     */
+    uint64_t minActiveEpoch();
+private:
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    /// 本线程的记录
+    static thread_local Record* t_record;
+    /// 全局epoch, 从1开始
+    std::atomic<uint64_t> m_epoch;
+    /// 读者记录链表, 只增不删
+    std::atomic<Record*> m_records;
+    /// 保护m_retired
+    Mutex m_mutex;
+    /// 等待释放的对象
+    std::vector<Retired> m_retired;
+};
+
+/**
+ * @brief 局部读区
+ */
+class RcuReadLock : Noncopyable {
+public:
+    RcuReadLock()
+        :m_domain(RcuDomain::GetInstance())
+        ,m_record(m_domain->enter()) {
+    }
+
+    ~RcuReadLock() {
+        m_domain->exit(m_record);
+    }
+private:
+    RcuDomain* m_domain;
+    RcuDomain::Record* m_record;
+};
+
+}
+
+#endif
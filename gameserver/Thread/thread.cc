@@ -0,0 +1,96 @@
+#include "thread.h"
+#include "Util/util.h"
+#include <unordered_set>
+#include <system_error>
+
+namespace gameserver{
+
+/// 当前线程的Thread对象
+static thread_local Thread* t_thread = nullptr;
+/// 当前线程名称(驻留)
+static thread_local const char* t_thread_name = nullptr;
+
+/**
+ * @brief 设置内核里的线程名, 最多15个字符
+ */
+static void SetSystemName(const std::string& name) {
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+}
+
+const char* Thread::InternName(const std::string& name) {
+    static Mutex s_mutex;
+    // 不析构, 静态对象析构阶段写日志时名称指针仍然有效; 节点式容器扩容不移动元素
+    static std::unordered_set<std::string>* s_names = new std::unordered_set<std::string>;
+    Mutex::Lock lock(s_mutex);
+    return s_names->insert(name).first->c_str();
+}
+
+Thread* Thread::GetThis() {
+    return t_thread;
+}
+
+const char* Thread::GetName() {
+    if(!t_thread_name) {
+        char buf[16] = {0};
+        if(pthread_getname_np(pthread_self(), buf, sizeof(buf))) {
+            buf[0] = '\0';
+        }
+        t_thread_name = InternName(buf);
+    }
+    return t_thread_name;
+}
+
+void Thread::SetName(const std::string& name) {
+    if(name.empty()) {
+        return;
+    }
+    if(t_thread) {
+        t_thread->m_name = name;
+    }
+    t_thread_name = InternName(name);
+    SetSystemName(name);
+}
+
+Thread::Thread(std::function<void()> cb, const std::string& name)
+    :m_cb(cb)
+    ,m_name(name.empty() ? "UNKNOW" : name) {
+    int rt = pthread_create(&m_thread, nullptr, &Thread::run, this);
+    if(rt) {
+        m_thread = 0;
+        throw std::system_error(rt, std::system_category(), "pthread_create fail, name=" + m_name);
+    }
+    m_semaphore.wait();
+}
+
+Thread::~Thread() {
+    if(m_thread) {
+        pthread_detach(m_thread);
+    }
+}
+
+void Thread::join() {
+    if(m_thread) {
+        int rt = pthread_join(m_thread, nullptr);
+        if(rt) {
+            throw std::system_error(rt, std::system_category(), "pthread_join fail, name=" + m_name);
+        }
+        m_thread = 0;
+    }
+}
+
+void* Thread::run(void* arg) {
+    Thread* thread = (Thread*)arg;
+    t_thread = thread;
+    t_thread_name = InternName(thread->m_name);
+    thread->m_id = GetThreadId();
+    SetSystemName(thread->m_name);
+
+    std::function<void()> cb;
+    cb.swap(thread->m_cb);
+    // 之后构造函数返回, thread可能被析构, 不能再访问
+    thread->m_semaphore.notify();
+    cb();
+    return 0;
+}
+
+}
@@ -0,0 +1,97 @@
+#ifndef __GAMESERVER_THREAD_H__
+#define __GAMESERVER_THREAD_H__
+
+#include <memory>
+#include <functional>
+#include <string>
+#include <pthread.h>
+#include <sys/types.h>
+#include "mutex.h"
+
+namespace gameserver{
+
+/**
+ * @brief 线程
+ * @details 构造时创建线程, 等新线程记下内核线程id和名称后才返回, 构造完getId()即可用.
+ *          线程id和名称指针缓存在线程局部变量里, 日志每条只读一次, 不做系统调用也不拷贝字符串.
+ *          名称经过InternName()驻留, 指针在进程结束前一直有效;
+ *          内核里的线程名(pthread_setname_np)最多15个字符, 超出截断
+ */
+class Thread : Noncopyable {
+public:
+    typedef std::shared_ptr<Thread> ptr;
+
+    /**
+     * @brief 构造函数, 创建并启动线程
+     * @param[in] cb 线程执行函数
+     * @param[in] name 线程名称
+     * @exception std::system_error 创建线程失败
+     */
+    Thread(std::function<void()> cb, const std::string& name);
+
+    /**
+     * @brief 析构函数, 没有join的线程会被detach
+     */
+    ~Thread();
+
+    /**
+     * @brief 内核线程id
+     */
+    pid_t getId() const { return m_id;}
+
+    /**
+     * @brief 线程名称
+     */
+    const std::string& getName() const { return m_name;}
+
+    /**
+     * @brief 是否还可以join
+     */
+    bool joinable() const { return m_thread != 0;}
+
+    /**
+     * @brief 等待线程执行完成
+     */
+    void join();
+
+    /**
+     * @brief 当前线程对应的Thread对象, 不是Thread创建的线程返回nullptr
+     */
+    static Thread* GetThis();
+
+    /**
+     * @brief 当前线程名称, 驻留的字符串
+     * @details 不是Thread创建且没有调用过SetName()的线程, 第一次调用时取内核里的线程名
+     */
+    static const char* GetName();
+
+    /**
+     * @brief 设置当前线程名称
+     */
+    static void SetName(const std::string& name);
+
+    /**
+     * @brief 驻留字符串, 相同内容返回同一个指针, 不会释放
+     */
+    static const char* InternName(const std::string& name);
+private:
+    /**
+     * @brief 线程入口
+     */
+    static void* run(void* arg);
+private:
+    /// 内核线程id
+    pid_t m_id = -1;
+    /// 线程句柄
+    pthread_t m_thread = 0;
+    /// 线程执行函数
+    std::function<void()> m_cb;
+    /// 线程名称
+    std::string m_name;
+    /// 等新线程初始化完成
+    Semaphore m_semaphore;
+};
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef __GAMESERVER_MACRO_H__
+#define __GAMESERVER_MACRO_H__
+
+#include <string.h>
+#include <assert.h>
+#include "Log/log.h"
+#include "util.h"
+
+#if defined __GNUC__ || defined __llvm__
+/// 告诉编译器优化, 条件大概率成立
+#define GAMESERVER_LIKELY(x) __builtin_expect(!!(x), 1)
+/// 告诉编译器优化, 条件大概率不成立
+#define GAMESERVER_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define GAMESERVER_LIKELY(x) (x)
+#define GAMESERVER_UNLIKELY(x) (x)
+#endif
+
+/**
+ * @brief 断言, 失败时把调用栈写到system日志
+ */
+#define GAMESERVER_ASSERT(x) \
+    if(GAMESERVER_UNLIKELY(!(x))) { \
+        GAMESERVER_LOG_ERROR(GAMESERVER_LOG_NAME("system")) << "ASSERTION: " #x \
+            << "\nbacktrace:\n" \
+            << gameserver::BacktraceToString(100, 2, "    "); \
+        assert(x); \
+    }
+
+/**
+ * @brief 带说明的断言
+ */
+#define GAMESERVER_ASSERT2(x, w) \
+    if(GAMESERVER_UNLIKELY(!(x))) { \
+        GAMESERVER_LOG_ERROR(GAMESERVER_LOG_NAME("system")) << "ASSERTION: " #x \
+            << "\n" << w \
+            << "\nbacktrace:\n" \
+            << gameserver::BacktraceToString(100, 2, "    "); \
+        assert(x); \
+    }
+
+#endif
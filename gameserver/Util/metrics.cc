@@ -0,0 +1,123 @@
+#include "metrics.h"
+#include <stdlib.h>
+#include <new>
+
+namespace gameserver{
+
+static std::atomic<uint32_t> s_nextShard(0);
+
+uint32_t GetShardIndex() {
+    static thread_local uint32_t t_shard = s_nextShard.fetch_add(1, std::memory_order_relaxed);
+    return t_shard;
+}
+
+bool MetricsSampleTick() {
+    static thread_local uint32_t t_tick = 0;
+    return (t_tick++ % METRICS_SAMPLE_EVERY) == 0;
+}
+
+void* CacheAligned::operator new(size_t size) {
+    void* p = nullptr;
+    if(posix_memalign(&p, 64, size) != 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void CacheAligned::operator delete(void* p) {
+    free(p);
+}
+
+ShardedCounter::ShardedCounter() {
+    for(auto& s : m_shards) {
+        s.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ShardedCounter::get() const {
+    uint64_t sum = 0;
+    for(auto& s : m_shards) {
+        sum += s.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const {
+    if(!count || buckets.empty()) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(p * count);
+    if(target >= count) {
+        target = count - 1;
+    }
+    uint64_t seen = 0;
+    for(size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if(seen > target) {
+            uint64_t upper = LatencyHistogram::BucketUpper(b);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+LatencyHistogram::LatencyHistogram() {
+    for(auto& s : m_shards) {
+        for(auto& b : s.buckets) {
+            b.store(0, std::memory_order_relaxed);
+        }
+        s.sum.store(0, std::memory_order_relaxed);
+        s.max.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t LatencyHistogram::BucketOf(uint64_t v) {
+    if(v < SUB_BUCKETS) {
+        return v;
+    }
+    uint32_t msb = 63 - __builtin_clzll(v);
+    if(msb >= MAX_BITS) {
+        return BUCKETS - 1;
+    }
+    uint32_t shift = msb - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((v >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint64_t LatencyHistogram::BucketUpper(uint32_t b) {
+    if(b < SUB_BUCKETS) {
+        return b;
+    }
+    uint32_t shift = b / SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t)(SUB_BUCKETS + b % SUB_BUCKETS) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t v) {
+    Shard& s = m_shards[GetShardIndex() % SHARDS];
+    s.buckets[BucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+    s.sum.fetch_add(v, std::memory_order_relaxed);
+    uint64_t max = s.max.load(std::memory_order_relaxed);
+    while(v > max && !s.max.compare_exchange_weak(max, v, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot snap;
+    snap.buckets.resize(BUCKETS, 0);
+    for(auto& s : m_shards) {
+        for(uint32_t b = 0; b < BUCKETS; ++b) {
+            uint64_t n = s.buckets[b].load(std::memory_order_relaxed);
+            snap.buckets[b] += n;
+            // 次数由各桶相加, 与各桶总是一致
+            snap.count += n;
+        }
+        snap.sum += s.sum.load(std::memory_order_relaxed);
+        uint64_t max = s.max.load(std::memory_order_relaxed);
+        if(max > snap.max) {
+            snap.max = max;
+        }
+    }
+    return snap;
+}
+
+}
@@ -0,0 +1,148 @@
+#ifndef __GAMESERVER_METRICS_H__
+#define __GAMESERVER_METRICS_H__
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include "noncopyable.h"
+
+namespace gameserver{
+
+/**
+ * @brief 本线程使用的分片下标
+ * @details 线程第一次调用时按顺序分配, 之后缓存在线程局部变量中
+ */
+uint32_t GetShardIndex();
+
+/**
+ * @brief 本线程这一次是否取样计时, 每METRICS_SAMPLE_EVERY次取一次
+ * @details 计时需要两次读时钟, 只对一部分事件计时, 直方图按取样统计
+ */
+static const uint32_t METRICS_SAMPLE_EVERY = 16;
+bool MetricsSampleTick();
+
+/**
+ * @brief 计时用的单调时钟(纳秒)
+ */
+inline uint64_t MetricsNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief 按缓存行对齐分配的基类
+ * @details C++11的new不保证超过16字节的对齐, 含有计数器或直方图成员又在堆上创建的类继承它
+ */
+class CacheAligned {
+public:
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+};
+
+/**
+ * @brief 分片计数器
+ * @details 每个线程固定累加到一个分片(不同分片不在同一缓存行), 读取时把各分片加起来.
+ *          线程数不超过分片数时写入没有竞争
+ */
+class ShardedCounter : Noncopyable {
+public:
+    /// 分片数
+    static const uint32_t SHARDS = 16;
+
+    ShardedCounter();
+
+    void add(uint64_t v = 1) {
+        m_shards[GetShardIndex() % SHARDS].value.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 各分片之和, 并发写入时是近似值
+     */
+    uint64_t get() const;
+private:
+    /// 每个分片独占一个缓存行
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value;
+    };
+    Shard m_shards[SHARDS];
+};
+
+/**
+ * @brief 直方图快照
+ */
+struct HistogramSnapshot {
+    /// 记录的次数
+    uint64_t count = 0;
+    /// 记录值之和
+    uint64_t sum = 0;
+    /// 最大值
+    uint64_t max = 0;
+    /// 各桶计数
+    std::vector<uint64_t> buckets;
+
+    /**
+     * @brief 分位数, 返回所在桶的上界
+     * @param[in] p 0~1
+     */
+    uint64_t percentile(double p) const;
+
+    /**
+     * @brief 平均值
+     */
+    uint64_t mean() const { return count ? sum / count : 0;}
+};
+
+/**
+ * @brief 无锁的对数-线性直方图(HDR风格)
+ * @details 每个2的幂区间分成8个等宽的桶, 相对误差不超过12.5%, 覆盖0 ~ 2^40(纳秒约18分钟),
+ *          更大的值记到最后一个桶. 记录只有relaxed原子加, 按线程分片
+ */
+class LatencyHistogram : Noncopyable {
+public:
+    /// 每个2的幂区间的桶数(2^SUB_BITS)
+    static const uint32_t SUB_BITS = 3;
+    static const uint32_t SUB_BUCKETS = 1 << SUB_BITS;
+    /// 最大值的位数
+    static const uint32_t MAX_BITS = 40;
+    /// 桶数
+    static const uint32_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+    /// 分片数
+    static const uint32_t SHARDS = 4;
+
+    LatencyHistogram();
+
+    /**
+     * @brief 记录一个值
+     */
+    void record(uint64_t v);
+
+    /**
+     * @brief 合并各分片
+     */
+    HistogramSnapshot snapshot() const;
+
+    /**
+     * @brief 值所在的桶
+     */
+    static uint32_t BucketOf(uint64_t v);
+
+    /**
+     * @brief 桶的上界
+     */
+    static uint64_t BucketUpper(uint32_t b);
+private:
+    /// 分片按缓存行对齐, 相邻分片不共享缓存行
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> buckets[BUCKETS];
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    };
+    Shard m_shards[SHARDS];
+};
+
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef __GAMESERVER_NONCOPYABLE_H__
+#define __GAMESERVER_NONCOPYABLE_H__
+
+namespace gameserver{
+
+/**
+ * @brief 对象无法拷贝,赋值
+ */
+class Noncopyable {
+public:
+    Noncopyable() = default;
+    ~Noncopyable() = default;
+    Noncopyable(const Noncopyable&) = delete;
+    Noncopyable& operator=(const Noncopyable&) = delete;
+};
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+#include "util.h"
+#include "Fiber/fiber.h"
+#include <sstream>
+#include <execinfo.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace gameserver{
+
+static thread_local uint32_t t_thread_id = 0;
+
+uint32_t GetThreadId() {
+    if(!t_thread_id) {
+        t_thread_id = syscall(SYS_gettid);
+    }
+    return t_thread_id;
+}
+
+uint32_t GetFiberId() {
+    return (uint32_t)Fiber::GetFiberId();
+}
+
+void Backtrace(std::vector<std::string>& bt, int size, int skip) {
+    std::vector<void*> array(size);
+    int s = ::backtrace(&array[0], size);
+    char** strings = backtrace_symbols(&array[0], s);
+    if(strings == NULL) {
+        return;
+    }
+    for(int i = skip; i < s; ++i) {
+        bt.push_back(strings[i]);
+    }
+    free(strings);
+}
+
+std::string BacktraceToString(int size, int skip, const std::string& prefix) {
+    std::vector<std::string> bt;
+    Backtrace(bt, size, skip);
+    std::stringstream ss;
+    for(size_t i = 0; i < bt.size(); ++i) {
+        ss << prefix << bt[i] << std::endl;
+    }
+    return ss.str();
+}
+
+uint64_t GetCurrentMS() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000ul  + tv.tv_usec / 1000;
+}
+
+uint64_t GetCurrentUS() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000 * 1000ul  + tv.tv_usec;
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef __GAMESERVER_UTIL_H__
+#define __GAMESERVER_UTIL_H__
+
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+namespace gameserver{
+
+/**
+ * @brief 当前线程的内核线程id, 首次调用后缓存在线程局部变量中
+ */
+uint32_t GetThreadId();
+
+/**
+ * @brief 当前协程id, 不在协程里时为0
+ * @details 取Fiber::GetFiberId()的低32位, 与LogEvent的协程id一致
+ */
+uint32_t GetFiberId();
+
+/**
+ * @brief 获取当前的调用栈
+ * @param[out] bt 保存调用栈
+ * @param[in] size 最多返回层数
+ * @param[in] skip 跳过栈顶的层数
+ */
+void Backtrace(std::vector<std::string>& bt, int size = 64, int skip = 1);
+
+/**
+ * @brief 获取当前栈信息的字符串
+ * @param[in] size 栈的最大层数
+ * @param[in] skip 跳过栈顶的层数
+ * @param[in] prefix 栈信息前输出的内容
+ */
+std::string BacktraceToString(int size = 64, int skip = 2, const std::string& prefix = "");
+
+/**
+ * @brief 当前时间的毫秒数
+ */
+uint64_t GetCurrentMS();
+
+/**
+ * @brief 当前时间的微秒数
+ */
+uint64_t GetCurrentUS();
+
+/**
+ * @brief 单调时钟的毫秒数(CLOCK_MONOTONIC), 不受系统改时间影响, 用于定时器
+ */
+inline uint64_t GetMonotonicMS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ul + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief 读取粗粒度的当前时间(CLOCK_REALTIME_COARSE)
+ * @details 走vDSO, 只读内核上次时钟中断时的时间, 比CLOCK_REALTIME便宜,
+ *          精度是一个时钟中断周期(1~4ms), 适合给日志打时间戳
+ * @param[out] sec 秒
+ * @param[out] usec 微秒部分
+ */
+inline void GetCoarseTime(uint64_t& sec, uint32_t& usec) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    sec = ts.tv_sec;
+    usec = ts.tv_nsec / 1000;
+}
+
+}
+
+#endif
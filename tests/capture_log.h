@@ -0,0 +1,125 @@
+#ifndef __GAMESERVER_TESTS_CAPTURE_LOG_H__
+#define __GAMESERVER_TESTS_CAPTURE_LOG_H__
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <unistd.h>
+#include "Log/log.h"
+#include "Thread/mutex.h"
+
+/**
+ * @brief 测试用的Handler, 记下收到的日志, 多个线程同时写也安全
+ * @details 按格式器格式化后连同事件的字段一起记成一条Record.
+ *          writer为true时按已格式化的字节流接收(isWriter()), write()收到的每段记一条只有level和text的Record
+ */
+class CaptureLogHandler : public gameserver::LogHandler {
+public:
+    typedef std::shared_ptr<CaptureLogHandler> ptr;
+
+    struct Record {
+        gameserver::LogLevel::Level level;
+        /// 产生日志的日志器名称
+        std::string logger;
+        std::string file;
+        int32_t line;
+        uint32_t threadId;
+        /// 线程名, Thread::InternName驻留的指针
+        const char* threadName;
+        uint64_t time;
+        /// 消息内容
+        std::string content;
+        /// 格式化后的整行
+        std::string text;
+    };
+
+    /**
+     * @brief 构造函数
+     * @param[in] writer 是否按已格式化的字节流接收
+     * @param[in] delay_us 每条日志休眠的微秒数, 模拟慢速磁盘
+     */
+    CaptureLogHandler(bool writer = false, uint32_t delay_us = 0)
+        :m_delay(delay_us) {
+        m_writer = writer;
+    }
+
+    void log(const std::shared_ptr<gameserver::Logger>& logger, gameserver::LogLevel::Level level, const gameserver::LogEvent& event) override {
+        if(m_delay) {
+            usleep(m_delay);
+        }
+        // 包在AsyncLogHandler里且没有自己的格式器时只记字段
+        gameserver::LogStream buf;
+        gameserver::LogFormatter::ptr fmt = getFormatter();
+        if(fmt) {
+            fmt->format(buf, logger, level, event);
+        }
+        if(m_writer) {
+            write(level, buf.data(), buf.size());
+            return;
+        }
+        Record r{level, event.getLogger() ? event.getLogger()->getName() : "", event.getFile()
+                , event.getLine(), event.getThreadId(), event.getThreadName(), event.getTime()
+                , event.getContent(), buf.str()};
+        gameserver::Mutex::Lock lock(m_lock);
+        m_records.push_back(std::move(r));
+    }
+
+    void write(gameserver::LogLevel::Level level, const char* data, size_t len) override {
+        Record r{level, "", "", 0, 0, nullptr, 0, "", std::string(data, len)};
+        gameserver::Mutex::Lock lock(m_lock);
+        m_records.push_back(std::move(r));
+    }
+
+    void flush() override { ++m_flushes;}
+
+    /**
+     * @brief 收到的日志(副本)
+     */
+    std::vector<Record> records() const {
+        gameserver::Mutex::Lock lock(m_lock);
+        return m_records;
+    }
+
+    /**
+     * @brief 格式化后的各行
+     */
+    std::vector<std::string> lines() const {
+        gameserver::Mutex::Lock lock(m_lock);
+        std::vector<std::string> v;
+        for(auto& i : m_records) {
+            v.push_back(i.text);
+        }
+        return v;
+    }
+
+    /**
+     * @brief 各条日志的消息内容
+     */
+    std::vector<std::string> contents() const {
+        gameserver::Mutex::Lock lock(m_lock);
+        std::vector<std::string> v;
+        for(auto& i : m_records) {
+            v.push_back(i.content);
+        }
+        return v;
+    }
+
+    size_t count() const {
+        gameserver::Mutex::Lock lock(m_lock);
+        return m_records.size();
+    }
+
+    void clear() {
+        gameserver::Mutex::Lock lock(m_lock);
+        m_records.clear();
+    }
+
+    uint64_t flushes() const { return m_flushes;}
+private:
+    uint32_t m_delay;
+    mutable gameserver::Mutex m_lock;
+    std::vector<Record> m_records;
+    std::atomic<uint64_t> m_flushes {0};
+};
+
+#endif
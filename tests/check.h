@@ -0,0 +1,20 @@
+#ifndef __GAMESERVER_TESTS_CHECK_H__
+#define __GAMESERVER_TESTS_CHECK_H__
+
+#include <iostream>
+
+/// 失败的检查数, main里据此返回
+static int s_failed = 0;
+
+/**
+ * @brief 检查条件, 失败时输出位置并计数, 不中断测试
+ */
+#define CHECK(x) \
+    do { \
+        if(!(x)) { \
+            std::cout << __FILE__ << ":" << __LINE__ << " check failed: " #x << std::endl; \
+            ++s_failed; \
+        } \
+    } while(0)
+
+#endif
@@ -1,5 +1,7 @@
 #include <iostream>
 #include "Log/log.h"
+#include "Thread/thread.h"
+#include "Util/util.h"
 
 int main(int argc, char** argv) {
     gameserver::Logger::ptr logger(new gameserver::Logger);
@@ -12,9 +14,16 @@ int main(int argc, char** argv) {
 
     // logger->addHandler(file_Handler);
 
-    gameserver::LogEvent::ptr event(new gameserver::LogEvent(logger, __FILE__, __LINE__, 0, 1, 2, time(0), "name"));
+    gameserver::LogEvent::ptr event(new gameserver::LogEvent(logger, __FILE__, __LINE__, 0
+                , gameserver::GetThreadId(), gameserver::GetFiberId(), time(0), gameserver::Thread::GetName()));
     //event->getSS() << "hello gameserver log";
     logger->log(gameserver::LogLevel::DEBUG, event);
+
+    GAMESERVER_LOG_INFO(logger) << "test macro";
+    GAMESERVER_LOG_FMT_ERROR(logger, "test macro fmt error %s", "aa");
+
+    logger->setLevel(gameserver::LogLevel::ERROR);
+    GAMESERVER_LOG_INFO(logger) << "test macro filtered";
     std::cout << "hello gameserver log" << std::endl;
 
     return 0;
@@ -0,0 +1,166 @@
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <unistd.h>
+#include "Log/log.h"
+#include "Log/async_log.h"
+#include "check.h"
+#include "capture_log.h"
+
+static void produce(gameserver::Logger::ptr logger, int threads, int count) {
+    std::vector<std::thread> thrs;
+    for(int t = 0; t < threads; ++t) {
+        thrs.push_back(std::thread([logger, count, t]() {
+            for(int i = 0; i < count; ++i) {
+                gameserver::LogEvent::ptr event = gameserver::LogEvent::Create(logger, __FILE__, __LINE__, 0, t, 0, time(0), "async");
+                logger->log(gameserver::LogLevel::INFO, event);
+            }
+        }));
+    }
+    for(auto& i : thrs) {
+        i.join();
+    }
+}
+
+void test_block() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("block"));
+    CaptureLogHandler::ptr counter(new CaptureLogHandler);
+    gameserver::AsyncLogHandler::ptr async(new gameserver::AsyncLogHandler(64, gameserver::AsyncLogHandler::BLOCK));
+    async->addHandler(counter);
+    logger->addHandler(async);
+
+    produce(logger, 4, 10000);
+    async->flush();
+    CHECK(counter->count() == 40000);
+    CHECK(counter->flushes() >= 1);
+    CHECK(async->getDropped() == 0);
+    std::cout << "block: written=" << counter->count() << std::endl;
+}
+
+void test_drop(gameserver::AsyncLogHandler::OverflowPolicy policy) {
+    gameserver::Logger::ptr logger(new gameserver::Logger("drop"));
+    CaptureLogHandler::ptr counter(new CaptureLogHandler(false, 20));
+    gameserver::AsyncLogHandler::ptr async(new gameserver::AsyncLogHandler(16, policy));
+    async->addHandler(counter);
+    logger->addHandler(async);
+
+    produce(logger, 2, 2000);
+    async->stop();
+    CHECK(async->getDropped() > 0);
+    CHECK(counter->count() + async->getDropped() == 4000);
+    if(policy == gameserver::AsyncLogHandler::DROP_NEWEST) {
+        CHECK(async->getDroppedOldest() == 0);
+    } else {
+        CHECK(async->getDroppedNewest() == 0);
+    }
+    std::cout << "drop(" << policy << "): written=" << counter->count()
+              << " dropped=" << async->getDropped() << std::endl;
+}
+
+void test_shutdown() {
+    CaptureLogHandler::ptr counter(new CaptureLogHandler(false, 1));
+    {
+        gameserver::Logger::ptr logger(new gameserver::Logger("shutdown"));
+        gameserver::AsyncLogHandler::ptr async(new gameserver::AsyncLogHandler(1024));
+        async->addHandler(counter);
+        logger->addHandler(async);
+        produce(logger, 1, 500);
+        logger->clearHandler();
+    }
+    // Handler析构时写完队列中的日志
+    CHECK(counter->count() == 500);
+    std::cout << "shutdown: written=" << counter->count() << std::endl;
+
+    // 只剩队列里的日志事件持有Logger, Handler最终在后台线程上析构
+    CaptureLogHandler::ptr counter2(new CaptureLogHandler(false, 1));
+    {
+        gameserver::Logger::ptr logger(new gameserver::Logger("orphan"));
+        gameserver::AsyncLogHandler::ptr async(new gameserver::AsyncLogHandler(1024));
+        async->addHandler(counter2);
+        logger->addHandler(async);
+        produce(logger, 1, 500);
+    }
+    for(int i = 0; i < 1000 && counter2->count() != 500; ++i) {
+        usleep(1000);
+    }
+    CHECK(counter2->count() == 500);
+    std::cout << "orphan: written=" << counter2->count() << std::endl;
+}
+
+/**
+ * @brief stop()与入队并发时, 每条被接受的日志都写出
+ */
+void test_stop_race() {
+    for(int round = 0; round < 50; ++round) {
+        gameserver::Logger::ptr logger(new gameserver::Logger("stoprace"));
+        CaptureLogHandler::ptr counter(new CaptureLogHandler);
+        gameserver::AsyncLogHandler::ptr async(new gameserver::AsyncLogHandler(64, gameserver::AsyncLogHandler::BLOCK));
+        async->addHandler(counter);
+        logger->addHandler(async);
+
+        std::atomic<uint64_t> logged {0};
+        std::atomic<bool> done {false};
+        std::vector<std::thread> thrs;
+        for(int t = 0; t < 4; ++t) {
+            thrs.push_back(std::thread([logger, t, &logged, &done]() {
+                while(!done) {
+                    gameserver::LogEvent::ptr event = gameserver::LogEvent::Create(logger, __FILE__, __LINE__, 0, t, 0, time(0), "async");
+                    logger->log(gameserver::LogLevel::INFO, event);
+                    ++logged;
+                }
+            }));
+        }
+        usleep(1000);
+        async->stop();
+        done = true;
+        for(auto& i : thrs) {
+            i.join();
+        }
+        if(counter->count() != logged) {
+            std::cout << "stop race: logged=" << logged << " written=" << counter->count() << std::endl;
+            CHECK(false);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 被包装的Handler跟随Logger的格式器, 自己的格式器不被改动
+ */
+void test_formatter() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("format"));
+    logger->setFormatter("%m%n");
+    CaptureLogHandler::ptr inner(new CaptureLogHandler(true));
+    CaptureLogHandler::ptr own(new CaptureLogHandler(true));
+    own->setFormatter(gameserver::LogFormatter::ptr(new gameserver::LogFormatter("own %m%n")));
+    gameserver::AsyncLogHandler::ptr async(new gameserver::AsyncLogHandler(64));
+    async->addHandler(inner);
+    async->addHandler(own);
+    logger->addHandler(async);
+
+    GAMESERVER_LOG_INFO(logger) << "first";
+    async->flush();
+    CHECK(!inner->getFormatter());
+    logger->setFormatter("[%p] %m%n");
+    GAMESERVER_LOG_INFO(logger) << "second";
+    async->flush();
+    CHECK(!inner->getFormatter());
+    std::vector<std::string> lines = inner->lines();
+    CHECK(lines.size() == 2);
+    CHECK(lines.size() == 2 && lines[0] == "first\n");
+    CHECK(lines.size() == 2 && lines[1] == "[INFO] second\n");
+    lines = own->lines();
+    CHECK(lines.size() == 2 && lines[1] == "own second\n");
+}
+
+int main(int argc, char** argv) {
+    test_block();
+    test_formatter();
+    test_drop(gameserver::AsyncLogHandler::DROP_NEWEST);
+    test_drop(gameserver::AsyncLogHandler::DROP_OLDEST);
+    test_shutdown();
+    test_stop_race();
+    return s_failed ? 1 : 0;
+}
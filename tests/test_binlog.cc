@@ -0,0 +1,233 @@
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Log/log.h"
+#include "Log/binlog.h"
+#include "check.h"
+
+static const int COUNT = 20000;
+
+static std::string file_path(const char* name) {
+    return "/tmp/gameserver_" + std::to_string(getpid()) + "_" + name;
+}
+
+static uint64_t file_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+static std::string expect(int t, int i) {
+    char buf[256];
+    std::string name = "knight" + std::to_string(i % 7);
+    snprintf(buf, sizeof(buf), "t%d player %d moved to %.2f hp=%u %x%% %c %5s|%-4hd|%lld %s"
+             ,t, -i, 1.5 * i, (unsigned)i * 3, -i, 'a' + i % 26, "ab", (short)i
+             ,(long long)i << 33, name.c_str());
+    return buf;
+}
+
+static void log_some(gameserver::BinLogWriter::ptr writer, int t) {
+    for(int i = 0; i < COUNT; ++i) {
+        std::string name = "knight" + std::to_string(i % 7);
+        GAMESERVER_BINLOG_INFO(writer, "t%d player %d moved to %.2f hp=%u %x%% %c %5s|%-4hd|%lld %s"
+                , t, -i, 1.5 * i, (unsigned)i * 3, -i, 'a' + i % 26, "ab", (short)i
+                , (long long)i << 33, name.c_str());
+        if(i % 1000 == 0) {
+            GAMESERVER_BINLOG_DEBUG(writer, "checkpoint");
+        }
+    }
+}
+
+/**
+ * @brief 两个线程写, 解码后与snprintf的结果逐条比较
+ */
+void test_roundtrip() {
+    std::string path = file_path("binlog.bin");
+    gameserver::BinLogWriter::ptr writer(new gameserver::BinLogWriter(path));
+    std::thread t1(log_some, writer, 1);
+    std::thread t2(log_some, writer, 2);
+    t1.join();
+    t2.join();
+    writer->stop();
+    CHECK(writer->getDropped() == 0);
+
+    FILE* in = fopen(path.c_str(), "rb");
+    CHECK(in != nullptr);
+    std::stringstream ss;
+    int64_t n = gameserver::BinLogDecoder::Decode(in, ss);
+    fclose(in);
+    CHECK(n == 2 * (COUNT + COUNT / 1000));
+
+    int next[3] = {0, 0, 0};
+    int checkpoints = 0;
+    std::string line;
+    while(std::getline(ss, line)) {
+        std::vector<std::string> fields;
+        std::stringstream ls(line);
+        std::string f;
+        while(std::getline(ls, f, '\t')) {
+            fields.push_back(f);
+        }
+        CHECK(fields.size() == 6);
+        if(fields.size() != 6) {
+            break;
+        }
+        CHECK(fields[0].size() == strlen("2024-01-01 00:00:00.000000"));
+        CHECK(fields[4].find("test_binlog.cc:") != std::string::npos);
+        if(fields[5] == "checkpoint") {
+            CHECK(fields[3] == "[DEBUG]");
+            ++checkpoints;
+            continue;
+        }
+        CHECK(fields[3] == "[INFO]");
+        int t = fields[5][1] - '0';
+        CHECK(t == 1 || t == 2);
+        if(t != 1 && t != 2) {
+            break;
+        }
+        // 同一线程的日志保持顺序
+        CHECK(fields[5] == expect(t, next[t]));
+        ++next[t];
+    }
+    CHECK(next[1] == COUNT && next[2] == COUNT);
+    CHECK(checkpoints == 2 * COUNT / 1000);
+
+    // 同样的日志用文本格式写一遍, 比较文件大小
+    std::string text_path = file_path("binlog.txt");
+    gameserver::Logger::ptr logger(new gameserver::Logger("binlog"));
+    gameserver::FileLogHandler::ptr handler(new gameserver::FileLogHandler(text_path));
+    logger->addHandler(handler);
+    for(int t = 1; t <= 2; ++t) {
+        for(int i = 0; i < COUNT; ++i) {
+            gameserver::LogEvent::ptr event = gameserver::LogEvent::Create(logger, __FILE__, __LINE__, 0
+                    , gameserver::GetThreadId(), 0, time(0), "binlog");
+            event->getSS() << expect(t, i);
+            logger->log(gameserver::LogLevel::INFO, event);
+        }
+    }
+    handler->flush();
+    uint64_t bin_size = file_size(path);
+    uint64_t text_size = file_size(text_path);
+    std::cout << "binary: " << bin_size << " bytes, text: " << text_size << " bytes, ratio "
+              << (double)text_size / bin_size << std::endl;
+    CHECK(bin_size * 3 < text_size);
+    unlink(path.c_str());
+    unlink(text_path.c_str());
+}
+
+/**
+ * @brief 环满时丢弃并计数, 不阻塞
+ */
+void test_drop() {
+    std::string path = file_path("binlog_drop.bin");
+    // 环很小, 轮询间隔很长, 后台线程来不及读
+    gameserver::BinLogWriter::ptr writer(new gameserver::BinLogWriter(path, 4096, 1000));
+    for(int i = 0; i < 10000; ++i) {
+        GAMESERVER_BINLOG_INFO(writer, "drop %d %s", i, "payload payload payload");
+    }
+    uint64_t dropped = writer->getDropped();
+    CHECK(dropped > 0);
+    writer->stop();
+
+    FILE* in = fopen(path.c_str(), "rb");
+    std::stringstream ss;
+    int64_t n = gameserver::BinLogDecoder::Decode(in, ss);
+    fclose(in);
+    CHECK(n > 0);
+    CHECK((uint64_t)n + writer->getDropped() == 10000);
+
+    // 级别过滤
+    writer->setLevel(gameserver::LogLevel::ERROR);
+    CHECK(!writer->isEnabled(gameserver::LogLevel::INFO));
+    unlink(path.c_str());
+}
+
+/**
+ * @brief 星号宽度和精度的参数按printf的规则消耗
+ */
+void test_star() {
+    std::string path = file_path("binlog_star.bin");
+    gameserver::BinLogWriter::ptr writer(new gameserver::BinLogWriter(path));
+    GAMESERVER_BINLOG_INFO(writer, "[%*d][%-*d][%*d][%.*s][%.*s][%*.*f]"
+                           ,6, 42, 4, 7, -5, 3, 3, "abcdef", -1, "xyz", 8, 2, 3.14159);
+    writer->stop();
+
+    char expect_buf[256];
+    snprintf(expect_buf, sizeof(expect_buf), "[%*d][%-*d][%*d][%.*s][%.*s][%*.*f]"
+             ,6, 42, 4, 7, -5, 3, 3, "abcdef", -1, "xyz", 8, 2, 3.14159);
+    FILE* in = fopen(path.c_str(), "rb");
+    CHECK(in != nullptr);
+    std::stringstream ss;
+    int64_t n = gameserver::BinLogDecoder::Decode(in, ss);
+    fclose(in);
+    CHECK(n == 1);
+    std::string line;
+    std::getline(ss, line);
+    CHECK(line.size() > strlen(expect_buf));
+    CHECK(line.compare(line.size() - strlen(expect_buf), std::string::npos, expect_buf) == 0);
+    unlink(path.c_str());
+}
+
+/**
+ * @brief std::string参数按%s检查和记录, 无参数的日志也能写
+ */
+void test_string() {
+    std::string path = file_path("binlog_string.bin");
+    gameserver::BinLogWriter::ptr writer(new gameserver::BinLogWriter(path));
+    std::string name = "alice";
+    const std::string zone = "north gate";
+    GAMESERVER_BINLOG_INFO(writer, "player %s enter [%-12s] %d", name, zone, 7);
+    GAMESERVER_BINLOG_INFO(writer, "no args");
+    writer->stop();
+
+    FILE* in = fopen(path.c_str(), "rb");
+    CHECK(in != nullptr);
+    std::stringstream ss;
+    int64_t n = gameserver::BinLogDecoder::Decode(in, ss);
+    fclose(in);
+    CHECK(n == 2);
+    const char* expects[] = {"player alice enter [north gate  ] 7", "no args"};
+    for(const char* e : expects) {
+        std::string line;
+        std::getline(ss, line);
+        CHECK(line.size() > strlen(e));
+        CHECK(line.compare(line.size() - strlen(e), std::string::npos, e) == 0);
+    }
+    unlink(path.c_str());
+}
+
+/**
+ * @brief 单线程每条日志的耗时
+ */
+void test_speed() {
+    std::string path = file_path("binlog_speed.bin");
+    gameserver::BinLogWriter::ptr writer(new gameserver::BinLogWriter(path, 64 << 20));
+    const int n = 1000000;
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < n; ++i) {
+        GAMESERVER_BINLOG_INFO(writer, "player %d moved to %.2f zone %s", i, 1.5 * i, "north");
+    }
+    auto end = std::chrono::steady_clock::now();
+    writer->stop();
+    std::cout << "binlog: " << std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / n
+              << " ns/line, dropped " << writer->getDropped() << std::endl;
+    unlink(path.c_str());
+}
+
+int main(int argc, char** argv) {
+    test_roundtrip();
+    test_drop();
+    test_star();
+    test_string();
+    test_speed();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
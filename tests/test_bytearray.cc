@@ -0,0 +1,287 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <endian.h>
+#include "Net/bytearray.h"
+#include "check.h"
+
+/**
+ * @brief 各种类型写入后按顺序读出, 小块大小让数据跨块
+ */
+#define XX(type, write_fun, read_fun) \
+    for(size_t block : {1, 3, 7, 64, 4096}) { \
+        for(bool little : {false, true}) { \
+            gameserver::ByteArray ba(block); \
+            ba.setIsLittleEndian(little); \
+            std::vector<type> vec; \
+            for(int i = 0; i < 100; ++i) { \
+                vec.push_back((type)(((uint64_t)rand() << 33) ^ ((uint64_t)rand() << 11) ^ rand())); \
+            } \
+            vec.push_back(std::numeric_limits<type>::min()); \
+            vec.push_back(std::numeric_limits<type>::max()); \
+            vec.push_back(0); \
+            for(auto& v : vec) { \
+                ba.write_fun(v); \
+            } \
+            bool ok = true; \
+            for(auto& v : vec) { \
+                ok = ok && ba.read_fun() == v; \
+            } \
+            CHECK(ok); \
+            CHECK(ba.getReadSize() == 0); \
+        } \
+    }
+
+void test_roundtrip() {
+    XX(int8_t, writeFint8, readFint8);
+    XX(uint8_t, writeFuint8, readFuint8);
+    XX(int16_t, writeFint16, readFint16);
+    XX(uint16_t, writeFuint16, readFuint16);
+    XX(int32_t, writeFint32, readFint32);
+    XX(uint32_t, writeFuint32, readFuint32);
+    XX(int64_t, writeFint64, readFint64);
+    XX(uint64_t, writeFuint64, readFuint64);
+    XX(int32_t, writeInt32, readInt32);
+    XX(uint32_t, writeUint32, readUint32);
+    XX(int64_t, writeInt64, readInt64);
+    XX(uint64_t, writeUint64, readUint64);
+    XX(float, writeFloat, readFloat);
+    XX(double, writeDouble, readDouble);
+}
+
+#undef XX
+
+/**
+ * @brief 编码格式: 字节序和varint/zigzag
+ */
+void test_encoding() {
+    gameserver::ByteArray ba;
+    ba.writeFuint32(0x01020304);
+    CHECK(ba.toHexString() == "01 02 03 04 ");
+    ba.clear();
+    ba.setIsLittleEndian(true);
+    ba.writeFuint32(0x01020304);
+    CHECK(ba.toHexString() == "04 03 02 01 ");
+    ba.clear();
+    ba.writeUint32(300);
+    ba.writeInt32(-1);
+    ba.writeInt32(1);
+    ba.writeInt64(-64);
+    CHECK(ba.toHexString() == "ac 02 01 02 7f ");
+    ba.clear();
+    ba.writeStringF16("ab");
+    ba.writeStringVint("c");
+    CHECK(ba.toString() == std::string("\x02\x00" "ab" "\x01" "c", 6));
+}
+
+void test_string() {
+    gameserver::ByteArray ba(5);
+    std::string big(10000, 'x');
+    for(size_t i = 0; i < big.size(); ++i) {
+        big[i] = 'a' + i % 26;
+    }
+    ba.writeStringF16("hello");
+    ba.writeStringF32("");
+    ba.writeStringF64(big);
+    ba.writeStringVint(big);
+    ba.writeStringWithoutLength("tail");
+    CHECK(ba.readStringF16() == "hello");
+    CHECK(ba.readStringF32() == "");
+    CHECK(ba.readStringF64() == big);
+    CHECK(ba.readStringVint() == big);
+    CHECK(ba.toString() == "tail");
+}
+
+/**
+ * @brief 数据不够时抛出异常且不消费
+ */
+void test_underflow() {
+    gameserver::ByteArray ba(4);
+    ba.writeFuint16(7);
+    bool thrown = false;
+    try {
+        ba.readFuint32();
+    } catch(std::out_of_range&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(ba.getReadSize() == 2);
+    CHECK(ba.readFuint16() == 7);
+
+    // 不完整的varint和字符串
+    ba.writeFuint8(0x80);
+    thrown = false;
+    try {
+        ba.readUint64();
+    } catch(std::out_of_range&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(ba.getReadSize() == 1);
+    ba.clear();
+    ba.writeUint32(10);
+    ba.writeStringWithoutLength("abc");
+    thrown = false;
+    try {
+        ba.readStringVint();
+    } catch(std::out_of_range&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(ba.getReadSize() == 4);
+
+    // 超长的varint
+    ba.clear();
+    for(int i = 0; i < 6; ++i) {
+        ba.writeFuint8(0xff);
+    }
+    thrown = false;
+    try {
+        ba.readUint32();
+    } catch(std::out_of_range&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+/**
+ * @brief peek, skip, 占位回填包头长度
+ */
+void test_peek_skip_write_at() {
+    gameserver::ByteArray ba(3);
+    ba.writeFuint32(0);
+    ba.writeStringWithoutLength("payload!");
+    uint32_t len = ba.getReadSize() - 4;
+    uint32_t be = htobe32(len);
+    ba.writeAt(0, &be, sizeof(be));
+    char buf[8];
+    ba.peek(buf, 7, 4);
+    CHECK(std::string(buf, 7) == "payload");
+    CHECK(ba.getReadSize() == 12);
+    CHECK(ba.readFuint32() == 8);
+    ba.skip(3);
+    CHECK(ba.toString() == "load!");
+    bool thrown = false;
+    try {
+        ba.skip(6);
+    } catch(std::out_of_range&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    ba.skip(5);
+    CHECK(ba.getReadSize() == 0);
+}
+
+/**
+ * @brief writev写出, readv读入, 不经过中间缓冲
+ */
+void test_iovec() {
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    gameserver::ByteArray out(64);
+    for(int i = 0; i < 1000; ++i) {
+        out.writeInt32(i * 37 - 5000);
+    }
+    size_t total = out.getReadSize();
+    std::vector<iovec> iovs;
+    CHECK(out.getReadBuffers(iovs) == total);
+    CHECK(iovs.size() > 1);
+    size_t n = 0;
+    for(auto& iov : iovs) {
+        n += iov.iov_len;
+    }
+    CHECK(n == total);
+    // 跳过开头再取
+    std::vector<iovec> part;
+    CHECK(out.getReadBuffers(part, 10, total - 5) == 5);
+    CHECK(writev(fds[1], &iovs[0], iovs.size()) == (ssize_t)total);
+    out.skip(total);
+    CHECK(out.getReadSize() == 0);
+
+    gameserver::ByteArray in(100);
+    in.writeFuint8(1);
+    size_t got = 0;
+    while(got < total) {
+        std::vector<iovec> wiovs;
+        in.getWriteBuffers(wiovs, 333);
+        ssize_t rt = readv(fds[0], &wiovs[0], wiovs.size());
+        CHECK(rt > 0);
+        if(rt <= 0) {
+            break;
+        }
+        in.commit(rt);
+        got += rt;
+    }
+    CHECK(in.getReadSize() == total + 1);
+    CHECK(in.readFuint8() == 1);
+    bool ok = true;
+    for(int i = 0; i < 1000; ++i) {
+        ok = ok && in.readInt32() == i * 37 - 5000;
+    }
+    CHECK(ok);
+    bool thrown = false;
+    try {
+        std::vector<iovec> wiovs;
+        in.getWriteBuffers(wiovs, 10);
+        in.commit(100000);
+    } catch(std::out_of_range&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @brief 读完的块释放, 默认大小的块回到线程缓存再被复用
+ */
+void test_blocks() {
+    size_t cached = gameserver::ByteArray::GetCachedBlocks();
+    {
+        gameserver::ByteArray ba;
+        std::string s(gameserver::ByteArray::DEFAULT_BLOCK_SIZE * 4, 'z');
+        ba.writeStringWithoutLength(s);
+        CHECK(ba.getCapacity() == gameserver::ByteArray::DEFAULT_BLOCK_SIZE * 4);
+        ba.skip(gameserver::ByteArray::DEFAULT_BLOCK_SIZE * 2 + 1);
+        CHECK(ba.getCapacity() == gameserver::ByteArray::DEFAULT_BLOCK_SIZE * 2);
+        // 读空后保留写入块
+        ba.skip(ba.getReadSize());
+        CHECK(ba.getCapacity() == gameserver::ByteArray::DEFAULT_BLOCK_SIZE);
+        ba.writeFuint64(42);
+        CHECK(ba.getCapacity() == gameserver::ByteArray::DEFAULT_BLOCK_SIZE);
+        CHECK(ba.readFuint64() == 42);
+    }
+    size_t after = gameserver::ByteArray::GetCachedBlocks();
+    // 分配时先用缓存里的块
+    CHECK(after == std::max<size_t>(cached, 4));
+    {
+        gameserver::ByteArray ba;
+        ba.writeFuint8(1);
+        CHECK(gameserver::ByteArray::GetCachedBlocks() == after - 1);
+    }
+    CHECK(gameserver::ByteArray::GetCachedBlocks() == after);
+}
+
+int main(int argc, char** argv) {
+    srand(12345);
+    test_roundtrip();
+    test_encoding();
+    test_string();
+    test_underflow();
+    test_peek_skip_write_at();
+    test_iovec();
+    test_blocks();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Log/log.h"
+#include "Fiber/fiber.h"
+#include "Fiber/stack.h"
+#include "Thread/thread.h"
+#include "check.h"
+#include "capture_log.h"
+
+void test_switch() {
+    std::vector<int> order;
+    CHECK(gameserver::Fiber::GetFiberId() == 0);
+    gameserver::Fiber::ptr fiber(new gameserver::Fiber([&order]() {
+        // 跨切换保存的局部变量
+        double d = 1.5;
+        long n = 7;
+        order.push_back(1);
+        gameserver::Fiber::YieldToHold();
+        order.push_back(3);
+        gameserver::Fiber::YieldToReady();
+        order.push_back(5 + (int)(d * 2) + n - 10);
+    }));
+    CHECK(fiber->getId() > 0);
+    CHECK(fiber->getState() == gameserver::Fiber::INIT);
+    fiber->swapIn();
+    CHECK(fiber->getState() == gameserver::Fiber::HOLD);
+    order.push_back(2);
+    fiber->swapIn();
+    CHECK(fiber->getState() == gameserver::Fiber::READY);
+    order.push_back(4);
+    fiber->swapIn();
+    CHECK(fiber->getState() == gameserver::Fiber::TERM);
+    CHECK((order == std::vector<int>{1, 2, 3, 4, 5}));
+    // 主协程
+    CHECK(gameserver::Fiber::GetThis()->getId() == 0);
+    CHECK(gameserver::Fiber::GetFiberId() == 0);
+}
+
+void test_nested() {
+    std::vector<std::string> order;
+    gameserver::Fiber::ptr inner(new gameserver::Fiber([&order]() {
+        order.push_back("inner1");
+        gameserver::Fiber::YieldToHold();
+        order.push_back("inner2");
+    }));
+    gameserver::Fiber::ptr outer(new gameserver::Fiber([&order, inner]() {
+        order.push_back("outer1");
+        inner->swapIn();
+        // inner让出后回到outer, 不是主协程
+        order.push_back("outer2");
+        gameserver::Fiber::YieldToHold();
+        inner->swapIn();
+        order.push_back("outer3");
+    }));
+    outer->swapIn();
+    order.push_back("main1");
+    outer->swapIn();
+    order.push_back("main2");
+    CHECK(outer->getState() == gameserver::Fiber::TERM);
+    CHECK(inner->getState() == gameserver::Fiber::TERM);
+    CHECK((order == std::vector<std::string>{"outer1", "inner1", "outer2", "main1", "inner2", "outer3", "main2"}));
+}
+
+void test_exception_reset() {
+    int runs = 0;
+    gameserver::Fiber::ptr fiber(new gameserver::Fiber([]() {
+        throw std::runtime_error("boom");
+    }));
+    fiber->swapIn();
+    CHECK(fiber->getState() == gameserver::Fiber::EXCEPT);
+    fiber->reset([&runs]() {
+        ++runs;
+    });
+    CHECK(fiber->getState() == gameserver::Fiber::INIT);
+    fiber->swapIn();
+    CHECK(fiber->getState() == gameserver::Fiber::TERM);
+    CHECK(runs == 1);
+}
+
+/**
+ * @brief 日志的%F是当前协程id
+ */
+void test_log() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("fiber"));
+    CaptureLogHandler::ptr handler(new CaptureLogHandler);
+    handler->setFormatter(gameserver::LogFormatter::ptr(new gameserver::LogFormatter("%F %m")));
+    logger->addHandler(handler);
+    GAMESERVER_LOG_INFO(logger) << "main";
+    gameserver::Fiber::ptr fiber(new gameserver::Fiber([logger]() {
+        GAMESERVER_LOG_INFO(logger) << "in fiber";
+    }));
+    fiber->swapIn();
+    std::vector<std::string> lines = handler->lines();
+    CHECK(lines.size() == 2);
+    if(lines.size() == 2) {
+        CHECK(lines[0] == "0 main");
+        CHECK(lines[1] == std::to_string(fiber->getId()) + " in fiber");
+    }
+}
+
+/**
+ * @brief 创建销毁协程复用栈, 不再mmap
+ */
+void test_pool() {
+    uint64_t before_total = gameserver::Fiber::TotalFibers();
+    {
+        gameserver::Fiber::ptr warm(new gameserver::Fiber([]() {}));
+        warm->swapIn();
+    }
+    uint64_t maps = gameserver::StackPool::GetMapCount();
+    int sum = 0;
+    for(int i = 0; i < 10000; ++i) {
+        gameserver::Fiber::ptr fiber(new gameserver::Fiber([&sum, i]() {
+            sum += i % 3;
+        }));
+        fiber->swapIn();
+    }
+    CHECK(gameserver::StackPool::GetMapCount() == maps);
+    CHECK(gameserver::Fiber::TotalFibers() == before_total);
+
+    // 同时存在多个时各自分配, 释放后进缓存
+    std::vector<gameserver::Fiber::ptr> fibers;
+    for(int i = 0; i < 64; ++i) {
+        fibers.push_back(gameserver::Fiber::ptr(new gameserver::Fiber([]() {})));
+    }
+    size_t mapped = gameserver::StackPool::GetMapped();
+    fibers.clear();
+    CHECK(gameserver::StackPool::GetMapped() == mapped);
+    // 其他大小单独分配
+    gameserver::Fiber::ptr big(new gameserver::Fiber([]() {}, 1 << 20));
+    CHECK(big->getStackSize() == (1 << 20));
+    CHECK(gameserver::StackPool::GetMapped() == mapped + 1);
+}
+
+/**
+ * @brief 在别的线程上跑协程, 每个线程有自己的主协程
+ */
+void test_threads() {
+    std::vector<gameserver::Thread::ptr> threads;
+    std::vector<int> results(4, 0);
+    for(int t = 0; t < 4; ++t) {
+        threads.push_back(gameserver::Thread::ptr(new gameserver::Thread([t, &results]() {
+            int count = 0;
+            gameserver::Fiber::ptr fiber(new gameserver::Fiber([&count]() {
+                for(int i = 0; i < 1000; ++i) {
+                    ++count;
+                    gameserver::Fiber::YieldToHold();
+                }
+            }));
+            while(fiber->getState() != gameserver::Fiber::TERM) {
+                fiber->swapIn();
+            }
+            results[t] = count;
+        }, "fiber_" + std::to_string(t))));
+    }
+    for(auto& t : threads) {
+        t->join();
+    }
+    CHECK((results == std::vector<int>(4, 1000)));
+}
+
+static int recurse(int n) {
+    volatile char buf[1024];
+    buf[0] = (char)n;
+    return n <= 0 ? buf[0] : recurse(n - 1) + buf[0];
+}
+
+/**
+ * @brief 栈溢出碰到保护页, 进程收到SIGSEGV
+ */
+void test_guard_page() {
+    pid_t pid = fork();
+    if(pid == 0) {
+        gameserver::Fiber::ptr fiber(new gameserver::Fiber([]() {
+            recurse(1000);
+        }, 64 * 1024));
+        fiber->swapIn();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+}
+
+int main(int argc, char** argv) {
+    test_switch();
+    test_nested();
+    test_exception_reset();
+    test_log();
+    test_pool();
+    test_threads();
+    test_guard_page();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "Log/log.h"
+#include "Log/flight_recorder.h"
+#include "check.h"
+#include "capture_log.h"
+
+static std::string file_path(const char* name) {
+    return "/tmp/gameserver_" + std::to_string(getpid()) + "_" + name;
+}
+
+static std::vector<std::string> read_lines(const std::string& path) {
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while(std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+/**
+ * @brief 被Logger过滤掉的DEBUG日志也被记录, 环满后只保留最近的
+ */
+void test_record_filtered() {
+    std::string path = file_path("flight.log");
+    gameserver::FlightRecorder::SetDumpPath(path);
+
+    gameserver::Logger::ptr logger(new gameserver::Logger("flight"));
+    CaptureLogHandler::ptr handler(new CaptureLogHandler);
+    logger->addHandler(handler);
+    logger->setLevel(gameserver::LogLevel::ERROR);
+
+    for(int i = 0; i < 1100; ++i) {
+        GAMESERVER_LOG_DEBUG(logger) << "debug " << i;
+    }
+    GAMESERVER_LOG_FMT_INFO(logger, "info %d", 7);
+    CHECK(handler->count() == 0);
+
+    CHECK(gameserver::FlightRecorder::Dump("test") == 1024);
+    std::vector<std::string> lines = read_lines(path);
+    CHECK(lines.size() == 1025);
+    if(lines.size() == 1025) {
+        CHECK(lines[0].find("=== flight recorder dump: test at ") == 0);
+        // 最早的77条已被覆盖
+        CHECK(lines[1].find("\t[DEBUG]\t") != std::string::npos);
+        CHECK(lines[1].find("test_flight_recorder.cc:") != std::string::npos);
+        CHECK(lines[1].substr(lines[1].size() - 9) == "\tdebug 77");
+        CHECK(lines[1023].substr(lines[1023].size() - 11) == "\tdebug 1099");
+        CHECK(lines[1024].find("\t[INFO]\t") != std::string::npos);
+        CHECK(lines[1024].substr(lines[1024].size() - 7) == "\tinfo 7");
+        // 时间格式 YYYY-mm-dd HH:MM:SS.uuuuuu
+        CHECK(lines[1][4] == '-' && lines[1][10] == ' ' && lines[1][19] == '.' && lines[1][26] == '\t');
+    }
+    unlink(path.c_str());
+}
+
+/**
+ * @brief 超长消息截断, FATAL自动转储
+ */
+void test_fatal() {
+    std::string path = file_path("flight_fatal.log");
+    gameserver::FlightRecorder::SetDumpPath(path);
+    gameserver::Logger::ptr logger(new gameserver::Logger("flight_fatal"));
+    CaptureLogHandler::ptr handler(new CaptureLogHandler);
+    logger->addHandler(handler);
+
+    GAMESERVER_LOG_DEBUG(logger) << std::string(1000, 'x');
+    GAMESERVER_LOG_FATAL(logger) << "boom";
+    CHECK(handler->count() == 2);
+    std::vector<std::string> lines = read_lines(path);
+    CHECK(lines.size() >= 3);
+    if(lines.size() >= 3) {
+        CHECK(lines[0].find("=== flight recorder dump: FATAL") == 0);
+        std::string& big = lines[lines.size() - 2];
+        CHECK(big.find(std::string(gameserver::FlightRecorder::MESSAGE_SIZE, 'x') + "...") != std::string::npos);
+        CHECK(lines.back().find("\t[FATAL]\t") != std::string::npos);
+        CHECK(lines.back().substr(lines.back().size() - 5) == "\tboom");
+    }
+    unlink(path.c_str());
+}
+
+/**
+ * @brief 每个线程有自己的环, 转储包含所有线程
+ */
+void test_threads() {
+    std::string path = file_path("flight_threads.log");
+    gameserver::FlightRecorder::SetDumpPath(path);
+    gameserver::Logger::ptr logger(new gameserver::Logger("flight_threads"));
+    logger->setLevel(gameserver::LogLevel::ERROR);
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.push_back(std::thread([logger, t]() {
+            for(int i = 0; i < 10; ++i) {
+                GAMESERVER_LOG_DEBUG(logger) << "thread " << t << " line " << i;
+            }
+        }));
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    gameserver::FlightRecorder::Dump();
+    std::vector<std::string> lines = read_lines(path);
+    for(int t = 0; t < 4; ++t) {
+        int found = 0;
+        std::string tag = "\tthread " + std::to_string(t) + " line ";
+        for(auto& l : lines) {
+            if(l.find(tag) != std::string::npos) {
+                ++found;
+            }
+        }
+        CHECK(found == 10);
+    }
+    unlink(path.c_str());
+}
+
+/**
+ * @brief 子进程abort, 信号处理函数转储后按原方式退出
+ */
+void test_signal() {
+    std::string path = file_path("flight_signal.log");
+    pid_t pid = fork();
+    if(pid == 0) {
+        gameserver::FlightRecorder::SetDumpPath(path);
+        gameserver::FlightRecorder::InstallSignalHandler();
+        gameserver::Logger::ptr logger(new gameserver::Logger("flight_signal"));
+        logger->setLevel(gameserver::LogLevel::ERROR);
+        GAMESERVER_LOG_DEBUG(logger) << "last words";
+        abort();
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    std::vector<std::string> lines = read_lines(path);
+    CHECK(lines.size() >= 2);
+    if(lines.size() >= 2) {
+        CHECK(lines[0].find("=== flight recorder dump: SIGABRT") == 0);
+        CHECK(lines.back().substr(lines.back().size() - 11) == "\tlast words");
+    }
+    unlink(path.c_str());
+}
+
+/**
+ * @brief 递归到栈溢出, n从1开始时永远不返回
+ */
+static int recurse(int n) {
+    volatile char buf[1024];
+    buf[0] = (char)n;
+    return n > 0 ? recurse(n + 1) + buf[0] : 0;
+}
+
+/**
+ * @brief 子进程里另一个线程栈溢出, 该线程领取环时设置的备用信号栈让处理函数能转储
+ */
+void test_stack_overflow() {
+    std::string path = file_path("flight_overflow.log");
+    pid_t pid = fork();
+    if(pid == 0) {
+        gameserver::FlightRecorder::SetDumpPath(path);
+        gameserver::FlightRecorder::InstallSignalHandler();
+        gameserver::Logger::ptr logger(new gameserver::Logger("flight_overflow"));
+        logger->setLevel(gameserver::LogLevel::ERROR);
+        std::thread t([logger]() {
+            GAMESERVER_LOG_DEBUG(logger) << "going deep";
+            recurse(1);
+        });
+        t.join();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+    std::vector<std::string> lines = read_lines(path);
+    CHECK(lines.size() >= 2);
+    if(lines.size() >= 2) {
+        CHECK(lines[0].find("=== flight recorder dump: SIGSEGV") == 0);
+    }
+    // fork前父进程各线程的环也在转储里, 不一定是最后一行
+    bool found = false;
+    for(auto& line : lines) {
+        if(line.size() >= 11 && line.substr(line.size() - 11) == "\tgoing deep") {
+            found = true;
+        }
+    }
+    CHECK(found);
+    unlink(path.c_str());
+}
+
+/**
+ * @brief 关闭后不再记录, 宏不创建事件
+ */
+void test_disable() {
+    gameserver::FlightRecorder::Disable();
+    CHECK(!gameserver::FlightRecorder::IsEnabled(gameserver::LogLevel::FATAL));
+    gameserver::Logger::ptr logger(new gameserver::Logger("flight_off"));
+    logger->setLevel(gameserver::LogLevel::ERROR);
+    int evaluated = 0;
+    GAMESERVER_LOG_DEBUG(logger) << ++evaluated;
+    CHECK(evaluated == 0);
+    gameserver::FlightRecorder::Enable();
+}
+
+/**
+ * @brief 被过滤的日志只进记录器的耗时, 以及记录本身的耗时
+ */
+void test_speed() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("flight_speed"));
+    logger->setLevel(gameserver::LogLevel::ERROR);
+    const int n = 1000000;
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < n; ++i) {
+        GAMESERVER_LOG_DEBUG(logger) << "player " << i << " moved";
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    gameserver::LogEvent event(logger, __FILE__, __LINE__, 0, 1, 0, time(0), "");
+    event.getSS() << "player 12345 moved to 1.5 zone north";
+    auto rbegin = std::chrono::steady_clock::now();
+    for(int i = 0; i < n; ++i) {
+        gameserver::FlightRecorder::Record(gameserver::LogLevel::DEBUG, event);
+    }
+    auto rend = std::chrono::steady_clock::now();
+    std::cout << "filtered debug line: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / n
+              << " ns, record only: "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(rend - rbegin).count() / n
+              << " ns" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    gameserver::FlightRecorder::Enable(gameserver::LogLevel::DEBUG, 1024);
+    test_record_filtered();
+    test_fatal();
+    test_threads();
+    test_signal();
+    test_stack_overflow();
+    test_disable();
+    test_speed();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
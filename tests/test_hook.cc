@@ -0,0 +1,308 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "Log/log.h"
+#include "Fiber/iomanager.h"
+#include "Fiber/hook.h"
+#include "Fiber/fd_manager.h"
+#include "Util/util.h"
+#include "check.h"
+
+/**
+ * @brief 在回环地址上监听, 返回端口
+ */
+static int listen_local(int& port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    listen(fd, 128);
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+static int connect_local(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if(connect(fd, (sockaddr*)&addr, sizeof(addr))) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief 单线程里的多个协程同时sleep, 总时间接近一次sleep
+ */
+void test_sleep() {
+    std::atomic<int> done {0};
+    uint64_t begin = gameserver::GetMonotonicMS();
+    {
+        gameserver::IOManager iom(1, false, "hooksleep");
+        iom.setHookEnable(true);
+        iom.start();
+        for(int i = 0; i < 10; ++i) {
+            iom.schedule([&done, i]() {
+                if(i % 2) {
+                    usleep(100 * 1000);
+                } else {
+                    timespec ts = {0, 100 * 1000 * 1000};
+                    nanosleep(&ts, nullptr);
+                }
+                ++done;
+            });
+        }
+        iom.stop();
+    }
+    uint64_t used = gameserver::GetMonotonicMS() - begin;
+    CHECK(done == 10);
+    CHECK(used >= 100);
+    CHECK(used < 500);
+    // 没有启用hook的线程是真正的sleep
+    CHECK(!gameserver::IsHookEnable());
+    begin = gameserver::GetMonotonicMS();
+    usleep(20 * 1000);
+    CHECK(gameserver::GetMonotonicMS() - begin >= 20);
+}
+
+/**
+ * @brief 单线程上按阻塞方式写的服务端和客户端协程互相等待, 不会卡住线程
+ */
+void test_echo() {
+    const int N = 20;
+    std::atomic<int> echoed {0};
+    {
+        gameserver::IOManager iom(1, false, "hookecho");
+        iom.setHookEnable(true);
+        iom.start();
+        iom.schedule([&iom, &echoed, N]() {
+            int port = 0;
+            int lfd = listen_local(port);
+            for(int i = 0; i < N; ++i) {
+                iom.schedule([port, &echoed]() {
+                    int fd = connect_local(port);
+                    if(fd < 0) {
+                        return;
+                    }
+                    char buf[64];
+                    for(int k = 0; k < 10; ++k) {
+                        std::string msg = "ping" + std::to_string(k);
+                        send(fd, msg.c_str(), msg.size(), 0);
+                        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                        if(n == (ssize_t)msg.size() && std::string(buf, n) == msg) {
+                            ++echoed;
+                        }
+                    }
+                    close(fd);
+                });
+            }
+            for(int i = 0; i < N; ++i) {
+                int cfd = accept(lfd, nullptr, nullptr);
+                if(cfd < 0) {
+                    break;
+                }
+                iom.schedule([cfd]() {
+                    char buf[64];
+                    ssize_t n;
+                    while((n = read(cfd, buf, sizeof(buf))) > 0) {
+                        write(cfd, buf, n);
+                    }
+                    close(cfd);
+                });
+            }
+            close(lfd);
+        });
+        iom.stop();
+    }
+    CHECK(echoed == N * 10);
+}
+
+/**
+ * @brief SO_RCVTIMEO超时返回EAGAIN, connect/读写的阻塞属性按用户设置报告
+ */
+void test_timeout_nonblock() {
+    int port = 0;
+    int lfd = listen_local(port);
+    std::atomic<uint64_t> waited {0};
+    std::atomic<int> recv_errno {0};
+    std::atomic<bool> flags_ok {false};
+    std::atomic<int> nonblock_errno {0};
+    {
+        gameserver::IOManager iom(1, false, "hooktimeout");
+        iom.setHookEnable(true);
+        iom.start();
+        iom.schedule([port, &waited, &recv_errno, &flags_ok, &nonblock_errno]() {
+            int fd = connect_local(port);
+            timeval tv = {0, 100 * 1000};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            char buf[16];
+            uint64_t begin = gameserver::GetMonotonicMS();
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            waited = gameserver::GetMonotonicMS() - begin;
+            recv_errno = n == -1 ? errno : 0;
+
+            // 系统层面是非阻塞的, 用户看到的是阻塞
+            int fl = fcntl(fd, F_GETFL);
+            bool ok = !(fl & O_NONBLOCK);
+            fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+            ok = ok && (fcntl(fd, F_GETFL) & O_NONBLOCK);
+            flags_ok = ok;
+            begin = gameserver::GetMonotonicMS();
+            n = recv(fd, buf, sizeof(buf), 0);
+            nonblock_errno = n == -1 && gameserver::GetMonotonicMS() - begin < 50 ? errno : 0;
+            close(fd);
+        });
+        iom.stop();
+    }
+    CHECK(recv_errno == EAGAIN);
+    CHECK(waited >= 100);
+    CHECK(waited < 1000);
+    CHECK(flags_ok);
+    CHECK(nonblock_errno == EAGAIN);
+    close(lfd);
+}
+
+/**
+ * @brief 启用hook的线程上创建的socket(系统非阻塞)交给普通线程, 仍是阻塞语义
+ */
+void test_cross_thread() {
+    int port = 0;
+    int lfd = listen_local(port);
+    std::atomic<int> fd {-1};
+    {
+        gameserver::IOManager iom(1, false, "hookcross");
+        iom.setHookEnable(true);
+        iom.start();
+        iom.schedule([port, &fd]() {
+            fd = connect_local(port);
+        });
+        iom.stop();
+    }
+    CHECK(fd >= 0);
+    int cfd = accept(lfd, nullptr, nullptr);
+    std::thread peer([cfd]() {
+        usleep(50 * 1000);
+        write(cfd, "late", 4);
+    });
+    char buf[16];
+    uint64_t begin = gameserver::GetMonotonicMS();
+    ssize_t n = read(fd, buf, sizeof(buf));
+    CHECK(n == 4);
+    CHECK(gameserver::GetMonotonicMS() - begin >= 40);
+    peer.join();
+
+    // 记录的超时在普通线程上也生效
+    timeval tv = {0, 50 * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    n = read(fd, buf, sizeof(buf));
+    CHECK(n == -1 && errno == EAGAIN);
+    close(fd);
+    close(cfd);
+    close(lfd);
+}
+
+/**
+ * @brief 未hook的线程上创建的socket没有上下文, 在hook的协程里connect按原样阻塞连接
+ */
+void test_foreign_socket() {
+    int port = 0;
+    int lfd = listen_local(port);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(!gameserver::FdMgr::GetInstance()->get(fd));
+    std::atomic<int> rt {-2};
+    std::atomic<int> err {0};
+    {
+        gameserver::IOManager iom(1, false, "hookforeign");
+        iom.setHookEnable(true);
+        iom.start();
+        iom.schedule([fd, port, &rt, &err]() {
+            sockaddr_in addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(port);
+            rt = connect(fd, (sockaddr*)&addr, sizeof(addr));
+            err = errno;
+        });
+        iom.stop();
+    }
+    CHECK(rt == 0);
+    if(rt != 0) {
+        std::cout << "connect errno=" << err << std::endl;
+        close(fd);
+        close(lfd);
+        return;
+    }
+    int cfd = accept(lfd, nullptr, nullptr);
+    CHECK(cfd >= 0);
+    CHECK(write(fd, "ping", 4) == 4);
+    char buf[16];
+    CHECK(read(cfd, buf, sizeof(buf)) == 4);
+    close(fd);
+    close(cfd);
+    close(lfd);
+}
+
+/**
+ * @brief 关闭fd唤醒等在上面的协程, 返回EBADF
+ */
+void test_close_wakeup() {
+    int port = 0;
+    int lfd = listen_local(port);
+    std::atomic<int> read_errno {0};
+    {
+        gameserver::IOManager iom(1, false, "hookclose");
+        iom.setHookEnable(true);
+        iom.start();
+        iom.schedule([&iom, port, &read_errno]() {
+            int fd = connect_local(port);
+            iom.schedule([fd]() {
+                usleep(50 * 1000);
+                close(fd);
+            });
+            char buf[16];
+            ssize_t n = read(fd, buf, sizeof(buf));
+            read_errno = n == -1 ? errno : 0;
+        });
+        iom.stop();
+    }
+    CHECK(read_errno == EBADF);
+    close(lfd);
+}
+
+int main(int argc, char** argv) {
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::INFO);
+    test_sleep();
+    test_echo();
+    test_timeout_nonblock();
+    test_cross_thread();
+    test_foreign_socket();
+    test_close_wakeup();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,307 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+#include "Net/http_parser.h"
+#include "check.h"
+
+using namespace gameserver::http;
+
+/**
+ * @brief 按step字节一次喂给解析器, 每次都把已收数据整体挪到新的缓冲里(模拟接收缓冲整理)
+ */
+static HttpParser::Result feed(HttpParser& parser, std::string& data, size_t step, std::string& buf) {
+    HttpParser::Result rt = HttpParser::NEED_MORE;
+    size_t have = 0;
+    while(have < data.size()) {
+        have = std::min(data.size(), have + step);
+        // 换一块内存, 解析结果是偏移, 不受影响
+        std::string moved(buf.data(), buf.size());
+        moved.append(data, moved.size(), have - moved.size());
+        buf.swap(moved);
+        rt = parser.execute(&buf[0], buf.size());
+        if(rt != HttpParser::NEED_MORE) {
+            break;
+        }
+    }
+    return rt;
+}
+
+/**
+ * @brief 请求行, 头部, 查询参数; 整块和逐字节结果相同
+ */
+void test_request() {
+    std::string raw = "GET http://example.com/api/user?id=42&name=bob&flag#top HTTP/1.1\r\n"
+                      "Host: example.com\r\n"
+                      "X-Empty:\r\n"
+                      "User-Agent:   test/1.0  \r\n"
+                      "Content-Length: 5\r\n"
+                      "\r\n"
+                      "hello";
+    for(size_t step : {raw.size(), (size_t)1, (size_t)7}) {
+        HttpRequestParser parser;
+        std::string data = raw;
+        std::string buf;
+        CHECK(feed(parser, data, step, buf) == HttpParser::COMPLETE);
+        CHECK(parser.getConsumed() == raw.size());
+        const HttpRequest& req = parser.getRequest();
+        CHECK(req.getMethod() == HttpMethod::GET);
+        CHECK(req.getVersion() == 0x11);
+        CHECK(!req.isClose());
+        CHECK(req.getUri() == "http://example.com/api/user?id=42&name=bob&flag#top");
+        CHECK(req.getPath() == "/api/user");
+        CHECK(req.getQuery() == "id=42&name=bob&flag");
+        CHECK(req.getFragment() == "top");
+        CHECK(req.getParam("id") == "42");
+        CHECK(req.getParam("name") == "bob");
+        CHECK(req.getParam("flag").empty());
+        CHECK(req.getParam("none", "def") == "def");
+        CHECK(req.getHeaderCount() == 4);
+        CHECK(req.getHeader("host") == "example.com");
+        CHECK(req.getHeader("user-agent") == "test/1.0");
+        CHECK(req.hasHeader("X-Empty"));
+        CHECK(req.getHeader("x-empty").empty());
+        CHECK(req.getHeader(1).name == "X-Empty");
+        CHECK(req.getBody() == "hello");
+        CHECK(!req.isChunked());
+    }
+}
+
+/**
+ * @brief 流水线: 一块数据里多个请求, reset()后从getConsumed()继续
+ */
+void test_pipeline() {
+    std::string data = "\r\nGET /a HTTP/1.1\r\nHost: x\r\n\r\n"
+                       "POST /b HTTP/1.1\r\nContent-Length: 3\r\n\r\nabc"
+                       "HEAD /c HTTP/1.0\r\n\r\n"
+                       "GET /d HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n"
+                       "DELETE /e HTTP/1.1\r\nConnection: foo, close\r\n\r\n"
+                       "GET /f HTTP/1.1\r\n";
+    HttpRequestParser parser;
+    size_t pos = 0;
+    std::vector<std::string> paths;
+    std::vector<bool> closes;
+    while(true) {
+        HttpParser::Result rt = parser.execute(&data[pos], data.size() - pos);
+        if(rt != HttpParser::COMPLETE) {
+            CHECK(rt == HttpParser::NEED_MORE);
+            break;
+        }
+        paths.push_back(parser.getRequest().getPath().toString());
+        closes.push_back(parser.getRequest().isClose());
+        if(paths.size() == 2) {
+            CHECK(parser.getRequest().getMethod() == HttpMethod::POST);
+            CHECK(parser.getRequest().getBody() == "abc");
+        }
+        pos += parser.getConsumed();
+        parser.reset();
+    }
+    CHECK(paths.size() == 5);
+    CHECK(paths == std::vector<std::string>({"/a", "/b", "/c", "/d", "/e"}));
+    CHECK(closes == std::vector<bool>({false, false, true, false, true}));
+    CHECK(data.compare(pos, std::string::npos, "GET /f HTTP/1.1\r\n") == 0);
+}
+
+/**
+ * @brief chunked消息体原地解码, 扩展和trailer忽略
+ */
+void test_chunked() {
+    std::string raw = "POST /upload HTTP/1.1\r\n"
+                      "Transfer-Encoding: gzip, chunked\r\n"
+                      "\r\n"
+                      "5\r\nhello\r\n"
+                      "1;ext=1\r\n \r\n"
+                      "A\r\n0123456789\r\n"
+                      "0\r\n"
+                      "X-Trailer: 1\r\n"
+                      "\r\n"
+                      "GET /next HTTP/1.1\r\n\r\n";
+    for(size_t step : {raw.size(), (size_t)1, (size_t)3}) {
+        HttpRequestParser parser;
+        std::string data = raw;
+        std::string buf;
+        CHECK(feed(parser, data, step, buf) == HttpParser::COMPLETE);
+        const HttpRequest& req = parser.getRequest();
+        CHECK(req.isChunked());
+        CHECK(req.getBody() == "hello 0123456789");
+        CHECK(parser.getConsumed() == raw.find("GET /next"));
+    }
+
+    // 数据块后面不是CRLF
+    HttpRequestParser parser;
+    std::string bad = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabcd\r\n";
+    CHECK(parser.execute(&bad[0], bad.size()) == HttpParser::ERROR);
+    CHECK(parser.getError() == HttpStatus::BAD_REQUEST);
+}
+
+/**
+ * @brief 各种错误对应的状态
+ */
+void test_errors() {
+    struct Case {
+        const char* data;
+        HttpStatus status;
+    };
+    Case cases[] = {
+        {"GET / HTTP/1.1\r\n folded: x\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"GET / HTTP/1.1\r\nBad Name: x\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"GET / HTTP/1.1\r\nNoColon\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"GET / HTTP/1.1\r\nContent-Length: 1\r\nTransfer-Encoding: chunked\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"GET / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", HttpStatus::NOT_IMPLEMENTED},
+        {"BREW /pot HTTP/1.1\r\n\r\n", HttpStatus::NOT_IMPLEMENTED},
+        {"GET / HTTP/2.0\r\n\r\n", HttpStatus::HTTP_VERSION_NOT_SUPPORTED},
+        {"GET / FTP/1.1\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"GET /a b HTTP/1.1\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"GET HTTP/1.1\r\n\r\n", HttpStatus::BAD_REQUEST},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nxyz\r\n", HttpStatus::BAD_REQUEST},
+    };
+    for(auto& c : cases) {
+        HttpRequestParser parser;
+        std::string data = c.data;
+        HttpParser::Result rt = parser.execute(&data[0], data.size());
+        CHECK(rt == HttpParser::ERROR);
+        CHECK(parser.getError() == c.status);
+        if(rt != HttpParser::ERROR || parser.getError() != c.status) {
+            std::cout << "  case: " << c.data << " -> " << (int)parser.getError()
+                      << " " << parser.getErrorString() << std::endl;
+        }
+        // 出错后保持错误状态
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::ERROR);
+    }
+}
+
+/**
+ * @brief 大小限制
+ */
+void test_limits() {
+    HttpParser::Limits limits;
+    limits.maxHeaderSize = 64;
+    limits.maxHeaders = 2;
+    limits.maxBodySize = 10;
+
+    // 头部超长: 没有换行也能在超出时立即报错, 不用等整行
+    {
+        HttpRequestParser parser(limits);
+        std::string data = "GET / HTTP/1.1\r\nX-Long: " + std::string(60, 'a');
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::ERROR);
+        CHECK(parser.getError() == HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE);
+    }
+    {
+        HttpRequestParser parser(limits);
+        std::string data = "GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\nC: 3\r\n\r\n";
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::ERROR);
+        CHECK(parser.getError() == HttpStatus::REQUEST_HEADER_FIELDS_TOO_LARGE);
+    }
+    {
+        HttpRequestParser parser(limits);
+        std::string data = "POST / HTTP/1.1\r\nContent-Length: 11\r\n\r\n";
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::ERROR);
+        CHECK(parser.getError() == HttpStatus::PAYLOAD_TOO_LARGE);
+    }
+    {
+        HttpRequestParser parser(limits);
+        std::string data = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n6\r\nabcdef\r\n5\r\n";
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::ERROR);
+        CHECK(parser.getError() == HttpStatus::PAYLOAD_TOO_LARGE);
+    }
+    {
+        // 刚好在限制内
+        HttpRequestParser parser(limits);
+        std::string data = "POST / HTTP/1.1\r\nContent-Length: 10\r\n\r\n0123456789";
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::COMPLETE);
+        CHECK(parser.getRequest().getBody() == "0123456789");
+    }
+}
+
+/**
+ * @brief 响应解析: 定长, 没有消息体的状态, HEAD, 到连接关闭为止
+ */
+void test_response() {
+    {
+        HttpResponseParser parser;
+        std::string data = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nokHTTP/1.1 204 No Content\r\n\r\n"
+                           "HTTP/1.1 404 Not Found\r\nContent-Length: 3\r\n\r\nabc";
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::COMPLETE);
+        CHECK(parser.getResponse().getStatus() == HttpStatus::OK);
+        CHECK(parser.getResponse().getReason() == "OK");
+        CHECK(parser.getResponse().getBody() == "ok");
+        size_t pos = parser.getConsumed();
+        parser.reset();
+        CHECK(parser.execute(&data[pos], data.size() - pos) == HttpParser::COMPLETE);
+        CHECK(parser.getResponse().getStatus() == HttpStatus::NO_CONTENT);
+        CHECK(parser.getResponse().getBody().empty());
+        pos += parser.getConsumed();
+        parser.reset();
+        // HEAD的响应有Content-Length但没有消息体
+        parser.setHeadRequest(true);
+        CHECK(parser.execute(&data[pos], data.size() - pos) == HttpParser::COMPLETE);
+        CHECK(parser.getResponse().getStatus() == HttpStatus::NOT_FOUND);
+        CHECK(parser.getResponse().getBody().empty());
+        CHECK(data.size() - pos - parser.getConsumed() == 3);
+    }
+    {
+        HttpResponseParser parser;
+        std::string data = "HTTP/1.0 200\r\nServer: x\r\n\r\nuntil close";
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::NEED_MORE);
+        CHECK(parser.getResponse().getReason().empty());
+        CHECK(parser.finish(&data[0], data.size()) == HttpParser::COMPLETE);
+        CHECK(parser.getResponse().isClose());
+        CHECK(parser.getResponse().getBody() == "until close");
+    }
+    {
+        // 消息没收完连接就关了
+        HttpResponseParser parser;
+        std::string data = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nabc";
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::NEED_MORE);
+        CHECK(parser.finish(&data[0], data.size()) == HttpParser::ERROR);
+    }
+    {
+        HttpResponseParser parser;
+        std::string data = "HTTP/1.1 2x0 OK\r\n\r\n";
+        CHECK(parser.execute(&data[0], data.size()) == HttpParser::ERROR);
+    }
+}
+
+/**
+ * @brief 响应序列化后能被响应解析器读回
+ */
+void test_dump() {
+    HttpResponse rsp(0x11, false);
+    rsp.setStatus(HttpStatus::CREATED);
+    rsp.setHeader("Content-Type", "text/plain");
+    rsp.setHeader("content-type", "application/json");
+    rsp.setHeader("Content-Length", "999");
+    rsp.setBody("{\"a\":1}");
+    std::string s = rsp.toString();
+    CHECK(s == "HTTP/1.1 201 Created\r\ncontent-type: application/json\r\nContent-Length: 7\r\n\r\n{\"a\":1}"
+            || s == "HTTP/1.1 201 Created\r\nContent-Type: application/json\r\nContent-Length: 7\r\n\r\n{\"a\":1}");
+
+    HttpResponseParser parser;
+    CHECK(parser.execute(&s[0], s.size()) == HttpParser::COMPLETE);
+    CHECK(parser.getResponse().getStatus() == HttpStatus::CREATED);
+    CHECK(parser.getResponse().getHeader("CONTENT-TYPE") == "application/json");
+    CHECK(parser.getResponse().getBody() == "{\"a\":1}");
+    CHECK(!parser.getResponse().isClose());
+
+    rsp.reset(0x10, true);
+    rsp.setStatus(HttpStatus::NOT_MODIFIED);
+    CHECK(rsp.toString() == "HTTP/1.0 304 Not Modified\r\nConnection: close\r\n\r\n");
+}
+
+int main(int argc, char** argv) {
+    test_request();
+    test_pipeline();
+    test_chunked();
+    test_errors();
+    test_limits();
+    test_response();
+    test_dump();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,307 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <unistd.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "Log/log.h"
+#include "Net/http_server.h"
+#include "Util/util.h"
+#include "check.h"
+
+using namespace gameserver::http;
+
+/**
+ * @brief 普通线程上的阻塞客户端
+ */
+static int connect_local(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if(connect(fd, (sockaddr*)&addr, sizeof(addr))) {
+        close(fd);
+        return -1;
+    }
+    timeval tv = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+static void send_all(int fd, const std::string& data) {
+    size_t off = 0;
+    while(off < data.size()) {
+        ssize_t n = send(fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if(n <= 0) {
+            return;
+        }
+        off += n;
+    }
+}
+
+struct Reply {
+    int status;
+    std::string body;
+    bool close;
+    std::string server;
+};
+
+/**
+ * @brief 读n个响应, 连接关闭或超时时提前返回
+ * @param[out] eof 读完后连接是否已被对端关闭
+ */
+static std::vector<Reply> read_replies(int fd, size_t n, bool* eof = nullptr, bool head = false) {
+    std::vector<Reply> replies;
+    std::string buf;
+    size_t pos = 0;
+    HttpResponseParser parser;
+    parser.setHeadRequest(head);
+    char tmp[4096];
+    bool closed = false;
+    while(replies.size() < n) {
+        if(pos < buf.size()) {
+            HttpParser::Result rt = parser.execute(&buf[pos], buf.size() - pos);
+            if(rt == HttpParser::COMPLETE) {
+                const HttpResponseView& rsp = parser.getResponse();
+                Reply r{(int)rsp.getStatus(), rsp.getBody().toString(), rsp.isClose(),
+                        rsp.getHeader("Server").toString()};
+                replies.push_back(r);
+                pos += parser.getConsumed();
+                parser.reset();
+                parser.setHeadRequest(head);
+                continue;
+            }
+            if(rt == HttpParser::ERROR) {
+                break;
+            }
+        }
+        ssize_t rt = recv(fd, tmp, sizeof(tmp), 0);
+        if(rt <= 0) {
+            closed = rt == 0;
+            break;
+        }
+        buf.append(tmp, rt);
+    }
+    if(eof) {
+        if(!closed && replies.size() == n) {
+            closed = recv(fd, tmp, sizeof(tmp), 0) == 0;
+        }
+        *eof = closed;
+    }
+    return replies;
+}
+
+static std::string get(const std::string& path, const std::string& extra = "") {
+    return "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n" + extra + "\r\n";
+}
+
+static HttpServer::ptr make_server(gameserver::IOManager* iom) {
+    HttpServer::ptr server(new HttpServer(true, iom, iom));
+    auto sd = server->getServletDispatch();
+    sd->addServlet("/hello", [](const HttpRequest& req, HttpResponse& rsp) {
+        rsp.setBody("hello " + req.getParam("name", "world").toString());
+        return 0;
+    });
+    sd->addServlet("/echo", [](const HttpRequest& req, HttpResponse& rsp) {
+        rsp.setHeader("Content-Type", "application/octet-stream");
+        rsp.setBody(req.getBody().toString());
+        return 0;
+    });
+    sd->addServlet("/bye", [](const HttpRequest& req, HttpResponse& rsp) {
+        rsp.setClose(true);
+        rsp.setBody("bye");
+        return 0;
+    });
+    sd->addServlet("/throw", [](const HttpRequest& req, HttpResponse& rsp) -> int32_t {
+        throw std::runtime_error("servlet failed");
+    });
+    sd->addGlobServlet("/api/*", [](const HttpRequest& req, HttpResponse& rsp) {
+        rsp.setBody("api:" + req.getPath().toString());
+        return 0;
+    });
+    return server;
+}
+
+/**
+ * @brief 路由, 长连接, 流水线, 错误处理
+ */
+void test_server() {
+    gameserver::IOManager iom(2, false, "http");
+    iom.setHookEnable(true);
+    iom.start();
+    HttpServer::ptr server = make_server(&iom);
+    CHECK(server->bind("127.0.0.1", 0));
+    CHECK(server->getPort() != 0);
+    CHECK(server->start());
+    int port = server->getPort();
+
+    // 同一个连接上的多个请求
+    {
+        int fd = connect_local(port);
+        CHECK(fd >= 0);
+        send_all(fd, get("/hello"));
+        auto r = read_replies(fd, 1);
+        CHECK(r.size() == 1 && r[0].status == 200 && r[0].body == "hello world" && !r[0].close);
+        CHECK(r.size() == 1 && r[0].server == "gameserver/1.0");
+        send_all(fd, get("/hello?name=bob"));
+        r = read_replies(fd, 1);
+        CHECK(r.size() == 1 && r[0].body == "hello bob");
+        send_all(fd, get("/missing"));
+        r = read_replies(fd, 1);
+        CHECK(r.size() == 1 && r[0].status == 404);
+        send_all(fd, get("/api/v1/items"));
+        r = read_replies(fd, 1);
+        CHECK(r.size() == 1 && r[0].body == "api:/api/v1/items");
+        // 分几次发一个请求
+        std::string req = "POST /echo HTTP/1.1\r\nContent-Length: 11\r\n\r\nhello there";
+        for(size_t i = 0; i < req.size(); i += 9) {
+            send_all(fd, req.substr(i, 9));
+            usleep(1000);
+        }
+        r = read_replies(fd, 1);
+        CHECK(r.size() == 1 && r[0].body == "hello there");
+        close(fd);
+    }
+
+    // 流水线: 一次发出, 按顺序回来; 最后一个要求关闭
+    {
+        int fd = connect_local(port);
+        std::string batch;
+        for(int i = 0; i < 50; ++i) {
+            batch += get("/hello?name=" + std::to_string(i));
+        }
+        batch += "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n2\r\nde\r\n0\r\n\r\n";
+        batch += get("/bye");
+        batch += get("/hello");
+        send_all(fd, batch);
+        bool eof = false;
+        auto r = read_replies(fd, 52, &eof);
+        CHECK(r.size() == 52);
+        bool ordered = r.size() == 52;
+        for(int i = 0; ordered && i < 50; ++i) {
+            ordered = r[i].body == "hello " + std::to_string(i);
+        }
+        CHECK(ordered);
+        CHECK(r.size() == 52 && r[50].body == "abcde");
+        CHECK(r.size() == 52 && r[51].body == "bye" && r[51].close);
+        // /bye之后的请求不处理
+        CHECK(eof);
+        close(fd);
+    }
+
+    // HTTP/1.0默认短连接, HEAD没有消息体
+    {
+        int fd = connect_local(port);
+        send_all(fd, "HEAD /hello HTTP/1.0\r\n\r\n");
+        bool eof = false;
+        auto r = read_replies(fd, 1, &eof, true);
+        CHECK(r.size() == 1 && r[0].status == 200 && r[0].body.empty() && r[0].close);
+        CHECK(eof);
+        close(fd);
+    }
+
+    // 格式错误返回400并关闭, 处理器抛异常返回500
+    {
+        int fd = connect_local(port);
+        send_all(fd, get("/hello") + "GET / HTTP/1.1\r\nBad Header\r\n\r\n");
+        bool eof = false;
+        auto r = read_replies(fd, 2, &eof);
+        CHECK(r.size() == 2 && r[0].status == 200 && r[1].status == 400 && r[1].close);
+        CHECK(eof);
+        close(fd);
+
+        fd = connect_local(port);
+        send_all(fd, get("/throw"));
+        r = read_replies(fd, 1, &eof);
+        CHECK(r.size() == 1 && r[0].status == 500);
+        CHECK(eof);
+        close(fd);
+    }
+
+    // Expect: 100-continue先回100再等消息体
+    {
+        int fd = connect_local(port);
+        send_all(fd, "POST /echo HTTP/1.1\r\nContent-Length: 4\r\nExpect: 100-continue\r\n\r\n");
+        auto r = read_replies(fd, 1);
+        CHECK(r.size() == 1 && r[0].status == 100);
+        send_all(fd, "data");
+        r = read_replies(fd, 1);
+        CHECK(r.size() == 1 && r[0].status == 200 && r[0].body == "data");
+        close(fd);
+    }
+
+    // stop()唤醒空闲的长连接和accept
+    int idle = connect_local(port);
+    send_all(idle, get("/hello"));
+    CHECK(read_replies(idle, 1).size() == 1);
+    // 前面客户端关闭的连接由服务端协程异步清理
+    for(int i = 0; i < 100 && server->getConnectionCount() != 1; ++i) {
+        usleep(10 * 1000);
+    }
+    CHECK(server->getConnectionCount() == 1);
+    server->stop();
+    bool eof = false;
+    read_replies(idle, 0, &eof);
+    CHECK(eof);
+    close(idle);
+    iom.stop();
+    CHECK(server->getConnectionCount() == 0);
+}
+
+/**
+ * @brief 长连接空闲超时关闭
+ */
+void test_idle_timeout() {
+    gameserver::IOManager iom(1, false, "httpidle");
+    iom.setHookEnable(true);
+    iom.start();
+    HttpServer::ptr server = make_server(&iom);
+    server->setRecvTimeout(100);
+    CHECK(server->bind("127.0.0.1", 0));
+    CHECK(server->start());
+    int fd = connect_local(server->getPort());
+    send_all(fd, get("/hello"));
+    CHECK(read_replies(fd, 1).size() == 1);
+    uint64_t begin = gameserver::GetMonotonicMS();
+    bool eof = false;
+    read_replies(fd, 0, &eof);
+    uint64_t used = gameserver::GetMonotonicMS() - begin;
+    CHECK(eof);
+    CHECK(used >= 80);
+    CHECK(used < 1000);
+    close(fd);
+    server->stop();
+    iom.stop();
+}
+
+/**
+ * @brief 没有启用hook的调度器不能启动
+ */
+void test_requires_hook() {
+    gameserver::IOManager iom(1, false, "httpnohook");
+    iom.start();
+    HttpServer::ptr server(new HttpServer(true, &iom, &iom));
+    CHECK(server->bind("127.0.0.1", 0));
+    CHECK(!server->start());
+    CHECK(!server->bind("not an ip", 0));
+    iom.stop();
+}
+
+int main(int argc, char** argv) {
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::FATAL);
+    test_server();
+    test_idle_timeout();
+    test_requires_hook();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,283 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "Log/log.h"
+#include "Fiber/iomanager.h"
+#include "Util/util.h"
+#include "check.h"
+
+static void set_nonblock(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+/**
+ * @brief 在当前协程里等fd就绪后读, 没有数据时让出
+ */
+static ssize_t fiber_read(int fd, void* buf, size_t len) {
+    while(true) {
+        ssize_t n = read(fd, buf, len);
+        if(n >= 0 || errno != EAGAIN) {
+            return n;
+        }
+        gameserver::IOManager::GetThis()->addEvent(fd, gameserver::IOManager::READ);
+        gameserver::Fiber::YieldToHold();
+    }
+}
+
+static ssize_t fiber_write(int fd, const void* buf, size_t len) {
+    while(true) {
+        ssize_t n = write(fd, buf, len);
+        if(n >= 0 || errno != EAGAIN) {
+            return n;
+        }
+        gameserver::IOManager::GetThis()->addEvent(fd, gameserver::IOManager::WRITE);
+        gameserver::Fiber::YieldToHold();
+    }
+}
+
+/**
+ * @brief 回调方式等待读事件
+ */
+void test_callback() {
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    set_nonblock(fds[0]);
+    std::atomic<int> called {0};
+    {
+        gameserver::IOManager iom(2, false, "iocb");
+        iom.start();
+        CHECK(iom.addEvent(fds[0], gameserver::IOManager::READ, [&called]() {
+            ++called;
+        }) == 0);
+        CHECK(iom.getPendingEventCount() == 1);
+        CHECK(write(fds[1], "x", 1) == 1);
+        iom.stop();
+        CHECK(iom.getPendingEventCount() == 0);
+    }
+    CHECK(called == 1);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @brief 协程等待读事件, 就绪后被重新调度; 读写两个事件可以同时注册
+ */
+void test_fiber_wait() {
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    set_nonblock(fds[0]);
+    set_nonblock(fds[1]);
+    std::string got;
+    {
+        gameserver::IOManager iom(1, false, "iofiber");
+        iom.start();
+        int rfd = fds[0];
+        int wfd = fds[1];
+        iom.schedule([rfd, &got]() {
+            char buf[16];
+            ssize_t n = fiber_read(rfd, buf, sizeof(buf));
+            if(n > 0) {
+                got.assign(buf, n);
+            }
+        });
+        iom.schedule([wfd]() {
+            // 让读协程先挂起
+            usleep(10000);
+            fiber_write(wfd, "hello", 5);
+        });
+        iom.stop();
+    }
+    CHECK(got == "hello");
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @brief cancelEvent触发等待者, delEvent不触发
+ */
+void test_cancel() {
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    set_nonblock(fds[0]);
+    std::atomic<int> cancelled {0};
+    std::atomic<int> deleted {0};
+    {
+        gameserver::IOManager iom(1, false, "iocancel");
+        iom.start();
+        CHECK(iom.addEvent(fds[0], gameserver::IOManager::READ, [&cancelled]() {
+            ++cancelled;
+        }) == 0);
+        CHECK(iom.cancelEvent(fds[0], gameserver::IOManager::READ));
+        CHECK(!iom.cancelEvent(fds[0], gameserver::IOManager::READ));
+
+        CHECK(iom.addEvent(fds[0], gameserver::IOManager::READ, [&deleted]() {
+            ++deleted;
+        }) == 0);
+        CHECK(iom.delEvent(fds[0], gameserver::IOManager::READ));
+        CHECK(iom.getPendingEventCount() == 0);
+        iom.stop();
+    }
+    CHECK(cancelled == 1);
+    CHECK(deleted == 0);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * @brief 指定线程的任务能唤醒在epoll里休眠的那个线程
+ */
+void test_tickle() {
+    gameserver::IOManager iom(3, false, "iotickle");
+    iom.setSpinCount(0);
+    iom.start();
+    std::vector<int> ids = iom.getThreadIds();
+    std::atomic<int> wrong {0};
+    std::atomic<int> count {0};
+    for(int r = 0; r < 300; ++r) {
+        for(int i = 0; i < 100 && !iom.hasIdleThreads(); ++i) {
+            usleep(100);
+        }
+        int tid = ids[r % 3];
+        iom.schedule([tid, &wrong, &count]() {
+            if((int)gameserver::GetThreadId() != tid) {
+                ++wrong;
+            }
+            ++count;
+        }, tid);
+        while(count != r + 1) {
+            usleep(10);
+        }
+    }
+    iom.stop();
+    CHECK(count == 300);
+    CHECK(wrong == 0);
+}
+
+/**
+ * @brief 单线程上的回环echo: 一个accept协程, 每个连接一个协程, 客户端也是协程
+ */
+void test_echo(int clients) {
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    CHECK(bind(lfd, (sockaddr*)&addr, sizeof(addr)) == 0);
+    CHECK(listen(lfd, 1024) == 0);
+    socklen_t len = sizeof(addr);
+    getsockname(lfd, (sockaddr*)&addr, &len);
+    set_nonblock(lfd);
+
+    std::atomic<int> accepted {0};
+    std::atomic<int> echoed {0};
+    {
+        gameserver::IOManager iom(1, false, "ioecho");
+        iom.start();
+        iom.schedule([lfd, clients, &accepted]() {
+            while(accepted < clients) {
+                int fd = accept(lfd, nullptr, nullptr);
+                if(fd < 0) {
+                    if(errno == EAGAIN) {
+                        gameserver::IOManager::GetThis()->addEvent(lfd, gameserver::IOManager::READ);
+                        gameserver::Fiber::YieldToHold();
+                    }
+                    continue;
+                }
+                ++accepted;
+                set_nonblock(fd);
+                gameserver::IOManager::GetThis()->schedule([fd]() {
+                    char buf[64];
+                    ssize_t n;
+                    while((n = fiber_read(fd, buf, sizeof(buf))) > 0) {
+                        fiber_write(fd, buf, n);
+                    }
+                    close(fd);
+                });
+            }
+        });
+        for(int i = 0; i < clients; ++i) {
+            iom.schedule([addr, i, &echoed]() {
+                int fd = socket(AF_INET, SOCK_STREAM, 0);
+                set_nonblock(fd);
+                int rt = connect(fd, (const sockaddr*)&addr, sizeof(addr));
+                if(rt < 0 && errno == EINPROGRESS) {
+                    gameserver::IOManager::GetThis()->addEvent(fd, gameserver::IOManager::WRITE);
+                    gameserver::Fiber::YieldToHold();
+                }
+                std::string msg = "ping " + std::to_string(i);
+                fiber_write(fd, msg.c_str(), msg.size());
+                char buf[64];
+                std::string got;
+                while(got.size() < msg.size()) {
+                    ssize_t n = fiber_read(fd, buf, sizeof(buf));
+                    if(n <= 0) {
+                        break;
+                    }
+                    got.append(buf, n);
+                }
+                if(got == msg) {
+                    ++echoed;
+                }
+                close(fd);
+            });
+        }
+        iom.stop();
+    }
+    close(lfd);
+    CHECK(accepted == clients);
+    CHECK(echoed == clients);
+}
+
+/**
+ * @brief use_caller且只有调用线程时, 在stop()里处理IO
+ */
+void test_use_caller() {
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+    set_nonblock(fds[0]);
+    std::atomic<int> called {0};
+    {
+        gameserver::IOManager iom(1, true, "iocaller");
+        CHECK(gameserver::IOManager::GetThis() == &iom);
+        iom.start();
+        iom.addEvent(fds[0], gameserver::IOManager::READ, [&called]() {
+            ++called;
+        });
+        int wfd = fds[1];
+        iom.schedule([wfd]() {
+            CHECK(write(wfd, "x", 1) == 1);
+        });
+        iom.stop();
+    }
+    CHECK(called == 1);
+    CHECK(gameserver::Scheduler::GetThis() == nullptr);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main(int argc, char** argv) {
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::INFO);
+    test_callback();
+    test_fiber_wait();
+    test_cancel();
+    test_tickle();
+    test_echo(500);
+    test_use_caller();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Log/log.h"
+#include "check.h"
+
+/**
+ * @brief 接受已格式化日志的Handler, 记下收到的缓冲和刷新次数
+ */
+class RecordLogHandler : public gameserver::LogHandler {
+public:
+    typedef std::shared_ptr<RecordLogHandler> ptr;
+    RecordLogHandler() {
+        m_writer = true;
+    }
+
+    void log(const std::shared_ptr<gameserver::Logger>& logger, gameserver::LogLevel::Level level, const gameserver::LogEvent& event) override {
+        ++m_logs;
+        gameserver::LogStream buf;
+        getFormatter()->format(buf, logger, level, event);
+        write(level, buf.data(), buf.size());
+    }
+
+    void write(gameserver::LogLevel::Level level, const char* data, size_t len) override {
+        gameserver::LogHandler::MutexType::Lock lock(m_mutex);
+        m_data.push_back(data);
+        m_lines.push_back(std::string(data, len));
+        if(needFlush(level, len)) {
+            ++m_flushes;
+        }
+    }
+
+    std::vector<const char*> m_data;
+    std::vector<std::string> m_lines;
+    int m_logs = 0;
+    int m_flushes = 0;
+};
+
+/**
+ * @brief 数sync次数的streambuf
+ */
+class CountSyncBuf : public std::stringbuf {
+public:
+    int sync() override {
+        ++m_syncs;
+        return std::stringbuf::sync();
+    }
+    int m_syncs = 0;
+};
+
+/**
+ * @brief 使用同一格式器的Handler只格式化一次
+ */
+void test_format_once() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("once"));
+    RecordLogHandler::ptr a(new RecordLogHandler);
+    RecordLogHandler::ptr b(new RecordLogHandler);
+    RecordLogHandler::ptr c(new RecordLogHandler);
+    c->setFormatter(gameserver::LogFormatter::ptr(new gameserver::LogFormatter("%p %m%n")));
+    logger->addHandler(a);
+    logger->addHandler(b);
+    logger->addHandler(c);
+
+    GAMESERVER_LOG_INFO(logger) << "hello";
+    CHECK(a->m_data.size() == 1 && b->m_data.size() == 1 && c->m_data.size() == 1);
+    // a和b拿到的是同一块缓冲
+    CHECK(a->m_data[0] == b->m_data[0]);
+    CHECK(a->m_lines[0] == b->m_lines[0]);
+    CHECK(a->m_data[0] != c->m_data[0]);
+    CHECK(c->m_lines[0] == "INFO hello\n");
+    CHECK(a->m_logs == 0 && b->m_logs == 0 && c->m_logs == 0);
+
+    // 换了Logger的格式器后跟着变, 有自己格式器的不变
+    logger->setFormatter("%m%n");
+    GAMESERVER_LOG_INFO(logger) << "again";
+    CHECK(a->m_lines.size() == 2 && a->m_lines[1] == "again\n");
+    CHECK(b->m_lines.size() == 2 && b->m_lines[1] == "again\n");
+    CHECK(c->m_lines.size() == 2 && c->m_lines[1] == "INFO again\n");
+
+    // Handler自己的级别仍然生效
+    c->setLevel(gameserver::LogLevel::ERROR);
+    GAMESERVER_LOG_INFO(logger) << "filtered";
+    CHECK(a->m_lines.size() == 3 && c->m_lines.size() == 2);
+}
+
+void test_flush_policy() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("flush"));
+    logger->setFormatter("%m%n");
+    RecordLogHandler::ptr per_line(new RecordLogHandler);
+    per_line->setFlushPolicy(gameserver::FlushPolicy::PerLine());
+    RecordLogHandler::ptr bytes(new RecordLogHandler);
+    bytes->setFlushPolicy(gameserver::FlushPolicy::Buffered(100, 0));
+    RecordLogHandler::ptr warn(new RecordLogHandler);
+    warn->setFlushPolicy(gameserver::FlushPolicy::Buffered(0, 0, gameserver::LogLevel::WARN));
+    logger->addHandler(per_line);
+    logger->addHandler(bytes);
+    logger->addHandler(warn);
+
+    // 每条10字节
+    for(int i = 0; i < 25; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "123456789";
+    }
+    CHECK(per_line->m_flushes == 25);
+    CHECK(bytes->m_flushes == 2);
+    CHECK(warn->m_flushes == 0);
+    GAMESERVER_LOG_WARN(logger) << "123456789";
+    CHECK(warn->m_flushes == 1);
+    GAMESERVER_LOG_ERROR(logger) << "123456789";
+    CHECK(warn->m_flushes == 2);
+}
+
+/**
+ * @brief %n不再刷新输出流
+ */
+void test_newline_no_flush() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("newline"));
+    gameserver::LogEvent event(logger, __FILE__, __LINE__, 0, 1, 0, time(0), "newline");
+    event.getSS() << "msg";
+    CountSyncBuf sb;
+    std::ostream os(&sb);
+    // 运行期格式和编译期格式都试一下
+    gameserver::LogFormatter runtime("%p%T%m%n%n");
+    gameserver::LogFormatter fast(gameserver::LogFormatter::DEFAULT_PATTERN);
+    CHECK(!runtime.isStatic() && fast.isStatic());
+    runtime.format(os, logger, gameserver::LogLevel::INFO, event);
+    fast.format(os, logger, gameserver::LogLevel::INFO, event);
+    CHECK(sb.m_syncs == 0);
+    CHECK(sb.str().substr(0, 10) == "INFO\tmsg\n\n");
+}
+
+static uint64_t file_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+/**
+ * @brief 文件Handler默认策略: INFO攒着, WARN立即写出
+ */
+void test_file_default() {
+    std::string path = "/tmp/gameserver_" + std::to_string(getpid()) + "_flush.log";
+    gameserver::Logger::ptr logger(new gameserver::Logger("file"));
+    logger->setFormatter("%m%n");
+    gameserver::FileLogHandler::ptr file(new gameserver::FileLogHandler(path));
+    logger->addHandler(file);
+    for(int i = 0; i < 10; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "info line";
+    }
+    CHECK(file_size(path) == 0);
+    GAMESERVER_LOG_WARN(logger) << "warn line";
+    CHECK(file_size(path) == 10 * 10 + 10);
+    GAMESERVER_LOG_INFO(logger) << "info line";
+    file->flush();
+    CHECK(file_size(path) == 11 * 10 + 10);
+    unlink(path.c_str());
+}
+
+int main(int argc, char** argv) {
+    test_format_once();
+    test_flush_policy();
+    test_newline_no_flush();
+    test_file_default();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
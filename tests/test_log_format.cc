@@ -0,0 +1,137 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include "Log/log.h"
+#include "Log/log_format.h"
+#include "check.h"
+
+typedef gameserver::StaticLogFormatter<gameserver::logfmt::Level
+        , gameserver::logfmt::Tab, gameserver::logfmt::Elapse
+        , gameserver::logfmt::Char<'%'>, gameserver::logfmt::Char<' '>
+        , gameserver::logfmt::Message, gameserver::logfmt::NewLine> ShortFormat;
+
+static_assert(ShortFormat::Matches("%p%T%r%% %m%n"), "ShortFormat mismatch");
+static_assert(!ShortFormat::Matches("%p%T%r%% %m"), "ShortFormat must match whole pattern");
+
+static std::string strftime_local(const char* fmt, time_t t) {
+    struct tm tm;
+    localtime_r(&t, &tm);
+    char buf[128];
+    size_t n = strftime(buf, sizeof(buf), fmt, &tm);
+    return std::string(buf, n);
+}
+
+void test_timestamp() {
+    gameserver::TimestampFormat ms("%Y-%m-%d %H:%M:%S.%L");
+    gameserver::TimestampFormat us("%H:%M:%S.%f %z %%L");
+    gameserver::LogStream buf;
+    time_t now = time(0);
+
+    // 同一秒内只改毫秒/微秒数字
+    for(uint32_t usec : {0u, 7u, 123456u, 999999u}) {
+        buf.clear();
+        ms.format(buf, now, usec);
+        char sub[16];
+        snprintf(sub, sizeof(sub), ".%03u", usec / 1000);
+        CHECK(buf.str() == strftime_local("%Y-%m-%d %H:%M:%S", now) + sub);
+
+        buf.clear();
+        us.format(buf, now, usec);
+        snprintf(sub, sizeof(sub), ".%06u", usec);
+        CHECK(buf.str() == strftime_local("%H:%M:%S", now) + sub + strftime_local(" %z %%L", now));
+    }
+
+    // 跨秒/跨小时/跨天与localtime_r + strftime一致
+    gameserver::TimestampFormat full("%Y-%m-%d %H:%M:%S %z %Z %j %a");
+    for(int i = 0; i < 200000; ++i) {
+        time_t t = now + (time_t)i * 97;
+        buf.clear();
+        full.format(buf, t, 0);
+        if(buf.str() != strftime_local("%Y-%m-%d %H:%M:%S %z %Z %j %a", t)) {
+            CHECK(buf.str() == strftime_local("%Y-%m-%d %H:%M:%S %z %Z %j %a", t));
+            break;
+        }
+    }
+
+    // 运行期格式中的%d子格式
+    gameserver::Logger::ptr logger(new gameserver::Logger("ts"));
+    gameserver::LogEvent::ptr event(new gameserver::LogEvent(logger, __FILE__, __LINE__, 0, 1, 0, now, "ts", 45678));
+    gameserver::LogFormatter::ptr fmt(new gameserver::LogFormatter("%d{%H:%M:%S.%L}|%d{%f}%n"));
+    CHECK(fmt->format(logger, gameserver::LogLevel::INFO, *event) == strftime_local("%H:%M:%S", now) + ".045|045678\n");
+    std::cout << fmt->format(logger, gameserver::LogLevel::INFO, *event);
+}
+
+/**
+ * @brief 同样的输出操作在LogStream和std::ostringstream上结果一致
+ */
+#define CHECK_SAME_AS_OSTREAM(ops) \
+    do { \
+        gameserver::LogStream ls; \
+        std::ostringstream ss; \
+        ls ops; \
+        ss ops; \
+        if(ls.str() != ss.str()) { \
+            std::cout << "LogStream: " << ls.str() << " ostringstream: " << ss.str() << std::endl; \
+        } \
+        CHECK(ls.str() == ss.str()); \
+    } while(0)
+
+/**
+ * @brief LogStream的输出格式: 默认与std::ostringstream相同, 支持常用操纵符, clear()恢复默认格式
+ */
+void test_stream_format() {
+    CHECK_SAME_AS_OSTREAM(<< 3.5 << ' ' << 1.0 / 3 << ' ' << 1e20 << ' ' << 2.5f << ' ' << 123456789.0);
+    CHECK_SAME_AS_OSTREAM(<< true << ' ' << false << ' ' << 'x' << ' ' << -17 << ' ' << 42u);
+    CHECK_SAME_AS_OSTREAM(<< std::setprecision(3) << 3.14159 << ' ' << 2.0f / 3);
+    CHECK_SAME_AS_OSTREAM(<< std::fixed << std::setprecision(2) << 3.14159 << ' ' << 1e6);
+    CHECK_SAME_AS_OSTREAM(<< std::scientific << 1234.5 << std::defaultfloat << ' ' << 1234.5);
+    CHECK_SAME_AS_OSTREAM(<< std::hex << 255 << ' ' << std::showbase << 255 << std::dec << ' ' << 255);
+    CHECK_SAME_AS_OSTREAM(<< std::setw(6) << 42 << '|' << std::setfill('0') << std::setw(4) << 7 << '|' << 7);
+    CHECK_SAME_AS_OSTREAM(<< std::left << std::setw(5) << "ab" << '|' << std::boolalpha << true);
+
+    // 格式状态跟随同一个LogStream, clear()后恢复默认
+    gameserver::LogStream ls;
+    ls << std::hex << 255;
+    ls.clear();
+    ls << 255 << ' ' << 0.1 + 0.2;
+    CHECK(ls.str() == "255 0.3");
+
+    // std::endl只换行, std::flush和std::ends不输出, 格式状态不受影响
+    ls.clear();
+    ls << 1 << std::endl << std::hex << 255 << std::flush << std::ends << std::endl << 2.5;
+    CHECK(ls.str() == "1\nff\n2.5");
+}
+
+int main(int argc, char** argv) {
+    test_timestamp();
+    test_stream_format();
+
+    gameserver::Logger::ptr logger(new gameserver::Logger("format"));
+    gameserver::LogEvent::ptr event(new gameserver::LogEvent(logger, __FILE__, __LINE__, 1234, 42, 7, time(0), "worker"));
+    event->getSS() << "hello " << 3.5 << " " << -17;
+
+    // 默认格式走编译期格式, 与运行期逐项解析的结果一致
+    gameserver::LogFormatter::ptr fast(new gameserver::LogFormatter(gameserver::LogFormatter::DEFAULT_PATTERN));
+    gameserver::LogFormatter::ptr slow(new gameserver::LogFormatter("%d%T%t%T%N%T%F%T[%p]%T[%c]%T%f:%l%T%m%n"));
+    CHECK(fast->isStatic());
+    CHECK(!slow->isStatic());
+    std::string a = fast->format(logger, gameserver::LogLevel::WARN, *event);
+    std::string b = slow->format(logger, gameserver::LogLevel::WARN, *event);
+    CHECK(a == b);
+    std::cout << a << b;
+
+    gameserver::LogFormatter::ptr sfast = ShortFormat::Create("%p%T%r%% %m%n");
+    gameserver::LogFormatter::ptr sslow(new gameserver::LogFormatter("%p%T%r%% %m%n"));
+    CHECK(sfast->isStatic());
+    a = sfast->format(logger, gameserver::LogLevel::ERROR, *event);
+    b = sslow->format(logger, gameserver::LogLevel::ERROR, *event);
+    CHECK(a == b);
+    CHECK(a == "ERROR\t1234% hello 3.5 -17\n");
+    std::cout << a;
+
+    // 与类型列表不一致的模板退回运行期解析
+    gameserver::LogFormatter::ptr fallback = ShortFormat::Create("%m%n");
+    CHECK(!fallback->isStatic());
+    CHECK(fallback->format(logger, gameserver::LogLevel::INFO, *event) == "hello 3.5 -17\n");
+    return s_failed ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include "Log/log.h"
+#include "Log/log_json.h"
+#include "check.h"
+#include "capture_log.h"
+
+static std::string escape(const std::string& str) {
+    gameserver::LogStream buf;
+    gameserver::json::Escape(buf, str.data(), str.size());
+    return buf.str();
+}
+
+/**
+ * @brief 各实现与逐字节实现结果一致
+ */
+void test_find_escape() {
+    std::cout << "impl: " << gameserver::json::GetImpl() << std::endl;
+    srand(1);
+    std::vector<char> buf(200);
+    for(int round = 0; round < 20000; ++round) {
+        size_t n = rand() % buf.size();
+        for(size_t i = 0; i < n; ++i) {
+            // 多数是普通字符, 包括非ASCII字节
+            buf[i] = (char)(0x20 + rand() % 0xe0);
+            if(buf[i] == '"' || buf[i] == '\\') {
+                buf[i] = 'a';
+            }
+        }
+        if(n && rand() % 4) {
+            static const char specials[] = {'"', '\\', '\n', '\0', 0x1f, 0x01};
+            buf[rand() % n] = specials[rand() % sizeof(specials)];
+        }
+        size_t expect = gameserver::json::FindEscapeScalar(&buf[0], n);
+        CHECK(gameserver::json::FindEscapeSSE2(&buf[0], n) == expect);
+        if(gameserver::json::HasAVX2()) {
+            CHECK(gameserver::json::FindEscapeAVX2(&buf[0], n) == expect);
+        }
+        CHECK(gameserver::json::FindEscape(&buf[0], n) == expect);
+    }
+    // 0x7f和高位字节不转义
+    std::string high = "\x7f\x80\xff\xe4\xb8\xad";
+    CHECK(gameserver::json::FindEscape(high.data(), high.size()) == high.size());
+}
+
+void test_escape() {
+    CHECK(escape("") == "");
+    CHECK(escape("plain text") == "plain text");
+    CHECK(escape("a\"b") == "a\\\"b");
+    CHECK(escape("back\\slash") == "back\\\\slash");
+    CHECK(escape("tab\tnl\ncr\r") == "tab\\tnl\\ncr\\r");
+    CHECK(escape(std::string("nul\0x", 5)) == "nul\\u0000x");
+    CHECK(escape("\x1f\b\f") == "\\u001f\\b\\f");
+    CHECK(escape("中文") == "中文");
+    std::string longstr(100, 'x');
+    longstr[70] = '"';
+    CHECK(escape(longstr) == std::string(70, 'x') + "\\\"" + std::string(29, 'x'));
+}
+
+void test_format() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("json"));
+    CaptureLogHandler::ptr handler(new CaptureLogHandler);
+    handler->setFormatter(gameserver::JsonLogFormat::Create());
+    logger->addHandler(handler);
+    CHECK(handler->getFormatter()->isStatic());
+
+    int line = __LINE__ + 1;
+    GAMESERVER_LOG_FIELDS_INFO(logger).with("uid", 42).with("name", "a\"b").with("ok", true)
+        .with("ratio", 0.5).with("neg", -3).with("str", std::string("s")) << "say \"hi\"\n" << 1;
+    GAMESERVER_LOG_WARN(logger) << "plain";
+    std::vector<std::string> lines = handler->lines();
+    CHECK(lines.size() == 2);
+    if(lines.size() == 2) {
+        const std::string& l = lines[0];
+        std::cout << l;
+        CHECK(l.compare(0, 9, "{\"time\":\"") == 0);
+        // 2026-10-16T12:00:00.123456
+        CHECK(l.size() > 35 && l[19] == 'T' && l[28] == '.' && l[35] == '"');
+        CHECK(l.find(",\"level\":\"INFO\",\"logger\":\"json\",\"file\":\"") != std::string::npos);
+        CHECK(l.find(",\"line\":" + std::to_string(line) + ",\"thread\":") != std::string::npos);
+        CHECK(l.find(",\"thread_name\":\"") != std::string::npos);
+        CHECK(l.find(",\"fiber\":") != std::string::npos);
+        CHECK(l.find(",\"msg\":\"say \\\"hi\\\"\\n1\""
+                     ",\"uid\":42,\"name\":\"a\\\"b\",\"ok\":true,\"ratio\":0.5,\"neg\":-3,\"str\":\"s\"}\n")
+              != std::string::npos);
+        const std::string& w = lines[1];
+        CHECK(w.find("\"level\":\"WARN\"") != std::string::npos);
+        CHECK(w.size() > 15 && w.compare(w.size() - 15, 15, "\"msg\":\"plain\"}\n") == 0);
+    }
+
+    // 文本格式忽略字段
+    handler->clear();
+    handler->setFormatter(gameserver::LogFormatter::ptr(new gameserver::LogFormatter("%p %m")));
+    GAMESERVER_LOG_FIELDS_ERROR(logger).with("uid", 1) << "text";
+    lines = handler->lines();
+    CHECK(lines.size() == 1 && lines[0] == "ERROR text");
+
+    // 被过滤时字段参数不求值
+    int evaluated = 0;
+    logger->setLevel(gameserver::LogLevel::ERROR);
+    GAMESERVER_LOG_FIELDS_INFO(logger).with("n", ++evaluated) << "filtered";
+    CHECK(evaluated == 0);
+}
+
+void test_logger_pattern() {
+    // Logger用"json"模板时也走JSON格式
+    gameserver::Logger::ptr logger(new gameserver::Logger("json2"));
+    CaptureLogHandler::ptr handler(new CaptureLogHandler);
+    logger->addHandler(handler);
+    logger->setFormatter(gameserver::LogFormatter::JSON_PATTERN);
+    GAMESERVER_LOG_FMT_INFO(logger, "%d\t%s", 7, "x");
+    std::vector<std::string> lines = handler->lines();
+    CHECK(lines.size() == 1);
+    if(lines.size() == 1) {
+        CHECK(lines[0].find("\"logger\":\"json2\"") != std::string::npos);
+        CHECK(lines[0].find("\"msg\":\"7\\tx\"}\n") != std::string::npos);
+    }
+}
+
+int main(int argc, char** argv) {
+    test_find_escape();
+    test_escape();
+    test_format();
+    test_logger_pattern();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
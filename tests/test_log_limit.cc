@@ -0,0 +1,160 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <unistd.h>
+#include "Log/log.h"
+#include "check.h"
+#include "capture_log.h"
+
+/**
+ * @brief 收到的日志里分开统计普通日志和汇总行里的丢弃条数
+ */
+struct Summary {
+    uint64_t lines = 0;
+    uint64_t suppressed = 0;
+    uint64_t reports = 0;
+    std::string last;
+    gameserver::LogLevel::Level lastLevel = gameserver::LogLevel::UNKNOW;
+};
+
+static Summary summarize(const CaptureLogHandler::ptr& handler) {
+    Summary s;
+    for(auto& r : handler->records()) {
+        unsigned long long n = 0;
+        if(sscanf(r.content.c_str(), "suppressed %llu messages", &n) == 1) {
+            s.suppressed += n;
+            ++s.reports;
+            s.last = r.content;
+            s.lastLevel = r.level;
+        } else {
+            ++s.lines;
+        }
+    }
+    return s;
+}
+
+static gameserver::Logger::ptr make_logger(const std::string& name, CaptureLogHandler::ptr& handler) {
+    gameserver::Logger::ptr logger(new gameserver::Logger(name));
+    handler.reset(new CaptureLogHandler);
+    logger->addHandler(handler);
+    return logger;
+}
+
+static void error_site(gameserver::Logger::ptr logger, int i) {
+    GAMESERVER_LOG_ERROR(logger) << "bad packet " << i;
+}
+
+/**
+ * @brief 1/N采样, 汇总行补上丢弃的条数
+ */
+void test_sample() {
+    CaptureLogHandler::ptr handler;
+    gameserver::Logger::ptr logger = make_logger("limit_sample", handler);
+    logger->setRateLimit(gameserver::LogLevel::ERROR, 0, 0, 10);
+    gameserver::LogSite::SetReportInterval(60 * 1000);
+    int evaluated = 0;
+    for(int i = 0; i < 1000; ++i) {
+        GAMESERVER_LOG_ERROR(logger) << "sampled " << ++evaluated;
+    }
+    Summary s = summarize(handler);
+    CHECK(s.lines == 100);
+    // 被丢弃的语句不求值
+    CHECK(evaluated == 100);
+    // 间隔内不汇总, 放行的日志前面不会每次都多一行
+    CHECK(s.reports == 0);
+    gameserver::LogSite::ReportAll();
+    CHECK(summarize(handler).reports == 0);
+    // 强制汇总剩下的, 一行, 用被丢弃日志的级别
+    gameserver::LogSite::ReportAll(true);
+    s = summarize(handler);
+    CHECK(s.reports == 1);
+    CHECK(s.suppressed == 900);
+    CHECK(s.last.find("suppressed 900 messages in the last ") == 0);
+    CHECK(s.lastLevel == gameserver::LogLevel::ERROR);
+    gameserver::LogSite::ReportAll(true);
+    CHECK(summarize(handler).reports == 1);
+    gameserver::LogSite::SetReportInterval(1000);
+
+    // 其他级别和其他日志器不受影响
+    for(int i = 0; i < 100; ++i) {
+        GAMESERVER_LOG_WARN(logger) << "warn";
+    }
+    CHECK(summarize(handler).lines == 200);
+    logger->clearRateLimit(gameserver::LogLevel::ERROR);
+    CHECK(!logger->hasRateLimit(gameserver::LogLevel::ERROR));
+    for(int i = 0; i < 100; ++i) {
+        GAMESERVER_LOG_ERROR(logger) << "unlimited";
+    }
+    CHECK(summarize(handler).lines == 300);
+}
+
+/**
+ * @brief 令牌桶: 风暴中只放行突发加上按速率补充的条数, 丢弃的条数每个间隔汇总一次
+ */
+void test_rate() {
+    CaptureLogHandler::ptr handler;
+    gameserver::Logger::ptr logger = make_logger("limit_rate", handler);
+    logger->setRateLimit(gameserver::LogLevel::ERROR, 100, 10);
+    gameserver::LogSite::SetReportInterval(20);
+    const int total = 200000;
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < total; ++i) {
+        error_site(logger, i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / 1e6;
+    Summary s = summarize(handler);
+    std::cout << "storm: " << total << " calls in " << sec << "s, passed " << s.lines
+              << ", " << (uint64_t)(sec * 1e9 / total) << " ns/call" << std::endl;
+    CHECK(s.lines >= 10);
+    CHECK(s.lines <= 10 + 100 * sec + 2);
+    CHECK(s.reports <= sec * 1000 / 20 + 2);
+
+    // 风暴结束后调用点不再有日志, 定时汇总输出剩下的丢弃条数
+    usleep(50 * 1000);
+    gameserver::LogSite::ReportAll();
+    s = summarize(handler);
+    CHECK(s.lines + s.suppressed == total);
+    CHECK(s.lastLevel == gameserver::LogLevel::ERROR);
+    gameserver::LogSite::SetReportInterval(1000);
+}
+
+/**
+ * @brief 多线程同时打同一个调用点, 条数不丢
+ */
+void test_threads() {
+    CaptureLogHandler::ptr handler;
+    gameserver::Logger::ptr logger = make_logger("limit_threads", handler);
+    logger->setRateLimit(gameserver::LogLevel::ERROR, 1000, 50, 3);
+    const int per_thread = 50000;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.push_back(std::thread([logger]() {
+            for(int i = 0; i < per_thread; ++i) {
+                error_site(logger, i);
+            }
+        }));
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    gameserver::LogSite::ReportAll(true);
+    Summary s = summarize(handler);
+    CHECK(s.lines + s.suppressed == 4 * per_thread);
+    CHECK(s.lines < 4 * per_thread / 3);
+}
+
+int main(int argc, char** argv) {
+    test_sample();
+    test_rate();
+    test_threads();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
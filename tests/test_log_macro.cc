@@ -0,0 +1,95 @@
+// 编译期去掉DEBUG日志
+#define GAMESERVER_LOG_MIN_LEVEL 2
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include "Log/log.h"
+#include "Util/util.h"
+#include "check.h"
+#include "capture_log.h"
+
+static int s_evaluated = 0;
+
+static int side_effect() {
+    ++s_evaluated;
+    return 42;
+}
+
+void test_macros() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("macro"));
+    CaptureLogHandler::ptr handler(new CaptureLogHandler);
+    logger->addHandler(handler);
+    logger->setLevel(gameserver::LogLevel::DEBUG);
+
+    // 低于编译期最低级别, 不求值也不输出
+    GAMESERVER_LOG_DEBUG(logger) << side_effect();
+    GAMESERVER_LOG_FMT_DEBUG(logger, "%d", side_effect());
+    CHECK(s_evaluated == 0);
+    CHECK(handler->count() == 0);
+
+    int line = __LINE__ + 1;
+    GAMESERVER_LOG_INFO(logger) << "hp=" << side_effect() << " name=" << std::string("knight");
+    CHECK(s_evaluated == 1);
+    std::vector<CaptureLogHandler::Record> records = handler->records();
+    CHECK(records.size() == 1);
+    if(records.size() == 1) {
+        const CaptureLogHandler::Record& r = records[0];
+        CHECK(r.level == gameserver::LogLevel::INFO);
+        CHECK(r.content == "hp=42 name=knight");
+        CHECK(r.file == __FILE__);
+        CHECK(r.line == line);
+        CHECK(r.threadId == gameserver::GetThreadId());
+        CHECK(r.time + 2 >= (uint64_t)time(0) && r.time <= (uint64_t)time(0));
+    }
+
+    GAMESERVER_LOG_FMT_ERROR(logger, "player %d lost %s", 7, "sword");
+    records = handler->records();
+    CHECK(records.size() == 2 && records[1].content == "player 7 lost sword");
+    CHECK(records.size() == 2 && records[1].level == gameserver::LogLevel::ERROR);
+
+    // 运行期级别过滤, 同样不求值
+    logger->setLevel(gameserver::LogLevel::WARN);
+    GAMESERVER_LOG_INFO(logger) << side_effect();
+    GAMESERVER_LOG_FMT_INFO(logger, "%d", side_effect());
+    CHECK(s_evaluated == 1);
+    CHECK(handler->count() == 2);
+    GAMESERVER_LOG_WARN(logger) << "warn";
+    CHECK(handler->count() == 3);
+
+    // 宏可以放在不带花括号的if/else里
+    bool flag = false;
+    if(flag)
+        GAMESERVER_LOG_FATAL(logger) << "not here";
+    else
+        GAMESERVER_LOG_FATAL(logger) << "here";
+    records = handler->records();
+    CHECK(records.size() == 4 && records[3].content == "here");
+}
+
+/**
+ * @brief 被过滤的日志语句的耗时
+ */
+void test_disabled_cost() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("macro"));
+    logger->setLevel(gameserver::LogLevel::ERROR);
+    const int n = 10000000;
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < n; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "player " << i << " moved";
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "disabled: " << (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / n
+              << " ns/line" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    test_macros();
+    test_disabled_cost();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <string>
+#include <unistd.h>
+#include "Log/log.h"
+#include "Log/async_log.h"
+#include "Log/log_metrics.h"
+#include "Util/metrics.h"
+#include "check.h"
+#include "capture_log.h"
+
+/**
+ * @brief 接受已格式化日志, 丢弃
+ */
+class NullLogHandler : public gameserver::LogHandler {
+public:
+    NullLogHandler() {
+        m_writer = true;
+    }
+    void log(const std::shared_ptr<gameserver::Logger>& logger, gameserver::LogLevel::Level level, const gameserver::LogEvent& event) override {
+        gameserver::LogStream buf;
+        getFormatter()->format(buf, logger, level, event);
+        write(level, buf.data(), buf.size());
+    }
+    void write(gameserver::LogLevel::Level level, const char* data, size_t len) override {}
+    std::string getName() const override { return "null";}
+};
+
+void test_counter() {
+    gameserver::ShardedCounter counter;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 8; ++t) {
+        threads.push_back(std::thread([&counter]() {
+            for(int i = 0; i < 100000; ++i) {
+                counter.add();
+            }
+        }));
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    CHECK(counter.get() == 800000);
+}
+
+void test_histogram() {
+    // 桶的上界单调递增, 每个值落在上界不小于它的桶里, 相对误差不超过1/8
+    uint64_t last = 0;
+    for(uint32_t b = 1; b < gameserver::LatencyHistogram::BUCKETS; ++b) {
+        uint64_t upper = gameserver::LatencyHistogram::BucketUpper(b);
+        CHECK(upper > last);
+        last = upper;
+    }
+    for(uint64_t v : {0ull, 1ull, 7ull, 8ull, 9ull, 100ull, 1000ull, 123456ull, 987654321ull}) {
+        uint32_t b = gameserver::LatencyHistogram::BucketOf(v);
+        uint64_t upper = gameserver::LatencyHistogram::BucketUpper(b);
+        CHECK(upper >= v);
+        CHECK(upper - v <= v / 8);
+    }
+
+    gameserver::LatencyHistogram hist;
+    for(uint64_t v = 1; v <= 10000; ++v) {
+        hist.record(v);
+    }
+    gameserver::HistogramSnapshot snap = hist.snapshot();
+    CHECK(snap.count == 10000);
+    CHECK(snap.max == 10000);
+    CHECK(snap.mean() == 5000);
+    uint64_t p50 = snap.percentile(0.5);
+    uint64_t p99 = snap.percentile(0.99);
+    CHECK(p50 >= 5000 && p50 <= 5000 + 5000 / 8);
+    CHECK(p99 >= 9900 && p99 <= 10000);
+    CHECK(snap.percentile(1.0) == 10000);
+}
+
+/**
+ * @brief Logger和Handler的计数
+ */
+void test_logger_metrics() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("metrics"));
+    std::shared_ptr<NullLogHandler> handler(new NullLogHandler);
+    logger->addHandler(handler);
+    logger->setFormatter("%m%n");
+    logger->setLevel(gameserver::LogLevel::INFO);
+
+    for(int i = 0; i < 1000; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "0123456789";
+    }
+    // 直接调用log()时被级别过滤的日志计入filtered
+    gameserver::LogEvent::ptr event = gameserver::LogEvent::Create(logger, __FILE__, __LINE__, 0, 1, 0, time(0), "");
+    for(int i = 0; i < 10; ++i) {
+        logger->log(gameserver::LogLevel::DEBUG, event);
+    }
+    // 限流丢弃计入dropped, 间隔内不输出suppressed汇总
+    logger->setRateLimit(gameserver::LogLevel::WARN, 0, 0, 10);
+    for(int i = 0; i < 100; ++i) {
+        GAMESERVER_LOG_WARN(logger) << "0123456789";
+    }
+
+    gameserver::LoggerMetrics m = logger->getMetrics();
+    CHECK(m.name == "metrics");
+    CHECK(m.accepted == 1010);
+    CHECK(m.filtered == 10);
+    CHECK(m.dropped == 90);
+    // 每16条取样计时一次
+    CHECK(m.formatTime.count >= 1010 / gameserver::METRICS_SAMPLE_EVERY - 1);
+    CHECK(m.formatTime.count <= 1010 / gameserver::METRICS_SAMPLE_EVERY + 1);
+    CHECK(m.handlers.size() == 1);
+    if(m.handlers.size() == 1) {
+        CHECK(m.handlers[0].name == "null");
+        CHECK(m.handlers[0].events == 1010);
+        CHECK(m.handlers[0].bytes >= 1010 * 11);
+        CHECK(m.handlers[0].writeTime.count > 0);
+    }
+}
+
+/**
+ * @brief 异步Handler的丢弃数和队列深度, 被包装的Handler也有计量
+ */
+void test_async_metrics() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("metrics_async"));
+    std::shared_ptr<NullLogHandler> inner(new NullLogHandler);
+    gameserver::AsyncLogHandler::ptr async(new gameserver::AsyncLogHandler(16, gameserver::AsyncLogHandler::DROP_NEWEST));
+    async->addHandler(inner);
+    logger->addHandler(async);
+    for(int i = 0; i < 10000; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "async " << i;
+    }
+    gameserver::LoggerMetrics m = logger->getMetrics();
+    CHECK(m.handlers.size() == 1);
+    if(m.handlers.size() == 1) {
+        CHECK(m.handlers[0].name == "async");
+        CHECK(m.handlers[0].events == 10000);
+        CHECK(m.handlers[0].queueDepth <= 16);
+    }
+    async->flush();
+    gameserver::LogHandlerMetrics am = async->getMetrics();
+    gameserver::LogHandlerMetrics im = inner->getMetrics();
+    CHECK(am.queueDepth == 0);
+    CHECK(im.events + am.dropped == 10000);
+    std::cout << "async: dropped " << am.dropped << ", written " << im.events << std::endl;
+}
+
+/**
+ * @brief 定期输出到专用日志器
+ */
+void test_reporter() {
+    gameserver::Logger::ptr target(new gameserver::Logger("metrics_report"));
+    CaptureLogHandler::ptr collect(new CaptureLogHandler);
+    target->addHandler(collect);
+
+    gameserver::Logger::ptr net = GAMESERVER_LOG_NAME("metrics_test.net");
+    net->addHandler(gameserver::LogHandler::ptr(new NullLogHandler));
+    for(int i = 0; i < 100; ++i) {
+        GAMESERVER_LOG_ERROR(net) << "err";
+    }
+
+    {
+        gameserver::LogMetricsReporter reporter(target, 20);
+        usleep(100 * 1000);
+    }
+    std::vector<std::string> lines = collect->contents();
+    bool found_logger = false;
+    bool found_handler = false;
+    for(auto& l : lines) {
+        if(l.find("logger=metrics_test.net accepted=100 filtered=0 dropped=0 format_ns=count:") == 0) {
+            found_logger = true;
+        }
+        if(l.find("logger=metrics_test.net handler=null events=100 bytes=") == 0
+                && l.find(" write_ns=count:") != std::string::npos) {
+            found_handler = true;
+        }
+    }
+    CHECK(found_logger);
+    CHECK(found_handler);
+    // 至少输出了两轮
+    int rounds = 0;
+    for(auto& l : lines) {
+        if(l.find("logger=root ") == 0) {
+            ++rounds;
+        }
+    }
+    CHECK(rounds >= 2);
+    if(!lines.empty()) {
+        std::cout << lines[0] << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    test_counter();
+    test_histogram();
+    test_logger_metrics();
+    test_async_metrics();
+    test_reporter();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
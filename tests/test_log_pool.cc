@@ -0,0 +1,106 @@
+#include <iostream>
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include "Log/log.h"
+#include "Log/async_log.h"
+#include "check.h"
+
+/// 全局分配计数
+static std::atomic<uint64_t> s_allocs(0);
+
+void* operator new(size_t size) {
+    ++s_allocs;
+    void* p = malloc(size ? size : 1);
+    if(!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+/**
+ * @brief 格式化后丢弃
+ */
+class NullLogHandler : public gameserver::LogHandler {
+public:
+    NullLogHandler() {
+        m_writer = true;
+    }
+    void log(const std::shared_ptr<gameserver::Logger>& logger, gameserver::LogLevel::Level level, const gameserver::LogEvent& event) override {
+        m_buf.clear();
+        getFormatter()->format(m_buf, logger, level, event);
+        write(level, m_buf.data(), m_buf.size());
+    }
+    void write(gameserver::LogLevel::Level level, const char* data, size_t len) override {
+        m_bytes += len;
+    }
+    gameserver::LogStream m_buf;
+    std::atomic<uint64_t> m_bytes{0};
+};
+
+static void log_some(gameserver::Logger::ptr logger, int count) {
+    for(int i = 0; i < count; ++i) {
+        gameserver::LogEvent::ptr event = gameserver::LogEvent::Create(logger, __FILE__, __LINE__, 0, 1, 0, time(0), "pool_test");
+        event->getSS() << "player " << i << " moved to " << 1.5 * i << ' ' << true;
+        event->format(" hp=%d name=%s", i, "knight");
+        logger->log(gameserver::LogLevel::INFO, event);
+    }
+}
+
+void test_sync() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("pool"));
+    std::shared_ptr<NullLogHandler> handler(new NullLogHandler);
+    logger->addHandler(handler);
+
+    log_some(logger, 1000);
+    uint64_t before = s_allocs;
+    log_some(logger, 100000);
+    uint64_t allocs = s_allocs - before;
+    std::cout << "sync: allocs=" << allocs << " bytes=" << handler->m_bytes << std::endl;
+    CHECK(allocs == 0);
+}
+
+void test_async() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("pool_async"));
+    std::shared_ptr<NullLogHandler> handler(new NullLogHandler);
+    gameserver::AsyncLogHandler::ptr async(new gameserver::AsyncLogHandler(1024));
+    async->addHandler(handler);
+    logger->addHandler(async);
+
+    log_some(logger, 2000);
+    async->flush();
+    uint64_t before = s_allocs;
+    log_some(logger, 100000);
+    async->flush();
+    uint64_t allocs = s_allocs - before;
+    std::cout << "async: allocs=" << allocs << " bytes=" << handler->m_bytes << std::endl;
+    CHECK(allocs == 0);
+    logger->clearHandler();
+}
+
+void test_content() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("content"));
+    const char* name = "a_very_long_thread_name_that_is_not_copied";
+    gameserver::LogEvent::ptr event = gameserver::LogEvent::Create(logger, __FILE__, __LINE__, 0, 1, 0, time(0), name);
+    event->getSS() << "x=" << 42;
+    event->format(" %s", std::string(1000, 'y').c_str());
+    CHECK(event->getSS().size() == 1005);
+    CHECK(event->getContent() == "x=42 " + std::string(1000, 'y'));
+    // 线程名称只保存指针
+    CHECK(event->getThreadName() == name);
+}
+
+int main(int argc, char** argv) {
+    test_content();
+    test_sync();
+    test_async();
+    return s_failed ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include "Log/log.h"
+#include "Thread/rcu.h"
+#include "check.h"
+
+/// 存活的CountLogHandler个数
+static std::atomic<int> s_alive(0);
+
+/**
+ * @brief 只计数, 析构时检查自己没有在被使用
+ */
+class CountLogHandler : public gameserver::LogHandler {
+public:
+    typedef std::shared_ptr<CountLogHandler> ptr;
+    CountLogHandler() { ++s_alive;}
+    ~CountLogHandler() {
+        m_dead = 0xdead;
+        --s_alive;
+    }
+
+    void log(const std::shared_ptr<gameserver::Logger>& logger, gameserver::LogLevel::Level level, const gameserver::LogEvent& event) override {
+        if(m_dead != 0) {
+            ++s_useAfterFree;
+        }
+        ++m_count;
+    }
+
+    std::atomic<uint64_t> m_count{0};
+    volatile int m_dead = 0;
+    static std::atomic<int> s_useAfterFree;
+};
+
+std::atomic<int> CountLogHandler::s_useAfterFree(0);
+
+struct Node {
+    Node(int* freed) : freed(freed) {}
+    ~Node() { ++*freed;}
+    int* freed;
+};
+
+/**
+ * @brief 读区里的读者拿着的对象不会被释放
+ */
+void test_domain() {
+    gameserver::RcuDomain* domain = gameserver::RcuDomain::GetInstance();
+    int freed = 0;
+    std::atomic<bool> entered(false);
+    std::atomic<bool> leave(false);
+    std::thread reader([&]() {
+        gameserver::RcuReadLock lock;
+        entered = true;
+        while(!leave) {
+            std::this_thread::yield();
+        }
+    });
+    while(!entered) {
+        std::this_thread::yield();
+    }
+    domain->retire(new Node(&freed));
+    domain->collect();
+    CHECK(freed == 0);
+    leave = true;
+    reader.join();
+    domain->collect();
+    CHECK(freed == 1);
+
+    // 在读区里retire的对象要等离开读区后才释放
+    {
+        gameserver::RcuReadLock lock;
+        domain->retire(new Node(&freed));
+        CHECK(freed == 1);
+    }
+    domain->synchronize();
+    CHECK(freed == 2);
+    CHECK(domain->pending() == 0);
+}
+
+/**
+ * @brief N个线程持续写日志, 一个线程不停增删Handler, 更换格式和级别
+ */
+void test_reconfigure() {
+    const int threads = 8;
+    const int count = 100000;
+    gameserver::Logger::ptr logger(new gameserver::Logger("rcu"));
+    // 固定的Handler必须收到每一条
+    CountLogHandler::ptr fixed(new CountLogHandler);
+    logger->addHandler(fixed);
+
+    std::atomic<bool> stop(false);
+    uint64_t changes = 0;
+    std::thread writer([&]() {
+        while(!stop) {
+            CountLogHandler::ptr extra(new CountLogHandler);
+            logger->addHandler(extra);
+            logger->setFormatter(changes % 2 ? "%p %m%n" : "%d %m%n");
+            logger->setLevel(gameserver::LogLevel::DEBUG);
+            logger->delHandler(extra);
+            ++changes;
+        }
+    });
+
+    std::vector<std::thread> vec;
+    auto begin = std::chrono::steady_clock::now();
+    for(int t = 0; t < threads; ++t) {
+        vec.push_back(std::thread([&logger]() {
+            for(int i = 0; i < count; ++i) {
+                GAMESERVER_LOG_INFO(logger) << i;
+            }
+        }));
+    }
+    for(auto& t : vec) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    stop = true;
+    writer.join();
+
+    CHECK(fixed->m_count == (uint64_t)threads * count);
+    CHECK(CountLogHandler::s_useAfterFree == 0);
+    gameserver::RcuDomain::GetInstance()->synchronize();
+    // 删掉的Handler都已回收
+    CHECK(s_alive == 1);
+    std::cout << "reconfigured " << changes << " times, "
+              << (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / ((double)threads * count)
+              << " ns/log" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    test_domain();
+    test_reconfigure();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
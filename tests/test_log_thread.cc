@@ -0,0 +1,84 @@
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <unistd.h>
+#include "Log/log.h"
+#include "check.h"
+
+static const int THREADS = 8;
+static const int COUNT = 20000;
+
+/**
+ * @brief 多个线程同时写同一个日志器, 另一个线程不停增删Handler和更换格式,
+ *        文件里每一行都必须完整
+ */
+void test_concurrent() {
+    std::string path = "/tmp/gameserver_" + std::to_string(getpid()) + "_thread.log";
+    gameserver::Logger::ptr logger(new gameserver::Logger("thread"));
+    gameserver::FileLogHandler::ptr file(new gameserver::FileLogHandler(path));
+    file->setFormatter(gameserver::LogFormatter::ptr(new gameserver::LogFormatter("%t|%m%n")));
+    logger->addHandler(file);
+
+    std::atomic<bool> stop(false);
+    std::thread churn([&]() {
+        int i = 0;
+        while(!stop) {
+            gameserver::FileLogHandler::ptr extra(new gameserver::FileLogHandler("/dev/null"));
+            logger->addHandler(extra);
+            logger->setFormatter(i++ % 2 ? "%p %m%n" : "%d %m%n");
+            logger->delHandler(extra);
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < THREADS; ++t) {
+        threads.push_back(std::thread([&logger, t]() {
+            for(int i = 0; i < COUNT; ++i) {
+                GAMESERVER_LOG_INFO(logger) << "thread " << t << " line " << i << " payload payload payload";
+            }
+        }));
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    stop = true;
+    churn.join();
+    file->flush();
+
+    std::ifstream in(path);
+    std::string line;
+    int lines = 0;
+    std::vector<int> next(THREADS, 0);
+    while(std::getline(in, line)) {
+        ++lines;
+        size_t bar = line.find('|');
+        int t = -1, i = -1;
+        char tail[64] = {0};
+        CHECK(bar != std::string::npos);
+        if(bar == std::string::npos
+                || sscanf(line.c_str() + bar + 1, "thread %d line %d %63[a-z ]", &t, &i, tail) != 3
+                || t < 0 || t >= THREADS) {
+            CHECK(!"bad line");
+            std::cout << line << std::endl;
+            break;
+        }
+        CHECK(std::string(tail) == "payload payload payload");
+        // 同一线程的日志保持顺序
+        CHECK(i == next[t]);
+        next[t] = i + 1;
+    }
+    CHECK(lines == THREADS * COUNT);
+    unlink(path.c_str());
+}
+
+int main(int argc, char** argv) {
+    test_concurrent();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string.h>
+#include "Log/log.h"
+#include "check.h"
+#include "capture_log.h"
+
+void test_hierarchy() {
+    gameserver::LoggerManager mgr;
+    gameserver::Logger::ptr root = mgr.getRoot();
+    CHECK(root->getName() == "root");
+    CHECK(mgr.getLogger("root") == root);
+    CHECK(mgr.findLogger("net") == nullptr);
+
+    gameserver::Logger::ptr http = mgr.getLogger("net.http");
+    gameserver::Logger::ptr net = mgr.findLogger("net");
+    CHECK(http->getName() == "net.http");
+    CHECK(net && net->getName() == "net");
+    CHECK(http->getParent() == net);
+    CHECK(net && net->getParent() == root);
+    CHECK(mgr.getLogger("net.http") == http);
+    CHECK(mgr.getLogger("game.match")->getParent() == mgr.getLogger("game"));
+
+    // 没有Handler的日志器转发到上级, 名称保持原日志器
+    root->clearHandler();
+    CaptureLogHandler::ptr root_handler(new CaptureLogHandler);
+    root->addHandler(root_handler);
+    GAMESERVER_LOG_INFO(http) << "hello";
+    std::vector<CaptureLogHandler::Record> records = root_handler->records();
+    CHECK(records.size() == 1 && records[0].logger == "net.http" && records[0].content == "hello");
+
+    CaptureLogHandler::ptr net_handler(new CaptureLogHandler);
+    net->addHandler(net_handler);
+    GAMESERVER_LOG_INFO(http) << "world";
+    records = net_handler->records();
+    CHECK(records.size() == 1 && records[0].logger == "net.http" && records[0].content == "world");
+    CHECK(root_handler->count() == 1);
+
+    // 多线程拿到同一个日志器
+    std::vector<gameserver::Logger::ptr> got(8);
+    std::vector<std::thread> threads;
+    for(size_t i = 0; i < got.size(); ++i) {
+        threads.push_back(std::thread([&mgr, &got, i]() {
+            got[i] = mgr.getLogger("net.rpc");
+        }));
+    }
+    for(auto& t : threads) {
+        t.join();
+    }
+    for(auto& i : got) {
+        CHECK(i == got[0]);
+    }
+    CHECK(got[0]->getParent() == net);
+}
+
+void test_singleton() {
+    CHECK(GAMESERVER_LOG_ROOT() == gameserver::LoggerMgr::GetInstance()->getRoot());
+    CHECK(GAMESERVER_LOG_NAME("system") == GAMESERVER_LOG_NAME("system"));
+    CHECK(GAMESERVER_LOG_NAME("system")->getParent() == GAMESERVER_LOG_ROOT());
+}
+
+/**
+ * @brief 按const char*取日志器: 与std::string的结果一致, 同一缓冲换了内容也不会取错
+ */
+void test_literal_lookup() {
+    gameserver::LoggerManager mgr;
+    gameserver::Logger::ptr http = mgr.getLogger("net.http");
+    CHECK(http == mgr.getLogger(std::string("net.http")));
+    CHECK(http == mgr.getLogger("net.http"));
+    CHECK(mgr.getLogger("") == mgr.getRoot());
+    CHECK(mgr.getLogger("net") == http->getParent());
+
+    char buf[32];
+    strcpy(buf, "game.match");
+    gameserver::Logger::ptr match = mgr.getLogger(buf);
+    CHECK(match->getName() == "game.match");
+    strcpy(buf, "game.chat");
+    gameserver::Logger::ptr chat = mgr.getLogger(buf);
+    CHECK(chat != match && chat->getName() == "game.chat");
+    CHECK(mgr.getLogger(buf) == chat);
+
+    // 缓存按管理器区分
+    gameserver::LoggerManager other;
+    CHECK(other.getLogger("net.http") != http);
+}
+
+void test_level_from_string() {
+    CHECK(gameserver::LogLevel::FromString("debug") == gameserver::LogLevel::DEBUG);
+    CHECK(gameserver::LogLevel::FromString("INFO") == gameserver::LogLevel::INFO);
+    CHECK(gameserver::LogLevel::FromString("warn") == gameserver::LogLevel::WARN);
+    CHECK(gameserver::LogLevel::FromString("ERROR") == gameserver::LogLevel::ERROR);
+    CHECK(gameserver::LogLevel::FromString("fatal") == gameserver::LogLevel::FATAL);
+    CHECK(gameserver::LogLevel::FromString("xx") == gameserver::LogLevel::UNKNOW);
+}
+
+/**
+ * @brief 缓存命中时的查找耗时
+ */
+void test_lookup_cost() {
+    gameserver::LoggerManager mgr;
+    mgr.getLogger("net.http");
+    const int n = 1000000;
+    std::string name = "net.http";
+    size_t hits = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < n; ++i) {
+        hits += mgr.getLogger(name) != nullptr;
+    }
+    auto end = std::chrono::steady_clock::now();
+    CHECK(hits == (size_t)n);
+    std::cout << "getLogger: " << (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / n
+              << " ns/lookup" << std::endl;
+
+    hits = 0;
+    begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < n; ++i) {
+        hits += mgr.getLogger("net.http") != nullptr;
+    }
+    end = std::chrono::steady_clock::now();
+    CHECK(hits == (size_t)n);
+    std::cout << "getLogger(literal): " << (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / n
+              << " ns/lookup" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    test_hierarchy();
+    test_singleton();
+    test_literal_lookup();
+    test_level_from_string();
+    test_lookup_cost();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
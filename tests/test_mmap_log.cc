@@ -0,0 +1,232 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdlib.h>
+#include <glob.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "Log/log.h"
+#include "Log/mmap_log.h"
+#include "check.h"
+
+static std::string file_path(const char* name) {
+    return "/tmp/gameserver_" + std::to_string(getpid()) + "_" + name;
+}
+
+/**
+ * @brief 按文件名末尾的序号排序的文件列表, 即写入顺序
+ */
+static std::vector<std::string> list_files(const std::string& pattern) {
+    std::vector<std::string> files;
+    glob_t g;
+    if(glob(pattern.c_str(), 0, nullptr, &g) == 0) {
+        for(size_t i = 0; i < g.gl_pathc; ++i) {
+            files.push_back(g.gl_pathv[i]);
+        }
+    }
+    globfree(&g);
+    std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
+        return atoll(a.c_str() + a.rfind('.') + 1) < atoll(b.c_str() + b.rfind('.') + 1);
+    });
+    return files;
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static void remove_files(const std::vector<std::string>& files) {
+    for(auto& f : files) {
+        unlink(f.c_str());
+    }
+}
+
+static gameserver::Logger::ptr make_logger(gameserver::LogHandler::ptr handler) {
+    gameserver::Logger::ptr logger(new gameserver::Logger("mmap"));
+    logger->setFormatter("%m%n");
+    logger->addHandler(handler);
+    return logger;
+}
+
+/**
+ * @brief 段写满时滚动: 每行完整地落在某一段里, 按文件顺序读出来是写入顺序
+ */
+void test_size_roll() {
+    std::string base = file_path("mmap_size");
+    const int count = 20000;
+    uint64_t dropped;
+    uint64_t segments;
+    {
+        gameserver::MmapFileLogHandler::ptr handler(new gameserver::MmapFileLogHandler(base, 16 * 1024));
+        gameserver::Logger::ptr logger = make_logger(handler);
+        CHECK(handler->getCurrentPath().find(base + ".") == 0);
+        for(int i = 0; i < count; ++i) {
+            GAMESERVER_LOG_INFO(logger) << "line " << i << " payload payload payload";
+            if(i % 500 == 0) {
+                // 给后台线程时间准备下一段
+                std::this_thread::yield();
+            }
+        }
+        handler->flush();
+        dropped = handler->getDropped();
+        segments = handler->getSegmentCount();
+    }
+    std::vector<std::string> files = list_files(base + ".*");
+    std::cout << "segments: " << segments << " files: " << files.size()
+              << " dropped: " << dropped << std::endl;
+    CHECK(files.size() > 1);
+    CHECK(files.size() == segments);
+    // 预分配的空白尾部已截掉, 没用过的下一段已删除
+    CHECK(list_files(base + ".next.*").empty());
+
+    int next = 0;
+    int written = 0;
+    for(auto& f : files) {
+        CHECK(read_file(f).size() <= 16 * 1024);
+        std::stringstream ss(read_file(f));
+        std::string line;
+        while(std::getline(ss, line)) {
+            int n = -1;
+            char tail[64] = {0};
+            CHECK(sscanf(line.c_str(), "line %d %63[a-z ]", &n, tail) == 2);
+            CHECK(std::string(tail) == "payload payload payload");
+            CHECK(n >= next);
+            next = n + 1;
+            ++written;
+        }
+    }
+    CHECK(written + dropped == (uint64_t)count);
+    remove_files(files);
+}
+
+/**
+ * @brief 按时间滚动: 跨过秒边界后换到新文件
+ */
+void test_time_roll() {
+    std::string base = file_path("mmap_time");
+    {
+        gameserver::MmapFileLogHandler::ptr handler(new gameserver::MmapFileLogHandler(base, 1 << 20, 1));
+        gameserver::Logger::ptr logger = make_logger(handler);
+        GAMESERVER_LOG_INFO(logger) << "first";
+        std::string first = handler->getCurrentPath();
+        usleep(1100 * 1000);
+        GAMESERVER_LOG_INFO(logger) << "second";
+        CHECK(handler->getSegmentCount() == 2);
+        usleep(1100 * 1000);
+        // 没有日志的时间段不产生文件
+        usleep(1100 * 1000);
+        GAMESERVER_LOG_INFO(logger) << "third";
+        CHECK(handler->getSegmentCount() == 3);
+        CHECK(handler->getCurrentPath() != first);
+    }
+    std::vector<std::string> files = list_files(base + ".*");
+    CHECK(files.size() == 3);
+    if(files.size() == 3) {
+        CHECK(read_file(files[0]) == "first\n");
+        CHECK(read_file(files[1]) == "second\n");
+        CHECK(read_file(files[2]) == "third\n");
+    }
+    remove_files(files);
+}
+
+/**
+ * @brief 多线程写, 条数不丢不重
+ */
+void test_threads() {
+    std::string base = file_path("mmap_thread");
+    const int count = 10000;
+    uint64_t dropped;
+    {
+        gameserver::MmapFileLogHandler::ptr handler(new gameserver::MmapFileLogHandler(base, 1 << 20));
+        gameserver::Logger::ptr logger = make_logger(handler);
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; ++t) {
+            threads.push_back(std::thread([logger, t]() {
+                for(int i = 0; i < count; ++i) {
+                    GAMESERVER_LOG_INFO(logger) << "t" << t << " " << i;
+                }
+            }));
+        }
+        for(auto& t : threads) {
+            t.join();
+        }
+        dropped = handler->getDropped();
+    }
+    std::vector<std::string> files = list_files(base + ".*");
+    int next[4] = {0, 0, 0, 0};
+    uint64_t written = 0;
+    for(auto& f : files) {
+        std::stringstream ss(read_file(f));
+        std::string line;
+        while(std::getline(ss, line)) {
+            int t = -1;
+            int n = -1;
+            CHECK(sscanf(line.c_str(), "t%d %d", &t, &n) == 2);
+            if(t < 0 || t >= 4) {
+                break;
+            }
+            CHECK(n >= next[t]);
+            next[t] = n + 1;
+            ++written;
+        }
+    }
+    CHECK(written + dropped == 4 * (uint64_t)count);
+    remove_files(files);
+}
+
+/**
+ * @brief FileLogHandler重新打开时追加, 不截断
+ */
+void test_file_append() {
+    std::string path = file_path("append.log");
+    gameserver::FileLogHandler::ptr handler(new gameserver::FileLogHandler(path));
+    gameserver::Logger::ptr logger = make_logger(handler);
+    GAMESERVER_LOG_INFO(logger) << "before";
+    handler->flush();
+    CHECK(handler->reopen());
+    GAMESERVER_LOG_INFO(logger) << "after";
+    handler->flush();
+    CHECK(read_file(path) == "before\nafter\n");
+
+    gameserver::FileLogHandler::ptr again(new gameserver::FileLogHandler(path));
+    gameserver::Logger::ptr logger2 = make_logger(again);
+    GAMESERVER_LOG_INFO(logger2) << "again";
+    again->flush();
+    CHECK(read_file(path) == "before\nafter\nagain\n");
+
+    // 外部轮转后写路径不自己重新打开, reopen()之后才写到新文件
+    std::string rotated = path + ".1";
+    CHECK(rename(path.c_str(), rotated.c_str()) == 0);
+    GAMESERVER_LOG_INFO(logger) << "old";
+    handler->flush();
+    CHECK(handler->reopen());
+    GAMESERVER_LOG_INFO(logger) << "new";
+    handler->flush();
+    CHECK(read_file(rotated) == "before\nafter\nagain\nold\n");
+    CHECK(read_file(path) == "new\n");
+    // 打不开时继续写原来的文件
+    gameserver::FileLogHandler::ptr missing(new gameserver::FileLogHandler(file_path("no_such_dir/x.log")));
+    CHECK(!missing->reopen());
+    unlink(path.c_str());
+    unlink(rotated.c_str());
+}
+
+int main(int argc, char** argv) {
+    test_size_roll();
+    test_threads();
+    test_file_append();
+    test_time_roll();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,498 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <poll.h>
+#include <endian.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "Log/log.h"
+#include "Log/net_log.h"
+#include "Util/util.h"
+#include "check.h"
+
+using gameserver::NetworkLogHandler;
+using gameserver::NetworkLogOptions;
+
+static std::string file_path(const char* name) {
+    return "/tmp/gameserver_" + std::to_string(getpid()) + "_" + name;
+}
+
+/**
+ * @brief 最多等待timeout_ms直到条件成立
+ */
+static bool wait_until(std::function<bool()> cond, int timeout_ms = 3000) {
+    uint64_t deadline = gameserver::GetMonotonicMS() + timeout_ms;
+    while(!cond()) {
+        if(gameserver::GetMonotonicMS() > deadline) {
+            return false;
+        }
+        usleep(5 * 1000);
+    }
+    return true;
+}
+
+/**
+ * @brief 取一个当前没有被监听的端口
+ */
+static int free_port() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+/**
+ * @brief 回环上的TCP日志收集器, 按帧解码并记录收到的日志
+ */
+class TcpCollector {
+public:
+    struct Record {
+        int level;
+        uint64_t ms;
+        std::string text;
+    };
+
+    ~TcpCollector() { stop();}
+
+    /**
+     * @brief 在指定端口(0为随机)监听并启动收集线程
+     * @param[in] rcvbuf 非0时设置连接的接收缓冲, 用来模拟慢收集器
+     */
+    bool start(int port = 0, int rcvbuf = 0) {
+        m_listen = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if(rcvbuf) {
+            // 接收缓冲要在listen之前设置才能影响窗口
+            setsockopt(m_listen, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+        }
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if(bind(m_listen, (sockaddr*)&addr, sizeof(addr)) || listen(m_listen, 16)) {
+            close(m_listen);
+            m_listen = -1;
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(m_listen, (sockaddr*)&addr, &len);
+        m_port = ntohs(addr.sin_port);
+        m_stop = false;
+        m_thread = std::thread(std::bind(&TcpCollector::run, this));
+        return true;
+    }
+
+    /**
+     * @brief 停止收集线程, 关闭监听和所有连接
+     */
+    void stop() {
+        if(m_listen < 0) {
+            return;
+        }
+        m_stop = true;
+        m_thread.join();
+        for(auto& c : m_conns) {
+            close(c.fd);
+        }
+        m_conns.clear();
+        close(m_listen);
+        m_listen = -1;
+    }
+
+    /**
+     * @brief 暂停读取, 让发送方的socket缓冲填满
+     */
+    void setPaused(bool v) { m_paused = v;}
+
+    int getPort() const { return m_port;}
+    uint64_t getAccepts() const { return m_accepts;}
+    uint64_t getBytes() const { return m_bytes;}
+
+    size_t count() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_records.size();
+    }
+
+    std::vector<Record> records() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_records;
+    }
+private:
+    struct Conn {
+        int fd;
+        std::string buf;
+    };
+
+    void run() {
+        std::vector<pollfd> fds;
+        char tmp[64 * 1024];
+        while(!m_stop) {
+            fds.clear();
+            fds.push_back({m_listen, POLLIN, 0});
+            if(!m_paused) {
+                for(auto& c : m_conns) {
+                    fds.push_back({c.fd, POLLIN, 0});
+                }
+            }
+            if(poll(&fds[0], fds.size(), 5) <= 0) {
+                continue;
+            }
+            if(fds[0].revents & POLLIN) {
+                int fd = accept(m_listen, nullptr, nullptr);
+                if(fd >= 0) {
+                    m_conns.push_back({fd, std::string()});
+                    ++m_accepts;
+                }
+            }
+            for(size_t i = 1; i < fds.size(); ++i) {
+                if(!fds[i].revents) {
+                    continue;
+                }
+                Conn& c = m_conns[i - 1];
+                ssize_t n = recv(c.fd, tmp, sizeof(tmp), 0);
+                if(n <= 0) {
+                    close(c.fd);
+                    c.fd = -1;
+                    continue;
+                }
+                m_bytes += n;
+                c.buf.append(tmp, n);
+                decode(c.buf);
+            }
+            for(size_t i = 0; i < m_conns.size();) {
+                if(m_conns[i].fd < 0) {
+                    m_conns.erase(m_conns.begin() + i);
+                } else {
+                    ++i;
+                }
+            }
+        }
+    }
+
+    void decode(std::string& buf) {
+        size_t pos = 0;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while(buf.size() - pos >= NetworkLogHandler::RECORD_HEADER_SIZE) {
+            uint32_t len;
+            uint64_t ms;
+            memcpy(&len, &buf[pos], 4);
+            memcpy(&ms, &buf[pos + 5], 8);
+            len = be32toh(len);
+            if(buf.size() - pos < len + 4) {
+                break;
+            }
+            size_t head = NetworkLogHandler::RECORD_HEADER_SIZE;
+            m_records.push_back({buf[pos + 4], be64toh(ms), buf.substr(pos + head, len + 4 - head)});
+            pos += len + 4;
+        }
+        buf.erase(0, pos);
+    }
+private:
+    int m_listen = -1;
+    int m_port = 0;
+    std::atomic<bool> m_stop {false};
+    std::atomic<bool> m_paused {false};
+    std::atomic<uint64_t> m_accepts {0};
+    std::atomic<uint64_t> m_bytes {0};
+    std::vector<Conn> m_conns;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::vector<Record> m_records;
+};
+
+static gameserver::Logger::ptr make_logger(gameserver::LogHandler::ptr handler) {
+    gameserver::Logger::ptr logger(new gameserver::Logger("net"));
+    logger->setFormatter("%m%n");
+    logger->addHandler(handler);
+    return logger;
+}
+
+/**
+ * @brief 收到的日志是否正好是prefix 0..count-1
+ */
+static bool check_sequence(const std::vector<TcpCollector::Record>& records, size_t begin
+                           ,const std::string& prefix, int count) {
+    if(records.size() < begin + count) {
+        return false;
+    }
+    for(int i = 0; i < count; ++i) {
+        if(records[begin + i].text != prefix + std::to_string(i) + "\n") {
+            std::cout << "record " << begin + i << ": " << records[begin + i].text << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按顺序完整送达, 记录头的级别和时间戳, 成批发送
+ */
+void test_tcp_delivery() {
+    TcpCollector collector;
+    CHECK(collector.start());
+    const int count = 20000;
+    {
+        NetworkLogHandler::ptr handler(new NetworkLogHandler(NetworkLogHandler::TCP, "127.0.0.1", collector.getPort()));
+        CHECK(handler->getName() == "net:tcp://127.0.0.1:" + std::to_string(collector.getPort()));
+        gameserver::Logger::ptr logger = make_logger(handler);
+        uint64_t now = gameserver::GetCurrentMS();
+        for(int i = 0; i < count; ++i) {
+            GAMESERVER_LOG_INFO(logger) << "line " << i;
+        }
+        GAMESERVER_LOG_ERROR(logger) << "error";
+        handler->flush();
+        CHECK(handler->isConnected());
+        CHECK(handler->getSent() == count + 1);
+        CHECK(handler->getDropped() == 0);
+        CHECK(handler->getQueueDepth() == 0);
+        CHECK(handler->getConnects() == 1);
+        // 成批写出, 远少于日志条数
+        CHECK(handler->getWrites() < (uint64_t)count / 10);
+        CHECK(wait_until([&]() { return collector.count() == count + 1;}));
+        CHECK(collector.getBytes() == handler->getSentBytes());
+        auto records = collector.records();
+        CHECK(check_sequence(records, 0, "line ", count));
+        CHECK(records.size() == count + 1 && records[0].level == gameserver::LogLevel::INFO);
+        CHECK(records.size() == count + 1 && records[count].level == gameserver::LogLevel::ERROR);
+        CHECK(records.size() == count + 1 && records[0].ms + 1000 >= now && records[0].ms < now + 1000);
+        std::cout << "tcp writes: " << handler->getWrites() << " bytes: " << handler->getSentBytes() << std::endl;
+    }
+    // 超长日志截断
+    {
+        NetworkLogOptions options;
+        options.maxRecordSize = 100;
+        NetworkLogHandler::ptr handler(new NetworkLogHandler(NetworkLogHandler::TCP, "127.0.0.1", collector.getPort(), options));
+        handler->write(gameserver::LogLevel::WARN, std::string(1000, 'x').c_str(), 1000);
+        handler->flush();
+        CHECK(wait_until([&]() { return collector.count() == count + 2;}));
+        auto records = collector.records();
+        CHECK(records.size() == count + 2 && records.back().text == std::string(100, 'x'));
+    }
+}
+
+/**
+ * @brief 收集器重启: 断开期间的日志进溢出文件, 重连后按顺序补发
+ */
+void test_reconnect_spill() {
+    int port = free_port();
+    TcpCollector collector;
+    CHECK(collector.start(port));
+    std::string spill = file_path("net_spill");
+    NetworkLogOptions options;
+    options.spillPath = spill;
+    options.reconnectMinMs = 20;
+    options.reconnectMaxMs = 100;
+    NetworkLogHandler::ptr handler(new NetworkLogHandler(NetworkLogHandler::TCP, "127.0.0.1", port, options));
+    gameserver::Logger::ptr logger = make_logger(handler);
+    for(int i = 0; i < 100; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "up " << i;
+    }
+    handler->flush();
+    CHECK(wait_until([&]() { return collector.count() == 100;}));
+
+    collector.stop();
+    CHECK(wait_until([&]() {
+        GAMESERVER_LOG_INFO(logger) << "probe";
+        return !handler->isConnected();
+    }));
+    uint64_t probes = handler->getEnqueued() - 100;
+    const int count = 5000;
+    for(int i = 0; i < count; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "down " << i;
+    }
+    // 连不上时flush不等待
+    uint64_t begin = gameserver::GetMonotonicMS();
+    handler->flush();
+    CHECK(gameserver::GetMonotonicMS() - begin < 500);
+    CHECK(wait_until([&]() { return handler->getSpillBytes() > 0;}));
+    CHECK(handler->getSpilled() >= (uint64_t)count);
+    CHECK(access(spill.c_str(), F_OK) == 0);
+
+    TcpCollector restarted;
+    CHECK(restarted.start(port));
+    CHECK(wait_until([&]() { return handler->getQueueDepth() == 0;}));
+    CHECK(handler->getConnects() >= 2);
+    CHECK(handler->getSpillBytes() == 0);
+    CHECK(handler->getDropped() == 0);
+    CHECK(wait_until([&]() { return restarted.count() == probes + count;}));
+    CHECK(check_sequence(restarted.records(), probes, "down ", count));
+    std::cout << "spilled: " << handler->getSpilled() << " probes: " << probes << std::endl;
+
+    handler.reset();
+    logger.reset();
+    // 析构时删除溢出文件
+    CHECK(access(spill.c_str(), F_OK) != 0);
+}
+
+/**
+ * @brief 收集器不读: 写日志不阻塞, 超出内存缓冲的部分进溢出文件, 恢复后全部按顺序送达
+ */
+void test_slow_collector() {
+    TcpCollector collector;
+    CHECK(collector.start(0, 16 * 1024));
+    collector.setPaused(true);
+    std::string spill = file_path("net_slow");
+    NetworkLogOptions options;
+    options.spillPath = spill;
+    options.bufferSize = 1024 * 1024;
+    NetworkLogHandler::ptr handler(new NetworkLogHandler(NetworkLogHandler::TCP, "127.0.0.1", collector.getPort(), options));
+    gameserver::Logger::ptr logger = make_logger(handler);
+    CHECK(wait_until([&]() { return handler->isConnected();}));
+    const int count = 50000;
+    std::string payload(100, 'p');
+    uint64_t begin = gameserver::GetMonotonicMS();
+    for(int i = 0; i < count; ++i) {
+        GAMESERVER_LOG_INFO(logger) << payload << " " << i;
+        if(i % 1000 == 0) {
+            // 让后台线程取走缓冲, 不然写线程的缓冲会写满
+            usleep(1000);
+        }
+    }
+    uint64_t used = gameserver::GetMonotonicMS() - begin;
+    CHECK(used < 2000);
+    CHECK(handler->getDropped() == 0);
+    CHECK(wait_until([&]() { return handler->getSpilled() > 0;}));
+    CHECK(handler->getQueueDepth() > 0);
+    std::cout << "slow spilled: " << handler->getSpilled() << " queued: " << handler->getQueueDepth() << std::endl;
+
+    collector.setPaused(false);
+    CHECK(wait_until([&]() { return collector.count() == count;}, 10000));
+    CHECK(handler->getQueueDepth() == 0);
+    auto records = collector.records();
+    CHECK(check_sequence(records, 0, payload + " ", count));
+}
+
+/**
+ * @brief 没有溢出文件时内存缓冲满了丢弃新日志并计数, 连上后送达已接受的
+ */
+void test_drop() {
+    int port = free_port();
+    NetworkLogOptions options;
+    options.bufferSize = 64 * 1024;
+    options.reconnectMinMs = 20;
+    options.reconnectMaxMs = 50;
+    NetworkLogHandler::ptr handler(new NetworkLogHandler(NetworkLogHandler::TCP, "127.0.0.1", port, options));
+    gameserver::Logger::ptr logger = make_logger(handler);
+    const int count = 10000;
+    for(int i = 0; i < count; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "drop " << i;
+        if(i % 1000 == 0) {
+            usleep(1000);
+        }
+    }
+    CHECK(!handler->isConnected());
+    CHECK(handler->getDropped() > 0);
+    CHECK(handler->getEnqueued() + handler->getDropped() == count);
+    CHECK(handler->getQueueDepth() == handler->getEnqueued());
+    std::cout << "enqueued: " << handler->getEnqueued() << " dropped: " << handler->getDropped() << std::endl;
+
+    TcpCollector collector;
+    CHECK(collector.start(port));
+    CHECK(wait_until([&]() { return handler->getQueueDepth() == 0;}));
+    CHECK(wait_until([&]() { return collector.count() == handler->getEnqueued();}));
+    // 接受的日志按序送达; 后台线程取走一批后缓冲又有空间, 所以不一定是连续的前缀
+    auto records = collector.records();
+    CHECK(records.size() == handler->getEnqueued());
+    CHECK(!records.empty() && records[0].text == "drop 0\n");
+    int last = -1;
+    bool ordered = true;
+    for(auto& r : records) {
+        int i = -1;
+        if(sscanf(r.text.c_str(), "drop %d", &i) != 1 || i <= last) {
+            std::cout << "record: " << r.text << std::endl;
+            ordered = false;
+            break;
+        }
+        last = i;
+    }
+    CHECK(ordered);
+}
+
+/**
+ * @brief UDP syslog: RFC 5424格式, 每条日志一个报文
+ */
+void test_udp_syslog() {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (sockaddr*)&addr, sizeof(addr));
+    int rcvbuf = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    timeval tv = {2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    NetworkLogOptions options;
+    options.hostname = "host1";
+    options.appName = "app";
+    NetworkLogHandler::ptr handler(new NetworkLogHandler(NetworkLogHandler::UDP_SYSLOG, "127.0.0.1"
+                                   ,ntohs(addr.sin_port), options));
+    CHECK(handler->getName() == "net:udp://127.0.0.1:" + std::to_string(ntohs(addr.sin_port)));
+    gameserver::Logger::ptr logger = make_logger(handler);
+    const int count = 1000;
+    for(int i = 0; i < count; ++i) {
+        GAMESERVER_LOG_INFO(logger) << "msg " << i;
+    }
+    GAMESERVER_LOG_ERROR(logger) << "failed";
+    handler->flush();
+    CHECK(handler->getSent() == count + 1);
+    CHECK(handler->getWrites() < (uint64_t)count);
+
+    std::string tail = " host1 app " + std::to_string(getpid()) + " - - ";
+    char buf[2048];
+    int ok = 0;
+    for(int i = 0; i <= count; ++i) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if(n <= 0) {
+            break;
+        }
+        std::string msg(buf, n);
+        // <PRI>1 YYYY-MM-DDTHH:MM:SS.mmmZ
+        std::string pri = i < count ? "<134>1 " : "<131>1 ";
+        std::string text = i < count ? "msg " + std::to_string(i) : "failed";
+        size_t ts = pri.size();
+        if(msg.compare(0, pri.size(), pri) == 0 && msg.size() > ts + 24
+                && msg[ts + 4] == '-' && msg[ts + 10] == 'T' && msg[ts + 19] == '.' && msg[ts + 23] == 'Z'
+                && msg.substr(ts + 24) == tail + text) {
+            ++ok;
+        } else {
+            std::cout << "bad datagram: " << msg << std::endl;
+        }
+    }
+    CHECK(ok == count + 1);
+    close(fd);
+}
+
+int main(int argc, char** argv) {
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::FATAL);
+    test_tcp_delivery();
+    test_reconnect_spill();
+    test_slow_collector();
+    test_drop();
+    test_udp_syslog();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
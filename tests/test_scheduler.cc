@@ -0,0 +1,276 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <set>
+#include <atomic>
+#include <unistd.h>
+#include "Log/log.h"
+#include "Fiber/scheduler.h"
+#include "Thread/mutex.h"
+#include "Util/util.h"
+#include "check.h"
+#include "capture_log.h"
+
+/**
+ * @brief 外部线程调度的函数都执行, stop()等全部执行完
+ */
+void test_callbacks() {
+    gameserver::Scheduler sc(4, false, "cb");
+    sc.start();
+    std::atomic<int> count {0};
+    for(int i = 0; i < 10000; ++i) {
+        sc.schedule([&count]() {
+            ++count;
+        });
+    }
+    sc.stop();
+    CHECK(count == 10000);
+    CHECK(gameserver::Scheduler::GetThis() == nullptr);
+}
+
+/**
+ * @brief 指定线程的任务只在该线程执行
+ */
+void test_pinned() {
+    gameserver::Scheduler sc(3, false, "pin");
+    sc.start();
+    std::vector<int> ids = sc.getThreadIds();
+    CHECK(ids.size() == 3);
+    std::vector<std::atomic<int> > wrong(3);
+    std::vector<std::atomic<int> > runs(3);
+    for(int i = 0; i < 3000; ++i) {
+        int t = i % 3;
+        int tid = ids[t];
+        sc.schedule([t, tid, &wrong, &runs]() {
+            if((int)gameserver::GetThreadId() != tid) {
+                ++wrong[t];
+            }
+            ++runs[t];
+        }, tid);
+    }
+    sc.stop();
+    for(int t = 0; t < 3; ++t) {
+        CHECK(runs[t] == 1000);
+        CHECK(wrong[t] == 0);
+    }
+}
+
+/**
+ * @brief 协程YieldToReady后重新调度, 可能换线程继续执行
+ */
+void test_fiber_yield() {
+    gameserver::Scheduler sc(4, false, "yield");
+    sc.start();
+    std::atomic<int> steps {0};
+    std::vector<gameserver::Fiber::ptr> fibers;
+    for(int i = 0; i < 100; ++i) {
+        fibers.push_back(gameserver::Fiber::ptr(new gameserver::Fiber([&steps]() {
+            for(int j = 0; j < 100; ++j) {
+                ++steps;
+                gameserver::Fiber::YieldToReady();
+            }
+        })));
+    }
+    sc.schedule(fibers.begin(), fibers.end());
+    sc.stop();
+    CHECK(steps == 10000);
+    for(auto& f : fibers) {
+        CHECK(f->getState() == gameserver::Fiber::TERM);
+    }
+}
+
+/// 自我调度的任务最多执行的次数
+static const int SPIN_LIMIT = 1000000;
+
+/**
+ * @brief 每次执行都把自己再调度一次, 直到done
+ */
+static void spin(gameserver::Scheduler* sc, std::atomic<bool>* done, std::atomic<int>* runs) {
+    if(!*done && ++*runs < SPIN_LIMIT) {
+        sc->schedule(std::bind(&spin, sc, done, runs));
+    }
+}
+
+/**
+ * @brief 单线程上一个任务一直自我调度, 让出的协程仍能继续执行, 不会等到前者停下
+ */
+void test_yield_fairness() {
+    gameserver::Scheduler sc(1, false, "fair");
+    std::atomic<bool> done {false};
+    std::atomic<int> runs {0};
+    gameserver::Fiber::ptr fiber(new gameserver::Fiber([&done]() {
+        for(int i = 0; i < 100; ++i) {
+            gameserver::Fiber::YieldToReady();
+        }
+        done = true;
+    }));
+    sc.schedule(fiber);
+    sc.schedule(std::bind(&spin, &sc, &done, &runs));
+    sc.start();
+    sc.stop();
+    CHECK(fiber->getState() == gameserver::Fiber::TERM);
+    CHECK(runs < SPIN_LIMIT / 10);
+}
+
+/**
+ * @brief 协程HOLD后由别人(这里是另一个任务)唤醒
+ */
+void test_fiber_hold() {
+    gameserver::Scheduler sc(2, false, "hold");
+    sc.start();
+    std::atomic<int> stage {0};
+    gameserver::Fiber::ptr fiber(new gameserver::Fiber([&stage]() {
+        stage = 1;
+        gameserver::Fiber::YieldToHold();
+        stage = 2;
+    }));
+    sc.schedule(fiber);
+    while(stage != 1 || fiber->getState() != gameserver::Fiber::HOLD) {
+        usleep(100);
+    }
+    sc.schedule(fiber);
+    sc.stop();
+    CHECK(stage == 2);
+    CHECK(fiber->getState() == gameserver::Fiber::TERM);
+}
+
+/**
+ * @brief 任务里调度的任务放进自己的队列, 空闲线程来偷, 多个线程都参与执行
+ */
+void test_steal() {
+    gameserver::Scheduler sc(4, false, "steal");
+    sc.start();
+    gameserver::Mutex mutex;
+    std::set<uint32_t> threads;
+    std::atomic<int> count {0};
+    gameserver::Scheduler* psc = &sc;
+    sc.schedule([psc, &mutex, &threads, &count]() {
+        CHECK(gameserver::Scheduler::GetThis() == psc);
+        CHECK(gameserver::Scheduler::GetWorkerIndex() >= 0);
+        for(int i = 0; i < 200; ++i) {
+            psc->schedule([&mutex, &threads, &count]() {
+                // 阻塞一下线程, 单核机器上别的线程也能被调度到来偷
+                usleep(100);
+                ++count;
+                gameserver::Mutex::Lock lock(mutex);
+                threads.insert(gameserver::GetThreadId());
+            });
+        }
+    });
+    sc.stop();
+    CHECK(count == 200);
+    CHECK(threads.size() >= 2);
+}
+
+/**
+ * @brief 日志里的线程名, 线程id, 协程id
+ */
+void test_log() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("sched"));
+    CaptureLogHandler::ptr handler(new CaptureLogHandler);
+    handler->setFormatter(gameserver::LogFormatter::ptr(new gameserver::LogFormatter("%N %t %F %m")));
+    logger->addHandler(handler);
+    gameserver::Scheduler sc(1, false, "logsc");
+    sc.start();
+    std::atomic<uint64_t> fid {0};
+    int tid = sc.getThreadIds()[0];
+    sc.schedule([logger, &fid]() {
+        fid = gameserver::Fiber::GetFiberId();
+        GAMESERVER_LOG_INFO(logger) << "in task";
+    });
+    sc.stop();
+    std::vector<std::string> lines = handler->lines();
+    CHECK(lines.size() == 1);
+    CHECK(fid > 0);
+    if(lines.size() == 1) {
+        CHECK(lines[0] == "logsc_0 " + std::to_string(tid) + " "
+                + std::to_string(fid) + " in task");
+    }
+}
+
+/**
+ * @brief use_caller: 调用线程是0号线程, 在stop()里执行任务
+ */
+void test_use_caller() {
+    int caller = gameserver::GetThreadId();
+    std::atomic<int> on_caller {0};
+    std::atomic<int> count {0};
+    {
+        gameserver::Scheduler sc(2, true, "caller");
+        CHECK(gameserver::Scheduler::GetThis() == &sc);
+        CHECK(sc.getThreadIds()[0] == caller);
+        sc.start();
+        for(int i = 0; i < 100; ++i) {
+            sc.schedule([&count]() {
+                ++count;
+            });
+            sc.schedule([caller, &on_caller]() {
+                if((int)gameserver::GetThreadId() == caller) {
+                    ++on_caller;
+                }
+            }, caller);
+        }
+        sc.stop();
+        CHECK(gameserver::Fiber::GetFiberId() == 0);
+    }
+    CHECK(count == 100);
+    CHECK(on_caller == 100);
+    CHECK(gameserver::Scheduler::GetThis() == nullptr);
+
+    // 只有调用线程
+    std::vector<int> order;
+    {
+        gameserver::Scheduler sc(1, true, "single");
+        sc.start();
+        for(int i = 0; i < 5; ++i) {
+            sc.schedule([i, &order]() {
+                order.push_back(i);
+            });
+        }
+        CHECK(order.empty());
+        sc.stop();
+    }
+    CHECK(order.size() == 5);
+}
+
+/**
+ * @brief 空闲线程休眠后能被新任务唤醒
+ */
+void test_park() {
+    gameserver::Scheduler sc(2, false, "park");
+    sc.setSpinCount(0);
+    sc.start();
+    for(int i = 0; i < 100 && !sc.hasIdleThreads(); ++i) {
+        usleep(1000);
+    }
+    CHECK(sc.hasIdleThreads());
+    std::atomic<int> count {0};
+    for(int r = 0; r < 100; ++r) {
+        sc.schedule([&count]() {
+            ++count;
+        });
+        while(count != r + 1) {
+            usleep(10);
+        }
+    }
+    sc.stop();
+    CHECK(count == 100);
+}
+
+int main(int argc, char** argv) {
+    test_callbacks();
+    test_pinned();
+    test_fiber_yield();
+    test_yield_fairness();
+    test_fiber_hold();
+    test_steal();
+    test_log();
+    test_use_caller();
+    test_park();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
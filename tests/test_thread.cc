@@ -0,0 +1,112 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "Log/log.h"
+#include "Thread/thread.h"
+#include "Util/util.h"
+#include "check.h"
+#include "capture_log.h"
+
+void test_intern() {
+    const char* a = gameserver::Thread::InternName("worker");
+    const char* b = gameserver::Thread::InternName(std::string("work") + "er");
+    CHECK(a == b);
+    CHECK(strcmp(a, "worker") == 0);
+    CHECK(gameserver::Thread::InternName("other") != a);
+}
+
+void test_thread() {
+    // 不是Thread创建的线程取内核里的线程名(进程名)
+    CHECK(gameserver::Thread::GetThis() == nullptr);
+    CHECK(strcmp(gameserver::Thread::GetName(), "test_thread") == 0);
+
+    std::atomic<pid_t> tid(0);
+    std::atomic<gameserver::Thread*> self(nullptr);
+    std::atomic<const char*> name(nullptr);
+    char sysname[16] = {0};
+    gameserver::Thread::ptr thread(new gameserver::Thread([&]() {
+        tid = syscall(SYS_gettid);
+        self = gameserver::Thread::GetThis();
+        name = gameserver::Thread::GetName();
+        pthread_getname_np(pthread_self(), sysname, sizeof(sysname));
+    }, "a_long_worker_name"));
+    // 构造返回时id已经可用
+    CHECK(thread->getId() > 0);
+    CHECK(thread->joinable());
+    thread->join();
+    CHECK(!thread->joinable());
+    CHECK(tid == thread->getId());
+    CHECK(self == thread.get());
+    CHECK(name == gameserver::Thread::InternName("a_long_worker_name"));
+    CHECK(strcmp(sysname, "a_long_worker_n") == 0);
+    CHECK(thread->getName() == "a_long_worker_name");
+
+    // SetName同时更新Thread对象和缓存
+    gameserver::Thread::ptr renamed(new gameserver::Thread([&]() {
+        gameserver::Thread::SetName("renamed");
+        name = gameserver::Thread::GetName();
+    }, "before"));
+    renamed->join();
+    CHECK(renamed->getName() == "renamed");
+    CHECK(strcmp(name, "renamed") == 0);
+
+    // 不join的线程析构时detach
+    gameserver::Semaphore sem;
+    {
+        gameserver::Thread detached([&sem]() {
+            sem.notify();
+        }, "detached");
+    }
+    sem.wait();
+}
+
+/**
+ * @brief 日志里的线程id和名称来自线程缓存
+ */
+void test_log() {
+    gameserver::Logger::ptr logger(new gameserver::Logger("thread_log"));
+    CaptureLogHandler::ptr handler(new CaptureLogHandler);
+    handler->setFormatter(gameserver::LogFormatter::ptr(new gameserver::LogFormatter("%t %N %m")));
+    logger->addHandler(handler);
+
+    std::vector<gameserver::Thread::ptr> threads;
+    for(int i = 0; i < 4; ++i) {
+        threads.push_back(gameserver::Thread::ptr(new gameserver::Thread([logger]() {
+            for(int j = 0; j < 3; ++j) {
+                GAMESERVER_LOG_INFO(logger) << "x";
+            }
+        }, "logger_" + std::to_string(i))));
+    }
+    for(auto& t : threads) {
+        t->join();
+    }
+    std::vector<CaptureLogHandler::Record> records = handler->records();
+    CHECK(records.size() == 12);
+    for(auto& t : threads) {
+        std::string expect = std::to_string(t->getId()) + " " + t->getName() + " x";
+        int n = 0;
+        for(auto& r : records) {
+            if(r.text == expect) {
+                ++n;
+                // 同一线程的事件共用驻留的名称
+                CHECK(r.threadName == gameserver::Thread::InternName(t->getName()));
+            }
+        }
+        CHECK(n == 3);
+    }
+}
+
+int main(int argc, char** argv) {
+    test_intern();
+    test_thread();
+    test_log();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,244 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <unistd.h>
+#include "Log/log.h"
+#include "Fiber/timer.h"
+#include "Fiber/iomanager.h"
+#include "Util/util.h"
+#include "check.h"
+
+/**
+ * @brief 手动推进时间的TimerManager
+ */
+class FakeTimerManager : public gameserver::TimerManager {
+public:
+    uint64_t m_now = 1000;
+    int m_front = 0;
+
+    /**
+     * @brief 推进到t并执行到期回调
+     */
+    size_t advance(uint64_t t) {
+        m_now = t;
+        std::vector<std::function<void()> > cbs;
+        listExpiredCbs(cbs);
+        for(auto& cb : cbs) {
+            cb();
+        }
+        return cbs.size();
+    }
+protected:
+    uint64_t nowMS() override { return m_now;}
+    void onTimerInsertedAtFront() override { ++m_front;}
+};
+
+/**
+ * @brief 到期顺序和时间, 跨过第0层和更高层
+ */
+void test_order() {
+    FakeTimerManager tm;
+    std::vector<uint64_t> fired;
+    uint64_t delays[] = {0, 1, 5, 255, 256, 300, 1000, 20000, 1u << 20, 1u << 27};
+    for(uint64_t d : delays) {
+        tm.addTimer(d, [&tm, &fired]() {
+            fired.push_back(tm.m_now);
+        });
+    }
+    CHECK(tm.getTimerCount() == 10);
+    // 一毫秒一毫秒推进前面的, 后面跳着推进
+    for(uint64_t t = 1000; t <= 1000 + 20000; ++t) {
+        tm.advance(t);
+    }
+    CHECK(fired.size() == 8);
+    for(size_t i = 0; i < fired.size() && i < 8; ++i) {
+        CHECK(fired[i] == 1000 + delays[i]);
+    }
+    tm.advance(1000 + (1u << 20) - 1);
+    CHECK(fired.size() == 8);
+    tm.advance(1000 + (1u << 20));
+    CHECK(fired.size() == 9);
+    tm.advance(1000 + (1u << 27) + 5);
+    CHECK(fired.size() == 10);
+    CHECK(!tm.hasTimer());
+}
+
+/**
+ * @brief 大跨度推进时同一时刻的定时器都执行, 跳过的时间里到期的也执行
+ */
+void test_jump() {
+    FakeTimerManager tm;
+    std::atomic<int> count {0};
+    for(int i = 0; i < 10000; ++i) {
+        tm.addTimer(i % 5000, [&count]() {
+            ++count;
+        });
+    }
+    CHECK(tm.advance(1000 + 2499) == 5000);
+    CHECK(tm.advance(1000 + 100000) == 5000);
+    CHECK(count == 10000);
+}
+
+/**
+ * @brief 取消, 刷新, 重设间隔
+ */
+void test_cancel_reset() {
+    FakeTimerManager tm;
+    int a = 0, b = 0, c = 0;
+    gameserver::Timer::ptr ta = tm.addTimer(100, [&a]() { ++a;});
+    gameserver::Timer::ptr tb = tm.addTimer(100, [&b]() { ++b;});
+    gameserver::Timer::ptr tc = tm.addTimer(100, [&c]() { ++c;});
+    CHECK(ta->cancel());
+    CHECK(!ta->cancel());
+    tm.advance(1050);
+    CHECK(tb->refresh());     // 到1150
+    CHECK(tc->reset(500, false));  // 到1500
+    tm.advance(1100);
+    CHECK(a == 0 && b == 0 && c == 0);
+    tm.advance(1150);
+    CHECK(b == 1);
+    CHECK(!tb->refresh());
+    tm.advance(1499);
+    CHECK(c == 0);
+    tm.advance(1500);
+    CHECK(c == 1);
+    CHECK(a == 0);
+    CHECK(!tm.hasTimer());
+}
+
+/**
+ * @brief 循环定时器按间隔重复执行, 取消后停止
+ */
+void test_recurring() {
+    FakeTimerManager tm;
+    int count = 0;
+    gameserver::Timer::ptr t = tm.addTimer(10, [&count]() { ++count;}, true);
+    for(uint64_t now = 1000; now <= 1100; ++now) {
+        tm.advance(now);
+    }
+    CHECK(count == 10);
+    CHECK(tm.hasTimer());
+    CHECK(t->cancel());
+    tm.advance(2000);
+    CHECK(count == 10);
+    CHECK(!tm.hasTimer());
+}
+
+/**
+ * @brief 条件对象释放后定时器不执行, 循环的也被删除
+ */
+void test_condition() {
+    FakeTimerManager tm;
+    int count = 0;
+    std::shared_ptr<int> owner(new int(1));
+    tm.addConditionTimer(10, [&count]() { ++count;}, owner, true);
+    tm.advance(1010);
+    CHECK(count == 1);
+    owner.reset();
+    tm.advance(1020);
+    CHECK(count == 1);
+    CHECK(!tm.hasTimer());
+}
+
+/**
+ * @brief 更早的定时器插入时通知, getNextTimer之后才会再通知
+ */
+void test_front() {
+    FakeTimerManager tm;
+    CHECK(tm.getNextTimer() == ~0ull);
+    tm.addTimer(100, []() {});
+    CHECK(tm.m_front == 1);
+    CHECK(tm.getNextTimer() == 100);
+    tm.addTimer(200, []() {});
+    CHECK(tm.m_front == 1);
+    tm.addTimer(50, []() {});
+    CHECK(tm.m_front == 2);
+    CHECK(tm.getNextTimer() == 50);
+    // 只有高层定时器时等到第0层转完一圈
+    FakeTimerManager tm2;
+    tm2.addTimer(5000, []() {});
+    uint64_t next = tm2.getNextTimer();
+    CHECK(next > 0 && next <= 256);
+}
+
+/**
+ * @brief 定时刷新日志Handler, Handler释放后定时器删除
+ */
+class CountFlushHandler : public gameserver::LogHandler {
+public:
+    void log(const std::shared_ptr<gameserver::Logger>& logger, gameserver::LogLevel::Level level, const gameserver::LogEvent& event) override {}
+    void flush() override { ++m_flushes;}
+    int m_flushes = 0;
+};
+
+void test_flush_timer() {
+    FakeTimerManager tm;
+    std::shared_ptr<CountFlushHandler> handler(new CountFlushHandler);
+    tm.addFlushTimer(100, handler);
+    tm.advance(1100);
+    tm.advance(1200);
+    CHECK(handler->m_flushes == 2);
+    handler.reset();
+    tm.advance(1300);
+    CHECK(!tm.hasTimer());
+}
+
+/**
+ * @brief IOManager里的定时器: 休眠的线程按时醒来, 协程可以用定时器睡眠
+ */
+void test_iomanager() {
+    std::atomic<int> count {0};
+    uint64_t begin = gameserver::GetMonotonicMS();
+    std::atomic<uint64_t> fired_at {0};
+    std::atomic<uint64_t> woke_at {0};
+    {
+        gameserver::IOManager iom(2, false, "iotimer");
+        iom.setSpinCount(0);
+        iom.start();
+        // 等线程都休眠(无限等待)后再加定时器, 需要被唤醒重新计算
+        for(int i = 0; i < 100 && !iom.hasIdleThreads(); ++i) {
+            usleep(1000);
+        }
+        iom.addTimer(50, [&fired_at]() {
+            fired_at = gameserver::GetMonotonicMS();
+        });
+        gameserver::Timer::ptr rt = iom.addTimer(10, [&count]() {
+            ++count;
+        }, true);
+        gameserver::IOManager* piom = &iom;
+        iom.schedule([piom, &woke_at]() {
+            gameserver::Fiber::ptr self = gameserver::Fiber::GetThis();
+            piom->addTimer(30, [piom, self]() {
+                piom->schedule(self);
+            });
+            gameserver::Fiber::YieldToHold();
+            woke_at = gameserver::GetMonotonicMS();
+        });
+        usleep(120 * 1000);
+        rt->cancel();
+        iom.stop();
+    }
+    CHECK(fired_at >= begin + 50);
+    CHECK(fired_at < begin + 50 + 500);
+    CHECK(woke_at >= begin + 30);
+    CHECK(count >= 5);
+}
+
+int main(int argc, char** argv) {
+    GAMESERVER_LOG_NAME("system")->setLevel(gameserver::LogLevel::INFO);
+    test_order();
+    test_jump();
+    test_cancel_reset();
+    test_recurring();
+    test_condition();
+    test_front();
+    test_flush_timer();
+    test_iomanager();
+    if(s_failed) {
+        std::cout << s_failed << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all passed" << std::endl;
+    return 0;
+}
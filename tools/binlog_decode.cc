@@ -0,0 +1,27 @@
+#include <iostream>
+#include <stdio.h>
+#include "Log/binlog.h"
+
+/**
+ * @brief 二进制日志解码工具
+ * @details 用法: binlog_decode <file>, 解码结果输出到标准输出
+ */
+int main(int argc, char** argv) {
+    if(argc != 2) {
+        std::cerr << "usage: " << argv[0] << " <binlog file>" << std::endl;
+        return 1;
+    }
+    FILE* in = fopen(argv[1], "rb");
+    if(!in) {
+        std::cerr << "open " << argv[1] << " failed" << std::endl;
+        return 1;
+    }
+    int64_t count = gameserver::BinLogDecoder::Decode(in, std::cout);
+    fclose(in);
+    std::cout.flush();
+    if(count < 0) {
+        std::cerr << argv[1] << ": bad binlog file" << std::endl;
+        return 1;
+    }
+    return 0;
+}